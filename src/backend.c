@@ -0,0 +1,187 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "backend.h"
+
+const backend_t *backend;
+uint64_t backend_requests[BACKEND_REQUESTS_COUNT];
+
+static const char *backend_request_names[BACKEND_REQUESTS_COUNT] = {
+	[BACKEND_GENERATE_ID] = "generateId",
+	[BACKEND_CONFIGURE_WINDOW] = "configureWindow",
+	[BACKEND_CHANGE_ATTRIBUTES] = "changeAttributes",
+	[BACKEND_CHANGE_PROPERTY] = "changeProperty",
+	[BACKEND_MAP_WINDOW] = "mapWindow",
+	[BACKEND_UNMAP_WINDOW] = "unmapWindow",
+	[BACKEND_SET_INPUT_FOCUS] = "setInputFocus",
+	[BACKEND_FLUSH] = "flush",
+	[BACKEND_CREATE_WINDOW] = "createWindow",
+	[BACKEND_DESTROY_WINDOW] = "destroyWindow",
+	[BACKEND_REPARENT_WINDOW] = "reparentWindow",
+	[BACKEND_CHANGE_SAVE_SET] = "changeSaveSet",
+	[BACKEND_SHAPE_RECTANGLES] = "shapeRectangles",
+	[BACKEND_SEND_EVENT] = "sendEvent",
+	[BACKEND_WARP_POINTER] = "warpPointer",
+	[BACKEND_KILL_CLIENT] = "killClient",
+	[BACKEND_QUERY_TREE] = "queryTree",
+	[BACKEND_GET_GEOMETRY] = "getGeometry",
+	[BACKEND_QUERY_POINTER] = "queryPointer",
+};
+
+const char *backend_request_name(backend_request_t r)
+{
+	return backend_request_names[r];
+}
+
+void reset_backend_requests(void)
+{
+	memset(backend_requests, 0, sizeof(backend_requests));
+}
+
+/* Identifiers are still unique, but drawn from a range that no X server hands out. */
+static uint32_t recording_generate_id(void)
+{
+	static uint32_t next_id = 0x80000000;
+	backend_requests[BACKEND_GENERATE_ID]++;
+	return next_id++;
+}
+
+static void recording_configure_window(__attribute__((unused)) xcb_window_t win, __attribute__((unused)) uint16_t mask, __attribute__((unused)) const uint32_t *values)
+{
+	backend_requests[BACKEND_CONFIGURE_WINDOW]++;
+}
+
+static void recording_change_attributes(__attribute__((unused)) xcb_window_t win, __attribute__((unused)) uint32_t mask, __attribute__((unused)) const uint32_t *values)
+{
+	backend_requests[BACKEND_CHANGE_ATTRIBUTES]++;
+}
+
+static void recording_change_property(__attribute__((unused)) xcb_window_t win, __attribute__((unused)) xcb_atom_t property, __attribute__((unused)) xcb_atom_t type, __attribute__((unused)) uint8_t format, __attribute__((unused)) uint32_t len, __attribute__((unused)) const void *data)
+{
+	backend_requests[BACKEND_CHANGE_PROPERTY]++;
+}
+
+static void recording_map_window(__attribute__((unused)) xcb_window_t win)
+{
+	backend_requests[BACKEND_MAP_WINDOW]++;
+}
+
+static void recording_unmap_window(__attribute__((unused)) xcb_window_t win)
+{
+	backend_requests[BACKEND_UNMAP_WINDOW]++;
+}
+
+static void recording_set_input_focus(__attribute__((unused)) uint8_t revert_to, __attribute__((unused)) xcb_window_t win)
+{
+	backend_requests[BACKEND_SET_INPUT_FOCUS]++;
+}
+
+static void recording_flush(void)
+{
+	backend_requests[BACKEND_FLUSH]++;
+}
+
+static void recording_create_window(__attribute__((unused)) xcb_window_t win, __attribute__((unused)) xcb_window_t parent, __attribute__((unused)) xcb_rectangle_t rect, __attribute__((unused)) uint16_t class, __attribute__((unused)) uint32_t mask, __attribute__((unused)) const uint32_t *values)
+{
+	backend_requests[BACKEND_CREATE_WINDOW]++;
+}
+
+static void recording_destroy_window(__attribute__((unused)) xcb_window_t win)
+{
+	backend_requests[BACKEND_DESTROY_WINDOW]++;
+}
+
+static void recording_reparent_window(__attribute__((unused)) xcb_window_t win, __attribute__((unused)) xcb_window_t parent, __attribute__((unused)) int16_t x, __attribute__((unused)) int16_t y)
+{
+	backend_requests[BACKEND_REPARENT_WINDOW]++;
+}
+
+static void recording_change_save_set(__attribute__((unused)) uint8_t mode, __attribute__((unused)) xcb_window_t win)
+{
+	backend_requests[BACKEND_CHANGE_SAVE_SET]++;
+}
+
+static void recording_shape_rectangles(__attribute__((unused)) uint8_t kind, __attribute__((unused)) xcb_window_t win, __attribute__((unused)) uint32_t len, __attribute__((unused)) const xcb_rectangle_t *rects)
+{
+	backend_requests[BACKEND_SHAPE_RECTANGLES]++;
+}
+
+static void recording_send_event(__attribute__((unused)) xcb_window_t win, __attribute__((unused)) uint32_t mask, __attribute__((unused)) const char *event)
+{
+	backend_requests[BACKEND_SEND_EVENT]++;
+}
+
+static void recording_warp_pointer(__attribute__((unused)) int16_t x, __attribute__((unused)) int16_t y)
+{
+	backend_requests[BACKEND_WARP_POINTER]++;
+}
+
+static void recording_kill_client(__attribute__((unused)) xcb_window_t win)
+{
+	backend_requests[BACKEND_KILL_CLIENT]++;
+}
+
+static bool recording_query_tree(__attribute__((unused)) xcb_window_t win, __attribute__((unused)) xcb_window_t **children, __attribute__((unused)) int *len)
+{
+	backend_requests[BACKEND_QUERY_TREE]++;
+	return false;
+}
+
+static void recording_get_geometries(__attribute__((unused)) const xcb_window_t *wins, int len, window_geometry_t *geos)
+{
+	for (int i = 0; i < len; i++) {
+		geos[i].valid = false;
+	}
+	backend_requests[BACKEND_GET_GEOMETRY] += len;
+}
+
+static bool recording_query_pointer(__attribute__((unused)) xcb_window_t win, __attribute__((unused)) xcb_window_t *child, __attribute__((unused)) xcb_point_t *pt)
+{
+	backend_requests[BACKEND_QUERY_POINTER]++;
+	return false;
+}
+
+const backend_t recording_backend = {
+	"recording",
+	recording_generate_id,
+	recording_configure_window,
+	recording_change_attributes,
+	recording_change_property,
+	recording_map_window,
+	recording_unmap_window,
+	recording_set_input_focus,
+	recording_flush,
+	recording_create_window,
+	recording_destroy_window,
+	recording_reparent_window,
+	recording_change_save_set,
+	recording_shape_rectangles,
+	recording_send_event,
+	recording_warp_pointer,
+	recording_kill_client,
+	recording_query_tree,
+	recording_get_geometries,
+	recording_query_pointer
+};
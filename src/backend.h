@@ -0,0 +1,98 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BSPWM_BACKEND_H
+#define BSPWM_BACKEND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+typedef enum {
+	BACKEND_GENERATE_ID,
+	BACKEND_CONFIGURE_WINDOW,
+	BACKEND_CHANGE_ATTRIBUTES,
+	BACKEND_CHANGE_PROPERTY,
+	BACKEND_MAP_WINDOW,
+	BACKEND_UNMAP_WINDOW,
+	BACKEND_SET_INPUT_FOCUS,
+	BACKEND_FLUSH,
+	BACKEND_CREATE_WINDOW,
+	BACKEND_DESTROY_WINDOW,
+	BACKEND_REPARENT_WINDOW,
+	BACKEND_CHANGE_SAVE_SET,
+	BACKEND_SHAPE_RECTANGLES,
+	BACKEND_SEND_EVENT,
+	BACKEND_WARP_POINTER,
+	BACKEND_KILL_CLIENT,
+	BACKEND_QUERY_TREE,
+	BACKEND_GET_GEOMETRY,
+	BACKEND_QUERY_POINTER,
+	BACKEND_REQUESTS_COUNT
+} backend_request_t;
+
+typedef struct {
+	xcb_rectangle_t rectangle;
+	uint16_t border_width;
+	bool valid;
+} window_geometry_t;
+
+/* The requests through which the core (the tree, the layout, the stacking, the
+ * focus and the EWMH hints) reaches the display. The X backend sends them to
+ * the server, the recording backend only counts them, which lets the core run
+ * without an X server: it answers the queries as if the windows were gone.
+ * Reading the windows and the outputs to manage is left to `manage.c`. */
+typedef struct {
+	const char *name;
+	uint32_t (*generate_id)(void);
+	void (*configure_window)(xcb_window_t win, uint16_t mask, const uint32_t *values);
+	void (*change_attributes)(xcb_window_t win, uint32_t mask, const uint32_t *values);
+	void (*change_property)(xcb_window_t win, xcb_atom_t property, xcb_atom_t type, uint8_t format, uint32_t len, const void *data);
+	void (*map_window)(xcb_window_t win);
+	void (*unmap_window)(xcb_window_t win);
+	void (*set_input_focus)(uint8_t revert_to, xcb_window_t win);
+	void (*flush)(void);
+	void (*create_window)(xcb_window_t win, xcb_window_t parent, xcb_rectangle_t rect, uint16_t class, uint32_t mask, const uint32_t *values);
+	void (*destroy_window)(xcb_window_t win);
+	void (*reparent_window)(xcb_window_t win, xcb_window_t parent, int16_t x, int16_t y);
+	void (*change_save_set)(uint8_t mode, xcb_window_t win);
+	void (*shape_rectangles)(uint8_t kind, xcb_window_t win, uint32_t len, const xcb_rectangle_t *rects);
+	void (*send_event)(xcb_window_t win, uint32_t mask, const char *event);
+	void (*warp_pointer)(int16_t x, int16_t y);
+	void (*kill_client)(xcb_window_t win);
+	bool (*query_tree)(xcb_window_t win, xcb_window_t **children, int *len);
+	void (*get_geometries)(const xcb_window_t *wins, int len, window_geometry_t *geos);
+	bool (*query_pointer)(xcb_window_t win, xcb_window_t *child, xcb_point_t *pt);
+} backend_t;
+
+/* Defined in xbackend.c, which only the window manager links. */
+extern const backend_t x_backend;
+extern const backend_t recording_backend;
+extern const backend_t *backend;
+extern uint64_t backend_requests[BACKEND_REQUESTS_COUNT];
+
+const char *backend_request_name(backend_request_t r);
+void reset_backend_requests(void);
+
+#endif
@@ -0,0 +1,207 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include "bspwm.h"
+#include "backend.h"
+#include "desktop.h"
+#include "ewmh.h"
+#include "history.h"
+#include "monitor.h"
+#include "query.h"
+#include "settings.h"
+#include "stats.h"
+#include "tree.h"
+
+#define BENCH_NODES          10000
+#define BENCH_ARRANGES       100
+#define BENCH_SELECTIONS     1000
+
+/* Runs the tree, layout, selector and history code of libbspwm-core against the
+ * recording backend: there is no display connection, every request is counted. */
+
+typedef struct {
+	const char *name;
+	unsigned int ops;
+	uint64_t start;
+	uint64_t requests[BACKEND_REQUESTS_COUNT];
+} bench_t;
+
+static uint32_t seed = 1;
+
+static unsigned int bench_rand(unsigned int n)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) % n;
+}
+
+static void bench_begin(bench_t *b, const char *name, unsigned int ops)
+{
+	b->name = name;
+	b->ops = ops;
+	reset_backend_requests();
+	b->start = stats_clock();
+}
+
+static void bench_end(bench_t *b)
+{
+	uint64_t elapsed = stats_clock() - b->start;
+	uint64_t total = 0;
+	for (int i = 0; i < BACKEND_REQUESTS_COUNT; i++) {
+		total += backend_requests[i];
+	}
+	printf("%-24s %8u ops %10llu us %10.1f ns/op %8g requests/op", b->name, b->ops,
+	       (unsigned long long) elapsed, 1e3 * elapsed / b->ops, (double) total / b->ops);
+	for (int i = 0; i < BACKEND_REQUESTS_COUNT; i++) {
+		if (backend_requests[i] > 0) {
+			printf(" %s=%g", backend_request_name(i), (double) backend_requests[i] / b->ops);
+		}
+	}
+	printf("\n");
+}
+
+static void setup_mock_display(void)
+{
+	static xcb_screen_t mock_screen;
+
+	dpy = NULL;
+	default_screen = 0;
+	screen_width = 1920;
+	screen_height = 1080;
+	mock_screen.root = root = 1;
+	mock_screen.width_in_pixels = screen_width;
+	mock_screen.height_in_pixels = screen_height;
+	screen = &mock_screen;
+
+	/* The atoms are left unset. */
+	ewmh = calloc(1, sizeof(xcb_ewmh_connection_t));
+
+	backend = &recording_backend;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int count = BENCH_NODES;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "hn:")) != -1) {
+		switch (opt) {
+			case 'h':
+				printf("bspwm-bench [-h|-n NODES]\n");
+				exit(EXIT_SUCCESS);
+				break;
+			case 'n':
+				count = strtoul(optarg, NULL, 10);
+				break;
+		}
+	}
+
+	if (count == 0) {
+		err("The number of nodes must be positive.\n");
+	}
+
+	setup_mock_display();
+	init();
+	load_settings();
+
+	xcb_rectangle_t rect = {0, 0, screen_width, screen_height};
+	monitor_t *m = make_monitor(NULL, &rect, XCB_NONE);
+	add_monitor(m);
+	desktop_t *d = make_desktop(NULL, XCB_NONE);
+	add_desktop(m, d);
+
+	node_t **nodes = malloc(count * sizeof(node_t *));
+	if (nodes == NULL) {
+		err("Can't allocate the nodes.\n");
+	}
+
+	bench_t b;
+
+	bench_begin(&b, "insert", count);
+	for (unsigned int i = 0; i < count; i++) {
+		node_t *n = make_node(backend->generate_id());
+		n->client = make_client();
+		insert_node(m, d, n, i > 0 ? nodes[bench_rand(i)] : NULL);
+		nodes[i] = n;
+		clients_count++;
+	}
+	bench_end(&b);
+
+	bench_begin(&b, "arrange", BENCH_ARRANGES);
+	for (unsigned int i = 0; i < BENCH_ARRANGES; i++) {
+		arrange(m, d);
+	}
+	bench_end(&b);
+
+	bench_begin(&b, "focus", count);
+	for (unsigned int i = 0; i < count; i++) {
+		focus_node(m, d, nodes[bench_rand(count)]);
+	}
+	bench_end(&b);
+
+	node_select_t sel = make_node_select();
+	bench_begin(&b, "history", BENCH_SELECTIONS);
+	for (unsigned int i = 0; i < BENCH_SELECTIONS; i++) {
+		coordinates_t ref = {m, d, nodes[bench_rand(count)]};
+		coordinates_t dst;
+		history_find_node(HISTORY_OLDER, &ref, &dst, &sel);
+	}
+	bench_end(&b);
+
+	/* The descriptors without a conversion ignore the identifier. */
+	char *descs[][2] = {
+		{"select any.leaf", "any.leaf"},
+		{"select biggest.local", "biggest.local"},
+		{"select next.leaf", "next.leaf"},
+		{"select older", "older"},
+		{"select @/first", "@/first"},
+		{"select id", "0x%08X"},
+	};
+	for (unsigned int j = 0; j < LENGTH(descs); j++) {
+		bench_begin(&b, descs[j][0], BENCH_SELECTIONS);
+		for (unsigned int i = 0; i < BENCH_SELECTIONS; i++) {
+			char desc[SMALEN];
+			snprintf(desc, sizeof(desc), descs[j][1], nodes[bench_rand(count)]->id);
+			coordinates_t ref = {m, d, d->focus};
+			coordinates_t dst;
+			node_from_desc(desc, &ref, &dst);
+		}
+		bench_end(&b);
+	}
+
+	bench_begin(&b, "remove", count);
+	for (unsigned int i = count; i > 0; i--) {
+		unsigned int k = bench_rand(i);
+		remove_node(m, d, nodes[k]);
+		nodes[k] = nodes[i - 1];
+	}
+	bench_end(&b);
+
+	free(nodes);
+	return EXIT_SUCCESS;
+}
@@ -24,6 +24,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -32,6 +36,126 @@
 #include <unistd.h>
 #include "helpers.h"
 #include "common.h"
+#include "mirror.h"
+
+#define MIRROR_READ_ATTEMPTS  1000
+
+static const char *layout_names[] = {"tiled", "monocle", "master_stack", "centered_master", "grid"};
+static const char *state_names[] = {"tiled", "pseudo_tiled", "floating", "fullscreen"};
+static const char *layer_names[] = {"below", "normal", "above"};
+
+/* The name of the shared memory object of the state mirror: taken from the
+ * environment, or derived from the display. */
+static bool mirror_name_for_display(char *name, size_t len)
+{
+	char *env = getenv(MIRROR_ENV_VAR);
+	if (env != NULL) {
+		snprintf(name, len, "%s", env);
+		return true;
+	}
+	char *host = NULL;
+	int dn = 0, sn = 0;
+	bool found = (xcb_parse_display(NULL, &host, &dn, &sn) != 0);
+	if (found) {
+		snprintf(name, len, MIRROR_NAME_TPL, host, dn, sn);
+	}
+	free(host);
+	return found;
+}
+
+/* Copy a consistent snapshot of the state mirror, without talking to bspwm. */
+static char *read_mirror(void)
+{
+	char name[MAXLEN] = "";
+	if (!mirror_name_for_display(name, sizeof(name))) {
+		err("Failed to parse the display name.\n");
+	}
+
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd == -1) {
+		err("Failed to open the state mirror.\n");
+	}
+
+	char *copy = NULL;
+	for (int i = 0; i < MIRROR_READ_ATTEMPTS && copy == NULL; i++) {
+		struct stat st;
+		if (fstat(fd, &st) == -1 || (size_t) st.st_size < sizeof(mirror_header_t)) {
+			sched_yield();
+			continue;
+		}
+		char *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (map == MAP_FAILED) {
+			break;
+		}
+		mirror_header_t *h = (mirror_header_t *) map;
+		uint32_t seq = __atomic_load_n(&h->sequence, __ATOMIC_ACQUIRE);
+		uint32_t size = h->size;
+		if (h->magic == MIRROR_MAGIC && h->version == MIRROR_VERSION &&
+		    (seq & 1) == 0 && size >= sizeof(mirror_header_t) && size <= st.st_size) {
+			copy = malloc(size);
+			if (copy != NULL) {
+				memcpy(copy, map, size);
+				__atomic_thread_fence(__ATOMIC_ACQUIRE);
+				if (__atomic_load_n(&h->sequence, __ATOMIC_RELAXED) != seq) {
+					free(copy);
+					copy = NULL;
+				}
+			}
+		}
+		munmap(map, st.st_size);
+		if (copy == NULL) {
+			sched_yield();
+		}
+	}
+
+	close(fd);
+
+	if (copy == NULL) {
+		err("Failed to read the state mirror.\n");
+	}
+
+	return copy;
+}
+
+static int print_mirror(void)
+{
+	char *copy = read_mirror();
+	mirror_header_t *h = (mirror_header_t *) copy;
+	mirror_monitor_t *mm = (mirror_monitor_t *) (h + 1);
+	mirror_desktop_t *md = (mirror_desktop_t *) (mm + h->monitors_count);
+	mirror_node_t *mn = (mirror_node_t *) (md + h->desktops_count);
+
+	for (uint32_t i = 0; i < h->monitors_count; i++, mm++) {
+		mirror_rectangle_t *r = &mm->rectangle;
+		printf("monitor 0x%08X %s %ux%u+%i+%i %s%s\n", mm->id, mm->name, r->width, r->height, r->x, r->y,
+		       mm->id == h->focused_monitor_id ? "focused" : "-", mm->id == h->primary_monitor_id ? " primary" : "");
+		for (uint32_t j = 0; j < mm->desktops_count; j++, md++) {
+			printf("desktop 0x%08X %s %s %s 0x%08X\n", md->id, md->name, md->layout < LENGTH(layout_names) ? layout_names[md->layout] : "-",
+			       md->id == mm->focused_desktop_id ? "active" : "-", md->focused_node_id);
+			for (uint32_t k = 0; k < md->nodes_count; k++, mn++) {
+				r = &mn->rectangle;
+				printf("node 0x%08X 0x%08X %ux%u+%i+%i", mn->id, mn->parent_id, r->width, r->height, r->x, r->y);
+				if (mn->flags & MIRROR_NODE_CLIENT) {
+					printf(" %s %s", mn->state < LENGTH(state_names) ? state_names[mn->state] : "-",
+					       mn->layer < LENGTH(layer_names) ? layer_names[mn->layer] : "-");
+				} else {
+					printf(" %s", mn->split_type == 0 ? "horizontal" : "vertical");
+				}
+				printf(" %c%c%c%c%c%c%c\n",
+				       mn->flags & MIRROR_NODE_FOCUSED ? 'F' : '-',
+				       mn->flags & MIRROR_NODE_HIDDEN ? 'H' : '-',
+				       mn->flags & MIRROR_NODE_STICKY ? 'S' : '-',
+				       mn->flags & MIRROR_NODE_PRIVATE ? 'P' : '-',
+				       mn->flags & MIRROR_NODE_LOCKED ? 'L' : '-',
+				       mn->flags & MIRROR_NODE_MARKED ? 'M' : '-',
+				       mn->flags & MIRROR_NODE_URGENT ? 'U' : '-');
+			}
+		}
+	}
+
+	free(copy);
+	return EXIT_SUCCESS;
+}
 
 int main(int argc, char *argv[])
 {
@@ -48,6 +172,10 @@ int main(int argc, char *argv[])
 		err("No arguments given.\n");
 	}
 
+	if (streq("mirror", argv[1])) {
+		return print_mirror();
+	}
+
 	sock_address.sun_family = AF_UNIX;
 	// The socket path
 	char *sp;
@@ -37,9 +37,11 @@
 #include <string.h>
 #include <xcb/xinerama.h>
 #include "types.h"
+#include "backend.h"
 #include "desktop.h"
 #include "monitor.h"
 #include "settings.h"
+#include "stats.h"
 #include "messages.h"
 #include "pointer.h"
 #include "events.h"
@@ -50,55 +52,27 @@
 #include "rule.h"
 #include "restore.h"
 #include "query.h"
+#include "subscribe.h"
+#include "journal.h"
+#include "manage.h"
+#include "delta.h"
+#include "mirror.h"
+#include "snapshot.h"
+#include "selector.h"
+#include "trace.h"
 #include "bspwm.h"
 
-// the X display connection
-xcb_connection_t *dpy;
-int default_screen, screen_width, screen_height;
-uint32_t clients_count;
-xcb_screen_t *screen;
-xcb_window_t root;
-// path to the config file
-char config_path[MAXLEN];
-
-monitor_t *mon;
-monitor_t *mon_head;
-monitor_t *mon_tail;
-monitor_t *pri_mon;
-history_t *history_head;
-history_t *history_tail;
-history_t *history_needle;
-rule_t *rule_head;
-rule_t *rule_tail;
-stacking_list_t *stack_head;
-stacking_list_t *stack_tail;
-subscriber_list_t *subscribe_head;
-subscriber_list_t *subscribe_tail;
-pending_rule_t *pending_rule_head;
-pending_rule_t *pending_rule_tail;
-
-xcb_window_t meta_window;
-motion_recorder_t motion_recorder;
-xcb_atom_t WM_STATE;
-xcb_atom_t WM_TAKE_FOCUS;
-xcb_atom_t WM_DELETE_WINDOW;
-int exit_status;
-
-bool auto_raise;
-bool sticky_still;
-bool hide_sticky;
-bool record_history;
-bool running;
-bool restart;
-bool randr;
-
 int main(int argc, char *argv[])
 {
 	fd_set descriptors;
 	char socket_path[MAXLEN];
 	char state_path[MAXLEN] = {0};
 	int run_level = 0;
+	uint64_t start_time = stats_clock();
+	uint64_t restart_time = 0;
 	config_path[0] = '\0';
+	commands_path[0] = '\0';
+	bool explicit_commands = false;
 	// socket file descriptor
 	int sock_fd = -1;
 	int cli_fd;
@@ -107,16 +81,15 @@ int main(int argc, char *argv[])
 	int max_fd, n;
 	struct sockaddr_un sock_address;
 	char msg[BUFSIZ] = {0};
-	xcb_generic_event_t *event;
 	char *end;
 	int opt;
 
 	// get commandline arguments
-	while ((opt = getopt(argc, argv, "hvc:s:o:")) != -1) {
+	while ((opt = getopt(argc, argv, "hvc:C:s:o:")) != -1) {
 		switch (opt) {
 			case 'h':
 				// print usage and exit
-				printf(WM_NAME " [-h|-v|-c CONFIG_PATH]\n");
+				printf(WM_NAME " [-h|-v|-c CONFIG_PATH|-C COMMANDS_PATH]\n");
 				exit(EXIT_SUCCESS);
 				break;
 			case 'v':
@@ -128,6 +101,11 @@ int main(int argc, char *argv[])
 				// set the config_path to the argument given with -c
 				snprintf(config_path, sizeof(config_path), "%s", optarg);
 				break;
+			case 'C':
+				// set the commands_path to the argument given with -C
+				snprintf(commands_path, sizeof(commands_path), "%s", optarg);
+				explicit_commands = true;
+				break;
 			case 's':
 				run_level |= 1;
 				// set the state_path to the argument given with -s
@@ -158,26 +136,63 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	// the commands file lives next to the config file
+	if (commands_path[0] == '\0') {
+		char *config_home = getenv(CONFIG_HOME_ENV);
+		if (config_home != NULL) {
+			snprintf(commands_path, sizeof(commands_path), "%s/%s/%s", config_home, WM_NAME, COMMANDS_NAME);
+		} else {
+			snprintf(commands_path, sizeof(commands_path), "%s/%s/%s/%s", getenv("HOME"), ".config", WM_NAME, COMMANDS_NAME);
+		}
+	}
+
 	// connect to the X server (displayname = NULL => use the DISPLAY envar)
 	// default screen will be set to 0
 	dpy = xcb_connect(NULL, &default_screen);
+	backend = &x_backend;
 
 	// if connection failed, exit
 	if (!check_connection(dpy)) {
 		exit(EXIT_FAILURE);
 	}
 
+	// name the state mirror after the display, unless BSPWM_MIRROR is set
+	char *mp = getenv(MIRROR_ENV_VAR);
+	if (mp != NULL) {
+		snprintf(mirror_name, MAXLEN, "%s", mp);
+	} else {
+		char *host = NULL;
+		int dn = 0, sn = 0;
+		if (xcb_parse_display(NULL, &host, &dn, &sn) != 0) {
+			snprintf(mirror_name, MAXLEN, MIRROR_NAME_TPL, host, dn, sn);
+		}
+		free(host);
+	}
+
 	// set the default settings
 	load_settings();
 	setup();
 
+	// run the commands file before any window is managed, the restored state takes precedence
+	if (explicit_commands || access(commands_path, F_OK) == 0) {
+		run_commands_file(commands_path);
+	}
+
 	// if state_path is not set
 	if (state_path[0] != '\0') {
+		// a state with a journal is a crash recovery snapshot: keep it until journaling resumes
+		bool recovering = has_journal(state_path);
 		restore_state(state_path);
-		unlink(state_path);
+		if (recovering) {
+			adopt_orphans();
+		} else {
+			unlink(state_path);
+		}
 	}
 
 	dpy_fd = xcb_get_file_descriptor(dpy);
+	// the children (the config, the external rules) don't inherit the display connection
+	fcntl(dpy_fd, F_SETFD, FD_CLOEXEC | fcntl(dpy_fd, F_GETFD));
 
 	// if socket does not yet exist
 	if (sock_fd == -1) {
@@ -238,10 +253,23 @@ int main(int argc, char *argv[])
 	signal(SIGTERM, sig_handler);
 	signal(SIGCHLD, sig_handler);
 	signal(SIGPIPE, SIG_IGN);
+	// the monotonic clock of the previous instance, when restarting
+	char *restart_clock = getenv(RESTART_CLOCK_ENV);
+	if (restart_clock != NULL) {
+		restart_time = strtoull(restart_clock, NULL, 10);
+		unsetenv(RESTART_CLOCK_ENV);
+	}
+
 	// execute bspwm's config file
 	run_config(run_level);
 	running = true;
 
+	stats_record_since(STAT_STARTUP, start_time);
+
+	if (restart_time > 0) {
+		stats_record_since(STAT_RESTART, restart_time);
+	}
+
 	while (running) {
 		// flush buffered output to the display server
 		xcb_flush(dpy);
@@ -263,14 +291,28 @@ int main(int argc, char *argv[])
 
 		// if any file descriptors in the descriptors set are ready to read
 		// first argument should be set to the highest-numbered fd + 1
-		if (select(max_fd + 1, &descriptors, NULL, NULL, NULL) > 0) {
+		// wake up when a throttled configure request can be handled, or a pending
+		// title event sent
+		struct timeval timeout, *tp = NULL;
+		int64_t delay = throttled_configure_delay();
+		int64_t title_delay = pending_title_delay();
+		if (title_delay >= 0 && (delay < 0 || title_delay < delay)) {
+			delay = title_delay;
+		}
+		if (delay >= 0) {
+			timeout.tv_sec = delay / 1000000;
+			timeout.tv_usec = delay % 1000000;
+			tp = &timeout;
+		}
+
+		if (select(max_fd + 1, &descriptors, NULL, NULL, tp) > 0) {
 			// enumerate all pending rules
 			pending_rule_t *pr = pending_rule_head;
 			while (pr != NULL) {
 				pending_rule_t *next = pr->next;
 				// if the pr's file descriptor is part of the descriptors fd_set
 				if (FD_ISSET(pr->fd, &descriptors)) {
-					if (manage_window(pr->win, pr->csq, pr->fd)) {
+					if (manage_window(pr->win, pr->csq, pr->fd, NULL)) {
 						for (event_queue_t *eq = pr->event_head; eq != NULL; eq = eq->next) {
 							handle_event(&eq->event);
 						}
@@ -299,23 +341,38 @@ int main(int argc, char *argv[])
 
 			// check if the display connection's fd is part of the descriptors fd_set
 			if (FD_ISSET(dpy_fd, &descriptors)) {
-				while ((event = xcb_poll_for_event(dpy)) != NULL) {
-					handle_event(event);
-					free(event);
-				}
+				handle_events();
 			}
 
 		}
 
+		flush_throttled_configures();
+		flush_pending_titles();
+
 		// if the connection fails, stop running
 		if (!check_connection(dpy)) {
 			running = false;
 		}
 
+		// send the state changes and the status report, once per iteration
+		flush_tree_delta();
+		flush_state_mirror();
+		flush_report();
 		prune_dead_subscribers();
+		// write the journal records accumulated during this iteration
+		journal_flush();
+		trace_flush();
 	}
 
+	journal_close();
+	trace_close();
+	mirror_close();
+	drain_snapshots();
+
 	if (restart) {
+		char restart_clock[SMALEN];
+		snprintf(restart_clock, sizeof(restart_clock), "%llu", (unsigned long long) stats_clock());
+		setenv(RESTART_CLOCK_ENV, restart_clock, 1);
 		char *host = NULL;
 		int dn = 0, sn = 0;
 		if (xcb_parse_display(NULL, &host, &dn, &sn) != 0) {
@@ -373,21 +430,6 @@ int main(int argc, char *argv[])
 	return exit_status;
 }
 
-void init(void)
-{
-	clients_count = 0;
-	mon = mon_head = mon_tail = pri_mon = NULL;
-	history_head = history_tail = history_needle = NULL;
-	rule_head = rule_tail = NULL;
-	stack_head = stack_tail = NULL;
-	subscribe_head = subscribe_tail = NULL;
-	pending_rule_head = pending_rule_tail = NULL;
-	auto_raise = sticky_still = hide_sticky = record_history = true;
-	randr_base = 0;
-	exit_status = 0;
-	restart = false;
-}
-
 void setup(void)
 {
 	init();
@@ -552,6 +594,8 @@ void cleanup(void)
 
 	// empty the history
 	empty_history();
+
+	empty_node_desc_cache();
 }
 
 bool check_connection (xcb_connection_t *dpy)
@@ -601,16 +645,3 @@ void sig_handler(int sig)
 		running = false;
 	}
 }
-
-/* Adapted from i3wm */
-uint32_t get_color_pixel(const char *color)
-{
-	unsigned int red, green, blue;
-	if (sscanf(color + 1, "%02x%02x%02x", &red, &green, &blue) == 3) {
-		/* We set the first 8 bits high to have 100% opacity in case of a 32 bit
-		 * color depth visual. */
-		return (0xFF << 24) | (red << 16 | green << 8 | blue);
-	} else {
-		return screen->black_pixel;
-	}
-}
@@ -29,13 +29,16 @@
 
 #define WM_NAME                  "bspwm"
 #define CONFIG_NAME              WM_NAME "rc"
+#define COMMANDS_NAME            WM_NAME "cmds"
 #define CONFIG_HOME_ENV          "XDG_CONFIG_HOME"
 #define RUNTIME_DIR_ENV          "XDG_RUNTIME_DIR"
+#define RESTART_CLOCK_ENV        "BSPWM_RESTART_CLOCK"
 
 #define STATE_PATH_TPL           "/tmp/bspwm%s_%i_%i-state"
 
 #define ROOT_EVENT_MASK     (XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_BUTTON_PRESS)
 #define CLIENT_EVENT_MASK   (XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_FOCUS_CHANGE)
+#define CONTAINER_EVENT_MASK (XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY)
 #define BSPWM_CLASS_NAME    "Bspwm"
 #define META_WINDOW_IC      "wm\0" BSPWM_CLASS_NAME
 #define ROOT_WINDOW_IC      "root\0" BSPWM_CLASS_NAME
@@ -43,6 +46,7 @@
 #define PRESEL_FEEDBACK_IC  PRESEL_FEEDBACK_I "\0" BSPWM_CLASS_NAME
 #define MOTION_RECORDER_I   "motion_recorder"
 #define MOTION_RECORDER_IC  MOTION_RECORDER_I "\0" BSPWM_CLASS_NAME
+#define CONTAINER_IC        "container\0" BSPWM_CLASS_NAME
 
 typedef struct {
 	xcb_window_t id;
@@ -56,6 +60,7 @@ extern uint32_t clients_count;
 extern xcb_screen_t *screen;
 extern xcb_window_t root;
 extern char config_path[MAXLEN];
+extern char commands_path[MAXLEN];
 
 extern monitor_t *mon;
 extern monitor_t *mon_head;
@@ -81,12 +86,15 @@ extern xcb_atom_t WM_DELETE_WINDOW;
 extern int exit_status;
 
 extern bool auto_raise;
-extern bool sticky_still;
 extern bool hide_sticky;
 extern bool record_history;
 extern bool running;
 extern bool restart;
 extern bool randr;
+extern uint8_t randr_base;
+extern bool grabbing;
+extern node_t *grabbed_node;
+extern uint32_t throttled_count;
 
 /**
  * @brief set variables to their initial values
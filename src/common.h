@@ -29,6 +29,10 @@
 #define SOCKET_PATH_TPL  "/tmp/bspwm%s_%i_%i-socket"
 // name of the environment variable to the socket
 #define SOCKET_ENV_VAR   "BSPWM_SOCKET"
+// name of the shared memory object holding the state mirror
+#define MIRROR_NAME_TPL  "/bspwm%s_%i_%i-mirror"
+// name of the environment variable to the state mirror
+#define MIRROR_ENV_VAR   "BSPWM_MIRROR"
 
 #define FAILURE_MESSAGE  "\x07"
 
@@ -0,0 +1,246 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "bspwm.h"
+#include "helpers.h"
+#include "query.h"
+#include "subscribe.h"
+#include "delta.h"
+
+typedef struct {
+	const char *type;
+	uint32_t id;
+} delta_removal_t;
+
+static bool pending;
+static bool primed;
+static uint64_t seq;
+static delta_record_t state_record;
+static delta_removal_t *removals;
+static int removals_len, removals_cap;
+
+/* The representations don't include the children: they're sent separately. */
+static query_projection_t flat = {NULL, NULL, 0, 0};
+
+static bool tree_delta_wanted(void)
+{
+	for (subscriber_list_t *sb = subscribe_head; sb != NULL; sb = sb->next) {
+		if (sb->field & SBSC_MASK_TREE_DELTA) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void forget_record(delta_record_t *r)
+{
+	free(r->text);
+	r->text = NULL;
+}
+
+static void forget_node(node_t *n)
+{
+	if (n == NULL) {
+		return;
+	}
+	forget_record(&n->delta);
+	forget_node(n->first_child);
+	forget_node(n->second_child);
+}
+
+static void forget_all(void)
+{
+	forget_record(&state_record);
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		forget_record(&m->delta);
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			forget_record(&d->delta);
+			forget_node(d->root);
+		}
+	}
+}
+
+/* Send the record if it differs from the last one sent for the same item. */
+static void update_record(delta_record_t *r, const char *type, char *record, size_t len, bool emit)
+{
+	/* A flushed memory stream has room for the null byte, but once rewound,
+	 * the byte after its position is a leftover of the previous record. */
+	record[len] = '\0';
+	uint32_t h = hash_string(record);
+	if (r->text != NULL && r->hash == h && strcmp(r->text, record) == 0) {
+		return;
+	}
+	free(r->text);
+	r->text = copy_string(record, len);
+	r->hash = h;
+	if (emit) {
+		seq++;
+		put_status(SBSC_MASK_TREE_DELTA, "tree_delta %" PRIu64 " {\"type\":\"%s\",%.*s}\n", seq, type, (int) len, record);
+	}
+}
+
+static void update_node(desktop_t *d, node_t *n, FILE *buf, char **record, bool emit)
+{
+	if (n == NULL) {
+		return;
+	}
+	rewind(buf);
+	fprintf(buf, "\"desktopId\":%u,\"parentId\":%u,\"firstChildId\":%u,\"secondChildId\":%u,\"node\":",
+	        d->id, n->parent != NULL ? n->parent->id : 0,
+	        n->first_child != NULL ? n->first_child->id : 0,
+	        n->second_child != NULL ? n->second_child->id : 0);
+	query_node_fields(n, &flat, 0, buf);
+	fflush(buf);
+	update_record(&n->delta, "node", *record, ftell(buf), emit);
+	update_node(d, n->first_child, buf, record, emit);
+	update_node(d, n->second_child, buf, record, emit);
+}
+
+/* Only the monitors and desktops that changed since the last call, or that
+ * were never sent, are serialized again, unless `emit` is false: the records
+ * are then gathered for every item, to prime the comparisons. */
+static void update_all(bool emit)
+{
+	char *record = NULL;
+	size_t len = 0;
+	FILE *buf = open_memstream(&record, &len);
+
+	if (buf == NULL) {
+		return;
+	}
+
+	fprintf(buf, "\"focusedMonitorId\":%u,\"primaryMonitorId\":%u,\"monitorIds\":[", mon != NULL ? mon->id : 0, pri_mon != NULL ? pri_mon->id : 0);
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		fprintf(buf, "%u%s", m->id, m->next != NULL ? "," : "");
+	}
+	fprintf(buf, "]");
+	fflush(buf);
+	update_record(&state_record, "state", record, ftell(buf), emit);
+
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		if (m->delta_dirty || m->delta.text == NULL || !emit) {
+			m->delta_dirty = false;
+			rewind(buf);
+			fprintf(buf, "\"desktopIds\":[");
+			for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+				fprintf(buf, "%u%s", d->id, d->next != NULL ? "," : "");
+			}
+			fprintf(buf, "],\"monitor\":");
+			query_monitor_fields(m, &flat, 0, buf);
+			fflush(buf);
+			update_record(&m->delta, "monitor", record, ftell(buf), emit);
+		}
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			if (!d->delta_dirty && d->delta.text != NULL && emit) {
+				continue;
+			}
+			d->delta_dirty = false;
+			rewind(buf);
+			fprintf(buf, "\"monitorId\":%u,\"rootId\":%u,\"desktop\":", m->id, d->root != NULL ? d->root->id : 0);
+			query_desktop_fields(d, &flat, 0, buf);
+			fflush(buf);
+			update_record(&d->delta, "desktop", record, ftell(buf), emit);
+			update_node(d, d->root, buf, &record, emit);
+		}
+	}
+
+	fclose(buf);
+	free(record);
+}
+
+void touch_tree_delta(coordinates_t *loc)
+{
+	pending = true;
+	if (loc == NULL) {
+		return;
+	}
+	if (loc->monitor != NULL) {
+		loc->monitor->delta_dirty = true;
+	}
+	if (loc->desktop != NULL) {
+		loc->desktop->delta_dirty = true;
+	}
+}
+
+void tree_delta_removed(const char *type, uint32_t id, delta_record_t *record)
+{
+	forget_record(record);
+	if (!primed) {
+		return;
+	}
+	if (removals_len == removals_cap) {
+		int cap = (removals_cap == 0 ? 8 : 2 * removals_cap);
+		delta_removal_t *r = realloc(removals, cap * sizeof(delta_removal_t));
+		if (r == NULL) {
+			return;
+		}
+		removals = r;
+		removals_cap = cap;
+	}
+	removals[removals_len++] = (delta_removal_t) {type, id};
+}
+
+void flush_tree_delta(void)
+{
+	if (!pending && removals_len == 0) {
+		return;
+	}
+
+	pending = false;
+
+	if (!tree_delta_wanted()) {
+		if (primed) {
+			forget_all();
+		}
+		primed = false;
+		removals_len = 0;
+		return;
+	}
+
+	/* Removals come first: the IDs of the windows can be reused. */
+	for (int i = 0; i < removals_len; i++) {
+		seq++;
+		put_status(SBSC_MASK_TREE_DELTA, "tree_delta %" PRIu64 " {\"type\":\"%s_remove\",\"id\":%u}\n", seq, removals[i].type, removals[i].id);
+	}
+	removals_len = 0;
+
+	update_all(primed);
+	primed = true;
+}
+
+void print_tree_snapshot(FILE *stream)
+{
+	if (!primed) {
+		update_all(false);
+		primed = true;
+	}
+	fprintf(stream, "tree_delta %" PRIu64 " {\"type\":\"snapshot\",\"state\":", seq);
+	query_state(stream);
+	fprintf(stream, "}\n");
+	fflush(stream);
+}
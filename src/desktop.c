@@ -25,16 +25,23 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <xcb/shape.h>
 #include "bspwm.h"
+#include "backend.h"
 #include "ewmh.h"
 #include "history.h"
 #include "monitor.h"
+#include "parse.h"
 #include "query.h"
 #include "tree.h"
 #include "window.h"
+#include "registry.h"
 #include "desktop.h"
 #include "subscribe.h"
 #include "settings.h"
+#include "stack.h"
+#include "stats.h"
+#include "delta.h"
 
 bool activate_desktop(monitor_t *m, desktop_t *d)
 {
@@ -57,9 +64,10 @@ bool activate_desktop(monitor_t *m, desktop_t *d)
 	}
 
 	if (m->sticky_count > 0 && m->desk != NULL) {
-		transfer_sticky_nodes(m, m->desk, m, d, m->desk->root);
+		transfer_sticky_nodes(m, m->desk, m, d);
 	}
 
+	stats_begin(d->container != XCB_NONE ? STAT_DESKTOP_SWITCH_CONTAINERS : STAT_DESKTOP_SWITCH_WINDOWS);
 	show_desktop(d);
 	hide_desktop(m->desk);
 
@@ -67,7 +75,7 @@ bool activate_desktop(monitor_t *m, desktop_t *d)
 
 	history_add(m, d, NULL, false);
 
-	put_status(SBSC_MASK_DESKTOP_ACTIVATE, "desktop_activate 0x%08X 0x%08X\n", m->id, d->id);
+	put_status_in(SBSC_MASK_DESKTOP_ACTIVATE, &(coordinates_t) {m, d, NULL}, NULL, "desktop_activate 0x%08X 0x%08X\n", m->id, d->id);
 	put_status(SBSC_MASK_REPORT);
 
 	return true;
@@ -144,7 +152,7 @@ bool set_layout(monitor_t *m, desktop_t *d, layout_t l, bool user)
 			arrange(m, d);
 		}
 
-		put_status(SBSC_MASK_DESKTOP_LAYOUT, "desktop_layout 0x%08X 0x%08X %s\n", m->id, d->id, LAYOUT_STR(d->layout));
+		put_status_in(SBSC_MASK_DESKTOP_LAYOUT, &(coordinates_t) {m, d, NULL}, NULL, "desktop_layout 0x%08X 0x%08X %s\n", m->id, d->id, layout_str(d->layout));
 
 		if (d == m->desk) {
 			put_status(SBSC_MASK_REPORT);
@@ -156,7 +164,7 @@ bool set_layout(monitor_t *m, desktop_t *d, layout_t l, bool user)
 
 void handle_presel_feedbacks(monitor_t *m, desktop_t *d)
 {
-	if (m->desk != d) {
+	if (m->desk != d && d->container == XCB_NONE) {
 		return;
 	}
 	if (d->layout == LAYOUT_MONOCLE) {
@@ -177,7 +185,9 @@ bool transfer_desktop(monitor_t *ms, monitor_t *md, desktop_t *d, bool follow)
 	unsigned int sc = (ms->sticky_count > 0 && d_was_active) ? sticky_count(d->root) : 0;
 
 	unlink_desktop(ms, d);
-	ms->sticky_count -= sc;
+	if (sc > 0) {
+		unregister_stickies(ms, d->root);
+	}
 
 	if ((!follow || !d_was_active || !ms_was_focused) && md->desk != NULL) {
 		hide_sticky = false;
@@ -186,7 +196,9 @@ bool transfer_desktop(monitor_t *ms, monitor_t *md, desktop_t *d, bool follow)
 	}
 
 	insert_desktop(md, d);
-	md->sticky_count += sc;
+	if (sc > 0) {
+		register_stickies(md, d->root);
+	}
 	history_remove(d, NULL, false);
 
 	if (d_was_active) {
@@ -208,9 +220,9 @@ bool transfer_desktop(monitor_t *ms, monitor_t *md, desktop_t *d, bool follow)
 
 	if (sc > 0) {
 		if (ms->desk != NULL) {
-			transfer_sticky_nodes(md, d, ms, ms->desk, d->root);
+			transfer_sticky_nodes(md, d, ms, ms->desk);
 		} else if (d != md->desk) {
-			transfer_sticky_nodes(md, d, md, md->desk, d->root);
+			transfer_sticky_nodes(md, d, md, md->desk);
 		}
 	}
 
@@ -230,7 +242,7 @@ bool transfer_desktop(monitor_t *ms, monitor_t *md, desktop_t *d, bool follow)
 	ewmh_update_desktop_viewport();
 	ewmh_update_current_desktop();
 
-	put_status(SBSC_MASK_DESKTOP_TRANSFER, "desktop_transfer 0x%08X 0x%08X 0x%08X\n", ms->id, d->id, md->id);
+	put_status_in(SBSC_MASK_DESKTOP_TRANSFER, &(coordinates_t) {ms, d, NULL}, &(coordinates_t) {md, d, NULL}, "desktop_transfer 0x%08X 0x%08X 0x%08X\n", ms->id, d->id, md->id);
 	put_status(SBSC_MASK_REPORT);
 
 	return true;
@@ -240,9 +252,7 @@ desktop_t *make_desktop(const char *name, uint32_t id)
 {
 	desktop_t *d = calloc(1, sizeof(desktop_t));
 	snprintf(d->name, sizeof(d->name), "%s", name == NULL ? DEFAULT_DESK_NAME : name);
-	if (id == XCB_NONE) {
-		d->id = xcb_generate_id(dpy);
-	}
+	d->id = (id == XCB_NONE ? backend->generate_id() : id);
 	d->prev = d->next = NULL;
 	d->root = d->focus = NULL;
 	d->user_layout = LAYOUT_TILED;
@@ -256,9 +266,11 @@ desktop_t *make_desktop(const char *name, uint32_t id)
 void rename_desktop(monitor_t *m, desktop_t *d, const char *name)
 {
 
-	put_status(SBSC_MASK_DESKTOP_RENAME, "desktop_rename 0x%08X 0x%08X %s %s\n", m->id, d->id, d->name, name);
+	put_status_in(SBSC_MASK_DESKTOP_RENAME, &(coordinates_t) {m, d, NULL}, NULL, "desktop_rename 0x%08X 0x%08X %s %s\n", m->id, d->id, d->name, name);
 
+	unregister_desktop(d);
 	snprintf(d->name, sizeof(d->name), "%s", name);
+	register_desktop(d);
 
 	put_status(SBSC_MASK_REPORT);
 	ewmh_update_desktop_names();
@@ -275,15 +287,24 @@ void insert_desktop(monitor_t *m, desktop_t *d)
 		d->prev = m->desk_tail;
 		m->desk_tail = d;
 	}
+	invalidate_desktop_order();
+	if (d->container != XCB_NONE) {
+		reshape_container(m, d);
+	}
 }
 
 void add_desktop(monitor_t *m, desktop_t *d)
 {
-	put_status(SBSC_MASK_DESKTOP_ADD, "desktop_add 0x%08X 0x%08X %s\n", m->id, d->id, d->name);
+	put_status_in(SBSC_MASK_DESKTOP_ADD, &(coordinates_t) {m, d, NULL}, NULL, "desktop_add 0x%08X 0x%08X %s\n", m->id, d->id, d->name);
 
 	d->border_width = m->border_width;
 	d->window_gap = m->window_gap;
 	insert_desktop(m, d);
+	register_desktop(d);
+	/* The containers of restored desktops are made once the stacking list is known. */
+	if (desktop_containers && d->root == NULL) {
+		make_container(m, d);
+	}
 	ewmh_update_current_desktop();
 	ewmh_update_number_of_desktops();
 	ewmh_update_desktop_names();
@@ -298,13 +319,10 @@ desktop_t *find_desktop_in(uint32_t id, monitor_t *m)
 		return NULL;
 	}
 
-	for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-		if (d->id == id) {
-			return d;
-		}
-	}
+	monitor_t *owner = NULL;
+	desktop_t *d = registered_desktop(id, &owner);
 
-	return NULL;
+	return owner == m ? d : NULL;
 }
 
 void unlink_desktop(monitor_t *m, desktop_t *d)
@@ -333,15 +351,21 @@ void unlink_desktop(monitor_t *m, desktop_t *d)
 	}
 
 	d->prev = d->next = NULL;
+	invalidate_desktop_order();
 }
 
 void remove_desktop(monitor_t *m, desktop_t *d)
 {
-	put_status(SBSC_MASK_DESKTOP_REMOVE, "desktop_remove 0x%08X 0x%08X\n", m->id, d->id);
+	put_status_in(SBSC_MASK_DESKTOP_REMOVE, &(coordinates_t) {m, d, NULL}, NULL, "desktop_remove 0x%08X 0x%08X\n", m->id, d->id);
 
 	remove_node(m, d, d->root);
+	if (d->container != XCB_NONE) {
+		remove_container(m, d);
+	}
 	unlink_desktop(m, d);
+	unregister_desktop(d);
 	history_remove(d, NULL, false);
+	tree_delta_removed("desktop", d->id, &d->delta);
 	free(d);
 
 	ewmh_update_current_desktop();
@@ -378,7 +402,7 @@ bool swap_desktops(monitor_t *m1, desktop_t *d1, monitor_t *m2, desktop_t *d2, b
 		return false;
 	}
 
-	put_status(SBSC_MASK_DESKTOP_SWAP, "desktop_swap 0x%08X 0x%08X 0x%08X 0x%08X\n", m1->id, d1->id, m2->id, d2->id);
+	put_status_in(SBSC_MASK_DESKTOP_SWAP, &(coordinates_t) {m1, d1, NULL}, &(coordinates_t) {m2, d2, NULL}, "desktop_swap 0x%08X 0x%08X 0x%08X 0x%08X\n", m1->id, d1->id, m2->id, d2->id);
 
 	bool d1_was_active = (m1->desk == d1);
 	bool d2_was_active = (m2->desk == d2);
@@ -390,13 +414,13 @@ bool swap_desktops(monitor_t *m1, desktop_t *d1, monitor_t *m2, desktop_t *d2, b
 	if (m1->sticky_count > 0 && d1 == m1->desk && sticky_count(d1->root) > 0) {
 		d1_stickies = make_desktop(NULL, XCB_NONE);
 		insert_desktop(m1, d1_stickies);
-		transfer_sticky_nodes(m1, d1, m1, d1_stickies, d1->root);
+		transfer_sticky_nodes(m1, d1, m1, d1_stickies);
 	}
 
 	if (m2->sticky_count > 0 && d2 == m2->desk && sticky_count(d2->root) > 0) {
 		d2_stickies = make_desktop(NULL, XCB_NONE);
 		insert_desktop(m2, d2_stickies);
-		transfer_sticky_nodes(m2, d2, m2, d2_stickies, d2->root);
+		transfer_sticky_nodes(m2, d2, m2, d2_stickies);
 	}
 
 	if (m1 != m2) {
@@ -458,8 +482,15 @@ bool swap_desktops(monitor_t *m1, desktop_t *d1, monitor_t *m2, desktop_t *d2, b
 	d1->next = n2 == d1 ? d2 : n2;
 	d2->prev = p1 == d2 ? d1 : p1;
 	d2->next = n1 == d2 ? d1 : n1;
+	invalidate_desktop_order();
 
 	if (m1 != m2) {
+		if (d1->container != XCB_NONE) {
+			reshape_container(m2, d1);
+		}
+		if (d2->container != XCB_NONE) {
+			reshape_container(m1, d2);
+		}
 		adapt_geometry(&m1->rectangle, &m2->rectangle, d1->root);
 		adapt_geometry(&m2->rectangle, &m1->rectangle, d2->root);
 		history_remove(d1, NULL, false);
@@ -469,13 +500,13 @@ bool swap_desktops(monitor_t *m1, desktop_t *d1, monitor_t *m2, desktop_t *d2, b
 	}
 
 	if (d1_stickies != NULL) {
-		transfer_sticky_nodes(m1, d1_stickies, m1, d2, d1_stickies->root);
+		transfer_sticky_nodes(m1, d1_stickies, m1, d2);
 		unlink_desktop(m1, d1_stickies);
 		free(d1_stickies);
 	}
 
 	if (d2_stickies != NULL) {
-		transfer_sticky_nodes(m2, d2_stickies, m2, d1, d2_stickies->root);
+		transfer_sticky_nodes(m2, d2_stickies, m2, d1);
 		unlink_desktop(m2, d2_stickies);
 		free(d2_stickies);
 	}
@@ -534,19 +565,208 @@ void show_desktop(desktop_t *d)
 		return;
 	}
 	show_node(d, d->root);
+	if (d->container != XCB_NONE) {
+		container_set_visibility(d, true);
+	}
 }
 
 void hide_desktop(desktop_t *d)
 {
-	if (d == NULL) {
+	if (d != NULL) {
+		hide_node(d, d->root);
+		if (d->container != XCB_NONE) {
+			container_set_visibility(d, false);
+		}
+	}
+	/* A desktop switch shows the new desktop first and ends here. */
+	if (stats_pending()) {
+		backend->flush();
+		stats_end();
+	}
+}
+
+xcb_window_t desktop_parent(desktop_t *d)
+{
+	return (d != NULL && d->container != XCB_NONE) ? d->container : root;
+}
+
+uint32_t container_event_mask(void)
+{
+	return CONTAINER_EVENT_MASK | (focus_follows_pointer ? XCB_EVENT_MASK_ENTER_WINDOW : 0);
+}
+
+void make_container(monitor_t *m, desktop_t *d)
+{
+	if (d->container != XCB_NONE) {
+		return;
+	}
+
+	d->container = backend->generate_id();
+	uint32_t mask = XCB_CW_BACK_PIXMAP | XCB_CW_EVENT_MASK;
+	uint32_t values[] = {XCB_BACK_PIXMAP_PARENT_RELATIVE, container_event_mask()};
+	backend->create_window(d->container, root, (xcb_rectangle_t) {0, 0, screen_width, screen_height},
+	                       XCB_WINDOW_CLASS_INPUT_OUTPUT, mask, values);
+	set_wm_class(d->container, sizeof(CONTAINER_IC), CONTAINER_IC);
+	reshape_container(m, d);
+
+	if (m->root != XCB_NONE) {
+		window_above(d->container, m->root);
+	} else {
+		window_lower(d->container);
+	}
+
+	if (m->desk == d) {
+		container_set_visibility(d, true);
+	}
+
+	if (d->root == NULL) {
 		return;
 	}
-	hide_node(d, d->root);
+
+	/* Adopt the existing windows, preserving their relative stacking order:
+	 * each reparented window lands on top of its new siblings. */
+	int len = 0;
+	for (stacking_list_t *s = stack_head; s != NULL; s = s->next) {
+		len++;
+	}
+	xcb_window_t *wins = malloc(len * sizeof(xcb_window_t));
+	if (wins != NULL) {
+		len = 0;
+		for (stacking_list_t *s = stack_head; s != NULL; s = s->next) {
+			if (is_descendant(s->node, d->root)) {
+				wins[len++] = s->node->id;
+			}
+		}
+		reparent_windows(wins, len, root, d->container);
+		free(wins);
+	}
+	reparent_presel_feedbacks(d->root, root, d->container);
+
+	if (m->desk != d) {
+		show_container_windows(d, d->root);
+	}
+
+	restack_presel_feedbacks(d);
+}
+
+void reshape_container(monitor_t *m, desktop_t *d)
+{
+	xcb_rectangle_t rect = m->rectangle;
+	window_resize(d->container, screen_width, screen_height);
+	backend->shape_rectangles(XCB_SHAPE_SK_BOUNDING, d->container, 1, &rect);
+}
+
+void remove_container(monitor_t *m, desktop_t *d)
+{
+	if (d->container == XCB_NONE) {
+		return;
+	}
+
+	uint32_t values[] = {XCB_EVENT_MASK_NO_EVENT};
+	backend->change_attributes(d->container, XCB_CW_EVENT_MASK, values);
+
+	xcb_window_t *wins;
+	int len;
+	if (backend->query_tree(d->container, &wins, &len)) {
+		/* The children of a hidden container are still mapped. */
+		if (m->desk != d) {
+			for (int i = 0; i < len; i++) {
+				backend->unmap_window(wins[i]);
+				set_window_state(wins[i], XCB_ICCCM_WM_STATE_ICONIC);
+			}
+		}
+		reparent_windows(wins, len, d->container, root);
+		free(wins);
+	}
+	invalidate_presel_feedbacks(d->root);
+
+	backend->destroy_window(d->container);
+	d->container = XCB_NONE;
+}
+
+void container_set_visibility(desktop_t *d, bool visible)
+{
+	uint32_t values_off[] = {ROOT_EVENT_MASK & ~XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY};
+	uint32_t values_on[] = {ROOT_EVENT_MASK};
+	backend->change_attributes(root, XCB_CW_EVENT_MASK, values_off);
+	if (visible) {
+		backend->map_window(d->container);
+	} else {
+		backend->unmap_window(d->container);
+	}
+	backend->change_attributes(root, XCB_CW_EVENT_MASK, values_on);
+}
+
+void reparent_presel_feedbacks(node_t *n, xcb_window_t from, xcb_window_t to)
+{
+	if (n == NULL) {
+		return;
+	}
+	if (n->presel != NULL && n->presel->feedback != XCB_NONE) {
+		reparent_windows(&n->presel->feedback, 1, from, to);
+		n->presel->feedback_anchor = n->presel->feedback_anchor_next = XCB_NONE;
+	}
+	reparent_presel_feedbacks(n->first_child, from, to);
+	reparent_presel_feedbacks(n->second_child, from, to);
+}
+
+void show_container_windows(desktop_t *d, node_t *n)
+{
+	if (n == NULL) {
+		return;
+	}
+	if (!n->hidden) {
+		if (n->client != NULL) {
+			window_show_in(d->container, n->id);
+		}
+		if (n->presel != NULL && d->layout != LAYOUT_MONOCLE) {
+			window_show_in(d->container, n->presel->feedback);
+		}
+	}
+	show_container_windows(d, n->first_child);
+	show_container_windows(d, n->second_child);
+}
+
+void refresh_container(monitor_t *m, desktop_t *d)
+{
+	uint32_t values[] = {container_event_mask()};
+	backend->change_attributes(d->container, XCB_CW_EVENT_MASK, values);
+	container_set_visibility(d, m->desk == d);
+}
+
+void update_desktop_containers(void)
+{
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			if (desktop_containers) {
+				if (d->container == XCB_NONE) {
+					make_container(m, d);
+				} else {
+					refresh_container(m, d);
+				}
+			} else if (d->container != XCB_NONE) {
+				remove_container(m, d);
+			}
+		}
+	}
+
+	if (!desktop_containers) {
+		/* Every window is a child of the root window again. */
+		for (stacking_list_t *s = stack_head; s != NULL && s->next != NULL; s = s->next) {
+			window_above(s->next->node->id, s->node->id);
+		}
+		for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+			for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+				invalidate_presel_feedbacks(d->root);
+				restack_presel_feedbacks(d);
+			}
+		}
+	}
 }
 
 bool is_urgent(desktop_t *d)
 {
-	for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+	for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 		if (n->client == NULL) {
 			continue;
 		}
@@ -192,4 +192,74 @@ void hide_desktop(desktop_t *d);
  */
 bool is_urgent(desktop_t *d);
 
+/**
+ * @brief Return the parent of the windows of the given desktop
+ *
+ * @param d the desktop
+ * @return xcb_window_t - the desktop's container, or the root window
+ */
+xcb_window_t desktop_parent(desktop_t *d);
+
+/**
+ * @brief Return the event mask of the desktop containers
+ *
+ * @return uint32_t - the event mask
+ */
+uint32_t container_event_mask(void);
+
+/**
+ * @brief Create the container of the given desktop and move its windows into it
+ *
+ * @param m the monitor
+ * @param d the desktop
+ */
+void make_container(monitor_t *m, desktop_t *d);
+
+/**
+ * @brief Restrict the container of the given desktop to the area of its monitor
+ *
+ * @param m the monitor
+ * @param d the desktop
+ */
+void reshape_container(monitor_t *m, desktop_t *d);
+
+/**
+ * @brief Move the windows of the given desktop back to the root window and destroy its container
+ *
+ * @param m the monitor
+ * @param d the desktop
+ */
+void remove_container(monitor_t *m, desktop_t *d);
+
+/**
+ * @brief Map or unmap the container of the given desktop
+ *
+ * @param d the desktop
+ * @param visible true: map the container, else unmap it
+ */
+void container_set_visibility(desktop_t *d, bool visible);
+void reparent_presel_feedbacks(node_t *n, xcb_window_t from, xcb_window_t to);
+
+/**
+ * @brief Map the windows of a hidden desktop inside its container
+ *
+ * @param d the desktop
+ * @param n the root of the subtree to map
+ */
+void show_container_windows(desktop_t *d, node_t *n);
+
+/**
+ * @brief Update the event mask and the visibility of the container of the given desktop
+ *
+ * @param m the monitor
+ * @param d the desktop
+ */
+void refresh_container(monitor_t *m, desktop_t *d);
+
+/**
+ * @brief Create or remove the desktop containers according to the desktop_containers setting
+ *
+ */
+void update_desktop_containers(void);
+
 #endif
@@ -33,12 +33,28 @@
 #include "window.h"
 #include "pointer.h"
 #include "rule.h"
+#include "stats.h"
+#include "trace.h"
+#include "manage.h"
 #include "events.h"
 
-uint8_t randr_base;
+/* The events drained from the connection before being handled, and for each
+ * of them, the index of the next event about the same window, or -1. */
+static xcb_generic_event_t **batch = NULL;
+static int *batch_next = NULL;
+static int batch_cap = 0;
+
+/* Open addressing table from the windows to the index of their next event. */
+typedef struct {
+	xcb_window_t win;
+	int index;
+} window_slot_t;
+static window_slot_t *slots = NULL;
+static int slots_cap = 0;
 
 void handle_event(xcb_generic_event_t *evt)
 {
+	uint64_t start = trace_clock();
 	uint8_t resp_type = XCB_EVENT_RESPONSE_TYPE(evt);
 	switch (resp_type) {
 		case XCB_MAP_REQUEST:
@@ -86,13 +102,316 @@ void handle_event(xcb_generic_event_t *evt)
 			}
 			break;
 	}
+	trace_event(evt, start);
+}
+
+void handle_events(void)
+{
+	while (true) {
+		int len = 0;
+		xcb_generic_event_t *evt, *overflow = NULL;
+		while ((evt = xcb_poll_for_event(dpy)) != NULL) {
+			if (len >= batch_cap) {
+				int cap = (batch_cap > 0 ? 2 * batch_cap : INIT_CAP);
+				xcb_generic_event_t **new = realloc(batch, cap * sizeof(xcb_generic_event_t *));
+				if (new != NULL) {
+					batch = new;
+				}
+				int *new_next = realloc(batch_next, cap * sizeof(int));
+				if (new_next != NULL) {
+					batch_next = new_next;
+				}
+				if (new == NULL || new_next == NULL) {
+					/* Handled after the events already read. */
+					overflow = evt;
+					break;
+				}
+				batch_cap = cap;
+			}
+			batch[len++] = evt;
+			/* The pointer tracking started by a button press reads the
+			 * events that follow it from the connection. */
+			if (XCB_EVENT_RESPONSE_TYPE(evt) == XCB_BUTTON_PRESS) {
+				break;
+			}
+		}
+
+		if (len == 0 && overflow == NULL) {
+			return;
+		}
+
+		if (len > 0 && index_batch(batch, batch_next, len)) {
+			cancel_destroyed_admissions(batch, batch_next, len);
+			collapse_property_notifies(batch, batch_next, len);
+			coalesce_configure_requests(batch, batch_next, len);
+		}
+
+		for (int i = 0; i < len; i++) {
+			if (batch[i] != NULL) {
+				handle_event(batch[i]);
+				free(batch[i]);
+			}
+		}
+
+		if (overflow != NULL) {
+			handle_event(overflow);
+			free(overflow);
+		}
+	}
+}
+
+/* Returns the window an event is about, for the events whose relative order
+ * matters for a given window. */
+xcb_window_t event_window(xcb_generic_event_t *evt)
+{
+	switch (XCB_EVENT_RESPONSE_TYPE(evt)) {
+		case XCB_CONFIGURE_REQUEST:
+			return ((xcb_configure_request_event_t *) evt)->window;
+		case XCB_MAP_REQUEST:
+			return ((xcb_map_request_event_t *) evt)->window;
+		case XCB_DESTROY_NOTIFY:
+			return ((xcb_destroy_notify_event_t *) evt)->window;
+		case XCB_UNMAP_NOTIFY:
+			return ((xcb_unmap_notify_event_t *) evt)->window;
+		case XCB_CLIENT_MESSAGE:
+			return ((xcb_client_message_event_t *) evt)->window;
+		case XCB_PROPERTY_NOTIFY:
+			return ((xcb_property_notify_event_t *) evt)->window;
+		default:
+			return XCB_NONE;
+	}
+}
+
+/* Fills `next` by walking the batch backwards, and returns false if the table
+ * of the windows couldn't be allocated. */
+bool index_batch(xcb_generic_event_t **batch, int *next, int len)
+{
+	int cap = 2 * INIT_CAP;
+	while (cap < 2 * len) {
+		cap *= 2;
+	}
+	if (cap > slots_cap) {
+		window_slot_t *new = realloc(slots, cap * sizeof(window_slot_t));
+		if (new == NULL) {
+			return false;
+		}
+		slots = new;
+		slots_cap = cap;
+	}
+	for (int i = 0; i < cap; i++) {
+		slots[i].win = XCB_NONE;
+	}
+
+	for (int i = len - 1; i >= 0; i--) {
+		next[i] = -1;
+		xcb_window_t win = event_window(batch[i]);
+		if (win == XCB_NONE) {
+			continue;
+		}
+		unsigned int h = (win * 2654435761u) & (cap - 1);
+		while (slots[h].win != XCB_NONE && slots[h].win != win) {
+			h = (h + 1) & (cap - 1);
+		}
+		if (slots[h].win == win) {
+			next[i] = slots[h].index;
+		}
+		slots[h].win = win;
+		slots[h].index = i;
+	}
+
+	return true;
+}
+
+/* Returns the next event that wasn't dropped about the same window as the
+ * `i`-th event, or -1. */
+int next_window_event(xcb_generic_event_t **batch, int *next, int i)
+{
+	int j = next[i];
+	while (j != -1 && batch[j] == NULL) {
+		j = next[j];
+	}
+	return j;
+}
+
+/* A window that is destroyed later in the same batch won't be managed. */
+void cancel_destroyed_admissions(xcb_generic_event_t **batch, int *next, int len)
+{
+	for (int i = 0; i < len; i++) {
+		if (batch[i] == NULL || XCB_EVENT_RESPONSE_TYPE(batch[i]) != XCB_MAP_REQUEST) {
+			continue;
+		}
+		for (int j = next_window_event(batch, next, i); j != -1; j = next_window_event(batch, next, j)) {
+			if (XCB_EVENT_RESPONSE_TYPE(batch[j]) == XCB_DESTROY_NOTIFY) {
+				free(batch[i]);
+				batch[i] = NULL;
+				stats_record(STAT_MAP_REQUESTS_CANCELED, 0);
+				break;
+			}
+		}
+	}
+}
+
+/* Drops each property notification that is followed by a notification for
+ * the same window and property, unless another event about that window, that
+ * isn't a property notification, comes in between. */
+void collapse_property_notifies(xcb_generic_event_t **batch, int *next, int len)
+{
+	for (int i = 0; i < len; i++) {
+		if (batch[i] == NULL || XCB_EVENT_RESPONSE_TYPE(batch[i]) != XCB_PROPERTY_NOTIFY) {
+			continue;
+		}
+		xcb_atom_t atom = ((xcb_property_notify_event_t *) batch[i])->atom;
+		for (int j = next_window_event(batch, next, i); j != -1 && XCB_EVENT_RESPONSE_TYPE(batch[j]) == XCB_PROPERTY_NOTIFY; j = next_window_event(batch, next, j)) {
+			if (((xcb_property_notify_event_t *) batch[j])->atom == atom) {
+				free(batch[i]);
+				batch[i] = NULL;
+				stats_record(STAT_PROPERTY_NOTIFIES_COLLAPSED, 0);
+				break;
+			}
+		}
+	}
+}
+
+/* Merges each configure request into the next configure request of the same
+ * window, unless another event about that window comes in between. */
+void coalesce_configure_requests(xcb_generic_event_t **batch, int *next, int len)
+{
+	for (int i = 0; i < len; i++) {
+		if (batch[i] == NULL || XCB_EVENT_RESPONSE_TYPE(batch[i]) != XCB_CONFIGURE_REQUEST) {
+			continue;
+		}
+		int j = next_window_event(batch, next, i);
+		if (j != -1 && XCB_EVENT_RESPONSE_TYPE(batch[j]) == XCB_CONFIGURE_REQUEST) {
+			merge_configure_request((xcb_configure_request_event_t *) batch[j], (xcb_configure_request_event_t *) batch[i]);
+			free(batch[i]);
+			batch[i] = NULL;
+			stats_record(STAT_CONFIGURE_COALESCED, 0);
+		}
+	}
+}
+
+/* Adds the values of `src` that `dst`, the most recent request, doesn't set. */
+void merge_configure_request(xcb_configure_request_event_t *dst, xcb_configure_request_event_t *src)
+{
+#define MERGE_VALUE(f, v) \
+	if ((src->value_mask & f) && !(dst->value_mask & f)) { \
+		dst->v = src->v; \
+		dst->value_mask |= f; \
+	}
+	MERGE_VALUE(XCB_CONFIG_WINDOW_X, x)
+	MERGE_VALUE(XCB_CONFIG_WINDOW_Y, y)
+	MERGE_VALUE(XCB_CONFIG_WINDOW_WIDTH, width)
+	MERGE_VALUE(XCB_CONFIG_WINDOW_HEIGHT, height)
+	MERGE_VALUE(XCB_CONFIG_WINDOW_BORDER_WIDTH, border_width)
+	MERGE_VALUE(XCB_CONFIG_WINDOW_SIBLING, sibling)
+	MERGE_VALUE(XCB_CONFIG_WINDOW_STACK_MODE, stack_mode)
+#undef MERGE_VALUE
+}
+
+/* Returns whether the request can be handled now. Otherwise, it is kept,
+ * merged with the previous throttled request of the client, until the bucket
+ * of the client holds a token again. */
+bool admit_configure_request(client_t *c, xcb_configure_request_event_t *e)
+{
+	refill_configure_tokens(c);
+
+	if (c->configure_tokens < 1) {
+		if (c->throttled_configure == NULL) {
+			c->throttled_configure = malloc(sizeof(xcb_configure_request_event_t));
+			if (c->throttled_configure == NULL) {
+				return true;
+			}
+			throttled_count++;
+		} else {
+			merge_configure_request(e, c->throttled_configure);
+		}
+		*c->throttled_configure = *e;
+		stats_record(STAT_CONFIGURE_THROTTLED, 0);
+		return false;
+	}
+
+	c->configure_tokens -= 1;
+
+	if (c->throttled_configure != NULL) {
+		merge_configure_request(e, c->throttled_configure);
+		discard_throttled_configure(c);
+	}
+
+	return true;
+}
+
+void refill_configure_tokens(client_t *c)
+{
+	uint64_t now = stats_clock();
+	double tokens = c->configure_tokens + (double) (now - c->configure_stamp) * CONFIGURE_REQUEST_RATE / 1e6;
+	c->configure_tokens = MIN(tokens, CONFIGURE_REQUEST_BURST);
+	c->configure_stamp = now;
+}
+
+/* Returns the number of microseconds until a throttled request can be
+ * handled, or -1 if there are none. */
+int64_t throttled_configure_delay(void)
+{
+	if (throttled_count == 0) {
+		return -1;
+	}
+	int64_t delay = -1;
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
+				client_t *c = n->client;
+				if (c == NULL || c->throttled_configure == NULL) {
+					continue;
+				}
+				refill_configure_tokens(c);
+				int64_t wait = (c->configure_tokens >= 1 ? 0 : (1 - c->configure_tokens) * 1e6 / CONFIGURE_REQUEST_RATE + 1);
+				if (delay == -1 || wait < delay) {
+					delay = wait;
+				}
+			}
+		}
+	}
+	return delay;
+}
+
+/* Handles the throttled requests whose clients have a token again. */
+void flush_throttled_configures(void)
+{
+	if (throttled_count == 0) {
+		return;
+	}
+	xcb_configure_request_event_t *ready = malloc(throttled_count * sizeof(xcb_configure_request_event_t));
+	if (ready == NULL) {
+		return;
+	}
+	int len = 0;
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
+				client_t *c = n->client;
+				if (c == NULL || c->throttled_configure == NULL) {
+					continue;
+				}
+				refill_configure_tokens(c);
+				if (c->configure_tokens >= 1) {
+					ready[len++] = *c->throttled_configure;
+					discard_throttled_configure(c);
+				}
+			}
+		}
+	}
+	/* The tree might change while the requests are handled. */
+	for (int i = 0; i < len; i++) {
+		configure_request((xcb_generic_event_t *) &ready[i]);
+	}
+	free(ready);
 }
 
 void map_request(xcb_generic_event_t *evt)
 {
 	xcb_map_request_event_t *e = (xcb_map_request_event_t *) evt;
 
-	schedule_window(e->window);
+	schedule_window(e->window, NULL);
 }
 
 void configure_request(xcb_generic_event_t *evt)
@@ -104,6 +423,10 @@ void configure_request(xcb_generic_event_t *evt)
 	client_t *c = (is_managed ? loc.node->client : NULL);
 	uint16_t width, height;
 
+	if (c != NULL && !admit_configure_request(c, e)) {
+		return;
+	}
+
 	if (!is_managed) {
 		uint16_t mask = 0;
 		uint32_t values[7];
@@ -173,7 +496,7 @@ void configure_request(xcb_generic_event_t *evt)
 
 		window_move_resize(e->window, r.x, r.y, r.width, r.height);
 
-		put_status(SBSC_MASK_NODE_GEOMETRY, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc.monitor->id, loc.desktop->id, e->window, r.width, r.height, r.x, r.y);
+		put_status_in(SBSC_MASK_NODE_GEOMETRY, &loc, NULL, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc.monitor->id, loc.desktop->id, e->window, r.width, r.height, r.x, r.y);
 
 		monitor_t *m = monitor_from_client(c);
 		if (m != loc.monitor) {
@@ -270,7 +593,8 @@ void property_notify(xcb_generic_event_t *evt)
 		}
 	}
 
-	if (e->atom != XCB_ATOM_WM_HINTS && e->atom != XCB_ATOM_WM_NORMAL_HINTS) {
+	if (e->atom != XCB_ATOM_WM_HINTS && e->atom != XCB_ATOM_WM_NORMAL_HINTS &&
+	    e->atom != XCB_ATOM_WM_NAME && e->atom != ewmh->_NET_WM_NAME) {
 		return;
 	}
 
@@ -295,6 +619,8 @@ void property_notify(xcb_generic_event_t *evt)
 		if (xcb_icccm_get_wm_normal_hints_reply(dpy, xcb_icccm_get_wm_normal_hints(dpy, e->window), &c->size_hints, NULL) == 1) {
 			arrange(loc.monitor, loc.desktop);
 		}
+	} else {
+		update_title(loc.monitor, loc.desktop, loc.node);
 	}
 }
 
@@ -401,7 +727,7 @@ void enter_notify(xcb_generic_event_t *evt)
 		return;
 	}
 
-	if (win == mon->root || (mon->desk->focus != NULL &&
+	if (win == mon->root || win == mon->desk->container || (mon->desk->focus != NULL &&
 	                         (win == mon->desk->focus->id ||
 	                          (mon->desk->focus->presel != NULL &&
 	                           win == mon->desk->focus->presel->feedback)))) {
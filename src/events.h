@@ -27,10 +27,14 @@
 
 #include <xcb/xcb.h>
 #include <xcb/xcb_event.h>
+#include "types.h"
 
 #define ERROR_CODE_BAD_WINDOW  3
 
-extern uint8_t randr_base;
+/* Sustained rate, per second, and burst of the configure requests of a client. */
+#define CONFIGURE_REQUEST_RATE   100
+#define CONFIGURE_REQUEST_BURST  20
+
 static const xcb_button_index_t BUTTONS[] = {XCB_BUTTON_INDEX_1, XCB_BUTTON_INDEX_2, XCB_BUTTON_INDEX_3};
 
 /**
@@ -39,6 +43,22 @@ static const xcb_button_index_t BUTTONS[] = {XCB_BUTTON_INDEX_1, XCB_BUTTON_INDE
  * @param evt the event
  */
 void handle_event(xcb_generic_event_t *evt);
+
+/**
+ * @brief Drain the events queued on the display connection and handle them, batch by batch
+ */
+void handle_events(void);
+xcb_window_t event_window(xcb_generic_event_t *evt);
+bool index_batch(xcb_generic_event_t **batch, int *next, int len);
+int next_window_event(xcb_generic_event_t **batch, int *next, int i);
+void cancel_destroyed_admissions(xcb_generic_event_t **batch, int *next, int len);
+void collapse_property_notifies(xcb_generic_event_t **batch, int *next, int len);
+void coalesce_configure_requests(xcb_generic_event_t **batch, int *next, int len);
+void merge_configure_request(xcb_configure_request_event_t *dst, xcb_configure_request_event_t *src);
+bool admit_configure_request(client_t *c, xcb_configure_request_event_t *e);
+void refill_configure_tokens(client_t *c);
+int64_t throttled_configure_delay(void);
+void flush_throttled_configures(void);
 void map_request(xcb_generic_event_t *evt);
 void configure_request(xcb_generic_event_t *evt);
 void configure_notify(xcb_generic_event_t *evt);
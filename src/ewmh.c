@@ -23,86 +23,61 @@
  */
 
 #include <stdlib.h>
-#include <sys/types.h>
 #include <string.h>
 #include <unistd.h>
 #include "bspwm.h"
 #include "settings.h"
+#include "backend.h"
 #include "tree.h"
+#include "registry.h"
+#include "transaction.h"
 #include "ewmh.h"
 
 xcb_ewmh_connection_t *ewmh;
 
-void ewmh_init(void)
-{
-	ewmh = calloc(1, sizeof(xcb_ewmh_connection_t));
-	if (xcb_ewmh_init_atoms_replies(ewmh, xcb_ewmh_init_atoms(dpy, ewmh), NULL) == 0) {
-		err("Can't initialize EWMH atoms.\n");
-	}
-}
-
 void ewmh_update_active_window(void)
 {
+	if (defer_ewmh_update(EWMH_ACTIVE_WINDOW)) {
+		return;
+	}
 	// select the current focused window, or XCB_NONE if no window is focused
 	xcb_window_t win = ((mon->desk->focus == NULL || mon->desk->focus->client == NULL) ? XCB_NONE : mon->desk->focus->id);
 	// update ewmh with the selected window
-	xcb_ewmh_set_active_window(ewmh, default_screen, win);
+	backend->change_property(root, ewmh->_NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, 32, 1, &win);
 }
 
 void ewmh_update_number_of_desktops(void)
 {
-	uint32_t desktops_count = 0;
-
-	// for all monitors
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		// count all desktops on that monitor
-		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			desktops_count++;
-		}
+	if (defer_ewmh_update(EWMH_NUMBER_OF_DESKTOPS)) {
+		return;
 	}
+	uint32_t desktops_count = registered_desktops_count();
 
 	// update ewmh with the new count
-	xcb_ewmh_set_number_of_desktops(ewmh, default_screen, desktops_count);
+	backend->change_property(root, ewmh->_NET_NUMBER_OF_DESKTOPS, XCB_ATOM_CARDINAL, 32, 1, &desktops_count);
 }
 
 uint32_t ewmh_get_desktop_index(desktop_t *d)
 {
-	uint32_t i = 0;
-	// enumerate all monitors to find the given desktop
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		for (desktop_t *cd = m->desk_head; cd != NULL; cd = cd->next, i++) {
-			if (d == cd) {
-				// return the index if the desktop is found
-				return i;
-			}
-		}
-	}
-	// if the given desktop was not found
-	return 0;
+	// the position of the desktop in the global order (0 if the given desktop was not found)
+	return desktop_ordinal(d);
 }
 
 bool ewmh_locate_desktop(uint32_t i, coordinates_t *loc)
 {
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		for (desktop_t *d = m->desk_head; d != NULL; d = d->next, i--) {
-			if (i == 0) {
-				loc->monitor = m;
-				loc->desktop = d;
-				loc->node = NULL;
-				return true;
-			}
-		}
-	}
-	return false;
+	return desktop_at(i, loc);
 }
 
 void ewmh_update_current_desktop(void)
 {
+	if (defer_ewmh_update(EWMH_CURRENT_DESKTOP)) {
+		return;
+	}
 	if (mon == NULL) {
 		return;
 	}
 	uint32_t i = ewmh_get_desktop_index(mon->desk);
-	xcb_ewmh_set_current_desktop(ewmh, default_screen, i);
+	backend->change_property(root, ewmh->_NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &i);
 }
 
 void ewmh_set_wm_desktop(node_t *n, desktop_t *d)
@@ -112,20 +87,23 @@ void ewmh_set_wm_desktop(node_t *n, desktop_t *d)
 		if (f->client == NULL) {
 			continue;
 		}
-		xcb_ewmh_set_wm_desktop(ewmh, f->id, i);
+		backend->change_property(f->id, ewmh->_NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &i);
 	}
 }
 
 void ewmh_update_wm_desktops(void)
 {
+	if (defer_ewmh_update(EWMH_WM_DESKTOPS)) {
+		return;
+	}
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
 		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
 			uint32_t i = ewmh_get_desktop_index(d);
-			for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 				if (n->client == NULL) {
 					continue;
 				}
-				xcb_ewmh_set_wm_desktop(ewmh, n->id, i);
+				backend->change_property(n->id, ewmh->_NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &i);
 			}
 		}
 	}
@@ -133,6 +111,9 @@ void ewmh_update_wm_desktops(void)
 
 void ewmh_update_desktop_names(void)
 {
+	if (defer_ewmh_update(EWMH_DESKTOP_NAMES)) {
+		return;
+	}
 	char names[MAXLEN];
 	unsigned int i, j;
 	uint32_t names_len;
@@ -151,16 +132,19 @@ void ewmh_update_desktop_names(void)
 	}
 
 	if (i < 1) {
-		xcb_ewmh_set_desktop_names(ewmh, default_screen, 0, NULL);
+		backend->change_property(root, ewmh->_NET_DESKTOP_NAMES, ewmh->UTF8_STRING, 8, 0, NULL);
 		return;
 	}
 
 	names_len = i - 1;
-	xcb_ewmh_set_desktop_names(ewmh, default_screen, names_len, names);
+	backend->change_property(root, ewmh->_NET_DESKTOP_NAMES, ewmh->UTF8_STRING, 8, names_len, names);
 }
 
 void ewmh_update_desktop_viewport(void)
 {
+	if (defer_ewmh_update(EWMH_DESKTOP_VIEWPORT)) {
+		return;
+	}
 	uint32_t desktops_count = 0;
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
 		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
@@ -168,7 +152,7 @@ void ewmh_update_desktop_viewport(void)
 		}
 	}
 	if (desktops_count == 0) {
-		xcb_ewmh_set_desktop_viewport(ewmh, default_screen, 0, NULL);
+		backend->change_property(root, ewmh->_NET_DESKTOP_VIEWPORT, XCB_ATOM_CARDINAL, 32, 0, NULL);
 		return;
 	}
 	xcb_ewmh_coordinates_t coords[desktops_count];
@@ -178,74 +162,17 @@ void ewmh_update_desktop_viewport(void)
 			coords[desktop++] = (xcb_ewmh_coordinates_t){m->rectangle.x, m->rectangle.y};
 		}
 	}
-	xcb_ewmh_set_desktop_viewport(ewmh, default_screen, desktop, coords);
-}
-
-bool ewmh_handle_struts(xcb_window_t win)
-{
-	xcb_ewmh_wm_strut_partial_t struts;
-	bool changed = false;
-	if (xcb_ewmh_get_wm_strut_partial_reply(ewmh, xcb_ewmh_get_wm_strut_partial(ewmh, win), &struts, NULL) == 1) {
-		for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-			xcb_rectangle_t rect = m->rectangle;
-			if (rect.x < (int16_t) struts.left &&
-			    (int16_t) struts.left < (rect.x + rect.width - 1) &&
-			    (int16_t) struts.left_end_y >= rect.y &&
-			    (int16_t) struts.left_start_y < (rect.y + rect.height)) {
-				int dx = struts.left - rect.x;
-				if (m->padding.left < 0) {
-					m->padding.left += dx;
-				} else {
-					m->padding.left = MAX(dx, m->padding.left);
-				}
-				changed = true;
-			}
-			if ((rect.x + rect.width) > (int16_t) (screen_width - struts.right) &&
-			    (int16_t) (screen_width - struts.right) > rect.x &&
-			    (int16_t) struts.right_end_y >= rect.y &&
-			    (int16_t) struts.right_start_y < (rect.y + rect.height)) {
-				int dx = (rect.x + rect.width) - screen_width + struts.right;
-				if (m->padding.right < 0) {
-					m->padding.right += dx;
-				} else {
-					m->padding.right = MAX(dx, m->padding.right);
-				}
-				changed = true;
-			}
-			if (rect.y < (int16_t) struts.top &&
-			    (int16_t) struts.top < (rect.y + rect.height - 1) &&
-			    (int16_t) struts.top_end_x >= rect.x &&
-			    (int16_t) struts.top_start_x < (rect.x + rect.width)) {
-				int dy = struts.top - rect.y;
-				if (m->padding.top < 0) {
-					m->padding.top += dy;
-				} else {
-					m->padding.top = MAX(dy, m->padding.top);
-				}
-				changed = true;
-			}
-			if ((rect.y + rect.height) > (int16_t) (screen_height - struts.bottom) &&
-			    (int16_t) (screen_height - struts.bottom) > rect.y &&
-			    (int16_t) struts.bottom_end_x >= rect.x &&
-			    (int16_t) struts.bottom_start_x < (rect.x + rect.width)) {
-				int dy = (rect.y + rect.height) - screen_height + struts.bottom;
-				if (m->padding.bottom < 0) {
-					m->padding.bottom += dy;
-				} else {
-					m->padding.bottom = MAX(dy, m->padding.bottom);
-				}
-				changed = true;
-			}
-		}
-	}
-	return changed;
+	backend->change_property(root, ewmh->_NET_DESKTOP_VIEWPORT, XCB_ATOM_CARDINAL, 32, 2 * desktop, coords);
 }
 
 void ewmh_update_client_list(bool stacking)
 {
+	if (defer_ewmh_update(stacking ? EWMH_CLIENT_LIST_STACKING : EWMH_CLIENT_LIST)) {
+		return;
+	}
 	if (clients_count == 0) {
-		xcb_ewmh_set_client_list(ewmh, default_screen, 0, NULL);
-		xcb_ewmh_set_client_list_stacking(ewmh, default_screen, 0, NULL);
+		backend->change_property(root, ewmh->_NET_CLIENT_LIST, XCB_ATOM_WINDOW, 32, 0, NULL);
+		backend->change_property(root, ewmh->_NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, 32, 0, NULL);
 		return;
 	}
 
@@ -256,11 +183,11 @@ void ewmh_update_client_list(bool stacking)
 		for (stacking_list_t *s = stack_head; s != NULL; s = s->next) {
 			wins[i++] = s->node->id;
 		}
-		xcb_ewmh_set_client_list_stacking(ewmh, default_screen, clients_count, wins);
+		backend->change_property(root, ewmh->_NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, 32, clients_count, wins);
 	} else {
 		for (monitor_t *m = mon_head; m != NULL; m = m->next) {
 			for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-				for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+				for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 					if (n->client == NULL) {
 						continue;
 					}
@@ -268,7 +195,7 @@ void ewmh_update_client_list(bool stacking)
 				}
 			}
 		}
-		xcb_ewmh_set_client_list(ewmh, default_screen, clients_count, wins);
+		backend->change_property(root, ewmh->_NET_CLIENT_LIST, XCB_ATOM_WINDOW, 32, clients_count, wins);
 	}
 }
 
@@ -294,14 +221,14 @@ void ewmh_wm_state_update(node_t *n)
 	HANDLE_WM_STATE(BELOW)
 	HANDLE_WM_STATE(DEMANDS_ATTENTION)
 #undef HANDLE_WM_STATE
-	xcb_ewmh_set_wm_state(ewmh, n->id, count, values);
+	backend->change_property(n->id, ewmh->_NET_WM_STATE, XCB_ATOM_ATOM, 32, count, values);
 }
 
 void ewmh_set_supporting(xcb_window_t win)
 {
-	pid_t wm_pid = getpid();
-	xcb_ewmh_set_supporting_wm_check(ewmh, root, win);
-	xcb_ewmh_set_supporting_wm_check(ewmh, win, win);
-	xcb_ewmh_set_wm_name(ewmh, win, strlen(WM_NAME), WM_NAME);
-	xcb_ewmh_set_wm_pid(ewmh, win, wm_pid);
+	uint32_t wm_pid = getpid();
+	backend->change_property(root, ewmh->_NET_SUPPORTING_WM_CHECK, XCB_ATOM_WINDOW, 32, 1, &win);
+	backend->change_property(win, ewmh->_NET_SUPPORTING_WM_CHECK, XCB_ATOM_WINDOW, 32, 1, &win);
+	backend->change_property(win, ewmh->_NET_WM_NAME, ewmh->UTF8_STRING, 8, strlen(WM_NAME), WM_NAME);
+	backend->change_property(win, ewmh->_NET_WM_PID, XCB_ATOM_CARDINAL, 32, 1, &wm_pid);
 }
@@ -29,12 +29,6 @@
 
 extern xcb_ewmh_connection_t *ewmh;
 
-/**
- * @brief Initialize ewmh
- *
- */
-void ewmh_init(void);
-
 /**
  * @brief Update ewmh with the currently active window
  *
@@ -60,7 +54,6 @@ void ewmh_set_wm_desktop(node_t *n, desktop_t *d);
 void ewmh_update_wm_desktops(void);
 void ewmh_update_desktop_names(void);
 void ewmh_update_desktop_viewport(void);
-bool ewmh_handle_struts(xcb_window_t win);
 void ewmh_update_client_list(bool stacking);
 void ewmh_wm_state_update(node_t *n);
 void ewmh_set_supporting(xcb_window_t win);
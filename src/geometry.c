@@ -177,3 +177,23 @@ int rect_cmp(xcb_rectangle_t r1, xcb_rectangle_t r2)
 		}
 	}
 }
+
+xcb_rectangle_t rect_slice(xcb_rectangle_t r, int i, int n, bool vertical)
+{
+	if (vertical) {
+		int16_t x = r.x + r.width * i / n;
+		r.width = r.x + r.width * (i + 1) / n - x;
+		r.x = x;
+	} else {
+		int16_t y = r.y + r.height * i / n;
+		r.height = r.y + r.height * (i + 1) / n - y;
+		r.y = y;
+	}
+	return r;
+}
+
+xcb_rectangle_t rect_union(xcb_rectangle_t a, xcb_rectangle_t b)
+{
+	int16_t x = MIN(a.x, b.x), y = MIN(a.y, b.y);
+	return (xcb_rectangle_t) {x, y, MAX(a.x + a.width, b.x + b.width) - x, MAX(a.y + a.height, b.y + b.height) - y};
+}
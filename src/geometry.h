@@ -93,4 +93,24 @@ bool rect_eq(xcb_rectangle_t a, xcb_rectangle_t b);
  */
 int rect_cmp(xcb_rectangle_t r1, xcb_rectangle_t r2);
 
+/**
+ * @brief Cut a rectangle in equal slices
+ *
+ * @param r the rectangle
+ * @param i the index of the slice
+ * @param n the number of slices
+ * @param vertical whether the slices are side by side or stacked
+ * @return xcb_rectangle_t, the `i`-th slice
+ */
+xcb_rectangle_t rect_slice(xcb_rectangle_t r, int i, int n, bool vertical);
+
+/**
+ * @brief Smallest rectangle containing two rectangles
+ *
+ * @param a rectangle a
+ * @param b rectangle b
+ * @return xcb_rectangle_t, the bounding box of a and b
+ */
+xcb_rectangle_t rect_union(xcb_rectangle_t a, xcb_rectangle_t b);
+
 #endif
@@ -193,3 +193,14 @@ bool is_hex_color(const char *color)
 	}
 	return true;
 }
+
+/* FNV-1a */
+uint32_t hash_string(const char *str)
+{
+	uint32_t h = 2166136261u;
+	for (const unsigned char *s = (const unsigned char *) str; *s != '\0'; s++) {
+		h ^= *s;
+		h *= 16777619u;
+	}
+	return h;
+}
@@ -25,15 +25,21 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include "bspwm.h"
+#include "settings.h"
 #include "tree.h"
 #include "query.h"
 #include "history.h"
 
+static unsigned int history_count;
+/* Number of entries at which the history is compacted next. */
+static unsigned int compaction_mark;
+
 history_t *make_history(monitor_t *m, desktop_t *d, node_t *n)
 {
 	history_t *h = calloc(1, sizeof(history_t));
 	h->loc = (coordinates_t) {m, d, n};
 	h->prev = h->next = NULL;
+	h->older = h->newer = NULL;
 	h->latest = true;
 	return h;
 }
@@ -52,14 +58,21 @@ void history_add(monitor_t *m, desktop_t *d, node_t *n, bool focused)
 
 	if (history_head == NULL) {
 		history_head = history_tail = h;
+		history_label(h);
+		history_link(h);
 	} else if ((n != NULL && history_tail->loc.node != n) || (n == NULL && d != history_tail->loc.desktop)) {
 		history_t *ip = focused ? history_tail : NULL;
 
-		for (history_t *hh = history_tail; hh != NULL; hh = hh->prev) {
-			if ((n != NULL && hh->loc.node == n) || (n == NULL && d == hh->loc.desktop)) {
-				hh->latest = false;
+		if (n == NULL) {
+			for (history_t *hh = history_tail; hh != NULL; hh = hh->prev) {
+				if (d == hh->loc.desktop) {
+					hh->latest = false;
+				}
 			}
-			if (ip == NULL && ((n != NULL && hh->loc.desktop == d) || (n == NULL && hh->loc.monitor == m))) {
+		}
+
+		for (history_t *hh = history_tail; ip == NULL && hh != NULL; hh = hh->prev) {
+			if ((n != NULL && hh->loc.desktop == d) || (n == NULL && hh->loc.monitor == m)) {
 				ip = hh;
 			}
 		}
@@ -78,6 +91,11 @@ void history_add(monitor_t *m, desktop_t *d, node_t *n, bool focused)
 			}
 			history_insert_before(h, ip);
 		}
+
+		history_link(h);
+		if (history_size_limit > 0 && history_count >= compaction_mark) {
+			history_compact();
+		}
 	} else {
 		free(h);
 	}
@@ -95,6 +113,7 @@ void history_insert_after(history_t *a, history_t *b)
 	if (history_tail == b) {
 		history_tail = a;
 	}
+	history_label(a);
 }
 
 // Inserts `a` before `b`.
@@ -109,65 +128,194 @@ void history_insert_before(history_t *a, history_t *b)
 	if (history_head == b) {
 		history_head = a;
 	}
+	history_label(a);
 }
 
-void history_remove(desktop_t *d, node_t *n, bool deep)
+/* Sequence numbers grow from the head to the tail, hence the distance
+ * between two entries can be computed by subtracting their numbers. */
+void history_label(history_t *h)
+{
+	uint32_t lo = (h->prev != NULL ? h->prev->seq : 0);
+	if (h->next == NULL) {
+		if (lo <= UINT32_MAX - HISTORY_SEQ_GAP) {
+			h->seq = lo + HISTORY_SEQ_GAP;
+			return;
+		}
+	} else if (h->next->seq - lo > 1) {
+		h->seq = lo + (h->next->seq - lo) / 2;
+		return;
+	}
+	history_relabel();
+}
+
+void history_relabel(void)
+{
+	uint32_t gap = UINT32_MAX / (history_count + 2);
+	if (gap > HISTORY_SEQ_GAP) {
+		gap = HISTORY_SEQ_GAP;
+	}
+	uint32_t seq = 0;
+	for (history_t *h = history_head; h != NULL; h = h->next) {
+		seq += gap;
+		h->seq = seq;
+	}
+}
+
+history_t **history_slot(history_t *h)
+{
+	if (h->loc.node != NULL) {
+		return &h->loc.node->history;
+	} else {
+		return &h->loc.desktop->history;
+	}
+}
+
+// Makes `h` the newest entry of its location.
+void history_link(history_t *h)
+{
+	history_t **slot = history_slot(h);
+	if (*slot != NULL) {
+		(*slot)->latest = false;
+		(*slot)->newer = h;
+	}
+	h->older = *slot;
+	*slot = h;
+	history_count++;
+}
+
+void history_unlink(history_t *h)
+{
+	if (h->next != NULL) {
+		h->next->prev = h->prev;
+	}
+	if (h->prev != NULL) {
+		h->prev->next = h->next;
+	}
+	if (history_head == h) {
+		history_head = h->next;
+	}
+	if (history_tail == h) {
+		history_tail = h->prev;
+	}
+	if (history_needle == h) {
+		history_needle = h->prev;
+	}
+
+	if (h->newer != NULL) {
+		h->newer->older = h->older;
+	} else {
+		*history_slot(h) = h->older;
+		if (h->older != NULL && h->latest) {
+			h->older->latest = true;
+		}
+	}
+	if (h->older != NULL) {
+		h->older->newer = h->newer;
+	}
+
+	history_count--;
+	free(h);
+}
+
+/* Removes `b` and the duplicates its removal reveals,
+ * returns the entry that preceded them. */
+history_t *history_remove_entry(history_t *b)
 {
+	history_t *a = b->next;
+	history_t *c = b->prev;
+	history_unlink(b);
+	if (a != NULL) {
+		while (c != NULL && ((a->loc.node != NULL && a->loc.node == c->loc.node) ||
+		       (a->loc.node == NULL && a->loc.desktop == c->loc.desktop))) {
+			history_t *p = c->prev;
+			history_unlink(c);
+			c = p;
+		}
+	}
+	return c;
+}
+
+void history_remove_node(node_t *n, bool deep)
+{
+	if (n == NULL) {
+		return;
+	}
 	/* removing from the newest to the oldest is required */
 	/* for maintaining the *latest* attribute */
+	while (n->history != NULL) {
+		history_remove_entry(n->history);
+	}
+	if (deep) {
+		history_remove_node(n->first_child, true);
+		history_remove_node(n->second_child, true);
+	}
+}
+
+/* Relocates the entries of the subtree rooted at `n`,
+ * which has moved to the given monitor and desktop. */
+void history_transfer_node(monitor_t *m, desktop_t *d, node_t *n)
+{
+	if (n == NULL) {
+		return;
+	}
+	for (history_t *h = n->history; h != NULL; h = h->older) {
+		h->loc.monitor = m;
+		h->loc.desktop = d;
+	}
+	history_transfer_node(m, d, n->first_child);
+	history_transfer_node(m, d, n->second_child);
+}
+
+void history_remove(desktop_t *d, node_t *n, bool deep)
+{
+	if (n != NULL) {
+		history_remove_node(n, deep);
+		return;
+	}
 	history_t *b = history_tail;
 	while (b != NULL) {
-		if ((n != NULL && ((deep && is_descendant(b->loc.node, n)) || (!deep && b->loc.node == n))) ||
-		    (n == NULL && d == b->loc.desktop)) {
-			history_t *a = b->next;
-			history_t *c = b->prev;
-			if (a != NULL) {
-				/* remove duplicate entries */
-				while (c != NULL && ((a->loc.node != NULL && a->loc.node == c->loc.node) ||
-				       (a->loc.node == NULL && a->loc.desktop == c->loc.desktop))) {
-					history_t *p = c->prev;
-					if (history_head == c) {
-						history_head = history_tail;
-					}
-					if (history_needle == c) {
-						history_needle = history_tail;
-					}
-					free(c);
-					c = p;
-				}
-				a->prev = c;
-			}
-			if (c != NULL) {
-				c->next = a;
-			}
-			if (history_tail == b) {
-				history_tail = c;
-			}
-			if (history_head == b) {
-				history_head = a;
-			}
-			if (history_needle == b) {
-				history_needle = c;
-			}
-			free(b);
-			b = c;
+		if (d == b->loc.desktop) {
+			b = history_remove_entry(b);
 		} else {
 			b = b->prev;
 		}
 	}
 }
 
+/* Drops the oldest superseded entries until the history fits its limit. The
+ * next compaction happens once the history has doubled, hence the scans are
+ * amortized over the additions, even when the latest entries alone exceed
+ * the limit. */
+void history_compact(void)
+{
+	if (history_size_limit <= 0) {
+		return;
+	}
+	unsigned int limit = history_size_limit;
+	history_t *h = history_head;
+	while (h != NULL && history_count > limit) {
+		history_t *next = h->next;
+		if (!h->latest) {
+			history_remove_entry(h);
+		}
+		h = next;
+	}
+	compaction_mark = 2 * MAX(history_count, limit);
+}
+
 void empty_history(void)
 {
 	history_t *h = history_head;
 	while (h != NULL) {
 		history_t *next = h->next;
+		*history_slot(h) = NULL;
 		free(h);
 		h = next;
 	}
-	history_head = history_tail = NULL;
+	history_head = history_tail = history_needle = NULL;
+	history_count = 0;
+	compaction_mark = 0;
 }
-
 node_t *history_last_node(desktop_t *d, node_t *n)
 {
 	for (history_t *h = history_tail; h != NULL; h = h->prev) {
@@ -310,15 +458,9 @@ bool history_find_monitor(history_dir_t hdi, coordinates_t *ref, coordinates_t *
 
 uint32_t history_rank(node_t *n)
 {
-	uint32_t r = 0;
-	history_t *h = history_tail;
-	while (h != NULL && (!h->latest || h->loc.node != n)) {
-		h = h->prev;
-		r++;
-	}
-	if (h == NULL) {
+	if (n->history == NULL || !n->history->latest) {
 		return UINT32_MAX;
 	} else {
-		return r;
+		return history_tail->seq - n->history->seq;
 	}
 }
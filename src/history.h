@@ -27,11 +27,22 @@
 
 #include "types.h"
 
+#define HISTORY_SEQ_GAP  64
+
 history_t *make_history(monitor_t *m, desktop_t *d, node_t *n);
 void history_add(monitor_t *m, desktop_t *d, node_t *n, bool focused);
 void history_insert_after(history_t *a, history_t *b);
 void history_insert_before(history_t *a, history_t *b);
+void history_label(history_t *h);
+void history_relabel(void);
+history_t **history_slot(history_t *h);
+void history_link(history_t *h);
+void history_unlink(history_t *h);
+history_t *history_remove_entry(history_t *b);
+void history_remove_node(node_t *n, bool deep);
+void history_transfer_node(monitor_t *m, desktop_t *d, node_t *n);
 void history_remove(desktop_t *d, node_t *n, bool deep);
+void history_compact(void);
 void empty_history(void);
 node_t *history_last_node(desktop_t *d, node_t *n);
 desktop_t *history_last_desktop(monitor_t *m, desktop_t *d);
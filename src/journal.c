@@ -0,0 +1,568 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "bspwm.h"
+#include "desktop.h"
+#include "monitor.h"
+#include "parse.h"
+#include "query.h"
+#include "settings.h"
+#include "tree.h"
+#include "window.h"
+#include "journal.h"
+
+/* Records are accumulated in memory and written with a single call at the end
+ * of each iteration of the event loop. */
+static char *journal_buf = NULL;
+static size_t journal_len = 0;
+static size_t journal_cap = 0;
+static int journal_fd = -1;
+static int journal_records = 0;
+static bool journal_stale = false;
+
+/* The ratios are only written once per iteration, and only after the pointer
+ * is released: dragging a fence changes the same ratios at every motion. */
+static uint32_t *ratio_ids = NULL;
+static size_t ratio_len = 0;
+static size_t ratio_cap = 0;
+
+/* The snapshot of a compaction is serialized by the main thread and written
+ * by a compaction thread. Meanwhile, the new records are kept in memory. */
+typedef struct {
+	char *state;
+	size_t len;
+	int fd;
+	char path[MAXLEN];
+	bool done;
+	bool ok;
+} compaction_t;
+
+static pthread_mutex_t compaction_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t compaction_thread;
+static compaction_t *compaction = NULL;
+
+static bool write_all(int fd, const char *data, size_t len)
+{
+	while (len > 0) {
+		ssize_t n = write(fd, data, len);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += n;
+		len -= n;
+	}
+	return true;
+}
+
+/* The snapshot is written to a temporary file and moved into place after the
+ * journal is truncated: a crash at any point leaves a snapshot and a journal
+ * that are either in sync, or missing the most recent records, but never
+ * replaying a record twice. */
+static void *compaction_worker(void *arg)
+{
+	compaction_t *c = arg;
+	char tmp_path[MAXLEN + SMALEN];
+	snprintf(tmp_path, sizeof(tmp_path), "%s%s", c->path, SNAPSHOT_TMP_SUFFIX);
+	int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	bool ok = false;
+
+	if (fd == -1) {
+		warn("Journal: can't write the snapshot '%s'.\n", tmp_path);
+	} else {
+		ok = write_all(fd, c->state, c->len) && fsync(fd) == 0;
+		ok = (close(fd) == 0 && ok);
+		if (!ok || ftruncate(c->fd, 0) == -1 || rename(tmp_path, c->path) == -1) {
+			warn("Journal: can't compact into '%s'.\n", c->path);
+			unlink(tmp_path);
+			ok = false;
+		}
+	}
+
+	pthread_mutex_lock(&compaction_lock);
+	c->ok = ok;
+	c->done = true;
+	pthread_mutex_unlock(&compaction_lock);
+
+	return NULL;
+}
+
+/* Returns whether no compaction is running anymore. */
+static bool finish_compaction(bool wait)
+{
+	if (compaction == NULL) {
+		return true;
+	}
+
+	pthread_mutex_lock(&compaction_lock);
+	bool done = compaction->done;
+	pthread_mutex_unlock(&compaction_lock);
+
+	if (!done && !wait) {
+		return false;
+	}
+
+	pthread_join(compaction_thread, NULL);
+
+	if (!compaction->ok) {
+		journal_stale = true;
+	}
+
+	free(compaction->state);
+	free(compaction);
+	compaction = NULL;
+
+	return true;
+}
+
+bool journal_open(void)
+{
+	journal_close();
+
+	if (journal_path[0] == '\0') {
+		return true;
+	}
+
+	char path[MAXLEN + SMALEN];
+	snprintf(path, sizeof(path), "%s%s", journal_path, JOURNAL_SUFFIX);
+	journal_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+
+	if (journal_fd == -1) {
+		warn("Journal: can't open '%s'.\n", path);
+		return false;
+	}
+
+	/* Records written by a previous session refer to IDs that aren't valid anymore. */
+	return journal_compact();
+}
+
+void journal_ratio(node_t *n)
+{
+	if (journal_fd == -1) {
+		return;
+	}
+
+	for (size_t i = 0; i < ratio_len; i++) {
+		if (ratio_ids[i] == n->id) {
+			return;
+		}
+	}
+
+	if (ratio_len == ratio_cap) {
+		size_t cap = MAX(2 * ratio_cap, 8);
+		uint32_t *ids = realloc(ratio_ids, cap * sizeof(uint32_t));
+		if (ids == NULL) {
+			journal_stale = true;
+			return;
+		}
+		ratio_ids = ids;
+		ratio_cap = cap;
+	}
+
+	ratio_ids[ratio_len++] = n->id;
+}
+
+static void journal_ratios(void)
+{
+	for (size_t i = 0; i < ratio_len; i++) {
+		coordinates_t loc;
+		if (find_by_id(ratio_ids[i], &loc)) {
+			journal_printf("node_ratio 0x%08X %lf\n", loc.node->id, loc.node->split_ratio);
+		}
+	}
+	ratio_len = 0;
+}
+
+void journal_close(void)
+{
+	if (journal_fd == -1) {
+		return;
+	}
+	journal_ratios();
+	finish_compaction(true);
+	journal_flush();
+	/* The flush might have started another compaction. */
+	finish_compaction(true);
+	close(journal_fd);
+	journal_fd = -1;
+	free(journal_buf);
+	journal_buf = NULL;
+	journal_len = journal_cap = 0;
+	free(ratio_ids);
+	ratio_ids = NULL;
+	ratio_len = ratio_cap = 0;
+	journal_records = 0;
+	journal_stale = false;
+}
+
+void journal_record(subscriber_mask_t mask, char *fmt, va_list args)
+{
+	if (journal_fd == -1 || !(mask & JOURNAL_MASK)) {
+		return;
+	}
+
+	va_list copy;
+	va_copy(copy, args);
+	int len = vsnprintf(NULL, 0, fmt, copy);
+	va_end(copy);
+
+	if (len < 0) {
+		return;
+	}
+
+	if (journal_len + len + 1 > journal_cap) {
+		size_t cap = MAX(2 * journal_cap, journal_len + len + 1);
+		char *buf = realloc(journal_buf, cap);
+		if (buf == NULL) {
+			/* We can't keep up: the next snapshot will hold the lost records. */
+			journal_stale = true;
+			return;
+		}
+		journal_buf = buf;
+		journal_cap = cap;
+	}
+
+	vsnprintf(journal_buf + journal_len, len + 1, fmt, args);
+	journal_len += len;
+	journal_records++;
+}
+
+void journal_printf(char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	journal_record(JOURNAL_MASK, fmt, args);
+	va_end(args);
+}
+
+void journal_flush(void)
+{
+	if (journal_fd == -1) {
+		return;
+	}
+
+	if (!grabbing) {
+		journal_ratios();
+	}
+
+	/* The records can't be appended before the journal is truncated. */
+	if (!finish_compaction(false)) {
+		return;
+	}
+
+	size_t i = 0;
+	while (i < journal_len) {
+		ssize_t n = write(journal_fd, journal_buf + i, journal_len - i);
+		if (n == -1) {
+			warn("Journal: write failed.\n");
+			journal_stale = true;
+			break;
+		}
+		i += n;
+	}
+	journal_len = 0;
+
+	/* Don't compact while the pointer is being dragged, every motion would rewrite the snapshot. */
+	if (!grabbing && (journal_stale || (journal_compaction_threshold > 0 && journal_records >= journal_compaction_threshold))) {
+		journal_compact();
+	}
+}
+
+bool journal_compact(void)
+{
+	if (journal_fd == -1) {
+		return false;
+	}
+
+	if (compaction != NULL) {
+		return true;
+	}
+
+	compaction_t *c = calloc(1, sizeof(compaction_t));
+
+	if (c == NULL) {
+		return false;
+	}
+
+	FILE *stream = open_memstream(&c->state, &c->len);
+
+	if (stream == NULL) {
+		free(c);
+		return false;
+	}
+
+	query_state(stream);
+
+	if (fclose(stream) != 0) {
+		free(c->state);
+		free(c);
+		return false;
+	}
+
+	c->fd = journal_fd;
+	snprintf(c->path, sizeof(c->path), "%s", journal_path);
+
+	/* The signals are handled by the main thread. */
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	int err = pthread_create(&compaction_thread, NULL, compaction_worker, c);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (err != 0) {
+		warn("Journal: can't start the compaction: %s.\n", strerror(err));
+		free(c->state);
+		free(c);
+		return false;
+	}
+
+	compaction = c;
+
+	/* The snapshot holds the records that weren't written yet. */
+	journal_len = 0;
+	ratio_len = 0;
+	journal_records = 0;
+	journal_stale = false;
+
+	return true;
+}
+
+bool has_journal(const char *state_path)
+{
+	char path[MAXLEN + SMALEN];
+	snprintf(path, sizeof(path), "%s%s", state_path, JOURNAL_SUFFIX);
+	return access(path, F_OK) == 0;
+}
+
+/* Called by restore_state before the IDs of the restored tree are regenerated,
+ * since the records reference the IDs of the crashed session. */
+void replay_journal(const char *state_path)
+{
+	char path[MAXLEN + SMALEN];
+	snprintf(path, sizeof(path), "%s%s", state_path, JOURNAL_SUFFIX);
+	FILE *f = fopen(path, "r");
+
+	if (f == NULL) {
+		return;
+	}
+
+	char *line = NULL;
+	size_t cap = 0;
+	ssize_t len;
+	while ((len = getline(&line, &cap, f)) != -1) {
+		if (len > 0 && line[len - 1] == '\n') {
+			line[len - 1] = '\0';
+		}
+		replay_record(line);
+	}
+
+	free(line);
+	fclose(f);
+
+	prune_vanished_windows();
+}
+
+static bool locate_record(uint32_t mid, uint32_t did, uint32_t nid, coordinates_t *loc)
+{
+	loc->monitor = find_monitor(mid);
+	loc->desktop = find_desktop_in(did, loc->monitor);
+	loc->node = NULL;
+	if (loc->desktop == NULL) {
+		return false;
+	}
+	if (nid != 0) {
+		loc->node = find_by_id_in(loc->desktop->root, nid);
+		return loc->node != NULL;
+	}
+	return true;
+}
+
+void replay_record(char *line)
+{
+	uint32_t mid1, did1, nid1, mid2, did2, nid2;
+	coordinates_t src, dst;
+	char arg1[SMALEN], arg2[SMALEN];
+	double ratio;
+	int deg, pos = 0;
+
+	if (sscanf(line, "node_insert %X %X %X %X", &mid1, &did1, &nid1, &nid2) == 4) {
+		if (locate_record(mid1, did1, nid1, &src) && !find_by_id(nid2, &dst)) {
+			node_t *n = make_node(nid2);
+			n->client = make_client();
+			n->client->border_width = src.desktop->border_width;
+			n->client->floating_rectangle = get_window_rectangle(n);
+			insert_node(src.monitor, src.desktop, n, src.node);
+			clients_count++;
+		}
+	} else if (sscanf(line, "node_receptacle %X %X %X %X", &mid1, &did1, &nid1, &nid2) == 4) {
+		if (locate_record(mid1, did1, nid1, &src) && !find_by_id(nid2, &dst)) {
+			insert_node(src.monitor, src.desktop, make_node(nid2), src.node);
+		}
+	} else if (sscanf(line, "node_remove %X %X %X", &mid1, &did1, &nid1) == 3) {
+		if (locate_record(mid1, did1, nid1, &src)) {
+			remove_node(src.monitor, src.desktop, src.node);
+		}
+	} else if (sscanf(line, "node_swap %X %X %X %X %X %X", &mid1, &did1, &nid1, &mid2, &did2, &nid2) == 6) {
+		if (locate_record(mid1, did1, nid1, &src) && locate_record(mid2, did2, nid2, &dst)) {
+			swap_nodes(src.monitor, src.desktop, src.node, dst.monitor, dst.desktop, dst.node, false);
+		}
+	} else if (sscanf(line, "node_transfer %X %X %X %X %X %X", &mid1, &did1, &nid1, &mid2, &did2, &nid2) == 6) {
+		if (locate_record(mid1, did1, nid1, &src) && locate_record(mid2, did2, nid2, &dst)) {
+			transfer_node(src.monitor, src.desktop, src.node, dst.monitor, dst.desktop, dst.node, false);
+		}
+	} else if (sscanf(line, "node_ratio %X %lf", &nid1, &ratio) == 2) {
+		if (find_by_id(nid1, &src)) {
+			set_ratio(src.node, ratio);
+		}
+	} else if (sscanf(line, "node_type %X %31s", &nid1, arg1) == 2) {
+		split_type_t typ;
+		if (parse_split_type(arg1, &typ) && find_by_id(nid1, &src)) {
+			set_type(src.node, typ);
+		}
+	} else if (sscanf(line, "node_rotate %X %i", &nid1, &deg) == 2) {
+		if (find_by_id(nid1, &src)) {
+			rotate_tree(src.desktop, src.node, deg);
+		}
+	} else if (sscanf(line, "node_flip %X %31s", &nid1, arg1) == 2) {
+		flip_t flp;
+		if (parse_flip(arg1, &flp) && find_by_id(nid1, &src)) {
+			flip_tree(src.desktop, src.node, flp);
+		}
+	} else if (sscanf(line, "node_state %X %X %X %31s %31s", &mid1, &did1, &nid1, arg1, arg2) == 5) {
+		client_state_t s;
+		if (streq("on", arg2) && parse_client_state(arg1, &s) && locate_record(mid1, did1, nid1, &src)) {
+			set_state(src.monitor, src.desktop, src.node, s);
+		}
+	} else if (sscanf(line, "node_layer %X %X %X %31s", &mid1, &did1, &nid1, arg1) == 4) {
+		stack_layer_t l;
+		if (parse_stack_layer(arg1, &l) && locate_record(mid1, did1, nid1, &src)) {
+			set_layer(src.monitor, src.desktop, src.node, l);
+		}
+	} else if (sscanf(line, "node_flag %X %X %X %31s %31s", &mid1, &did1, &nid1, arg1, arg2) == 5) {
+		bool v;
+		if (!parse_bool(arg2, &v) || !locate_record(mid1, did1, nid1, &src)) {
+			return;
+		}
+		if (streq("hidden", arg1)) {
+			set_hidden(src.monitor, src.desktop, src.node, v);
+		} else if (streq("sticky", arg1)) {
+			set_sticky(src.monitor, src.desktop, src.node, v);
+		} else if (streq("private", arg1)) {
+			set_private(src.monitor, src.desktop, src.node, v);
+		} else if (streq("locked", arg1)) {
+			set_locked(src.monitor, src.desktop, src.node, v);
+		} else if (streq("marked", arg1)) {
+			set_marked(src.monitor, src.desktop, src.node, v);
+		}
+	} else if (sscanf(line, "node_presel %X %X %X dir %31s", &mid1, &did1, &nid1, arg1) == 4) {
+		direction_t dir;
+		if (parse_direction(arg1, &dir) && locate_record(mid1, did1, nid1, &src)) {
+			presel_dir(src.monitor, src.desktop, src.node, dir);
+		}
+	} else if (sscanf(line, "node_presel %X %X %X ratio %lf", &mid1, &did1, &nid1, &ratio) == 4) {
+		if (locate_record(mid1, did1, nid1, &src)) {
+			presel_ratio(src.monitor, src.desktop, src.node, ratio);
+		}
+	} else if (sscanf(line, "node_presel %X %X %X cancel", &mid1, &did1, &nid1) == 3) {
+		if (locate_record(mid1, did1, nid1, &src)) {
+			cancel_presel(src.monitor, src.desktop, src.node);
+		}
+	} else if (sscanf(line, "desktop_add %X %X %n", &mid1, &did1, &pos) == 2 && pos > 0) {
+		monitor_t *m = find_monitor(mid1);
+		if (m != NULL && find_desktop_in(did1, m) == NULL) {
+			add_desktop(m, make_desktop(line + pos, did1));
+		}
+	} else if (sscanf(line, "desktop_rename %X %X %n", &mid1, &did1, &pos) == 2 && pos > 0) {
+		/* Desktop names may contain spaces: skip the old name, which is known. */
+		if (locate_record(mid1, did1, 0, &src)) {
+			size_t n = strlen(src.desktop->name);
+			char *name = line + pos;
+			if (strncmp(name, src.desktop->name, n) == 0 && name[n] == ' ') {
+				rename_desktop(src.monitor, src.desktop, name + n + 1);
+			}
+		}
+	} else if (sscanf(line, "desktop_remove %X %X", &mid1, &did1) == 2) {
+		if (locate_record(mid1, did1, 0, &src) && src.monitor->desk_head != src.monitor->desk_tail) {
+			desktop_t *fallback = src.desktop->prev == NULL ? src.desktop->next : src.desktop->prev;
+			merge_desktops(src.monitor, src.desktop, src.monitor, fallback);
+			remove_desktop(src.monitor, src.desktop);
+		}
+	} else if (sscanf(line, "desktop_swap %X %X %X %X", &mid1, &did1, &mid2, &did2) == 4) {
+		if (locate_record(mid1, did1, 0, &src) && locate_record(mid2, did2, 0, &dst)) {
+			swap_desktops(src.monitor, src.desktop, dst.monitor, dst.desktop, false);
+		}
+	} else if (sscanf(line, "desktop_transfer %X %X %X", &mid1, &did1, &mid2) == 3) {
+		monitor_t *md = find_monitor(mid2);
+		if (locate_record(mid1, did1, 0, &src) && md != NULL) {
+			transfer_desktop(src.monitor, md, src.desktop, false);
+		}
+	} else if (sscanf(line, "desktop_layout %X %X %31s", &mid1, &did1, arg1) == 3) {
+		layout_t l;
+		if (parse_layout(arg1, &l) && locate_record(mid1, did1, 0, &src)) {
+			set_layout(src.monitor, src.desktop, l, true);
+		}
+	} else if (sscanf(line, "monitor_rename %X %n", &mid1, &pos) == 1 && pos > 0) {
+		monitor_t *m = find_monitor(mid1);
+		if (m != NULL) {
+			size_t n = strlen(m->name);
+			char *name = line + pos;
+			if (strncmp(name, m->name, n) == 0 && name[n] == ' ') {
+				rename_monitor(m, name + n + 1);
+			}
+		}
+	}
+}
+
+/* Windows that were destroyed while the window manager was down. */
+void prune_vanished_windows(void)
+{
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			bool pruned = false;
+			node_t *n = first_extrema(d->root);
+			while (n != NULL) {
+				node_t *next = next_leaf(n, d->root);
+				if (n->client != NULL && !window_exists(n->id)) {
+					remove_node(m, d, n);
+					pruned = true;
+				}
+				n = next;
+			}
+			if (pruned) {
+				arrange(m, d);
+			}
+		}
+	}
+}
@@ -0,0 +1,57 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BSPWM_JOURNAL_H
+#define BSPWM_JOURNAL_H
+
+#include <stdarg.h>
+#include "subscribe.h"
+
+#define JOURNAL_SUFFIX       ".journal"
+#define SNAPSHOT_TMP_SUFFIX  ".tmp"
+
+/* Events that alter the structure of the tree: anything else (focus, stacking,
+ * geometry) is either recovered from the snapshot or recomputed on arrange.
+ * The insertions are journaled separately: the `node_add` event reports the
+ * node the window was inserted at after the insertion, which is gone when it
+ * was a receptacle. */
+#define JOURNAL_MASK  (SBSC_MASK_MONITOR_RENAME | \
+                       SBSC_MASK_DESKTOP_ADD | SBSC_MASK_DESKTOP_RENAME | SBSC_MASK_DESKTOP_REMOVE | \
+                       SBSC_MASK_DESKTOP_SWAP | SBSC_MASK_DESKTOP_TRANSFER | SBSC_MASK_DESKTOP_LAYOUT | \
+                       SBSC_MASK_NODE_REMOVE | SBSC_MASK_NODE_SWAP | SBSC_MASK_NODE_TRANSFER | \
+                       SBSC_MASK_NODE_PRESEL | SBSC_MASK_NODE_STATE | SBSC_MASK_NODE_FLAG | SBSC_MASK_NODE_LAYER)
+
+bool journal_open(void);
+void journal_close(void);
+void journal_record(subscriber_mask_t mask, char *fmt, va_list args);
+void journal_printf(char *fmt, ...);
+void journal_ratio(node_t *n);
+void journal_flush(void);
+bool journal_compact(void);
+bool has_journal(const char *state_path);
+void replay_journal(const char *state_path);
+void replay_record(char *line);
+void prune_vanished_windows(void);
+
+#endif
@@ -0,0 +1,662 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bspwm.h"
+#include "backend.h"
+#include "desktop.h"
+#include "ewmh.h"
+#include "geometry.h"
+#include "journal.h"
+#include "monitor.h"
+#include "pointer.h"
+#include "query.h"
+#include "rule.h"
+#include "settings.h"
+#include "stack.h"
+#include "subscribe.h"
+#include "tree.h"
+#include "window.h"
+#include "manage.h"
+
+void ewmh_init(void)
+{
+	ewmh = calloc(1, sizeof(xcb_ewmh_connection_t));
+	if (xcb_ewmh_init_atoms_replies(ewmh, xcb_ewmh_init_atoms(dpy, ewmh), NULL) == 0) {
+		err("Can't initialize EWMH atoms.\n");
+	}
+}
+
+void get_atom(char *name, xcb_atom_t *atom)
+{
+	xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(dpy, xcb_intern_atom(dpy, 0, strlen(name), name), NULL);
+	if (reply != NULL) {
+		*atom = reply->atom;
+	} else {
+		*atom = XCB_NONE;
+	}
+	free(reply);
+}
+
+bool update_monitors(void)
+{
+	xcb_randr_get_screen_resources_reply_t *sres = xcb_randr_get_screen_resources_reply(dpy, xcb_randr_get_screen_resources(dpy, root), NULL);
+	if (sres == NULL) {
+		return false;
+	}
+
+	monitor_t *last_wired = NULL;
+
+	int len = xcb_randr_get_screen_resources_outputs_length(sres);
+	xcb_randr_output_t *outputs = xcb_randr_get_screen_resources_outputs(sres);
+
+	xcb_randr_get_output_info_cookie_t cookies[len];
+	for (int i = 0; i < len; i++) {
+		cookies[i] = xcb_randr_get_output_info(dpy, outputs[i], XCB_CURRENT_TIME);
+	}
+
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		m->wired = false;
+	}
+
+	for (int i = 0; i < len; i++) {
+		xcb_randr_get_output_info_reply_t *info = xcb_randr_get_output_info_reply(dpy, cookies[i], NULL);
+		if (info != NULL) {
+			if (info->crtc != XCB_NONE) {
+				xcb_randr_get_crtc_info_reply_t *cir = xcb_randr_get_crtc_info_reply(dpy, xcb_randr_get_crtc_info(dpy, info->crtc, XCB_CURRENT_TIME), NULL);
+				if (cir != NULL) {
+					xcb_rectangle_t rect = (xcb_rectangle_t) {cir->x, cir->y, cir->width, cir->height};
+					last_wired = get_monitor_by_randr_id(outputs[i]);
+					if (last_wired != NULL) {
+						update_root(last_wired, &rect);
+						last_wired->wired = true;
+					} else {
+						char *name = (char *) xcb_randr_get_output_info_name(info);
+						size_t len = (size_t) xcb_randr_get_output_info_name_length(info);
+						char *name_copy = copy_string(name, len);
+						last_wired = make_monitor(name_copy, &rect, XCB_NONE);
+						free(name_copy);
+						last_wired->randr_id = outputs[i];
+						add_monitor(last_wired);
+					}
+				}
+				free(cir);
+			} else if (!remove_disabled_monitors && info->connection != XCB_RANDR_CONNECTION_DISCONNECTED) {
+				monitor_t *m = get_monitor_by_randr_id(outputs[i]);
+				if (m != NULL) {
+					m->wired = true;
+				}
+			}
+		}
+		free(info);
+	}
+
+	xcb_randr_get_output_primary_reply_t *gpo = xcb_randr_get_output_primary_reply(dpy, xcb_randr_get_output_primary(dpy, root), NULL);
+	if (gpo != NULL) {
+		pri_mon = get_monitor_by_randr_id(gpo->output);
+	}
+	free(gpo);
+
+	/* handle overlapping monitors */
+	if (merge_overlapping_monitors) {
+		monitor_t *m = mon_head;
+		while (m != NULL) {
+			monitor_t *next = m->next;
+			if (m->wired) {
+				monitor_t *mb = mon_head;
+				while (mb != NULL) {
+					monitor_t *mb_next = mb->next;
+					if (m != mb && mb->wired && contains(m->rectangle, mb->rectangle)) {
+						if (last_wired == mb) {
+							last_wired = m;
+						}
+						if (next == mb) {
+							next = mb_next;
+						}
+						merge_monitors(mb, m);
+						remove_monitor(mb);
+					}
+					mb = mb_next;
+				}
+			}
+			m = next;
+		}
+	}
+
+	/* merge and remove disconnected monitors */
+	if (remove_unplugged_monitors) {
+		monitor_t *m = mon_head;
+		while (m != NULL) {
+			monitor_t *next = m->next;
+			if (!m->wired) {
+				merge_monitors(m, last_wired);
+				remove_monitor(m);
+			}
+			m = next;
+		}
+	}
+
+	/* add one desktop to each new monitor */
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		if (m->desk == NULL) {
+			add_desktop(m, make_desktop(NULL, XCB_NONE));
+		}
+	}
+
+	if (!running && mon != NULL) {
+		if (pri_mon != NULL) {
+			mon = pri_mon;
+		}
+		center_pointer(mon->rectangle);
+		ewmh_update_current_desktop();
+	}
+
+	free(sres);
+
+	return (mon != NULL);
+}
+
+void request_window_cookies(xcb_window_t win, window_cookies_t *wc)
+{
+	wc->attributes = xcb_get_window_attributes(dpy, win);
+	request_rule_cookies(win, &wc->rule);
+	request_client_cookies(win, &wc->client);
+	wc->geometry = xcb_get_geometry(dpy, win);
+}
+
+void schedule_window(xcb_window_t win, window_cookies_t *wc)
+{
+	window_cookies_t cookies;
+	if (wc == NULL) {
+		request_window_cookies(win, &cookies);
+		wc = &cookies;
+	}
+
+	coordinates_t loc;
+	uint8_t override_redirect = 0;
+	xcb_get_window_attributes_reply_t *wa = xcb_get_window_attributes_reply(dpy, wc->attributes, NULL);
+
+	if (wa != NULL) {
+		override_redirect = wa->override_redirect;
+		free(wa);
+	}
+
+	bool pending = false;
+
+	/* ignore pending windows */
+	for (pending_rule_t *pr = pending_rule_head; pr != NULL && !pending; pr = pr->next) {
+		pending = (pr->win == win);
+	}
+
+	if (override_redirect || pending || locate_window(win, &loc)) {
+		discard_rule_cookies(&wc->rule);
+		discard_client_cookies(&wc->client);
+		xcb_discard_reply(dpy, wc->geometry.sequence);
+		return;
+	}
+
+	rule_consequence_t *csq = make_rule_consequence();
+	apply_rules(win, &wc->rule, csq);
+	if (!schedule_rules(win, csq)) {
+		manage_window(win, csq, -1, wc);
+		free(csq);
+	} else {
+		/* The external rules reply later, the window will be initialized from scratch. */
+		discard_client_cookies(&wc->client);
+		xcb_discard_reply(dpy, wc->geometry.sequence);
+	}
+}
+
+bool manage_window(xcb_window_t win, rule_consequence_t *csq, int fd, window_cookies_t *wc)
+{
+	monitor_t *m = mon;
+	desktop_t *d = mon->desk;
+	node_t *f = mon->desk->focus;
+
+	parse_rule_consequence(fd, csq);
+
+	if (!ignore_ewmh_struts && ewmh_handle_struts(win)) {
+		for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+			for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+				arrange(m, d);
+			}
+		}
+	}
+
+	if (!csq->manage) {
+		if (wc != NULL) {
+			discard_client_cookies(&wc->client);
+			xcb_discard_reply(dpy, wc->geometry.sequence);
+		}
+		free(csq->layer);
+		free(csq->state);
+		window_show(win);
+		return false;
+	}
+
+	if (csq->node_desc[0] != '\0') {
+		coordinates_t ref = {m, d, f};
+		coordinates_t trg = {NULL, NULL, NULL};
+		if (node_from_desc(csq->node_desc, &ref, &trg) == SELECTOR_OK) {
+			m = trg.monitor;
+			d = trg.desktop;
+			f = trg.node;
+		}
+	} else if (csq->desktop_desc[0] != '\0') {
+		coordinates_t ref = {m, d, NULL};
+		coordinates_t trg = {NULL, NULL, NULL};
+		if (desktop_from_desc(csq->desktop_desc, &ref, &trg) == SELECTOR_OK) {
+			m = trg.monitor;
+			d = trg.desktop;
+			f = trg.desktop->focus;
+		}
+	} else if (csq->monitor_desc[0] != '\0') {
+		coordinates_t ref = {m, NULL, NULL};
+		coordinates_t trg = {NULL, NULL, NULL};
+		if (monitor_from_desc(csq->monitor_desc, &ref, &trg) == SELECTOR_OK) {
+			m = trg.monitor;
+			d = trg.monitor->desk;
+			f = trg.monitor->desk->focus;
+		}
+	}
+
+	if (csq->sticky) {
+		m = mon;
+		d = mon->desk;
+		f = mon->desk->focus;
+	}
+
+	if (csq->split_dir != NULL && f != NULL) {
+		presel_dir(m, d, f, *csq->split_dir);
+	}
+
+	if (csq->split_ratio != 0 && f != NULL) {
+		presel_ratio(m, d, f, csq->split_ratio);
+	}
+
+	window_cookies_t cookies;
+	if (wc == NULL) {
+		request_client_cookies(win, &cookies.client);
+		cookies.geometry = xcb_get_geometry(dpy, win);
+		wc = &cookies;
+	}
+
+	node_t *n = make_node(win);
+	client_t *c = make_client();
+	c->border_width = csq->border ? d->border_width : 0;
+	n->client = c;
+	initialize_client(n, &wc->client);
+	initialize_floating_rectangle(n, wc->geometry);
+
+	if (csq->rect != NULL) {
+		c->floating_rectangle = *csq->rect;
+		free(csq->rect);
+	} else if (c->floating_rectangle.x == 0 && c->floating_rectangle.y == 0) {
+		csq->center = true;
+	}
+
+	monitor_t *mm = monitor_from_client(c);
+	embrace_client(mm, c);
+	adapt_geometry(&mm->rectangle, &m->rectangle, n);
+
+	if (csq->center) {
+		window_center(m, c);
+	}
+
+	if (d->container != XCB_NONE) {
+		backend->change_save_set(XCB_SET_MODE_INSERT, win);
+		backend->reparent_window(win, d->container, c->floating_rectangle.x, c->floating_rectangle.y);
+	}
+
+	snprintf(c->class_name, sizeof(c->class_name), "%s", csq->class_name);
+	snprintf(c->instance_name, sizeof(c->instance_name), "%s", csq->instance_name);
+
+	if ((csq->state != NULL && (*(csq->state) == STATE_FLOATING || *(csq->state) == STATE_FULLSCREEN)) || csq->hidden) {
+		n->vacant = true;
+	}
+
+	journal_printf("node_insert 0x%08X 0x%08X 0x%08X 0x%08X\n", m->id, d->id, f != NULL ? f->id : 0, win);
+	f = insert_node(m, d, n, f);
+	clients_count++;
+	if (single_monocle && d->layout == LAYOUT_MONOCLE && tiled_count(d->root, true) > 1) {
+		set_layout(m, d, d->user_layout, false);
+	}
+
+	n->vacant = false;
+
+	put_status_in(SBSC_MASK_NODE_ADD, &(coordinates_t) {m, d, n}, NULL, "node_add 0x%08X 0x%08X 0x%08X 0x%08X\n", m->id, d->id, f!=NULL?f->id:0, win);
+
+	if (f != NULL && f->client != NULL && csq->state != NULL && *(csq->state) == STATE_FLOATING) {
+		c->layer = f->client->layer;
+	}
+
+	if (csq->layer != NULL) {
+		c->layer = *(csq->layer);
+	}
+
+	if (csq->state != NULL) {
+		set_state(m, d, n, *(csq->state));
+	}
+
+	set_hidden(m, d, n, csq->hidden);
+	set_sticky(m, d, n, csq->sticky);
+	set_private(m, d, n, csq->private);
+	set_locked(m, d, n, csq->locked);
+	set_marked(m, d, n, csq->marked);
+
+	arrange(m, d);
+
+	uint32_t values[] = {CLIENT_EVENT_MASK | (focus_follows_pointer ? XCB_EVENT_MASK_ENTER_WINDOW : 0)};
+	backend->change_attributes(win, XCB_CW_EVENT_MASK, values);
+	set_window_state(win, XCB_ICCCM_WM_STATE_NORMAL);
+	window_grab_buttons(win);
+
+	if (d->container != XCB_NONE && !n->hidden) {
+		window_show_in(d->container, win);
+	}
+
+	if (d == m->desk) {
+		show_node(d, n);
+	} else {
+		hide_node(d, n);
+	}
+
+	ewmh_update_client_list(false);
+	ewmh_set_wm_desktop(n, d);
+
+	if (!csq->hidden && csq->focus) {
+		if (d == mon->desk || csq->follow) {
+			focus_node(m, d, n);
+		} else {
+			activate_node(m, d, n);
+		}
+	} else {
+		stack(d, n, false);
+		draw_border(n, false, (m == mon));
+	}
+
+	free(csq->layer);
+	free(csq->state);
+
+	return true;
+}
+
+void unmanage_window(xcb_window_t win)
+{
+	coordinates_t loc;
+	if (locate_window(win, &loc)) {
+		put_status_in(SBSC_MASK_NODE_REMOVE, &loc, NULL, "node_remove 0x%08X 0x%08X 0x%08X\n", loc.monitor->id, loc.desktop->id, win);
+		if (loc.desktop->container != XCB_NONE) {
+			reparent_windows(&win, 1, loc.desktop->container, root);
+		}
+		remove_node(loc.monitor, loc.desktop, loc.node);
+		arrange(loc.monitor, loc.desktop);
+	} else {
+		for (pending_rule_t *pr = pending_rule_head; pr != NULL; pr = pr->next) {
+			if (pr->win == win) {
+				remove_pending_rule(pr);
+				return;
+			}
+		}
+	}
+}
+
+void adopt_orphans(void)
+{
+	xcb_query_tree_reply_t *qtr = xcb_query_tree_reply(dpy, xcb_query_tree(dpy, root), NULL);
+	if (qtr == NULL) {
+		return;
+	}
+
+	int len = xcb_query_tree_children_length(qtr);
+	xcb_window_t *wins = xcb_query_tree_children(qtr);
+	xcb_get_property_cookie_t *desktop_cookies = malloc(len * sizeof(xcb_get_property_cookie_t));
+	window_cookies_t *cookies = malloc(len * sizeof(window_cookies_t));
+
+	if (desktop_cookies == NULL || cookies == NULL) {
+		for (int i = 0; i < len; i++) {
+			uint32_t idx;
+			if (xcb_ewmh_get_wm_desktop_reply(ewmh, xcb_ewmh_get_wm_desktop(ewmh, wins[i]), &idx, NULL) == 1) {
+				schedule_window(wins[i], NULL);
+			}
+		}
+	} else {
+		/* Each phase sends all its requests before waiting for the first reply,
+		 * so adopting a window costs a few round trips for the whole batch. */
+		for (int i = 0; i < len; i++) {
+			desktop_cookies[i] = xcb_ewmh_get_wm_desktop(ewmh, wins[i]);
+		}
+
+		int count = 0;
+		for (int i = 0; i < len; i++) {
+			uint32_t idx;
+			if (xcb_ewmh_get_wm_desktop_reply(ewmh, desktop_cookies[i], &idx, NULL) == 1) {
+				wins[count] = wins[i];
+				request_window_cookies(wins[count], &cookies[count]);
+				count++;
+			}
+		}
+
+		for (int i = 0; i < count; i++) {
+			schedule_window(wins[i], &cookies[i]);
+		}
+	}
+
+	free(desktop_cookies);
+	free(cookies);
+	free(qtr);
+}
+
+void initialize_floating_rectangle(node_t *n, xcb_get_geometry_cookie_t cookie)
+{
+	client_t *c = n->client;
+
+	xcb_get_geometry_reply_t *geo = xcb_get_geometry_reply(dpy, cookie, NULL);
+
+	if (geo != NULL) {
+		c->floating_rectangle = (xcb_rectangle_t) {geo->x, geo->y, geo->width, geo->height};
+	}
+
+	free(geo);
+}
+
+void request_client_cookies(xcb_window_t win, client_cookies_t *cc)
+{
+	cc->protocols = xcb_icccm_get_wm_protocols(dpy, win, ewmh->WM_PROTOCOLS);
+	cc->window_state = xcb_ewmh_get_wm_state(ewmh, win);
+	cc->hints = xcb_icccm_get_wm_hints(dpy, win);
+	cc->normal_hints = xcb_icccm_get_wm_normal_hints(dpy, win);
+	cc->wm_name = xcb_icccm_get_wm_name(dpy, win);
+	cc->net_wm_name = xcb_ewmh_get_wm_name(ewmh, win);
+}
+
+void discard_client_cookies(client_cookies_t *cc)
+{
+	xcb_discard_reply(dpy, cc->protocols.sequence);
+	xcb_discard_reply(dpy, cc->window_state.sequence);
+	xcb_discard_reply(dpy, cc->hints.sequence);
+	xcb_discard_reply(dpy, cc->normal_hints.sequence);
+	xcb_discard_reply(dpy, cc->wm_name.sequence);
+	xcb_discard_reply(dpy, cc->net_wm_name.sequence);
+}
+
+void initialize_client(node_t *n, client_cookies_t *cc)
+{
+	client_cookies_t cookies;
+	if (cc == NULL) {
+		request_client_cookies(n->id, &cookies);
+		cc = &cookies;
+	}
+	client_t *c = n->client;
+	xcb_icccm_get_wm_protocols_reply_t protos;
+	if (xcb_icccm_get_wm_protocols_reply(dpy, cc->protocols, &protos, NULL) == 1) {
+		for (uint32_t i = 0; i < protos.atoms_len; i++) {
+			if (protos.atoms[i] == WM_TAKE_FOCUS) {
+				c->icccm_props.take_focus = true;
+			} else if (protos.atoms[i] == WM_DELETE_WINDOW) {
+				c->icccm_props.delete_window = true;
+			}
+		}
+		xcb_icccm_get_wm_protocols_reply_wipe(&protos);
+	}
+	xcb_ewmh_get_atoms_reply_t wm_state;
+	if (xcb_ewmh_get_wm_state_reply(ewmh, cc->window_state, &wm_state, NULL) == 1) {
+		for (unsigned int i = 0; i < wm_state.atoms_len && i < MAX_WM_STATES; i++) {
+#define HANDLE_WM_STATE(s) \
+			if (wm_state.atoms[i] == ewmh->_NET_WM_STATE_##s) { \
+				c->wm_flags |= WM_FLAG_##s; continue; \
+			}
+			HANDLE_WM_STATE(MODAL)
+			HANDLE_WM_STATE(STICKY)
+			HANDLE_WM_STATE(MAXIMIZED_VERT)
+			HANDLE_WM_STATE(MAXIMIZED_HORZ)
+			HANDLE_WM_STATE(SHADED)
+			HANDLE_WM_STATE(SKIP_TASKBAR)
+			HANDLE_WM_STATE(SKIP_PAGER)
+			HANDLE_WM_STATE(HIDDEN)
+			HANDLE_WM_STATE(FULLSCREEN)
+			HANDLE_WM_STATE(ABOVE)
+			HANDLE_WM_STATE(BELOW)
+			HANDLE_WM_STATE(DEMANDS_ATTENTION)
+#undef HANDLE_WM_STATE
+		}
+		xcb_ewmh_get_atoms_reply_wipe(&wm_state);
+	}
+	xcb_icccm_wm_hints_t hints;
+	if (xcb_icccm_get_wm_hints_reply(dpy, cc->hints, &hints, NULL) == 1
+		&& (hints.flags & XCB_ICCCM_WM_HINT_INPUT)) {
+		c->icccm_props.input_hint = hints.input;
+	}
+	xcb_icccm_get_wm_normal_hints_reply(dpy, cc->normal_hints, &c->size_hints, NULL);
+	read_window_title(cc->net_wm_name, cc->wm_name, c->name, sizeof(c->name));
+}
+
+/* Copies at most `len - 1` bytes of the title without splitting a UTF-8
+ * sequence, and replaces the control characters, which would break the line
+ * based events, by spaces. */
+void copy_title(char *dst, size_t len, const char *src, size_t src_len)
+{
+	size_t end = MIN(src_len, len - 1);
+	if (end < src_len) {
+		while (end > 0 && (src[end] & 0xC0) == 0x80) {
+			end--;
+		}
+	}
+	for (size_t i = 0; i < end; i++) {
+		unsigned char ch = src[i];
+		if (ch == '\0') {
+			end = i;
+			break;
+		}
+		dst[i] = (ch < ' ' || ch == 0x7F) ? ' ' : ch;
+	}
+	dst[end] = '\0';
+}
+
+/* Reads the title of a window, preferring _NET_WM_NAME over WM_NAME. */
+void read_window_title(xcb_get_property_cookie_t net_wm_name, xcb_get_property_cookie_t wm_name, char *title, size_t len)
+{
+	xcb_ewmh_get_utf8_strings_reply_t utf8;
+	xcb_icccm_get_text_property_reply_t text;
+	title[0] = '\0';
+	if (xcb_ewmh_get_wm_name_reply(ewmh, net_wm_name, &utf8, NULL) == 1) {
+		copy_title(title, len, utf8.strings, utf8.strings_len);
+		xcb_ewmh_get_utf8_strings_reply_wipe(&utf8);
+		xcb_discard_reply(dpy, wm_name.sequence);
+	} else if (xcb_icccm_get_wm_name_reply(dpy, wm_name, &text, NULL) == 1) {
+		copy_title(title, len, text.name, text.name_len);
+		xcb_icccm_get_text_property_reply_wipe(&text);
+	}
+}
+
+/* Reads the title of the window of `n` again. */
+void update_title(monitor_t *m, desktop_t *d, node_t *n)
+{
+	char title[MAXLEN];
+	read_window_title(xcb_ewmh_get_wm_name(ewmh, n->id), xcb_icccm_get_wm_name(dpy, n->id), title, sizeof(title));
+	set_title(m, d, n, title);
+}
+
+bool ewmh_handle_struts(xcb_window_t win)
+{
+	xcb_ewmh_wm_strut_partial_t struts;
+	bool changed = false;
+	if (xcb_ewmh_get_wm_strut_partial_reply(ewmh, xcb_ewmh_get_wm_strut_partial(ewmh, win), &struts, NULL) == 1) {
+		for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+			xcb_rectangle_t rect = m->rectangle;
+			if (rect.x < (int16_t) struts.left &&
+			    (int16_t) struts.left < (rect.x + rect.width - 1) &&
+			    (int16_t) struts.left_end_y >= rect.y &&
+			    (int16_t) struts.left_start_y < (rect.y + rect.height)) {
+				int dx = struts.left - rect.x;
+				if (m->padding.left < 0) {
+					m->padding.left += dx;
+				} else {
+					m->padding.left = MAX(dx, m->padding.left);
+				}
+				changed = true;
+			}
+			if ((rect.x + rect.width) > (int16_t) (screen_width - struts.right) &&
+			    (int16_t) (screen_width - struts.right) > rect.x &&
+			    (int16_t) struts.right_end_y >= rect.y &&
+			    (int16_t) struts.right_start_y < (rect.y + rect.height)) {
+				int dx = (rect.x + rect.width) - screen_width + struts.right;
+				if (m->padding.right < 0) {
+					m->padding.right += dx;
+				} else {
+					m->padding.right = MAX(dx, m->padding.right);
+				}
+				changed = true;
+			}
+			if (rect.y < (int16_t) struts.top &&
+			    (int16_t) struts.top < (rect.y + rect.height - 1) &&
+			    (int16_t) struts.top_end_x >= rect.x &&
+			    (int16_t) struts.top_start_x < (rect.x + rect.width)) {
+				int dy = struts.top - rect.y;
+				if (m->padding.top < 0) {
+					m->padding.top += dy;
+				} else {
+					m->padding.top = MAX(dy, m->padding.top);
+				}
+				changed = true;
+			}
+			if ((rect.y + rect.height) > (int16_t) (screen_height - struts.bottom) &&
+			    (int16_t) (screen_height - struts.bottom) > rect.y &&
+			    (int16_t) struts.bottom_end_x >= rect.x &&
+			    (int16_t) struts.bottom_start_x < (rect.x + rect.width)) {
+				int dy = (rect.y + rect.height) - screen_height + struts.bottom;
+				if (m->padding.bottom < 0) {
+					m->padding.bottom += dy;
+				} else {
+					m->padding.bottom = MAX(dy, m->padding.bottom);
+				}
+				changed = true;
+			}
+		}
+	}
+	return changed;
+}
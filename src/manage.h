@@ -0,0 +1,62 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BSPWM_MANAGE_H
+#define BSPWM_MANAGE_H
+
+#include <xcb/xcb.h>
+#include "types.h"
+
+/* Reading the windows and the outputs to manage waits on the replies of the X
+ * server: these functions aren't part of libbspwm-core. */
+
+/**
+ * @brief Initialize ewmh
+ *
+ */
+void ewmh_init(void);
+
+/**
+ * @brief Get the atom by name
+ *
+ * @param name name of the atom
+ * @param atom pointer to the xcb_atom_t object
+ */
+void get_atom(char *name, xcb_atom_t *atom);
+bool update_monitors(void);
+void request_window_cookies(xcb_window_t win, window_cookies_t *wc);
+void schedule_window(xcb_window_t win, window_cookies_t *wc);
+bool manage_window(xcb_window_t win, rule_consequence_t *csq, int fd, window_cookies_t *wc);
+void unmanage_window(xcb_window_t win);
+void adopt_orphans(void);
+void initialize_floating_rectangle(node_t *n, xcb_get_geometry_cookie_t cookie);
+void request_client_cookies(xcb_window_t win, client_cookies_t *cc);
+void discard_client_cookies(client_cookies_t *cc);
+void initialize_client(node_t *n, client_cookies_t *cc);
+void copy_title(char *dst, size_t len, const char *src, size_t src_len);
+void read_window_title(xcb_get_property_cookie_t net_wm_name, xcb_get_property_cookie_t wm_name, char *title, size_t len);
+void update_title(monitor_t *m, desktop_t *d, node_t *n);
+bool ewmh_handle_struts(xcb_window_t win);
+
+#endif
@@ -23,6 +23,7 @@
  */
 
 #include <stdio.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
@@ -31,16 +32,24 @@
 #include <unistd.h>
 #include "bspwm.h"
 #include "desktop.h"
+#include "history.h"
 #include "monitor.h"
 #include "pointer.h"
 #include "query.h"
 #include "rule.h"
 #include "restore.h"
 #include "settings.h"
+#include "stats.h"
 #include "tree.h"
 #include "window.h"
 #include "common.h"
 #include "parse.h"
+#include "journal.h"
+#include "mirror.h"
+#include "snapshot.h"
+#include "transaction.h"
+#include "trace.h"
+#include "manage.h"
 #include "messages.h"
 
 void handle_message(char *msg, int msg_len, FILE *rsp)
@@ -79,11 +88,28 @@ void handle_message(char *msg, int msg_len, FILE *rsp)
 	}
 
 	char **args_orig = args;
+	trace_begin_message(msg, msg_len);
 	process_message(args, num, rsp);
+	trace_end_message();
 	free(args_orig);
 }
 
 void process_message(char **args, int num, FILE *rsp)
+{
+	if (streq("subscribe", *args)) {
+		cmd_subscribe(++args, --num, rsp);
+		return;
+	} else if (streq("batch", *args)) {
+		cmd_batch(++args, --num, rsp);
+	} else {
+		run_command(args, num, rsp);
+	}
+
+	fflush(rsp);
+	fclose(rsp);
+}
+
+void run_command(char **args, int num, FILE *rsp)
 {
 	if (streq("node", *args)) {
 		cmd_node(++args, --num, rsp);
@@ -93,9 +119,6 @@ void process_message(char **args, int num, FILE *rsp)
 		cmd_monitor(++args, --num, rsp);
 	} else if (streq("query", *args)) {
 		cmd_query(++args, --num, rsp);
-	} else if (streq("subscribe", *args)) {
-		cmd_subscribe(++args, --num, rsp);
-		return;
 	} else if (streq("wm", *args)) {
 		cmd_wm(++args, --num, rsp);
 	} else if (streq("rule", *args)) {
@@ -107,9 +130,188 @@ void process_message(char **args, int num, FILE *rsp)
 	} else {
 		fail(rsp, "Unknown domain or command: '%s'.\n", *args);
 	}
+}
 
-	fflush(rsp);
-	fclose(rsp);
+void cmd_batch(char **args, int num, FILE *rsp)
+{
+	if (num < 1) {
+		fail(rsp, "batch: Missing commands.\n");
+		return;
+	}
+
+	char *output = NULL;
+	size_t output_size = 0;
+	FILE *out = open_memstream(&output, &output_size);
+
+	if (out == NULL) {
+		fail(rsp, "batch: Can't allocate the output buffer.\n");
+		return;
+	}
+
+	begin_transaction();
+
+	while (num > 0) {
+		int len = 0;
+		while (len < num && !streq(BATCH_SEPARATOR, args[len])) {
+			len++;
+		}
+
+		if (len > 0) {
+			if (streq("subscribe", *args) || streq("batch", *args)) {
+				fail(rsp, "batch: Invalid command: '%s'.\n", *args);
+				break;
+			}
+
+			char *buf = NULL;
+			size_t size = 0;
+			FILE *cmd_rsp = open_memstream(&buf, &size);
+			if (cmd_rsp == NULL) {
+				fail(rsp, "batch: Can't allocate the output buffer.\n");
+				break;
+			}
+			run_command(args, len, cmd_rsp);
+			fclose(cmd_rsp);
+
+			/* Stop at the first failure: its message is the only response. */
+			if (size > 0 && buf[0] == FAILURE_MESSAGE[0]) {
+				fwrite(buf, 1, size, rsp);
+				free(buf);
+				break;
+			}
+
+			fwrite(buf, 1, size, out);
+			free(buf);
+		}
+
+		num -= len, args += len;
+		if (num > 0) {
+			num--, args++;
+		}
+	}
+
+	commit_transaction();
+
+	fclose(out);
+	if (num == 0) {
+		fwrite(output, 1, output_size, rsp);
+	}
+	free(output);
+}
+
+/* Splits a line of a commands file into arguments, in place, with the quoting
+ * rules of the shell: single quotes, double quotes and backslashes. Returns
+ * the number of arguments or -1 if a quote isn't closed. */
+int split_arguments(char *line, char ***args_ptr)
+{
+	int cap = INIT_CAP;
+	int num = 0;
+	char **args = malloc(cap * sizeof(char *));
+
+	if (args == NULL) {
+		return -1;
+	}
+
+	char *src = line, *dst = line;
+
+	while (true) {
+		while (isspace((unsigned char) *src)) {
+			src++;
+		}
+		if (*src == '\0' || *src == '#') {
+			break;
+		}
+		if (num >= cap) {
+			cap *= 2;
+			char **new = realloc(args, cap * sizeof(char *));
+			if (new == NULL) {
+				free(args);
+				return -1;
+			}
+			args = new;
+		}
+		args[num++] = dst;
+		char quote = '\0';
+		while (*src != '\0' && (quote != '\0' || !isspace((unsigned char) *src))) {
+			char c = *src++;
+			if (quote == '\0' && (c == '\'' || c == '"')) {
+				quote = c;
+			} else if (quote != '\0' && c == quote) {
+				quote = '\0';
+			} else if (c == '\\' && quote != '\'' && *src != '\0') {
+				*dst++ = *src++;
+			} else {
+				*dst++ = c;
+			}
+		}
+		if (quote != '\0') {
+			free(args);
+			return -1;
+		}
+		char *next = (*src != '\0' ? src + 1 : src);
+		*dst++ = '\0';
+		src = next;
+	}
+
+	*args_ptr = args;
+	return num;
+}
+
+/* Runs the commands of the given file, one per line, as a single transaction:
+ * nothing is arranged or reported before the last command was applied. */
+void run_commands_file(char *path)
+{
+	FILE *file = fopen(path, "r");
+
+	if (file == NULL) {
+		warn("Can't open the commands file '%s'.\n", path);
+		return;
+	}
+
+	uint64_t start = stats_clock();
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	int line_num = 0;
+
+	begin_transaction();
+
+	while ((len = getline(&line, &size, file)) != -1) {
+		line_num++;
+		if (len > 0 && line[len - 1] == '\n') {
+			line[len - 1] = '\0';
+		}
+		char **args = NULL;
+		int num = split_arguments(line, &args);
+		if (num < 0) {
+			warn("%s:%i: Unterminated quote.\n", path, line_num);
+			continue;
+		}
+		if (num > 0) {
+			if (streq("subscribe", *args) || streq("batch", *args)) {
+				warn("%s:%i: Invalid command: '%s'.\n", path, line_num, *args);
+			} else {
+				char *buf = NULL;
+				size_t buf_size = 0;
+				FILE *rsp = open_memstream(&buf, &buf_size);
+				if (rsp != NULL) {
+					run_command(args, num, rsp);
+					fclose(rsp);
+					if (buf_size > 0 && buf[0] == FAILURE_MESSAGE[0]) {
+						warn("%s:%i: %s", path, line_num, buf_size > 1 ? buf + 1 : "Command failed.\n");
+					}
+					free(buf);
+				}
+			}
+		}
+		free(args);
+	}
+
+	free(line);
+	fclose(file);
+
+	commit_transaction();
+
+	stats_record_since(STAT_COMMANDS_FILE, start);
 }
 
 void cmd_node(char **args, int num, FILE *rsp)
@@ -121,10 +323,17 @@ void cmd_node(char **args, int num, FILE *rsp)
 
 	coordinates_t ref = {mon, mon->desk, mon->desk->focus};
 	coordinates_t trg = ref;
+	uint32_t *ids = NULL;
+	int len = -1;
 
 	if ((*args)[0] != OPT_CHR) {
 		int ret;
-		if ((ret = node_from_desc(*args, &ref, &trg)) == SELECTOR_OK) {
+		if (selects_all(*args)) {
+			ret = node_ids_from_desc(*args, &ref, &ids, &len);
+		} else {
+			ret = node_from_desc(*args, &ref, &trg);
+		}
+		if (ret == SELECTOR_OK) {
 			num--, args++;
 		} else {
 			handle_failure(ret, "node", *args, rsp);
@@ -133,10 +342,21 @@ void cmd_node(char **args, int num, FILE *rsp)
 	}
 
 	if (num < 1) {
+		free(ids);
 		fail(rsp, "node: Missing commands.\n");
 		return;
 	}
 
+	if (len >= 0) {
+		run_for_each(DOMAIN_NODE, ids, len, args, num, rsp);
+		free(ids);
+	} else {
+		node_commands(ref, trg, args, num, rsp);
+	}
+}
+
+void node_commands(coordinates_t ref, coordinates_t trg, char **args, int num, FILE *rsp)
+{
 	bool changed = false;
 
 	while (num > 0) {
@@ -528,7 +748,7 @@ void cmd_node(char **args, int num, FILE *rsp)
 			}
 			flip_t flp;
 			if (parse_flip(*args, &flp)) {
-				flip_tree(trg.node, flp);
+				flip_tree(trg.desktop, trg.node, flp);
 				changed = true;
 			} else {
 				fail(rsp, "");
@@ -546,7 +766,7 @@ void cmd_node(char **args, int num, FILE *rsp)
 			}
 			int deg;
 			if (parse_degree(*args, &deg)) {
-				rotate_tree(trg.node, deg);
+				rotate_tree(trg.desktop, trg.node, deg);
 				changed = true;
 			} else {
 				fail(rsp, "node %s: Invalid argument: '%s'.\n", *(args - 1), *args);
@@ -632,10 +852,16 @@ void cmd_desktop(char **args, int num, FILE *rsp)
 
 	coordinates_t ref = {mon, mon->desk, NULL};
 	coordinates_t trg = ref;
+	uint32_t *ids = NULL;
+	int len = -1;
 
 	if ((*args)[0] != OPT_CHR) {
-		int ret;
-		if ((ret = desktop_from_desc(*args, &ref, &trg)) == SELECTOR_OK) {
+		/* an existing desktop named `all` takes precedence */
+		int ret = desktop_from_desc(*args, &ref, &trg);
+		if (ret == SELECTOR_BAD_DESCRIPTOR && selects_all(*args)) {
+			ret = desktop_ids_from_desc(*args, &ref, &ids, &len);
+		}
+		if (ret == SELECTOR_OK) {
 			num--, args++;
 		} else {
 			handle_failure(ret, "desktop", *args, rsp);
@@ -644,10 +870,21 @@ void cmd_desktop(char **args, int num, FILE *rsp)
 	}
 
 	if (num < 1) {
+		free(ids);
 		fail(rsp, "desktop: Missing commands.\n");
 		return;
 	}
 
+	if (len >= 0) {
+		run_for_each(DOMAIN_DESKTOP, ids, len, args, num, rsp);
+		free(ids);
+	} else {
+		desktop_commands(ref, trg, args, num, rsp);
+	}
+}
+
+void desktop_commands(coordinates_t ref, coordinates_t trg, char **args, int num, FILE *rsp)
+{
 	bool changed = false;
 
 	while (num > 0) {
@@ -770,7 +1007,7 @@ void cmd_desktop(char **args, int num, FILE *rsp)
 			layout_t lyt;
 			cycle_dir_t cyc;
 			if (parse_cycle_direction(*args, &cyc)) {
-				ret = set_layout(trg.monitor, trg.desktop, (trg.desktop->user_layout + 1) % 2, true);
+				ret = set_layout(trg.monitor, trg.desktop, trg.desktop->user_layout == LAYOUT_MONOCLE ? LAYOUT_TILED : LAYOUT_MONOCLE, true);
 			} else if (parse_layout(*args, &lyt)) {
 				ret = set_layout(trg.monitor, trg.desktop, lyt, true);
 			} else {
@@ -816,6 +1053,96 @@ void cmd_desktop(char **args, int num, FILE *rsp)
 	}
 }
 
+/* Copies the arguments in a single block, since the commands modify them. */
+char **copy_arguments(char **args, int num)
+{
+	size_t size = num * sizeof(char *);
+	for (int i = 0; i < num; i++) {
+		size += strlen(args[i]) + 1;
+	}
+	char **copy = malloc(size);
+	if (copy == NULL) {
+		return NULL;
+	}
+	char *s = (char *) (copy + num);
+	for (int i = 0; i < num; i++) {
+		size_t len = strlen(args[i]) + 1;
+		memcpy(s, args[i], len);
+		copy[i] = s;
+		s += len;
+	}
+	return copy;
+}
+
+/* Runs the commands for each of the given nodes or desktops, as a single
+ * transaction. The targets that no longer exist when their turn comes are
+ * skipped. As with batch, the first failure stops the run and becomes the
+ * only response. */
+void run_for_each(domain_t dom, uint32_t *ids, int len, char **args, int num, FILE *rsp)
+{
+	char *output = NULL;
+	size_t output_size = 0;
+	FILE *out = open_memstream(&output, &output_size);
+
+	if (out == NULL) {
+		fail(rsp, "%s: Can't allocate the output buffer.\n", dom == DOMAIN_NODE ? "node" : "desktop");
+		return;
+	}
+
+	bool failed = false;
+
+	begin_transaction();
+
+	for (int i = 0; i < len && !failed; i++) {
+		coordinates_t trg;
+		if ((dom == DOMAIN_NODE && !find_by_id(ids[i], &trg)) ||
+		    (dom == DOMAIN_DESKTOP && !desktop_from_id(ids[i], &trg, NULL))) {
+			continue;
+		}
+
+		char *buf = NULL;
+		size_t size = 0;
+		FILE *cmd_rsp = open_memstream(&buf, &size);
+		char **cmd_args = copy_arguments(args, num);
+		if (cmd_rsp == NULL || cmd_args == NULL) {
+			fail(rsp, "%s: Can't allocate the output buffer.\n", dom == DOMAIN_NODE ? "node" : "desktop");
+			if (cmd_rsp != NULL) {
+				fclose(cmd_rsp);
+				free(buf);
+			}
+			failed = true;
+			break;
+		}
+
+		if (dom == DOMAIN_NODE) {
+			coordinates_t ref = {mon, mon->desk, mon->desk->focus};
+			node_commands(ref, trg, cmd_args, num, cmd_rsp);
+		} else {
+			coordinates_t ref = {mon, mon->desk, NULL};
+			desktop_commands(ref, trg, cmd_args, num, cmd_rsp);
+		}
+
+		fclose(cmd_rsp);
+		free(cmd_args);
+
+		if (size > 0 && buf[0] == FAILURE_MESSAGE[0]) {
+			fwrite(buf, 1, size, rsp);
+			failed = true;
+		} else {
+			fwrite(buf, 1, size, out);
+		}
+		free(buf);
+	}
+
+	commit_transaction();
+
+	fclose(out);
+	if (!failed) {
+		fwrite(output, 1, output_size, rsp);
+	}
+	free(output);
+}
+
 void cmd_monitor(char **args, int num, FILE *rsp)
 {
 	if (num < 1) {
@@ -976,6 +1303,10 @@ void cmd_query(char **args, int num, FILE *rsp)
 	node_select_t *node_sel = NULL;
 	domain_t dom = DOMAIN_TREE;
 	bool print_ids = true;
+	char *format = NULL;
+	query_format_t qf = {NULL, 0};
+	query_projection_t proj = make_query_projection();
+	bool projected = false;
 	uint8_t d = 0;
 
 	if (num < 1) {
@@ -1094,6 +1425,35 @@ void cmd_query(char **args, int num, FILE *rsp)
 			}
 		} else if (streq("--names", *args)) {
 			print_ids = false;
+		} else if (streq("-F", *args) || streq("--format", *args)) {
+			num--, args++;
+			if (num < 1) {
+				fail(rsp, "query %s: Not enough arguments.\n", *(args - 1));
+				goto end;
+			}
+			format = *args;
+		} else if (streq("--fields", *args)) {
+			num--, args++;
+			if (num < 1) {
+				fail(rsp, "query %s: Not enough arguments.\n", *(args - 1));
+				goto end;
+			}
+			if (!parse_query_fields(*args, &proj)) {
+				fail(rsp, "query %s: Invalid argument: '%s'.\n", *(args - 1), *args);
+				goto end;
+			}
+			projected = true;
+		} else if (streq("--depth", *args)) {
+			num--, args++;
+			if (num < 1) {
+				fail(rsp, "query %s: Not enough arguments.\n", *(args - 1));
+				goto end;
+			}
+			if (sscanf(*args, "%i", &proj.depth) != 1 || proj.depth < 0) {
+				fail(rsp, "query %s: Invalid argument: '%s'.\n", *(args - 1), *args);
+				goto end;
+			}
+			projected = true;
 		} else {
 			fail(rsp, "query: Unknown option: '%s'.\n", *args);
 			goto end;
@@ -1121,6 +1481,21 @@ void cmd_query(char **args, int num, FILE *rsp)
 		goto end;
 	}
 
+	if (format != NULL && dom == DOMAIN_TREE) {
+		fail(rsp, "query -T: --format only applies to -M, -D and -N.\n");
+		goto end;
+	}
+
+	if (projected && dom != DOMAIN_TREE) {
+		fail(rsp, "query: --fields and --depth only apply to -T.\n");
+		goto end;
+	}
+
+	if (format != NULL && !compile_query_format(format, dom, &qf)) {
+		fail(rsp, "query --format: Invalid argument: '%s'.\n", format);
+		goto end;
+	}
+
 	if ((dom == DOMAIN_MONITOR && (desktop_sel != NULL || node_sel != NULL)) ||
 	    (dom == DOMAIN_DESKTOP && node_sel != NULL)) {
 		fail(rsp, "query -%c: Incompatible descriptor-free constraints.\n", dom == DOMAIN_MONITOR ? 'M' : 'D');
@@ -1128,32 +1503,39 @@ void cmd_query(char **args, int num, FILE *rsp)
 	}
 
 	if (dom == DOMAIN_NODE) {
-		if (query_node_ids(&monitor_ref, &desktop_ref, &node_ref, &trg, monitor_sel, desktop_sel, node_sel, rsp) < 1) {
+		if (query_node_ids(&monitor_ref, &desktop_ref, &node_ref, &trg, monitor_sel, desktop_sel, node_sel, format != NULL ? &qf : NULL, rsp) < 1) {
 			fail(rsp, "");
 		}
 	} else if (dom == DOMAIN_DESKTOP) {
-		if (query_desktop_ids(&monitor_ref, &desktop_ref, &trg, monitor_sel, desktop_sel, print_ids ? fprint_desktop_id : fprint_desktop_name, rsp) < 1) {
+		if (query_desktop_ids(&monitor_ref, &desktop_ref, &trg, monitor_sel, desktop_sel, print_ids ? fprint_desktop_id : fprint_desktop_name, format != NULL ? &qf : NULL, rsp) < 1) {
 			fail(rsp, "");
 		}
 	} else if (dom == DOMAIN_MONITOR) {
-		if (query_monitor_ids(&monitor_ref, &trg, monitor_sel, print_ids ? fprint_monitor_id : fprint_monitor_name, rsp) < 1) {
+		if (query_monitor_ids(&monitor_ref, &trg, monitor_sel, print_ids ? fprint_monitor_id : fprint_monitor_name, format != NULL ? &qf : NULL, rsp) < 1) {
 			fail(rsp, "");
 		}
 	} else {
-		if (trg.node != NULL) {
-			query_node(trg.node, rsp);
-		} else if (trg.desktop != NULL) {
-			query_desktop(trg.desktop, rsp);
-		} else  {
-			query_monitor(trg.monitor, rsp);
+		uint32_t id = trg.node != NULL ? trg.node->id : (trg.desktop != NULL ? trg.desktop->id : trg.monitor->id);
+		/* Projections are cheap to compute and can't be cut out of the snapshot. */
+		if (projected || !serve_snapshot(id, rsp)) {
+			query_projection_t *p = projected ? &proj : NULL;
+			if (trg.node != NULL) {
+				query_node_fields(trg.node, p, 0, rsp);
+			} else if (trg.desktop != NULL) {
+				query_desktop_fields(trg.desktop, p, 0, rsp);
+			} else  {
+				query_monitor_fields(trg.monitor, p, 0, rsp);
+			}
+			fprintf(rsp, "\n");
 		}
-		fprintf(rsp, "\n");
 	}
 
 end:
 	free(monitor_sel);
 	free(desktop_sel);
 	free(node_sel);
+	free_query_format(&qf);
+	free_query_projection(&proj);
 }
 
 void cmd_rule(char **args, int num, FILE *rsp)
@@ -1232,8 +1614,12 @@ void cmd_wm(char **args, int num, FILE *rsp)
 
 	while (num > 0) {
 		if (streq("-d", *args) || streq("--dump-state", *args)) {
-			query_state(rsp);
-			fprintf(rsp, "\n");
+			/* The worker writes its response after this command: it can't
+			 * be followed by the responses of other options. */
+			if (num > 1 || !serve_snapshot(XCB_NONE, rsp)) {
+				query_state(rsp);
+				fprintf(rsp, "\n");
+			}
 		} else if (streq("-l", *args) || streq("--load-state", *args)) {
 			num--, args++;
 			if (num < 1) {
@@ -1284,6 +1670,9 @@ void cmd_wm(char **args, int num, FILE *rsp)
 			adopt_orphans();
 		} else if (streq("-g", *args) || streq("--get-status", *args)) {
 			print_report(rsp);
+		} else if (streq("-S", *args) || streq("--stats", *args)) {
+			query_stats(rsp);
+			fprintf(rsp, "\n");
 		} else if (streq("-h", *args) || streq("--record-history", *args)) {
 			num--, args++;
 			if (num < 1) {
@@ -1315,6 +1704,7 @@ void cmd_subscribe(char **args, int num, FILE *rsp)
 	int count = -1;
 	FILE *stream = rsp;
 	char *fifo_path = NULL;
+	subscriber_filter_t *filter = NULL;
 	subscriber_mask_t mask;
 
 	while (num > 0) {
@@ -1334,6 +1724,23 @@ void cmd_subscribe(char **args, int num, FILE *rsp)
 				fail(rsp, "subscribe %s: Can't create FIFO.\n", *(args - 1));
 				goto failed;
 			}
+		} else if (streq("-m", *args) || streq("--monitor", *args) ||
+		           streq("-d", *args) || streq("--desktop", *args) ||
+		           streq("-n", *args) || streq("--node", *args)) {
+			char *opt = *args;
+			domain_t dom = (streq("-m", opt) || streq("--monitor", opt)) ? DOMAIN_MONITOR :
+			               ((streq("-d", opt) || streq("--desktop", opt)) ? DOMAIN_DESKTOP : DOMAIN_NODE);
+			num--, args++;
+			if (num < 1) {
+				fail(rsp, "subscribe %s: Not enough arguments.\n", opt);
+				goto failed;
+			}
+			if (filter == NULL) {
+				filter = make_subscriber_filter();
+			}
+			if (!set_subscriber_filter(dom, *args, filter, rsp)) {
+				goto failed;
+			}
 		} else if (parse_subscriber_mask(*args, &mask)) {
 			field |= mask;
 		} else {
@@ -1361,6 +1768,7 @@ void cmd_subscribe(char **args, int num, FILE *rsp)
 	}
 
 	subscriber_list_t *sb = make_subscriber(stream, fifo_path, field, count);
+	sb->filter = filter;
 	add_subscriber(sb);
 	return;
 
@@ -1369,12 +1777,74 @@ failed:
 	fclose(rsp);
 
 free_fifo_path:
+	free_subscriber_filter(filter);
 	if (fifo_path) {
 		unlink(fifo_path);
 		free(fifo_path);
 	}
 }
 
+/* Restricts the events of a subscriber to the given monitor, desktop or node,
+ * or to the ones matching the given modifiers. */
+bool set_subscriber_filter(domain_t dom, char *desc, subscriber_filter_t *filter, FILE *rsp)
+{
+	char *src = (dom == DOMAIN_MONITOR ? "subscribe -m" : (dom == DOMAIN_DESKTOP ? "subscribe -d" : "subscribe -n"));
+
+	if (desc[0] == '.') {
+		bool valid;
+		switch (dom) {
+			case DOMAIN_MONITOR:
+				valid = set_monitor_filter(desc, filter);
+				break;
+			case DOMAIN_DESKTOP:
+				valid = set_desktop_filter(desc, filter);
+				break;
+			default:
+				valid = set_node_filter(desc, filter);
+				break;
+		}
+		if (!valid) {
+			handle_failure(SELECTOR_BAD_MODIFIERS, src, desc, rsp);
+		}
+		return valid;
+	}
+
+	int ret;
+	coordinates_t ref = {mon, mon->desk, mon->desk->focus};
+	coordinates_t trg = {NULL, NULL, NULL};
+
+	switch (dom) {
+		case DOMAIN_MONITOR:
+			ret = monitor_from_desc(desc, &ref, &trg);
+			break;
+		case DOMAIN_DESKTOP:
+			ret = desktop_from_desc(desc, &ref, &trg);
+			break;
+		default:
+			ret = node_from_desc(desc, &ref, &trg);
+			break;
+	}
+
+	if (ret != SELECTOR_OK) {
+		handle_failure(ret, src, desc, rsp);
+		return false;
+	}
+
+	switch (dom) {
+		case DOMAIN_MONITOR:
+			filter->monitor_id = trg.monitor->id;
+			break;
+		case DOMAIN_DESKTOP:
+			filter->desktop_id = trg.desktop->id;
+			break;
+		default:
+			filter->node_id = trg.node->id;
+			break;
+	}
+
+	return true;
+}
+
 void cmd_quit(char **args, int num, FILE *rsp)
 {
 	if (num > 0 && sscanf(*args, "%i", &exit_status) != 1) {
@@ -1455,7 +1925,7 @@ void set_setting(coordinates_t loc, char *name, char *value, FILE *rsp)
 			} \
 		} else if (loc.desktop != NULL) { \
 			loc.desktop->k = v; \
-			for (node_t *n = first_extrema(loc.desktop->root); n != NULL; n = next_leaf(n, loc.desktop->root)) { \
+			for (node_t *n = loc.desktop->leaf_head; n != NULL; n = n->leaf_next) { \
 				if (n->client != NULL) { \
 					n->client->k = v; \
 				} \
@@ -1464,7 +1934,7 @@ void set_setting(coordinates_t loc, char *name, char *value, FILE *rsp)
 			loc.monitor->k = v; \
 			for (desktop_t *d = loc.monitor->desk_head; d != NULL; d = d->next) { \
 				d->k = v; \
-				for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) { \
+				for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) { \
 					if (n->client != NULL) { \
 						n->client->k = v; \
 					} \
@@ -1476,7 +1946,7 @@ void set_setting(coordinates_t loc, char *name, char *value, FILE *rsp)
 				m->k = v; \
 				for (desktop_t *d = m->desk_head; d != NULL; d = d->next) { \
 					d->k = v; \
-					for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) { \
+					for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) { \
 						if (n->client != NULL) { \
 							n->client->k = v; \
 						} \
@@ -1582,6 +2052,35 @@ void set_setting(coordinates_t loc, char *name, char *value, FILE *rsp)
 	SET_STR(external_rules_command)
 	SET_STR(status_prefix)
 #undef SET_STR
+	} else if (streq("journal_path", name)) {
+		if (snprintf(journal_path, sizeof(journal_path), "%s", value) < 0) {
+			fail(rsp, "");
+			return;
+		}
+		if (!journal_open()) {
+			fail(rsp, "config: %s: Can't write the journal at '%s'.\n", name, value);
+			return;
+		}
+	} else if (streq("trace_path", name)) {
+		if (snprintf(trace_path, sizeof(trace_path), "%s", value) < 0) {
+			fail(rsp, "");
+			return;
+		}
+		if (!trace_open()) {
+			fail(rsp, "config: %s: Can't write the trace at '%s'.\n", name, value);
+			return;
+		}
+	} else if (streq("journal_compaction_threshold", name)) {
+		if (sscanf(value, "%i", &journal_compaction_threshold) != 1) {
+			fail(rsp, "config: %s: Invalid value: '%s'.\n", name, value);
+			return;
+		}
+	} else if (streq("history_size_limit", name)) {
+		if (sscanf(value, "%i", &history_size_limit) != 1) {
+			fail(rsp, "config: %s: Invalid value: '%s'.\n", name, value);
+			return;
+		}
+		history_compact();
 	} else if (streq("split_ratio", name)) {
 		double r;
 		if (sscanf(value, "%lf", &r) == 1 && r > 0 && r < 1) {
@@ -1655,6 +2154,11 @@ void set_setting(coordinates_t loc, char *name, char *value, FILE *rsp)
 			fail(rsp, "config: %s: Invalid value: '%s'.\n", name, value);
 			return;
 		}
+	} else if (streq("node_title_interval", name)) {
+		if (sscanf(value, "%u", &node_title_interval) != 1) {
+			fail(rsp, "config: %s: Invalid value: '%s'.\n", name, value);
+			return;
+		}
 	} else if (streq("pointer_action1", name) ||
 	           streq("pointer_action2", name) ||
 	           streq("pointer_action3", name)) {
@@ -1710,6 +2214,9 @@ void set_setting(coordinates_t loc, char *name, char *value, FILE *rsp)
 					listen_enter_notify(d->root, focus_follows_pointer);
 				}
 			}
+			if (desktop_containers) {
+				update_desktop_containers();
+			}
 			if (focus_follows_pointer) {
 				update_motion_recorder();
 			} else {
@@ -1720,6 +2227,36 @@ void set_setting(coordinates_t loc, char *name, char *value, FILE *rsp)
 			fail(rsp, "config: %s: Invalid value: '%s'.\n", name, value);
 			return;
 		}
+	} else if (streq("desktop_containers", name)) {
+		bool b;
+		if (parse_bool(value, &b)) {
+			if (b == desktop_containers) {
+				fail(rsp, "");
+				return;
+			}
+			desktop_containers = b;
+			update_desktop_containers();
+			if (focus_follows_pointer) {
+				update_motion_recorder();
+			}
+		} else {
+			fail(rsp, "config: %s: Invalid value: '%s'.\n", name, value);
+			return;
+		}
+	} else if (streq("state_mirror", name)) {
+		bool b;
+		if (parse_bool(value, &b)) {
+			if (b && !mirror_open()) {
+				fail(rsp, "config: %s: Can't create the state mirror.\n", name);
+				return;
+			} else if (!b) {
+				mirror_close();
+			}
+			state_mirror = b;
+		} else {
+			fail(rsp, "config: %s: Invalid value: '%s'.\n", name, value);
+			return;
+		}
 #define SET_BOOL(s) \
 	} else if (streq(#s, name)) { \
 		if (!parse_bool(value, &s)) { \
@@ -1823,6 +2360,14 @@ void get_setting(coordinates_t loc, char *name, FILE* rsp)
 		fprintf(rsp, "%s", external_rules_command);
 	} else if (streq("status_prefix", name)) {
 		fprintf(rsp, "%s", status_prefix);
+	} else if (streq("journal_path", name)) {
+		fprintf(rsp, "%s", journal_path);
+	} else if (streq("trace_path", name)) {
+		fprintf(rsp, "%s", trace_path);
+	} else if (streq("journal_compaction_threshold", name)) {
+		fprintf(rsp, "%i", journal_compaction_threshold);
+	} else if (streq("history_size_limit", name)) {
+		fprintf(rsp, "%i", history_size_limit);
 	} else if (streq("initial_polarity", name)) {
 		fprintf(rsp, "%s", CHILD_POL_STR(initial_polarity));
 	} else if (streq("automatic_scheme", name)) {
@@ -1839,6 +2384,8 @@ void get_setting(coordinates_t loc, char *name, FILE* rsp)
 		print_button_index(click_to_focus, rsp);
 	} else if (streq("pointer_motion_interval", name)) {
 		fprintf(rsp, "%u", pointer_motion_interval);
+	} else if (streq("node_title_interval", name)) {
+		fprintf(rsp, "%u", node_title_interval);
 	} else if (streq("pointer_action1", name) ||
 	           streq("pointer_action2", name) ||
 	           streq("pointer_action3", name)) {
@@ -1860,6 +2407,8 @@ void get_setting(coordinates_t loc, char *name, FILE* rsp)
 	GET_BOOL(gapless_monocle)
 	GET_BOOL(single_monocle)
 	GET_BOOL(borderless_singleton)
+	GET_BOOL(desktop_containers)
+	GET_BOOL(state_mirror)
 	GET_BOOL(swallow_first_click)
 	GET_BOOL(focus_follows_pointer)
 	GET_BOOL(pointer_follows_focus)
@@ -27,16 +27,26 @@
 
 #include "types.h"
 #include "subscribe.h"
+#include "query.h"
 
 void handle_message(char *msg, int msg_len, FILE *rsp);
 void process_message(char **args, int num, FILE *rsp);
+void run_command(char **args, int num, FILE *rsp);
+void cmd_batch(char **args, int num, FILE *rsp);
+int split_arguments(char *line, char ***args_ptr);
+void run_commands_file(char *path);
 void cmd_node(char **args, int num, FILE *rsp);
+void node_commands(coordinates_t ref, coordinates_t trg, char **args, int num, FILE *rsp);
 void cmd_desktop(char **args, int num, FILE *rsp);
+void desktop_commands(coordinates_t ref, coordinates_t trg, char **args, int num, FILE *rsp);
+char **copy_arguments(char **args, int num);
+void run_for_each(domain_t dom, uint32_t *ids, int len, char **args, int num, FILE *rsp);
 void cmd_monitor(char **args, int num, FILE *rsp);
 void cmd_query(char **args, int num, FILE *rsp);
 void cmd_rule(char **args, int num, FILE *rsp);
 void cmd_wm(char **args, int num, FILE *rsp);
 void cmd_subscribe(char **args, int num, FILE *rsp);
+bool set_subscriber_filter(domain_t dom, char *desc, subscriber_filter_t *filter, FILE *rsp);
 void cmd_quit(char **args, int num, FILE *rsp);
 void cmd_config(char **args, int num, FILE *rsp);
 void set_setting(coordinates_t loc, char *name, char *value, FILE *rsp);
@@ -0,0 +1,223 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "bspwm.h"
+#include "tree.h"
+#include "mirror.h"
+
+static int mirror_fd = -1;
+static char *mirror_map = NULL;
+static size_t mirror_len = 0;
+char mirror_name[MAXLEN];
+static bool mirror_pending = false;
+
+bool mirror_open(void)
+{
+	if (mirror_fd != -1) {
+		return true;
+	}
+
+	if (mirror_name[0] == '\0') {
+		warn("Mirror: can't parse the display name.\n");
+		return false;
+	}
+
+	mirror_fd = shm_open(mirror_name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+	if (mirror_fd == -1) {
+		warn("Mirror: can't open '%s'.\n", mirror_name);
+		return false;
+	}
+
+	fcntl(mirror_fd, F_SETFD, FD_CLOEXEC | fcntl(mirror_fd, F_GETFD));
+	mirror_pending = true;
+	flush_state_mirror();
+	return mirror_map != NULL;
+}
+
+void mirror_close(void)
+{
+	if (mirror_fd == -1) {
+		return;
+	}
+	if (mirror_map != NULL) {
+		munmap(mirror_map, mirror_len);
+	}
+	close(mirror_fd);
+	shm_unlink(mirror_name);
+	mirror_fd = -1;
+	mirror_map = NULL;
+	mirror_len = 0;
+}
+
+void touch_state_mirror(void)
+{
+	mirror_pending = true;
+}
+
+/* Readers keep using their mapping while the object grows: it never shrinks. */
+static bool mirror_reserve(size_t size)
+{
+	if (size <= mirror_len) {
+		return true;
+	}
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t len = (mirror_len == 0 ? page : mirror_len);
+	while (len < size) {
+		len *= 2;
+	}
+	if (ftruncate(mirror_fd, len) == -1) {
+		return false;
+	}
+	char *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, mirror_fd, 0);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+	if (mirror_map != NULL) {
+		munmap(mirror_map, mirror_len);
+	}
+	mirror_map = map;
+	mirror_len = len;
+	return true;
+}
+
+static void copy_rectangle(mirror_rectangle_t *dst, xcb_rectangle_t src)
+{
+	dst->x = src.x;
+	dst->y = src.y;
+	dst->width = src.width;
+	dst->height = src.height;
+}
+
+static mirror_node_t *mirror_nodes(desktop_t *d, node_t *n, mirror_node_t *mn)
+{
+	if (n == NULL) {
+		return mn;
+	}
+	uint32_t flags = 0;
+	flags |= n->hidden ? MIRROR_NODE_HIDDEN : 0;
+	flags |= n->sticky ? MIRROR_NODE_STICKY : 0;
+	flags |= n->private ? MIRROR_NODE_PRIVATE : 0;
+	flags |= n->locked ? MIRROR_NODE_LOCKED : 0;
+	flags |= n->marked ? MIRROR_NODE_MARKED : 0;
+	flags |= n->vacant ? MIRROR_NODE_VACANT : 0;
+	flags |= (mon != NULL && n == mon->desk->focus) ? MIRROR_NODE_FOCUSED : 0;
+	mn->id = n->id;
+	mn->desktop_id = d->id;
+	mn->parent_id = n->parent != NULL ? n->parent->id : 0;
+	mn->split_type = n->split_type;
+	if (n->client != NULL) {
+		flags |= MIRROR_NODE_CLIENT;
+		flags |= n->client->urgent ? MIRROR_NODE_URGENT : 0;
+		mn->state = n->client->state;
+		mn->layer = n->client->layer;
+	} else {
+		mn->state = mn->layer = 0;
+	}
+	mn->flags = flags;
+	mn->reserved = 0;
+	copy_rectangle(&mn->rectangle, get_rectangle(NULL, NULL, n));
+	mn = mirror_nodes(d, n->first_child, mn + 1);
+	return mirror_nodes(d, n->second_child, mn);
+}
+
+static uint32_t count_nodes(node_t *n)
+{
+	if (n == NULL) {
+		return 0;
+	}
+	return 1 + count_nodes(n->first_child) + count_nodes(n->second_child);
+}
+
+void flush_state_mirror(void)
+{
+	if (mirror_fd == -1 || !mirror_pending) {
+		return;
+	}
+
+	uint32_t monitors_count = 0, desktops_count = 0, nodes_count = 0;
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		monitors_count++;
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			desktops_count++;
+			nodes_count += count_nodes(d->root);
+		}
+	}
+
+	size_t size = sizeof(mirror_header_t) + monitors_count * sizeof(mirror_monitor_t) +
+	              desktops_count * sizeof(mirror_desktop_t) + nodes_count * sizeof(mirror_node_t);
+
+	if (!mirror_reserve(size)) {
+		warn("Mirror: can't grow '%s'.\n", mirror_name);
+		return;
+	}
+
+	mirror_pending = false;
+
+	mirror_header_t *h = (mirror_header_t *) mirror_map;
+	uint32_t seq = h->magic == MIRROR_MAGIC ? h->sequence : 0;
+
+	__atomic_store_n(&h->sequence, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	h->magic = MIRROR_MAGIC;
+	h->version = MIRROR_VERSION;
+	h->size = size;
+	h->focused_monitor_id = mon != NULL ? mon->id : 0;
+	h->primary_monitor_id = pri_mon != NULL ? pri_mon->id : 0;
+	h->monitors_count = monitors_count;
+	h->desktops_count = desktops_count;
+	h->nodes_count = nodes_count;
+
+	mirror_monitor_t *mm = (mirror_monitor_t *) (h + 1);
+	mirror_desktop_t *md = (mirror_desktop_t *) (mm + monitors_count);
+	mirror_node_t *mn = (mirror_node_t *) (md + desktops_count);
+
+	for (monitor_t *m = mon_head; m != NULL; m = m->next, mm++) {
+		mm->id = m->id;
+		mm->focused_desktop_id = m->desk != NULL ? m->desk->id : 0;
+		mm->desktops_count = 0;
+		copy_rectangle(&mm->rectangle, m->rectangle);
+		snprintf(mm->name, sizeof(mm->name), "%s", m->name);
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next, md++) {
+			mirror_node_t *first = mn;
+			mn = mirror_nodes(d, d->root, mn);
+			md->id = d->id;
+			md->monitor_id = m->id;
+			md->focused_node_id = d->focus != NULL ? d->focus->id : 0;
+			md->nodes_count = mn - first;
+			md->layout = d->layout;
+			snprintf(md->name, sizeof(md->name), "%s", d->name);
+			mm->desktops_count++;
+		}
+	}
+
+	__atomic_store_n(&h->sequence, seq + 2, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,113 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BSPWM_MIRROR_H
+#define BSPWM_MIRROR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The layout of the state mirror, shared with its readers.
+ *
+ * The header is followed by the monitors, then the desktops grouped by
+ * monitor, then the nodes grouped by desktop, each tree in preorder. The
+ * writer increments `sequence` before and after updating the mirror: a
+ * reader copies `size` bytes while `sequence` is even, and retries if it
+ * changed in the meantime. The object only ever grows. */
+
+#define MIRROR_MAGIC     0x6D707362
+#define MIRROR_VERSION   1
+#define MIRROR_NAME_LEN  32
+
+typedef enum {
+	MIRROR_NODE_HIDDEN = 1 << 0,
+	MIRROR_NODE_STICKY = 1 << 1,
+	MIRROR_NODE_PRIVATE = 1 << 2,
+	MIRROR_NODE_LOCKED = 1 << 3,
+	MIRROR_NODE_MARKED = 1 << 4,
+	MIRROR_NODE_URGENT = 1 << 5,
+	MIRROR_NODE_VACANT = 1 << 6,
+	MIRROR_NODE_FOCUSED = 1 << 7,
+	MIRROR_NODE_CLIENT = 1 << 8
+} mirror_node_flag_t;
+
+typedef struct {
+	int16_t x;
+	int16_t y;
+	uint16_t width;
+	uint16_t height;
+} mirror_rectangle_t;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sequence;
+	uint32_t size;
+	uint32_t focused_monitor_id;
+	uint32_t primary_monitor_id;
+	uint32_t monitors_count;
+	uint32_t desktops_count;
+	uint32_t nodes_count;
+} mirror_header_t;
+
+typedef struct {
+	uint32_t id;
+	uint32_t focused_desktop_id;
+	uint32_t desktops_count;
+	mirror_rectangle_t rectangle;
+	char name[MIRROR_NAME_LEN];
+} mirror_monitor_t;
+
+/* `layout`, `state`, `layer` and `split_type` hold the values of the
+ * corresponding enumerations of types.h. */
+typedef struct {
+	uint32_t id;
+	uint32_t monitor_id;
+	uint32_t focused_node_id;
+	uint32_t nodes_count;
+	uint32_t layout;
+	char name[MIRROR_NAME_LEN];
+} mirror_desktop_t;
+
+typedef struct {
+	uint32_t id;
+	uint32_t desktop_id;
+	uint32_t parent_id;
+	uint32_t flags;
+	mirror_rectangle_t rectangle;
+	uint8_t state;
+	uint8_t layer;
+	uint8_t split_type;
+	uint8_t reserved;
+} mirror_node_t;
+
+/* Used by the window manager only. */
+extern char mirror_name[];
+
+bool mirror_open(void);
+void mirror_close(void);
+void touch_state_mirror(void);
+void flush_state_mirror(void);
+
+#endif
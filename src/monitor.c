@@ -28,15 +28,17 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "bspwm.h"
+#include "backend.h"
 #include "desktop.h"
 #include "ewmh.h"
 #include "query.h"
-#include "pointer.h"
 #include "settings.h"
 #include "geometry.h"
 #include "tree.h"
 #include "subscribe.h"
+#include "delta.h"
 #include "window.h"
+#include "registry.h"
 #include "monitor.h"
 
 monitor_t *make_monitor(const char *name, xcb_rectangle_t *rect, uint32_t id)
@@ -44,7 +46,7 @@ monitor_t *make_monitor(const char *name, xcb_rectangle_t *rect, uint32_t id)
 	monitor_t *m = calloc(1, sizeof(monitor_t));
 	// if id is not given, generate one
 	if (id == XCB_NONE) {
-		m->id = xcb_generate_id(dpy);
+		m->id = backend->generate_id();
 	}
 	m->randr_id = XCB_NONE;
 	// set the name to the given name, or the DEFAULT_MON_NAME if no name is given
@@ -58,6 +60,7 @@ monitor_t *make_monitor(const char *name, xcb_rectangle_t *rect, uint32_t id)
 	m->desk = m->desk_head = m->desk_tail = NULL;
 	m->wired = true;
 	m->sticky_count = 0;
+	m->sticky_head = m->sticky_tail = NULL;
 	if (rect != NULL) {
 		update_root(m, rect);
 	} else {
@@ -72,28 +75,29 @@ void update_root(monitor_t *m, xcb_rectangle_t *rect)
 	m->rectangle = *rect;
 	if (m->root == XCB_NONE) {
 		uint32_t values[] = {XCB_EVENT_MASK_ENTER_WINDOW};
-		m->root = xcb_generate_id(dpy);
-		xcb_create_window(dpy, XCB_COPY_FROM_PARENT, m->root, root,
-		                  rect->x, rect->y, rect->width, rect->height, 0,
-		                  XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT, XCB_CW_EVENT_MASK, values);
-		xcb_icccm_set_wm_class(dpy, m->root, sizeof(ROOT_WINDOW_IC), ROOT_WINDOW_IC);
-		xcb_icccm_set_wm_name(dpy, m->root, XCB_ATOM_STRING, 8, strlen(m->name), m->name);
+		m->root = backend->generate_id();
+		backend->create_window(m->root, root, *rect, XCB_WINDOW_CLASS_INPUT_ONLY, XCB_CW_EVENT_MASK, values);
+		set_wm_class(m->root, sizeof(ROOT_WINDOW_IC), ROOT_WINDOW_IC);
+		backend->change_property(m->root, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, strlen(m->name), m->name);
 		window_lower(m->root);
 		if (focus_follows_pointer) {
 			window_show(m->root);
 		}
 	} else {
 		window_move_resize(m->root, rect->x, rect->y, rect->width, rect->height);
-		put_status(SBSC_MASK_MONITOR_GEOMETRY, "monitor_geometry 0x%08X %ux%u+%i+%i\n",
+		put_status_in(SBSC_MASK_MONITOR_GEOMETRY, &(coordinates_t) {m, NULL, NULL}, NULL, "monitor_geometry 0x%08X %ux%u+%i+%i\n",
 		           m->id, rect->width, rect->height, rect->x, rect->y);
 	}
 	for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-		for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+		for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 			if (n->client == NULL) {
 				continue;
 			}
 			adapt_geometry(&last_rect, rect, n);
 		}
+		if (d->container != XCB_NONE) {
+			reshape_container(m, d);
+		}
 		arrange(m, d);
 	}
 	reorder_monitor(m);
@@ -118,22 +122,19 @@ void reorder_monitor(monitor_t *m)
 
 void rename_monitor(monitor_t *m, const char *name)
 {
-	put_status(SBSC_MASK_MONITOR_RENAME, "monitor_rename 0x%08X %s %s\n", m->id, m->name, name);
+	put_status_in(SBSC_MASK_MONITOR_RENAME, &(coordinates_t) {m, NULL, NULL}, NULL, "monitor_rename 0x%08X %s %s\n", m->id, m->name, name);
 
+	unregister_monitor(m);
 	snprintf(m->name, sizeof(m->name), "%s", name);
-	xcb_icccm_set_wm_name(dpy, m->root, XCB_ATOM_STRING, 8, strlen(m->name), m->name);
+	register_monitor(m);
+	backend->change_property(m->root, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, strlen(m->name), m->name);
 
 	put_status(SBSC_MASK_REPORT);
 }
 
 monitor_t *find_monitor(uint32_t id)
 {
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		if (m->id == id) {
-			return m;
-		}
-	}
-	return NULL;
+	return registered_monitor(id);
 }
 
 monitor_t *get_monitor_by_randr_id(xcb_randr_output_t id)
@@ -229,7 +230,9 @@ void add_monitor(monitor_t *m)
 		}
 	}
 
-	put_status(SBSC_MASK_MONITOR_ADD, "monitor_add 0x%08X %s %ux%u+%i+%i\n", m->id, m->name, r.width, r.height, r.x, r.y);
+	register_monitor(m);
+
+	put_status_in(SBSC_MASK_MONITOR_ADD, &(coordinates_t) {m, NULL, NULL}, NULL, "monitor_add 0x%08X %s %ux%u+%i+%i\n", m->id, m->name, r.width, r.height, r.x, r.y);
 
 	put_status(SBSC_MASK_REPORT);
 }
@@ -262,11 +265,13 @@ void unlink_monitor(monitor_t *m)
 	if (mon == m) {
 		mon = NULL;
 	}
+
+	invalidate_desktop_order();
 }
 
 void remove_monitor(monitor_t *m)
 {
-	put_status(SBSC_MASK_MONITOR_REMOVE, "monitor_remove 0x%08X\n", m->id);
+	put_status_in(SBSC_MASK_MONITOR_REMOVE, &(coordinates_t) {m, NULL, NULL}, NULL, "monitor_remove 0x%08X\n", m->id);
 
 	while (m->desk_head != NULL) {
 		remove_desktop(m, m->desk_head);
@@ -275,7 +280,9 @@ void remove_monitor(monitor_t *m)
 	monitor_t *last_mon = mon;
 
 	unlink_monitor(m);
-	xcb_destroy_window(dpy, m->root);
+	unregister_monitor(m);
+	backend->destroy_window(m->root);
+	tree_delta_removed("monitor", m->id, &m->delta);
 	free(m);
 
 	if (mon != last_mon) {
@@ -305,7 +312,7 @@ bool swap_monitors(monitor_t *m1, monitor_t *m2)
 		return false;
 	}
 
-	put_status(SBSC_MASK_MONITOR_SWAP, "monitor_swap 0x%08X 0x%08X\n", m1->id, m2->id);
+	put_status_in(SBSC_MASK_MONITOR_SWAP, &(coordinates_t) {m1, NULL, NULL}, &(coordinates_t) {m2, NULL, NULL}, "monitor_swap 0x%08X 0x%08X\n", m1->id, m2->id);
 
 	if (mon_head == m1) {
 		mon_head = m2;
@@ -340,6 +347,7 @@ bool swap_monitors(monitor_t *m1, monitor_t *m2)
 	m1->next = n2 == m1 ? m2 : n2;
 	m2->prev = p1 == m2 ? m1 : p1;
 	m2->next = n1 == m2 ? m1 : n1;
+	invalidate_desktop_order();
 
 	ewmh_update_wm_desktops();
 	ewmh_update_desktop_names();
@@ -441,120 +449,3 @@ bool find_any_monitor(coordinates_t *ref, coordinates_t *dst, monitor_select_t *
 	return false;
 }
 
-bool update_monitors(void)
-{
-	xcb_randr_get_screen_resources_reply_t *sres = xcb_randr_get_screen_resources_reply(dpy, xcb_randr_get_screen_resources(dpy, root), NULL);
-	if (sres == NULL) {
-		return false;
-	}
-
-	monitor_t *last_wired = NULL;
-
-	int len = xcb_randr_get_screen_resources_outputs_length(sres);
-	xcb_randr_output_t *outputs = xcb_randr_get_screen_resources_outputs(sres);
-
-	xcb_randr_get_output_info_cookie_t cookies[len];
-	for (int i = 0; i < len; i++) {
-		cookies[i] = xcb_randr_get_output_info(dpy, outputs[i], XCB_CURRENT_TIME);
-	}
-
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		m->wired = false;
-	}
-
-	for (int i = 0; i < len; i++) {
-		xcb_randr_get_output_info_reply_t *info = xcb_randr_get_output_info_reply(dpy, cookies[i], NULL);
-		if (info != NULL) {
-			if (info->crtc != XCB_NONE) {
-				xcb_randr_get_crtc_info_reply_t *cir = xcb_randr_get_crtc_info_reply(dpy, xcb_randr_get_crtc_info(dpy, info->crtc, XCB_CURRENT_TIME), NULL);
-				if (cir != NULL) {
-					xcb_rectangle_t rect = (xcb_rectangle_t) {cir->x, cir->y, cir->width, cir->height};
-					last_wired = get_monitor_by_randr_id(outputs[i]);
-					if (last_wired != NULL) {
-						update_root(last_wired, &rect);
-						last_wired->wired = true;
-					} else {
-						char *name = (char *) xcb_randr_get_output_info_name(info);
-						size_t len = (size_t) xcb_randr_get_output_info_name_length(info);
-						char *name_copy = copy_string(name, len);
-						last_wired = make_monitor(name_copy, &rect, XCB_NONE);
-						free(name_copy);
-						last_wired->randr_id = outputs[i];
-						add_monitor(last_wired);
-					}
-				}
-				free(cir);
-			} else if (!remove_disabled_monitors && info->connection != XCB_RANDR_CONNECTION_DISCONNECTED) {
-				monitor_t *m = get_monitor_by_randr_id(outputs[i]);
-				if (m != NULL) {
-					m->wired = true;
-				}
-			}
-		}
-		free(info);
-	}
-
-	xcb_randr_get_output_primary_reply_t *gpo = xcb_randr_get_output_primary_reply(dpy, xcb_randr_get_output_primary(dpy, root), NULL);
-	if (gpo != NULL) {
-		pri_mon = get_monitor_by_randr_id(gpo->output);
-	}
-	free(gpo);
-
-	/* handle overlapping monitors */
-	if (merge_overlapping_monitors) {
-		monitor_t *m = mon_head;
-		while (m != NULL) {
-			monitor_t *next = m->next;
-			if (m->wired) {
-				monitor_t *mb = mon_head;
-				while (mb != NULL) {
-					monitor_t *mb_next = mb->next;
-					if (m != mb && mb->wired && contains(m->rectangle, mb->rectangle)) {
-						if (last_wired == mb) {
-							last_wired = m;
-						}
-						if (next == mb) {
-							next = mb_next;
-						}
-						merge_monitors(mb, m);
-						remove_monitor(mb);
-					}
-					mb = mb_next;
-				}
-			}
-			m = next;
-		}
-	}
-
-	/* merge and remove disconnected monitors */
-	if (remove_unplugged_monitors) {
-		monitor_t *m = mon_head;
-		while (m != NULL) {
-			monitor_t *next = m->next;
-			if (!m->wired) {
-				merge_monitors(m, last_wired);
-				remove_monitor(m);
-			}
-			m = next;
-		}
-	}
-
-	/* add one desktop to each new monitor */
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		if (m->desk == NULL) {
-			add_desktop(m, make_desktop(NULL, XCB_NONE));
-		}
-	}
-
-	if (!running && mon != NULL) {
-		if (pri_mon != NULL) {
-			mon = pri_mon;
-		}
-		center_pointer(mon->rectangle);
-		ewmh_update_current_desktop();
-	}
-
-	free(sres);
-
-	return (mon != NULL);
-}
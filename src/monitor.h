@@ -148,6 +148,5 @@ monitor_t *monitor_from_client(client_t *c);
  */
 monitor_t *nearest_monitor(monitor_t *m, direction_t dir, monitor_select_t *sel);
 bool find_any_monitor(coordinates_t *ref, coordinates_t *dst, monitor_select_t *sel);
-bool update_monitors(void);
 
 #endif
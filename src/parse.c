@@ -61,10 +61,53 @@ bool parse_layout(char *s, layout_t *l)
 	} else if (streq("tiled", s)) {
 		*l = LAYOUT_TILED;
 		return true;
+	} else if (streq("master_stack", s)) {
+		*l = LAYOUT_MASTER_STACK;
+		return true;
+	} else if (streq("centered_master", s)) {
+		*l = LAYOUT_CENTERED_MASTER;
+		return true;
+	} else if (streq("grid", s)) {
+		*l = LAYOUT_GRID;
+		return true;
 	}
 	return false;
 }
 
+const char *layout_str(layout_t l)
+{
+	switch (l) {
+		case LAYOUT_TILED:
+			return "tiled";
+		case LAYOUT_MONOCLE:
+			return "monocle";
+		case LAYOUT_MASTER_STACK:
+			return "master_stack";
+		case LAYOUT_CENTERED_MASTER:
+			return "centered_master";
+		case LAYOUT_GRID:
+			return "grid";
+	}
+	return "tiled";
+}
+
+char layout_chr(layout_t l)
+{
+	switch (l) {
+		case LAYOUT_TILED:
+			return 'T';
+		case LAYOUT_MONOCLE:
+			return 'M';
+		case LAYOUT_MASTER_STACK:
+			return 'S';
+		case LAYOUT_CENTERED_MASTER:
+			return 'C';
+		case LAYOUT_GRID:
+			return 'G';
+	}
+	return 'T';
+}
+
 bool parse_client_state(char *s, client_state_t *t)
 {
 	if (streq("tiled", s)) {
@@ -440,6 +483,8 @@ bool parse_subscriber_mask(char *s, subscriber_mask_t *mask)
 		*mask = SBSC_MASK_NODE_FLAG;
 	} else if (streq("node_layer", s)) {
 		*mask = SBSC_MASK_NODE_LAYER;
+	} else if (streq("node_title", s)) {
+		*mask = SBSC_MASK_NODE_TITLE;
 	} else if (streq("desktop_add", s)) {
 		*mask = SBSC_MASK_DESKTOP_ADD;
 	} else if (streq("desktop_rename", s)) {
@@ -470,6 +515,8 @@ bool parse_subscriber_mask(char *s, subscriber_mask_t *mask)
 		*mask = SBSC_MASK_MONITOR_GEOMETRY;
 	} else if (streq("report", s)) {
 		*mask = SBSC_MASK_REPORT;
+	} else if (streq("tree_delta", s)) {
+		*mask = SBSC_MASK_TREE_DELTA;
 	} else {
 		return false;
 	}
@@ -517,8 +564,14 @@ bool parse_desktop_modifiers(char *desc, desktop_select_t *sel)
 		GET_MOD(local)
 		GET_MOD(tiled)
 		GET_MOD(monocle)
+		GET_MOD(master_stack)
+		GET_MOD(centered_master)
+		GET_MOD(grid)
 		GET_MOD(user_tiled)
 		GET_MOD(user_monocle)
+		GET_MOD(user_master_stack)
+		GET_MOD(user_centered_master)
+		GET_MOD(user_grid)
 		} else {
 			return false;
 		}
@@ -527,6 +580,14 @@ bool parse_desktop_modifiers(char *desc, desktop_select_t *sel)
 
 }
 
+#define GET_NODE_MOD(k, f) \
+	} else if (streq(#k, tok)) { \
+		sel->mask |= (f); \
+		sel->value |= (f); \
+	} else if (streq("!" #k, tok)) { \
+		sel->mask |= (f); \
+		sel->value &= ~(f);
+
 bool parse_node_modifiers(char *desc, node_select_t *sel)
 {
 	char *tok;
@@ -534,32 +595,34 @@ bool parse_node_modifiers(char *desc, node_select_t *sel)
 		tok[0] = '\0';
 		tok++;
 		if (streq("tiled", tok)) {
-			sel->tiled = OPTION_TRUE;
+			sel->mask |= NODE_FLAG_TILED;
+			sel->value |= NODE_FLAG_TILED;
 		} else if (streq("!tiled", tok)) {
-			sel->tiled = OPTION_FALSE;
-		GET_MOD(automatic)
-		GET_MOD(focused)
-		GET_MOD(active)
-		GET_MOD(local)
-		GET_MOD(leaf)
-		GET_MOD(window)
-		GET_MOD(pseudo_tiled)
-		GET_MOD(floating)
-		GET_MOD(fullscreen)
-		GET_MOD(hidden)
-		GET_MOD(sticky)
-		GET_MOD(private)
-		GET_MOD(locked)
-		GET_MOD(marked)
-		GET_MOD(urgent)
-		GET_MOD(same_class)
-		GET_MOD(descendant_of)
-		GET_MOD(ancestor_of)
-		GET_MOD(below)
-		GET_MOD(normal)
-		GET_MOD(above)
-		GET_MOD(horizontal)
-		GET_MOD(vertical)
+			sel->mask |= NODE_FLAG_TILED;
+			sel->value &= ~NODE_FLAG_TILED;
+		GET_NODE_MOD(automatic, NODE_FLAG_AUTOMATIC)
+		GET_NODE_MOD(focused, NODE_FLAG_FOCUSED)
+		GET_NODE_MOD(active, NODE_FLAG_ACTIVE | NODE_FLAG_ACTIVE_DESKTOP)
+		GET_NODE_MOD(local, NODE_FLAG_LOCAL)
+		GET_NODE_MOD(leaf, NODE_FLAG_LEAF)
+		GET_NODE_MOD(window, NODE_FLAG_WINDOW)
+		GET_NODE_MOD(pseudo_tiled, NODE_FLAG_PSEUDO_TILED)
+		GET_NODE_MOD(floating, NODE_FLAG_FLOATING)
+		GET_NODE_MOD(fullscreen, NODE_FLAG_FULLSCREEN)
+		GET_NODE_MOD(hidden, NODE_FLAG_HIDDEN)
+		GET_NODE_MOD(sticky, NODE_FLAG_STICKY)
+		GET_NODE_MOD(private, NODE_FLAG_PRIVATE)
+		GET_NODE_MOD(locked, NODE_FLAG_LOCKED)
+		GET_NODE_MOD(marked, NODE_FLAG_MARKED)
+		GET_NODE_MOD(urgent, NODE_FLAG_URGENT)
+		GET_NODE_MOD(same_class, NODE_FLAG_SAME_CLASS)
+		GET_NODE_MOD(descendant_of, NODE_FLAG_DESCENDANT_OF)
+		GET_NODE_MOD(ancestor_of, NODE_FLAG_ANCESTOR_OF)
+		GET_NODE_MOD(below, NODE_FLAG_BELOW)
+		GET_NODE_MOD(normal, NODE_FLAG_NORMAL)
+		GET_NODE_MOD(above, NODE_FLAG_ABOVE)
+		GET_NODE_MOD(horizontal, NODE_FLAG_HORIZONTAL)
+		GET_NODE_MOD(vertical, NODE_FLAG_VERTICAL)
 		} else {
 			return false;
 		}
@@ -567,4 +630,5 @@ bool parse_node_modifiers(char *desc, node_select_t *sel)
 	return true;
 }
 
+#undef GET_NODE_MOD
 #undef GET_MOD
@@ -40,9 +40,6 @@ uint16_t num_lock;
 uint16_t caps_lock;
 uint16_t scroll_lock;
 
-bool grabbing;
-node_t *grabbed_node;
-
 void pointer_init(void)
 {
 	num_lock = modfield_from_keysym(XK_Num_Lock);
@@ -101,7 +98,7 @@ void grab_buttons(void)
 {
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
 		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 				window_grab_buttons(n->id);
 				if (n->presel != NULL) {
 					window_grab_buttons(n->presel->feedback);
@@ -115,7 +112,7 @@ void ungrab_buttons(void)
 {
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
 		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 				xcb_ungrab_button(dpy, XCB_BUTTON_INDEX_ANY, n->id, XCB_MOD_MASK_ANY);
 			}
 		}
@@ -246,11 +243,11 @@ bool grab_pointer(pointer_action_t pac)
 	free(reply);
 
 	if (pac == ACTION_MOVE) {
-		put_status(SBSC_MASK_POINTER_ACTION, "pointer_action 0x%08X 0x%08X 0x%08X move begin\n", loc.monitor->id, loc.desktop->id, loc.node->id);
+		put_status_in(SBSC_MASK_POINTER_ACTION, &loc, NULL, "pointer_action 0x%08X 0x%08X 0x%08X move begin\n", loc.monitor->id, loc.desktop->id, loc.node->id);
 	} else if (pac == ACTION_RESIZE_CORNER) {
-		put_status(SBSC_MASK_POINTER_ACTION, "pointer_action 0x%08X 0x%08X 0x%08X resize_corner begin\n", loc.monitor->id, loc.desktop->id, loc.node->id);
+		put_status_in(SBSC_MASK_POINTER_ACTION, &loc, NULL, "pointer_action 0x%08X 0x%08X 0x%08X resize_corner begin\n", loc.monitor->id, loc.desktop->id, loc.node->id);
 	} else if (pac == ACTION_RESIZE_SIDE) {
-		put_status(SBSC_MASK_POINTER_ACTION, "pointer_action 0x%08X 0x%08X 0x%08X resize_side begin\n", loc.monitor->id, loc.desktop->id, loc.node->id);
+		put_status_in(SBSC_MASK_POINTER_ACTION, &loc, NULL, "pointer_action 0x%08X 0x%08X 0x%08X resize_side begin\n", loc.monitor->id, loc.desktop->id, loc.node->id);
 	}
 
 	track_pointer(loc, pac, pos);
@@ -314,26 +311,26 @@ void track_pointer(coordinates_t loc, pointer_action_t pac, xcb_point_t pos)
 	}
 
 	if (pac == ACTION_MOVE) {
-		put_status(SBSC_MASK_POINTER_ACTION, "pointer_action 0x%08X 0x%08X 0x%08X move end\n", loc.monitor->id, loc.desktop->id, n->id);
+		put_status_in(SBSC_MASK_POINTER_ACTION, &(coordinates_t) {loc.monitor, loc.desktop, n}, NULL, "pointer_action 0x%08X 0x%08X 0x%08X move end\n", loc.monitor->id, loc.desktop->id, n->id);
 	} else if (pac == ACTION_RESIZE_CORNER) {
-		put_status(SBSC_MASK_POINTER_ACTION, "pointer_action 0x%08X 0x%08X 0x%08X resize_corner end\n", loc.monitor->id, loc.desktop->id, n->id);
+		put_status_in(SBSC_MASK_POINTER_ACTION, &(coordinates_t) {loc.monitor, loc.desktop, n}, NULL, "pointer_action 0x%08X 0x%08X 0x%08X resize_corner end\n", loc.monitor->id, loc.desktop->id, n->id);
 	} else if (pac == ACTION_RESIZE_SIDE) {
-		put_status(SBSC_MASK_POINTER_ACTION, "pointer_action 0x%08X 0x%08X 0x%08X resize_side end\n", loc.monitor->id, loc.desktop->id, n->id);
+		put_status_in(SBSC_MASK_POINTER_ACTION, &(coordinates_t) {loc.monitor, loc.desktop, n}, NULL, "pointer_action 0x%08X 0x%08X 0x%08X resize_side end\n", loc.monitor->id, loc.desktop->id, n->id);
 	}
 
 	xcb_rectangle_t r = get_rectangle(NULL, NULL, n);
 
-	put_status(SBSC_MASK_NODE_GEOMETRY, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc.monitor->id, loc.desktop->id, loc.node->id, r.width, r.height, r.x, r.y);
+	put_status_in(SBSC_MASK_NODE_GEOMETRY, &loc, NULL, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc.monitor->id, loc.desktop->id, loc.node->id, r.width, r.height, r.x, r.y);
 
 	if ((pac == ACTION_MOVE && IS_TILED(n->client)) ||
 	    ((pac == ACTION_RESIZE_CORNER || pac == ACTION_RESIZE_SIDE) &&
 	     n->client->state == STATE_TILED)) {
-		for (node_t *f = first_extrema(loc.desktop->root); f != NULL; f = next_leaf(f, loc.desktop->root)) {
+		for (node_t *f = loc.desktop->leaf_head; f != NULL; f = f->leaf_next) {
 			if (f == n || f->client == NULL || !IS_TILED(f->client)) {
 				continue;
 			}
 			xcb_rectangle_t r = f->client->tiled_rectangle;
-			put_status(SBSC_MASK_NODE_GEOMETRY, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc.monitor->id, loc.desktop->id, f->id, r.width, r.height, r.x, r.y);
+			put_status_in(SBSC_MASK_NODE_GEOMETRY, &(coordinates_t) {loc.monitor, loc.desktop, f}, NULL, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc.monitor->id, loc.desktop->id, f->id, r.width, r.height, r.x, r.y);
 		}
 	}
 }
@@ -33,9 +33,6 @@ extern uint16_t num_lock;
 extern uint16_t caps_lock;
 extern uint16_t scroll_lock;
 
-extern bool grabbing;
-extern node_t *grabbed_node;
-
 void pointer_init(void);
 void window_grab_buttons(xcb_window_t win);
 void window_grab_button(xcb_window_t win, uint8_t button, uint16_t modifier);
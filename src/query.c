@@ -32,6 +32,8 @@
 #include "monitor.h"
 #include "window.h"
 #include "tree.h"
+#include "registry.h"
+#include "selector.h"
 #include "query.h"
 #include "geometry.h"
 
@@ -66,87 +68,119 @@ void query_state(FILE *rsp)
 	fprintf(rsp, "}");
 }
 
+static bool query_key(query_projection_t *proj, const char *key, bool *first, FILE *rsp)
+{
+	if (proj != NULL && proj->fields != NULL) {
+		bool found = false;
+		for (int i = 0; i < proj->fields_count && !found; i++) {
+			found = streq(proj->fields[i], key);
+		}
+		if (!found) {
+			return false;
+		}
+	}
+	fprintf(rsp, "%s\"%s\":", *first ? "" : ",", key);
+	*first = false;
+	return true;
+}
+
 void query_monitor(monitor_t *m, FILE *rsp)
 {
+	query_monitor_fields(m, NULL, 0, rsp);
+}
+
+void query_desktop(desktop_t *d, FILE *rsp)
+{
+	query_desktop_fields(d, NULL, 0, rsp);
+}
+
+void query_node(node_t *n, FILE *rsp)
+{
+	query_node_fields(n, NULL, 0, rsp);
+}
+
+void query_client(client_t *c, FILE *rsp)
+{
+	query_client_fields(c, NULL, rsp);
+}
+
+/* Print the key if it belongs to the projection: the structural keys are
+ * always printed, as long as the depth limit isn't reached. */
+#define QUERY_KEY(k)    if (query_key(proj, k, &first, rsp))
+#define QUERY_CHILD(k)  if (deeper && query_key(NULL, k, &first, rsp))
+#define DEEPER(proj, depth)  ((proj) == NULL || (proj)->depth < 0 || (depth) < (proj)->depth)
+
+void query_monitor_fields(monitor_t *m, query_projection_t *proj, int depth, FILE *rsp)
+{
+	bool first = true;
+	bool deeper = DEEPER(proj, depth);
 	fprintf(rsp, "{");
-	fprintf(rsp, "\"name\":\"%s\",", m->name);
-	fprintf(rsp, "\"id\":%u,", m->id);
-	fprintf(rsp, "\"randrId\":%u,", m->randr_id);
-	fprintf(rsp, "\"wired\":%s,", BOOL_STR(m->wired));
-	fprintf(rsp, "\"stickyCount\":%i,", m->sticky_count);
-	fprintf(rsp, "\"windowGap\":%i,", m->window_gap);
-	fprintf(rsp, "\"borderWidth\":%u,", m->border_width);
-	fprintf(rsp, "\"focusedDesktopId\":%u,", m->desk->id);
-	fprintf(rsp, "\"padding\":");
-	query_padding(m->padding, rsp);
-	fprintf(rsp,",");
-	fprintf(rsp, "\"rectangle\":");
-	query_rectangle(m->rectangle, rsp);
-	fprintf(rsp,",");
-	fprintf(rsp, "\"desktops\":");
-	fprintf(rsp, "[");
-	for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-		query_desktop(d, rsp);
-		if (d->next != NULL) {
-			fprintf(rsp,",");
+	QUERY_KEY("name") fprintf(rsp, "\"%s\"", m->name);
+	QUERY_KEY("id") fprintf(rsp, "%u", m->id);
+	QUERY_KEY("randrId") fprintf(rsp, "%u", m->randr_id);
+	QUERY_KEY("wired") fprintf(rsp, "%s", BOOL_STR(m->wired));
+	QUERY_KEY("stickyCount") fprintf(rsp, "%i", m->sticky_count);
+	QUERY_KEY("windowGap") fprintf(rsp, "%i", m->window_gap);
+	QUERY_KEY("borderWidth") fprintf(rsp, "%u", m->border_width);
+	QUERY_KEY("focusedDesktopId") fprintf(rsp, "%u", m->desk->id);
+	QUERY_KEY("padding") query_padding(m->padding, rsp);
+	QUERY_KEY("rectangle") query_rectangle(m->rectangle, rsp);
+	QUERY_CHILD("desktops") {
+		fprintf(rsp, "[");
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			query_desktop_fields(d, proj, depth + 1, rsp);
+			if (d->next != NULL) {
+				fprintf(rsp,",");
+			}
 		}
+		fprintf(rsp, "]");
 	}
-	fprintf(rsp, "]");
 	fprintf(rsp, "}");
 }
 
-void query_desktop(desktop_t *d, FILE *rsp)
+void query_desktop_fields(desktop_t *d, query_projection_t *proj, int depth, FILE *rsp)
 {
+	bool first = true;
+	bool deeper = DEEPER(proj, depth);
 	fprintf(rsp, "{");
-	fprintf(rsp, "\"name\":\"%s\",", d->name);
-	fprintf(rsp, "\"id\":%u,", d->id);
-	fprintf(rsp, "\"layout\":\"%s\",", LAYOUT_STR(d->layout));
-	fprintf(rsp, "\"userLayout\":\"%s\",", LAYOUT_STR(d->user_layout));
-	fprintf(rsp, "\"windowGap\":%i,", d->window_gap);
-	fprintf(rsp, "\"borderWidth\":%u,", d->border_width);
-	fprintf(rsp, "\"focusedNodeId\":%u,", d->focus != NULL ? d->focus->id : 0);
-	fprintf(rsp, "\"padding\":");
-	query_padding(d->padding, rsp);
-	fprintf(rsp,",");
-	fprintf(rsp, "\"root\":");
-	query_node(d->root, rsp);
+	QUERY_KEY("name") fprintf(rsp, "\"%s\"", d->name);
+	QUERY_KEY("id") fprintf(rsp, "%u", d->id);
+	QUERY_KEY("layout") fprintf(rsp, "\"%s\"", layout_str(d->layout));
+	QUERY_KEY("userLayout") fprintf(rsp, "\"%s\"", layout_str(d->user_layout));
+	QUERY_KEY("windowGap") fprintf(rsp, "%i", d->window_gap);
+	QUERY_KEY("borderWidth") fprintf(rsp, "%u", d->border_width);
+	QUERY_KEY("focusedNodeId") fprintf(rsp, "%u", d->focus != NULL ? d->focus->id : 0);
+	QUERY_KEY("padding") query_padding(d->padding, rsp);
+	QUERY_CHILD("root") query_node_fields(d->root, proj, depth + 1, rsp);
 	fprintf(rsp, "}");
 }
 
-void query_node(node_t *n, FILE *rsp)
+void query_node_fields(node_t *n, query_projection_t *proj, int depth, FILE *rsp)
 {
 	if (n == NULL) {
 		fprintf(rsp, "null");
-	} else {
-		fprintf(rsp, "{");
-		fprintf(rsp, "\"id\":%u,", n->id);
-		fprintf(rsp, "\"splitType\":\"%s\",", SPLIT_TYPE_STR(n->split_type));
-		fprintf(rsp, "\"splitRatio\":%lf,", n->split_ratio);
-		fprintf(rsp, "\"vacant\":%s,", BOOL_STR(n->vacant));
-		fprintf(rsp, "\"hidden\":%s,", BOOL_STR(n->hidden));
-		fprintf(rsp, "\"sticky\":%s,", BOOL_STR(n->sticky));
-		fprintf(rsp, "\"private\":%s,", BOOL_STR(n->private));
-		fprintf(rsp, "\"locked\":%s,", BOOL_STR(n->locked));
-		fprintf(rsp, "\"marked\":%s,", BOOL_STR(n->marked));
-		fprintf(rsp, "\"presel\":");
-		query_presel(n->presel, rsp);
-		fprintf(rsp,",");
-		fprintf(rsp, "\"rectangle\":");
-		query_rectangle(n->rectangle, rsp);
-		fprintf(rsp,",");
-		fprintf(rsp, "\"constraints\":");
-		query_constraints(n->constraints, rsp);
-		fprintf(rsp,",");
-		fprintf(rsp, "\"firstChild\":");
-		query_node(n->first_child, rsp);
-		fprintf(rsp,",");
-		fprintf(rsp, "\"secondChild\":");
-		query_node(n->second_child, rsp);
-		fprintf(rsp,",");
-		fprintf(rsp, "\"client\":");
-		query_client(n->client, rsp);
-		fprintf(rsp, "}");
+		return;
 	}
+	bool first = true;
+	bool deeper = DEEPER(proj, depth);
+	fprintf(rsp, "{");
+	QUERY_KEY("id") fprintf(rsp, "%u", n->id);
+	QUERY_KEY("splitType") fprintf(rsp, "\"%s\"", SPLIT_TYPE_STR(n->split_type));
+	QUERY_KEY("splitRatio") fprintf(rsp, "%lf", n->split_ratio);
+	QUERY_KEY("vacant") fprintf(rsp, "%s", BOOL_STR(n->vacant));
+	QUERY_KEY("hidden") fprintf(rsp, "%s", BOOL_STR(n->hidden));
+	QUERY_KEY("sticky") fprintf(rsp, "%s", BOOL_STR(n->sticky));
+	QUERY_KEY("private") fprintf(rsp, "%s", BOOL_STR(n->private));
+	QUERY_KEY("locked") fprintf(rsp, "%s", BOOL_STR(n->locked));
+	QUERY_KEY("marked") fprintf(rsp, "%s", BOOL_STR(n->marked));
+	QUERY_KEY("presel") query_presel(n->presel, rsp);
+	QUERY_KEY("rectangle") query_rectangle(n->rectangle, rsp);
+	QUERY_KEY("constraints") query_constraints(n->constraints, rsp);
+	QUERY_CHILD("firstChild") query_node_fields(n->first_child, proj, depth + 1, rsp);
+	QUERY_CHILD("secondChild") query_node_fields(n->second_child, proj, depth + 1, rsp);
+	query_key(NULL, "client", &first, rsp);
+	query_client_fields(n->client, proj, rsp);
+	fprintf(rsp, "}");
 }
 
 void query_presel(presel_t *p, FILE *rsp)
@@ -158,35 +192,52 @@ void query_presel(presel_t *p, FILE *rsp)
 	}
 }
 
-void query_client(client_t *c, FILE *rsp)
+void query_client_fields(client_t *c, query_projection_t *proj, FILE *rsp)
 {
 	if (c == NULL) {
 		fprintf(rsp, "null");
-	} else {
-		fprintf(rsp, "{");
-		fprintf(rsp, "\"className\":\"%s\",", c->class_name);
-		fprintf(rsp, "\"instanceName\":\"%s\",", c->instance_name);
-		fprintf(rsp, "\"borderWidth\":%u,", c->border_width);
-		fprintf(rsp, "\"state\":\"%s\",", STATE_STR(c->state));
-		fprintf(rsp, "\"lastState\":\"%s\",", STATE_STR(c->last_state));
-		fprintf(rsp, "\"layer\":\"%s\",", LAYER_STR(c->layer));
-		fprintf(rsp, "\"lastLayer\":\"%s\",", LAYER_STR(c->last_layer));
-		fprintf(rsp, "\"urgent\":%s,", BOOL_STR(c->urgent));
-		fprintf(rsp, "\"shown\":%s,", BOOL_STR(c->shown));
-		fprintf(rsp, "\"tiledRectangle\":");
-		query_rectangle(c->tiled_rectangle, rsp);
-		fprintf(rsp,",");
-		fprintf(rsp, "\"floatingRectangle\":");
-		query_rectangle(c->floating_rectangle, rsp);
-		fprintf(rsp, "}");
+		return;
 	}
+	bool first = true;
+	fprintf(rsp, "{");
+	QUERY_KEY("className") fprintf(rsp, "\"%s\"", c->class_name);
+	QUERY_KEY("instanceName") fprintf(rsp, "\"%s\"", c->instance_name);
+	QUERY_KEY("title") query_string(c->name, rsp);
+	QUERY_KEY("borderWidth") fprintf(rsp, "%u", c->border_width);
+	QUERY_KEY("state") fprintf(rsp, "\"%s\"", STATE_STR(c->state));
+	QUERY_KEY("lastState") fprintf(rsp, "\"%s\"", STATE_STR(c->last_state));
+	QUERY_KEY("layer") fprintf(rsp, "\"%s\"", LAYER_STR(c->layer));
+	QUERY_KEY("lastLayer") fprintf(rsp, "\"%s\"", LAYER_STR(c->last_layer));
+	QUERY_KEY("urgent") fprintf(rsp, "%s", BOOL_STR(c->urgent));
+	QUERY_KEY("shown") fprintf(rsp, "%s", BOOL_STR(c->shown));
+	QUERY_KEY("tiledRectangle") query_rectangle(c->tiled_rectangle, rsp);
+	QUERY_KEY("floatingRectangle") query_rectangle(c->floating_rectangle, rsp);
+	fprintf(rsp, "}");
 }
 
+#undef QUERY_KEY
+#undef QUERY_CHILD
+#undef DEEPER
+
 void query_rectangle(xcb_rectangle_t r, FILE *rsp)
 {
 	fprintf(rsp, "{\"x\":%i,\"y\":%i,\"width\":%u,\"height\":%u}", r.x, r.y, r.width, r.height);
 }
 
+/* Prints a string that may contain quotes and backslashes, such as a title:
+ * the control characters were already replaced when it was read. */
+void query_string(const char *s, FILE *rsp)
+{
+	fputc('"', rsp);
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\') {
+			fputc('\\', rsp);
+		}
+		fputc(*s, rsp);
+	}
+	fputc('"', rsp);
+}
+
 void query_constraints(constraints_t c, FILE *rsp)
 {
 	fprintf(rsp, "{\"min_width\":%u,\"min_height\":%u}", c.min_width, c.min_height);
@@ -234,7 +285,22 @@ void query_subscribers(FILE *rsp)
 		if (s->fifo_path != NULL) {
 			fprintf(rsp, ",\"fifoPath\":\"%s\"", s->fifo_path);
 		}
-		fprintf(rsp, ",\"field\":%i,\"count\":%i}", s->field, s->count);
+		fprintf(rsp, ",\"field\":%i,\"count\":%i", s->field, s->count);
+		if (s->filter != NULL) {
+			subscriber_filter_t *f = s->filter;
+			fprintf(rsp, ",\"filter\":{\"monitorId\":%u,\"desktopId\":%u,\"nodeId\":%u", f->monitor_id, f->desktop_id, f->node_id);
+			if (f->monitor_modifiers != NULL) {
+				fprintf(rsp, ",\"monitorModifiers\":\"%s\"", f->monitor_modifiers);
+			}
+			if (f->desktop_modifiers != NULL) {
+				fprintf(rsp, ",\"desktopModifiers\":\"%s\"", f->desktop_modifiers);
+			}
+			if (f->node_modifiers != NULL) {
+				fprintf(rsp, ",\"nodeModifiers\":\"%s\"", f->node_modifiers);
+			}
+			fprintf(rsp, "}");
+		}
+		fprintf(rsp, "}");
 		if (s->next != NULL) {
 			fprintf(rsp, ",");
 		}
@@ -242,7 +308,7 @@ void query_subscribers(FILE *rsp)
 	fprintf(rsp, "]");
 }
 
-int query_node_ids(coordinates_t *mon_ref, coordinates_t *desk_ref, coordinates_t* ref, coordinates_t *trg, monitor_select_t *mon_sel, desktop_select_t *desk_sel, node_select_t *sel, FILE *rsp)
+int query_node_ids(coordinates_t *mon_ref, coordinates_t *desk_ref, coordinates_t* ref, coordinates_t *trg, monitor_select_t *mon_sel, desktop_select_t *desk_sel, node_select_t *sel, query_format_t *qf, FILE *rsp)
 {
 	int count = 0;
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
@@ -257,13 +323,13 @@ int query_node_ids(coordinates_t *mon_ref, coordinates_t *desk_ref, coordinates_
 			    (desk_sel != NULL && !desktop_matches(&loc, desk_ref, desk_sel))) {
 				continue;
 			}
-			count += query_node_ids_in(d->root, d, m, ref, trg, sel, rsp);
+			count += query_node_ids_in(d->root, d, m, ref, trg, sel, qf, rsp);
 		}
 	}
 	return count;
 }
 
-int query_node_ids_in(node_t *n, desktop_t *d, monitor_t *m, coordinates_t *ref, coordinates_t *trg, node_select_t *sel, FILE *rsp)
+int query_node_ids_in(node_t *n, desktop_t *d, monitor_t *m, coordinates_t *ref, coordinates_t *trg, node_select_t *sel, query_format_t *qf, FILE *rsp)
 {
 	int count = 0;
 	if (n == NULL) {
@@ -272,16 +338,20 @@ int query_node_ids_in(node_t *n, desktop_t *d, monitor_t *m, coordinates_t *ref,
 		coordinates_t loc = {m, d, n};
 		if ((trg->node == NULL || n == trg->node) &&
 		    (sel == NULL || node_matches(&loc, ref, sel))) {
-			fprintf(rsp, "0x%08X\n", n->id);
+			if (qf != NULL) {
+				print_query_format(qf, &loc, rsp);
+			} else {
+				fprintf(rsp, "0x%08X\n", n->id);
+			}
 			count++;
 		}
-		count += query_node_ids_in(n->first_child, d, m, ref, trg, sel, rsp);
-		count += query_node_ids_in(n->second_child, d, m, ref, trg, sel, rsp);
+		count += query_node_ids_in(n->first_child, d, m, ref, trg, sel, qf, rsp);
+		count += query_node_ids_in(n->second_child, d, m, ref, trg, sel, qf, rsp);
 	}
 	return count;
 }
 
-int query_desktop_ids(coordinates_t* mon_ref, coordinates_t *ref, coordinates_t *trg, monitor_select_t *mon_sel, desktop_select_t *sel, desktop_printer_t printer, FILE *rsp)
+int query_desktop_ids(coordinates_t* mon_ref, coordinates_t *ref, coordinates_t *trg, monitor_select_t *mon_sel, desktop_select_t *sel, desktop_printer_t printer, query_format_t *qf, FILE *rsp)
 {
 	int count = 0;
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
@@ -296,14 +366,18 @@ int query_desktop_ids(coordinates_t* mon_ref, coordinates_t *ref, coordinates_t
 			    (sel != NULL && !desktop_matches(&loc, ref, sel))) {
 				continue;
 			}
-			printer(d, rsp);
+			if (qf != NULL) {
+				print_query_format(qf, &loc, rsp);
+			} else {
+				printer(d, rsp);
+			}
 			count++;
 		}
 	}
 	return count;
 }
 
-int query_monitor_ids(coordinates_t *ref, coordinates_t *trg, monitor_select_t *sel, monitor_printer_t printer, FILE *rsp)
+int query_monitor_ids(coordinates_t *ref, coordinates_t *trg, monitor_select_t *sel, monitor_printer_t printer, query_format_t *qf, FILE *rsp)
 {
 	int count = 0;
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
@@ -312,7 +386,11 @@ int query_monitor_ids(coordinates_t *ref, coordinates_t *trg, monitor_select_t *
 		    (sel != NULL && !monitor_matches(&loc, ref, sel))) {
 			continue;
 		}
-		printer(m, rsp);
+		if (qf != NULL) {
+			print_query_format(qf, &loc, rsp);
+		} else {
+			printer(m, rsp);
+		}
 		count++;
 	}
 	return count;
@@ -338,6 +416,193 @@ void fprint_desktop_name(desktop_t *d, FILE *rsp)
 	fprintf(rsp, "%s\n", d->name);
 }
 
+static const char *query_json_keys[] = {
+	"name", "id", "randrId", "wired", "stickyCount", "windowGap", "borderWidth",
+	"focusedDesktopId", "padding", "rectangle", "layout", "userLayout",
+	"focusedNodeId", "splitType", "splitRatio", "vacant", "hidden", "sticky",
+	"private", "locked", "marked", "presel", "constraints", "className",
+	"instanceName", "title", "state", "lastState", "layer", "lastLayer", "urgent", "shown",
+	"tiledRectangle", "floatingRectangle"
+};
+
+query_projection_t make_query_projection(void)
+{
+	query_projection_t proj = {
+		.buffer = NULL,
+		.fields = NULL,
+		.fields_count = 0,
+		.depth = -1
+	};
+	return proj;
+}
+
+bool parse_query_fields(char *list, query_projection_t *proj)
+{
+	free_query_projection(proj);
+	proj->buffer = copy_string(list, strlen(list));
+	for (char *key = strtok(proj->buffer, ","); key != NULL; key = strtok(NULL, ",")) {
+		bool known = false;
+		for (size_t i = 0; i < LENGTH(query_json_keys) && !known; i++) {
+			known = streq(query_json_keys[i], key);
+		}
+		if (!known) {
+			return false;
+		}
+		proj->fields = realloc(proj->fields, (proj->fields_count + 1) * sizeof(char *));
+		proj->fields[proj->fields_count++] = key;
+	}
+	return proj->fields_count > 0;
+}
+
+void free_query_projection(query_projection_t *proj)
+{
+	free(proj->buffer);
+	free(proj->fields);
+	proj->buffer = NULL;
+	proj->fields = NULL;
+	proj->fields_count = 0;
+}
+
+static bool parse_format_field(const char *s, int len, domain_t dom, format_field_t *f)
+{
+#define FIELD(str, val)  if (len == (int) strlen(str) && strncmp(s, str, len) == 0) { *f = val; return true; }
+	FIELD("id", FORMAT_ID)
+	if (dom == DOMAIN_NODE) {
+		FIELD("class", FORMAT_CLASS)
+		FIELD("instance", FORMAT_INSTANCE)
+		FIELD("title", FORMAT_TITLE)
+		FIELD("state", FORMAT_STATE)
+		FIELD("layer", FORMAT_LAYER)
+		FIELD("split_type", FORMAT_SPLIT_TYPE)
+		FIELD("split_ratio", FORMAT_SPLIT_RATIO)
+	} else if (dom == DOMAIN_DESKTOP) {
+		FIELD("name", FORMAT_NAME)
+		FIELD("layout", FORMAT_LAYOUT)
+		FIELD("focused", FORMAT_FOCUSED)
+	} else if (dom == DOMAIN_MONITOR) {
+		FIELD("name", FORMAT_NAME)
+	}
+	if (dom != DOMAIN_DESKTOP) {
+		FIELD("rect", FORMAT_RECT)
+		FIELD("desktop", FORMAT_DESKTOP)
+		FIELD("desktop_id", FORMAT_DESKTOP_ID)
+	}
+	if (dom != DOMAIN_MONITOR) {
+		FIELD("monitor", FORMAT_MONITOR)
+		FIELD("monitor_id", FORMAT_MONITOR_ID)
+	}
+#undef FIELD
+	return false;
+}
+
+static void add_format_item(query_format_t *qf, format_field_t field, const char *text, int len)
+{
+	qf->items = realloc(qf->items, (qf->len + 1) * sizeof(format_item_t));
+	qf->items[qf->len++] = (format_item_t) {field, text, len};
+}
+
+/* The items point into `fmt`, which must outlive the compiled format. */
+bool compile_query_format(const char *fmt, domain_t dom, query_format_t *qf)
+{
+	qf->items = NULL;
+	qf->len = 0;
+	const char *s = fmt;
+	while (*s != '\0') {
+		if (*s != '%') {
+			int len = strcspn(s, "%");
+			add_format_item(qf, FORMAT_LITERAL, s, len);
+			s += len;
+		} else if (s[1] == '%') {
+			add_format_item(qf, FORMAT_LITERAL, s, 1);
+			s += 2;
+		} else {
+			int len = strspn(s + 1, "abcdefghijklmnopqrstuvwxyz_");
+			format_field_t field;
+			if (!parse_format_field(s + 1, len, dom, &field)) {
+				free_query_format(qf);
+				return false;
+			}
+			add_format_item(qf, field, NULL, 0);
+			s += len + 1;
+		}
+	}
+	return true;
+}
+
+void free_query_format(query_format_t *qf)
+{
+	free(qf->items);
+	qf->items = NULL;
+	qf->len = 0;
+}
+
+void print_query_format(query_format_t *qf, coordinates_t *loc, FILE *rsp)
+{
+	monitor_t *m = loc->monitor;
+	desktop_t *d = loc->desktop;
+	node_t *n = loc->node;
+	client_t *c = n != NULL ? n->client : NULL;
+	for (int i = 0; i < qf->len; i++) {
+		format_item_t *it = &qf->items[i];
+		switch (it->field) {
+			case FORMAT_LITERAL:
+				fprintf(rsp, "%.*s", it->len, it->text);
+				break;
+			case FORMAT_ID:
+				fprintf(rsp, "0x%08X", n != NULL ? n->id : (d != NULL ? d->id : m->id));
+				break;
+			case FORMAT_NAME:
+				fprintf(rsp, "%s", d != NULL ? d->name : m->name);
+				break;
+			case FORMAT_CLASS:
+				fprintf(rsp, "%s", c != NULL ? c->class_name : "");
+				break;
+			case FORMAT_INSTANCE:
+				fprintf(rsp, "%s", c != NULL ? c->instance_name : "");
+				break;
+			case FORMAT_TITLE:
+				fprintf(rsp, "%s", c != NULL ? c->name : "");
+				break;
+			case FORMAT_STATE:
+				fprintf(rsp, "%s", c != NULL ? STATE_STR(c->state) : "");
+				break;
+			case FORMAT_LAYER:
+				fprintf(rsp, "%s", c != NULL ? LAYER_STR(c->layer) : "");
+				break;
+			case FORMAT_LAYOUT:
+				fprintf(rsp, "%s", layout_str(d->layout));
+				break;
+			case FORMAT_RECT: {
+				xcb_rectangle_t r = n != NULL ? get_rectangle(m, d, n) : m->rectangle;
+				fprintf(rsp, "%hux%hu+%hi+%hi", r.width, r.height, r.x, r.y);
+				break;
+			}
+			case FORMAT_SPLIT_TYPE:
+				fprintf(rsp, "%s", SPLIT_TYPE_STR(n->split_type));
+				break;
+			case FORMAT_SPLIT_RATIO:
+				fprintf(rsp, "%lf", n->split_ratio);
+				break;
+			case FORMAT_FOCUSED:
+				fprintf(rsp, "%s", BOOL_STR(d == mon->desk));
+				break;
+			case FORMAT_DESKTOP:
+				fprintf(rsp, "%s", d != NULL ? d->name : m->desk->name);
+				break;
+			case FORMAT_DESKTOP_ID:
+				fprintf(rsp, "0x%08X", d != NULL ? d->id : m->desk->id);
+				break;
+			case FORMAT_MONITOR:
+				fprintf(rsp, "%s", m->name);
+				break;
+			case FORMAT_MONITOR_ID:
+				fprintf(rsp, "0x%08X", m->id);
+				break;
+		}
+	}
+	fprintf(rsp, "\n");
+}
+
 void print_ignore_request(state_transition_t st, FILE *rsp)
 {
 	if (st == 0) {
@@ -476,30 +741,8 @@ void print_rectangle(char **buf, xcb_rectangle_t *rect)
 node_select_t make_node_select(void)
 {
 	node_select_t sel = {
-		.automatic = OPTION_NONE,
-		.focused = OPTION_NONE,
-		.active = OPTION_NONE,
-		.local = OPTION_NONE,
-		.leaf = OPTION_NONE,
-		.window = OPTION_NONE,
-		.tiled = OPTION_NONE,
-		.pseudo_tiled = OPTION_NONE,
-		.floating = OPTION_NONE,
-		.fullscreen = OPTION_NONE,
-		.hidden = OPTION_NONE,
-		.sticky = OPTION_NONE,
-		.private = OPTION_NONE,
-		.locked = OPTION_NONE,
-		.marked = OPTION_NONE,
-		.urgent = OPTION_NONE,
-		.same_class = OPTION_NONE,
-		.descendant_of = OPTION_NONE,
-		.ancestor_of = OPTION_NONE,
-		.below = OPTION_NONE,
-		.normal = OPTION_NONE,
-		.above = OPTION_NONE,
-		.horizontal = OPTION_NONE,
-		.vertical = OPTION_NONE
+		.mask = 0,
+		.value = 0
 	};
 	return sel;
 }
@@ -514,8 +757,14 @@ desktop_select_t make_desktop_select(void)
 		.local = OPTION_NONE,
 		.tiled = OPTION_NONE,
 		.monocle = OPTION_NONE,
+		.master_stack = OPTION_NONE,
+		.centered_master = OPTION_NONE,
+		.grid = OPTION_NONE,
 		.user_tiled = OPTION_NONE,
-		.user_monocle = OPTION_NONE
+		.user_monocle = OPTION_NONE,
+		.user_master_stack = OPTION_NONE,
+		.user_centered_master = OPTION_NONE,
+		.user_grid = OPTION_NONE
 	};
 	return sel;
 }
@@ -531,7 +780,28 @@ monitor_select_t make_monitor_select(void)
 
 int node_from_desc(char *desc, coordinates_t *ref, coordinates_t *dst)
 {
-	dst->node = NULL;
+	return node_from_node_desc(cached_node_desc(desc), ref, dst);
+}
+
+/* Whether the descriptor of the selector, after its reference, is `all`. */
+bool selects_all(char *desc)
+{
+	char *hash = strrchr(desc, '#');
+	char *s = (hash != NULL ? hash + 1 : desc);
+	return strncmp(s, "all", 3) == 0 && (s[3] == '\0' || s[3] == CAT_CHR);
+}
+
+int node_ids_from_desc(char *desc, coordinates_t *ref, uint32_t **ids, int *len)
+{
+	return node_ids_from_node_desc(cached_node_desc(desc), ref, ids, len);
+}
+
+/* Collects the IDs of the desktops matching a selector whose descriptor is
+ * `all`. The IDs are freed by the caller. */
+int desktop_ids_from_desc(char *desc, coordinates_t *ref, uint32_t **ids, int *len)
+{
+	*ids = NULL;
+	*len = 0;
 
 	coordinates_t ref_copy = *ref;
 	ref = &ref_copy;
@@ -539,24 +809,12 @@ int node_from_desc(char *desc, coordinates_t *ref, coordinates_t *dst)
 	desc = desc_copy;
 
 	char *hash = strrchr(desc, '#');
-	char *path = strrchr(desc, '@');
-	char *colon = strrchr(desc, ':');
-
-	/* Adjust or discard hashes inside a DESKTOP_SEL, e.g. `newest#@prev#older:/1/2` */
-	if (hash != NULL && colon != NULL && path != NULL &&
-	    path < hash && hash < colon) {
-		if (path > desc && *(path - 1) == '#') {
-			hash = path - 1;
-		} else {
-			hash = NULL;
-		}
-	}
 
 	if (hash != NULL) {
 		*hash = '\0';
 		int ret;
-		coordinates_t tmp = {mon, mon->desk, mon->desk->focus};
-		if ((ret = node_from_desc(desc, &tmp, ref)) == SELECTOR_OK) {
+		coordinates_t tmp = {mon, mon->desk, NULL};
+		if ((ret = desktop_from_desc(desc, &tmp, ref)) == SELECTOR_OK) {
 			desc = hash + 1;
 		} else {
 			free(desc_copy);
@@ -564,120 +822,40 @@ int node_from_desc(char *desc, coordinates_t *ref, coordinates_t *dst)
 		}
 	}
 
-	/* Discard colons within references, e.g. `@next.occupied:/#any.descendant_of.window` */
-	if (colon != NULL && hash != NULL && colon < hash) {
-		colon = NULL;
-	}
-
-	node_select_t sel = make_node_select();
+	desktop_select_t sel = make_desktop_select();
 
-	if (!parse_node_modifiers(colon != NULL ? colon : desc, &sel)) {
+	if (!parse_desktop_modifiers(desc, &sel)) {
 		free(desc_copy);
 		return SELECTOR_BAD_MODIFIERS;
 	}
 
-	direction_t dir;
-	cycle_dir_t cyc;
-	history_dir_t hdi;
-	if (parse_direction(desc, &dir)) {
-		find_nearest_neighbor(ref, dst, dir, &sel);
-	} else if (parse_cycle_direction(desc, &cyc)) {
-		find_closest_node(ref, dst, cyc, &sel);
-	} else if (parse_history_direction(desc, &hdi)) {
-		history_find_node(hdi, ref, dst, &sel);
-	} else if (streq("any", desc)) {
-		find_any_node(ref, dst, &sel);
-	} else if (streq("first_ancestor", desc)) {
-		find_first_ancestor(ref, dst, &sel);
-	} else if (streq("last", desc)) {
-		history_find_node(HISTORY_OLDER, ref, dst, &sel);
-	} else if (streq("newest", desc)) {
-		history_find_newest_node(ref, dst, &sel);
-	} else if (streq("biggest", desc)) {
-		find_by_area(AREA_BIGGEST, ref, dst, &sel);
-	} else if (streq("smallest", desc)) {
-		find_by_area(AREA_SMALLEST, ref, dst, &sel);
-	} else if (streq("pointed", desc)) {
-		xcb_window_t win = XCB_NONE;
-		query_pointer(&win, NULL);
-		if (locate_leaf(win, dst) && node_matches(dst, ref, &sel)) {
-			return SELECTOR_OK;
-		} else {
-			return SELECTOR_INVALID;
-		}
-	} else if (streq("focused", desc)) {
-		coordinates_t loc = {mon, mon->desk, mon->desk->focus};
-		if (node_matches(&loc, ref, &sel)) {
-			*dst = loc;
-		}
-	} else if (*desc == '@') {
-		desc++;
-		*dst = *ref;
-		if (colon != NULL) {
-			*colon = '\0';
-			int ret;
-			if ((ret = desktop_from_desc(desc, ref, dst)) == SELECTOR_OK) {
-				dst->node = dst->desktop->focus;
-				desc = colon + 1;
-			} else {
-				free(desc_copy);
-				return ret;
-			}
-		}
-		if (*desc == '/') {
-			dst->node = dst->desktop->root;
-		}
-		char *move = strtok(desc, PTH_TOK);
-		while (move != NULL && dst->node != NULL) {
-			if (streq("first", move) || streq("1", move)) {
-				dst->node = dst->node->first_child;
-			} else if (streq("second", move) || streq("2", move)) {
-				dst->node = dst->node->second_child;
-			} else if (streq("parent", move)) {
-				dst->node = dst->node->parent;
-			} else if (streq("brother", move)) {
-				dst->node = brother_tree(dst->node);
-			} else {
-				direction_t dir;
-				if (parse_direction(move, &dir)) {
-					dst->node = find_fence(dst->node, dir);
-				} else {
-					free(desc_copy);
-					return SELECTOR_BAD_DESCRIPTOR;
-				}
-			}
-			move = strtok(NULL, PTH_TOK);
-		}
+	if (!streq("all", desc)) {
 		free(desc_copy);
-		if (dst->node != NULL) {
-			if (node_matches(dst, ref, &sel)) {
-				return SELECTOR_OK;
-			} else {
-				return SELECTOR_INVALID;
-			}
-		} else if (dst->desktop->root != NULL) {
-			return SELECTOR_INVALID;
-		}
-		return SELECTOR_OK;
-	} else {
-		uint32_t id;
-		if (parse_id(desc, &id)) {
-			free(desc_copy);
-			if (find_by_id(id, dst) && node_matches(dst, ref, &sel)) {
-				return SELECTOR_OK;
-			} else {
-				return SELECTOR_INVALID;
-			}
-		} else {
-			free(desc_copy);
-			return SELECTOR_BAD_DESCRIPTOR;
-		}
+		return SELECTOR_BAD_DESCRIPTOR;
 	}
 
 	free(desc_copy);
 
-	if (dst->node == NULL) {
-		return SELECTOR_INVALID;
+	int cap = 0;
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			coordinates_t loc = {m, d, NULL};
+			if (!desktop_matches(&loc, ref, &sel)) {
+				continue;
+			}
+			if (*len == cap) {
+				cap = (cap == 0 ? 16 : 2 * cap);
+				uint32_t *new = realloc(*ids, cap * sizeof(uint32_t));
+				if (new == NULL) {
+					free(*ids);
+					*ids = NULL;
+					*len = 0;
+					return SELECTOR_INVALID;
+				}
+				*ids = new;
+			}
+			(*ids)[(*len)++] = d->id;
+		}
 	}
 
 	return SELECTOR_OK;
@@ -926,7 +1104,7 @@ bool locate_leaf(xcb_window_t win, coordinates_t *loc)
 {
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
 		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 				if (n->id == win) {
 					loc->monitor = m;
 					loc->desktop = d;
@@ -943,7 +1121,7 @@ bool locate_window(xcb_window_t win, coordinates_t *loc)
 {
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
 		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 				if (n->client == NULL) {
 					continue;
 				}
@@ -961,62 +1139,51 @@ bool locate_window(xcb_window_t win, coordinates_t *loc)
 
 bool locate_desktop(char *name, coordinates_t *loc)
 {
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			if (streq(d->name, name)) {
-				loc->monitor = m;
-				loc->desktop = d;
-				return true;
-			}
-		}
+	monitor_t *m = NULL;
+	desktop_t *d = next_desktop_named(name, NULL, &m);
+	if (d != NULL) {
+		loc->monitor = m;
+		loc->desktop = d;
+		return true;
 	}
 	return false;
 }
 
 bool locate_monitor(char *name, coordinates_t *loc)
 {
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		if (streq(m->name, name)) {
-			loc->monitor = m;
-			return true;
-		}
+	monitor_t *m = registered_monitor_named(name);
+	if (m != NULL) {
+		loc->monitor = m;
+		return true;
 	}
 	return false;
 }
 
 bool desktop_from_id(uint32_t id, coordinates_t *loc, monitor_t *mm)
 {
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		if (mm != NULL && m != mm) {
-			continue;
-		}
-		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			if (d->id == id) {
-				loc->monitor = m;
-				loc->desktop = d;
-				loc->node = NULL;
-				return true;
-			}
-		}
+	monitor_t *m = NULL;
+	desktop_t *d = registered_desktop(id, &m);
+	if (d != NULL && m != NULL && (mm == NULL || m == mm)) {
+		loc->monitor = m;
+		loc->desktop = d;
+		loc->node = NULL;
+		return true;
 	}
 	return false;
 }
 
 bool desktop_from_name(char *name, coordinates_t *ref, coordinates_t *dst, desktop_select_t *sel, int *hits)
 {
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			if (streq(d->name, name)) {
-				if (hits != NULL) {
-					(*hits)++;
-				}
-				coordinates_t loc = {m, d, NULL};
-				if (desktop_matches(&loc, ref, sel)) {
-					dst->monitor = m;
-					dst->desktop = d;
-					return true;
-				}
-			}
+	monitor_t *m = NULL;
+	for (desktop_t *d = next_desktop_named(name, NULL, &m); d != NULL; d = next_desktop_named(name, d, &m)) {
+		if (hits != NULL) {
+			(*hits)++;
+		}
+		coordinates_t loc = {m, d, NULL};
+		if (desktop_matches(&loc, ref, sel)) {
+			dst->monitor = m;
+			dst->desktop = d;
+			return true;
 		}
 	}
 	return false;
@@ -1024,31 +1191,34 @@ bool desktop_from_name(char *name, coordinates_t *ref, coordinates_t *dst, deskt
 
 bool desktop_from_index(uint16_t idx, coordinates_t *loc, monitor_t *mm)
 {
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		if (mm != NULL && m != mm) {
-			continue;
-		}
-		for (desktop_t *d = m->desk_head; d != NULL; d = d->next, idx--) {
-			if (idx == 1) {
-				loc->monitor = m;
-				loc->desktop = d;
-				loc->node = NULL;
-				return true;
-			}
+	if (idx < 1) {
+		return false;
+	}
+	unsigned int i = idx - 1;
+	if (mm != NULL) {
+		if (mm->desk_head == NULL) {
+			return false;
 		}
+		i += desktop_ordinal(mm->desk_head);
+	}
+	coordinates_t dloc;
+	if (desktop_at(i, &dloc) && (mm == NULL || dloc.monitor == mm)) {
+		loc->monitor = dloc.monitor;
+		loc->desktop = dloc.desktop;
+		loc->node = NULL;
+		return true;
 	}
 	return false;
 }
 
 bool monitor_from_id(uint32_t id, coordinates_t *loc)
 {
-	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		if (m->id == id) {
-			loc->monitor = m;
-			loc->desktop = NULL;
-			loc->node = NULL;
-			return true;
-		}
+	monitor_t *m = registered_monitor(id);
+	if (m != NULL) {
+		loc->monitor = m;
+		loc->desktop = NULL;
+		loc->node = NULL;
+		return true;
 	}
 	return false;
 }
@@ -1072,153 +1242,97 @@ bool node_matches(coordinates_t *loc, coordinates_t *ref, node_select_t *sel)
 		return false;
 	}
 
-	if (sel->focused != OPTION_NONE &&
-	    loc->node != mon->desk->focus
-	    ? sel->focused == OPTION_TRUE
-	    : sel->focused == OPTION_FALSE) {
-		return false;
-	}
+	return ((node_flags(loc, ref, sel->mask) ^ sel->value) & sel->mask) == 0;
+}
 
-	if (sel->active != OPTION_NONE &&
-	    loc->node != loc->desktop->focus
-	    ? sel->active == OPTION_TRUE
-	    : sel->active == OPTION_FALSE) {
-		return false;
-	}
+/* Only the flags relative to `ref` or to the focus that are in `mask` are computed. */
+uint32_t node_flags(coordinates_t *loc, coordinates_t *ref, uint32_t mask)
+{
+	node_t *n = loc->node;
+	client_t *c = n->client;
+	uint32_t flags = 0;
 
-	if (sel->automatic != OPTION_NONE &&
-	    loc->node->presel != NULL
-	    ? sel->automatic == OPTION_TRUE
-	    : sel->automatic == OPTION_FALSE) {
-		return false;
+	if (n->presel == NULL) {
+		flags |= NODE_FLAG_AUTOMATIC;
 	}
-
-	if (sel->local != OPTION_NONE &&
-	    loc->desktop != ref->desktop
-	    ? sel->local == OPTION_TRUE
-	    : sel->local == OPTION_FALSE) {
-		return false;
+	if (is_leaf(n)) {
+		flags |= NODE_FLAG_LEAF;
 	}
 
-	if (sel->active != OPTION_NONE &&
-	    loc->desktop != loc->monitor->desk
-	    ? sel->active == OPTION_TRUE
-	    : sel->active == OPTION_FALSE) {
-		return false;
-	}
-
-	if (sel->leaf != OPTION_NONE &&
-	    !is_leaf(loc->node)
-	    ? sel->leaf == OPTION_TRUE
-	    : sel->leaf == OPTION_FALSE) {
-		return false;
+#define NFLAG(p, f) \
+	if (n->p) { \
+		flags |= f; \
 	}
+	NFLAG(hidden, NODE_FLAG_HIDDEN)
+	NFLAG(sticky, NODE_FLAG_STICKY)
+	NFLAG(private, NODE_FLAG_PRIVATE)
+	NFLAG(locked, NODE_FLAG_LOCKED)
+	NFLAG(marked, NODE_FLAG_MARKED)
+#undef NFLAG
 
-	if (sel->window != OPTION_NONE &&
-	    loc->node->client == NULL
-	    ? sel->window == OPTION_TRUE
-	    : sel->window == OPTION_FALSE) {
-		return false;
-	}
+	flags |= (n->split_type == TYPE_HORIZONTAL ? NODE_FLAG_HORIZONTAL : NODE_FLAG_VERTICAL);
 
-#define NFLAG(p) \
-	if (sel->p != OPTION_NONE && \
-	    !loc->node->p \
-	    ? sel->p == OPTION_TRUE \
-	    : sel->p == OPTION_FALSE) { \
-		return false; \
+	if (c != NULL) {
+		flags |= NODE_FLAG_WINDOW;
+		switch (c->state) {
+			case STATE_TILED:
+				flags |= NODE_FLAG_TILED;
+				break;
+			case STATE_PSEUDO_TILED:
+				flags |= NODE_FLAG_PSEUDO_TILED;
+				break;
+			case STATE_FLOATING:
+				flags |= NODE_FLAG_FLOATING;
+				break;
+			case STATE_FULLSCREEN:
+				flags |= NODE_FLAG_FULLSCREEN;
+				break;
+		}
+		switch (c->layer) {
+			case LAYER_BELOW:
+				flags |= NODE_FLAG_BELOW;
+				break;
+			case LAYER_NORMAL:
+				flags |= NODE_FLAG_NORMAL;
+				break;
+			case LAYER_ABOVE:
+				flags |= NODE_FLAG_ABOVE;
+				break;
+		}
+		if (c->urgent) {
+			flags |= NODE_FLAG_URGENT;
+		}
 	}
-	NFLAG(hidden)
-	NFLAG(sticky)
-	NFLAG(private)
-	NFLAG(locked)
-	NFLAG(marked)
-#undef NFLAG
 
-#define NSPLIT(p, e) \
-	if (sel->p != OPTION_NONE && \
-	    loc->node->split_type != e \
-	    ? sel->p == OPTION_TRUE \
-	    : sel->p == OPTION_FALSE) { \
-		return false; \
+	if (!(mask & NODE_FLAG_RELATIVE)) {
+		return flags;
 	}
-	NSPLIT(horizontal, TYPE_HORIZONTAL)
-	NSPLIT(vertical, TYPE_VERTICAL)
-#undef NSPLIT
 
-	if (sel->descendant_of != OPTION_NONE &&
-	    !is_descendant(loc->node, ref->node)
-	    ? sel->descendant_of == OPTION_TRUE
-	    : sel->descendant_of == OPTION_FALSE) {
-		return false;
+	if (n == mon->desk->focus) {
+		flags |= NODE_FLAG_FOCUSED;
 	}
-
-	if (sel->ancestor_of != OPTION_NONE &&
-	    !is_descendant(ref->node, loc->node)
-	    ? sel->ancestor_of == OPTION_TRUE
-	    : sel->ancestor_of == OPTION_FALSE) {
-		return false;
+	if (n == loc->desktop->focus) {
+		flags |= NODE_FLAG_ACTIVE;
 	}
-
-	if (loc->node->client == NULL) {
-		if (sel->same_class == OPTION_TRUE ||
-		    sel->tiled == OPTION_TRUE ||
-		    sel->pseudo_tiled == OPTION_TRUE ||
-		    sel->floating == OPTION_TRUE ||
-		    sel->fullscreen == OPTION_TRUE ||
-		    sel->below == OPTION_TRUE ||
-		    sel->normal == OPTION_TRUE ||
-		    sel->above == OPTION_TRUE ||
-		    sel->urgent == OPTION_TRUE) {
-			return false;
-		}
-		return true;
+	if (loc->desktop == loc->monitor->desk) {
+		flags |= NODE_FLAG_ACTIVE_DESKTOP;
 	}
-
-	if (ref->node != NULL && ref->node->client != NULL &&
-	    sel->same_class != OPTION_NONE &&
-	    streq(loc->node->client->class_name, ref->node->client->class_name)
-	    ? sel->same_class == OPTION_FALSE
-	    : sel->same_class == OPTION_TRUE) {
-		return false;
+	if (loc->desktop == ref->desktop) {
+		flags |= NODE_FLAG_LOCAL;
 	}
-
-#define WSTATE(p, e) \
-	if (sel->p != OPTION_NONE && \
-	    loc->node->client->state != e \
-	    ? sel->p == OPTION_TRUE \
-	    : sel->p == OPTION_FALSE) { \
-		return false; \
+	if ((mask & NODE_FLAG_DESCENDANT_OF) && is_descendant(n, ref->node)) {
+		flags |= NODE_FLAG_DESCENDANT_OF;
 	}
-	WSTATE(tiled, STATE_TILED)
-	WSTATE(pseudo_tiled, STATE_PSEUDO_TILED)
-	WSTATE(floating, STATE_FLOATING)
-	WSTATE(fullscreen, STATE_FULLSCREEN)
-#undef WSTATE
-
-#define WLAYER(p, e) \
-	if (sel->p != OPTION_NONE && \
-	    loc->node->client->layer != e \
-	    ? sel->p == OPTION_TRUE \
-	    : sel->p == OPTION_FALSE) { \
-		return false; \
+	if ((mask & NODE_FLAG_ANCESTOR_OF) && is_descendant(ref->node, n)) {
+		flags |= NODE_FLAG_ANCESTOR_OF;
 	}
-	WLAYER(below, LAYER_BELOW)
-	WLAYER(normal, LAYER_NORMAL)
-	WLAYER(above, LAYER_ABOVE)
-#undef WLAYER
-
-#define WFLAG(p) \
-	if (sel->p != OPTION_NONE && \
-	    !loc->node->client->p \
-	    ? sel->p == OPTION_TRUE \
-	    : sel->p == OPTION_FALSE) { \
-		return false; \
+	if ((mask & NODE_FLAG_SAME_CLASS) && c != NULL &&
+	    ref->node != NULL && ref->node->client != NULL &&
+	    streq(c->class_name, ref->node->client->class_name)) {
+		flags |= NODE_FLAG_SAME_CLASS;
 	}
-	WFLAG(urgent)
-#undef WFLAG
 
-	return true;
+	return flags;
 }
 
 bool desktop_matches(coordinates_t *loc, coordinates_t *ref, desktop_select_t *sel)
@@ -1267,6 +1381,9 @@ bool desktop_matches(coordinates_t *loc, coordinates_t *ref, desktop_select_t *s
 	}
 	DLAYOUT(tiled, LAYOUT_TILED)
 	DLAYOUT(monocle, LAYOUT_MONOCLE)
+	DLAYOUT(master_stack, LAYOUT_MASTER_STACK)
+	DLAYOUT(centered_master, LAYOUT_CENTERED_MASTER)
+	DLAYOUT(grid, LAYOUT_GRID)
 #undef DLAYOUT
 
 #define DUSERLAYOUT(p, e) \
@@ -1278,6 +1395,9 @@ bool desktop_matches(coordinates_t *loc, coordinates_t *ref, desktop_select_t *s
 	}
 	DUSERLAYOUT(user_tiled, LAYOUT_TILED)
 	DUSERLAYOUT(user_monocle, LAYOUT_MONOCLE)
+	DUSERLAYOUT(user_master_stack, LAYOUT_MASTER_STACK)
+	DUSERLAYOUT(user_centered_master, LAYOUT_CENTERED_MASTER)
+	DUSERLAYOUT(user_grid, LAYOUT_GRID)
 #undef DUSERLAYOUT
 
 	return true;
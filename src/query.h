@@ -41,6 +41,46 @@ enum {
 	SELECTOR_BAD_DESCRIPTOR
 };
 
+/* Restrict the output of `query -T` to the given keys and depth. */
+typedef struct {
+	char *buffer;
+	char **fields;
+	int fields_count;
+	int depth;
+} query_projection_t;
+
+typedef enum {
+	FORMAT_LITERAL,
+	FORMAT_ID,
+	FORMAT_NAME,
+	FORMAT_CLASS,
+	FORMAT_INSTANCE,
+	FORMAT_TITLE,
+	FORMAT_STATE,
+	FORMAT_LAYER,
+	FORMAT_LAYOUT,
+	FORMAT_RECT,
+	FORMAT_SPLIT_TYPE,
+	FORMAT_SPLIT_RATIO,
+	FORMAT_FOCUSED,
+	FORMAT_DESKTOP,
+	FORMAT_DESKTOP_ID,
+	FORMAT_MONITOR,
+	FORMAT_MONITOR_ID
+} format_field_t;
+
+typedef struct {
+	format_field_t field;
+	const char *text;
+	int len;
+} format_item_t;
+
+/* The compiled form of the format strings of `query -N/-D/-M`. */
+typedef struct {
+	format_item_t *items;
+	int len;
+} query_format_t;
+
 typedef void (*monitor_printer_t)(monitor_t *m, FILE *rsp);
 typedef void (*desktop_printer_t)(desktop_t *m, FILE *rsp);
 
@@ -50,17 +90,28 @@ void query_desktop(desktop_t *d, FILE *rsp);
 void query_node(node_t *n, FILE *rsp);
 void query_presel(presel_t *p, FILE *rsp);
 void query_client(client_t *c, FILE *rsp);
+void query_monitor_fields(monitor_t *m, query_projection_t *proj, int depth, FILE *rsp);
+void query_desktop_fields(desktop_t *d, query_projection_t *proj, int depth, FILE *rsp);
+void query_node_fields(node_t *n, query_projection_t *proj, int depth, FILE *rsp);
+void query_client_fields(client_t *c, query_projection_t *proj, FILE *rsp);
+query_projection_t make_query_projection(void);
+bool parse_query_fields(char *list, query_projection_t *proj);
+void free_query_projection(query_projection_t *proj);
+bool compile_query_format(const char *fmt, domain_t dom, query_format_t *qf);
+void free_query_format(query_format_t *qf);
+void print_query_format(query_format_t *qf, coordinates_t *loc, FILE *rsp);
 void query_rectangle(xcb_rectangle_t r, FILE *rsp);
+void query_string(const char *s, FILE *rsp);
 void query_constraints(constraints_t c, FILE *rsp);
 void query_padding(padding_t p, FILE *rsp);
 void query_history(FILE *rsp);
 void query_coordinates(coordinates_t *loc, FILE *rsp);
 void query_stack(FILE *rsp);
 void query_subscribers(FILE *rsp);
-int query_node_ids(coordinates_t *mon_ref, coordinates_t *desk_ref, coordinates_t* ref, coordinates_t *trg, monitor_select_t *mon_sel, desktop_select_t *desk_sel, node_select_t *sel, FILE *rsp);
-int query_node_ids_in(node_t *n, desktop_t *d, monitor_t *m, coordinates_t *ref, coordinates_t *trg, node_select_t *sel, FILE *rsp);
-int query_desktop_ids(coordinates_t* mon_ref, coordinates_t *ref, coordinates_t *trg, monitor_select_t *mon_sel, desktop_select_t *sel, desktop_printer_t printer, FILE *rsp);
-int query_monitor_ids(coordinates_t *ref, coordinates_t *trg, monitor_select_t *sel, monitor_printer_t printer, FILE *rsp);
+int query_node_ids(coordinates_t *mon_ref, coordinates_t *desk_ref, coordinates_t* ref, coordinates_t *trg, monitor_select_t *mon_sel, desktop_select_t *desk_sel, node_select_t *sel, query_format_t *qf, FILE *rsp);
+int query_node_ids_in(node_t *n, desktop_t *d, monitor_t *m, coordinates_t *ref, coordinates_t *trg, node_select_t *sel, query_format_t *qf, FILE *rsp);
+int query_desktop_ids(coordinates_t* mon_ref, coordinates_t *ref, coordinates_t *trg, monitor_select_t *mon_sel, desktop_select_t *sel, desktop_printer_t printer, query_format_t *qf, FILE *rsp);
+int query_monitor_ids(coordinates_t *ref, coordinates_t *trg, monitor_select_t *sel, monitor_printer_t printer, query_format_t *qf, FILE *rsp);
 void fprint_monitor_id(monitor_t *m, FILE *rsp);
 void fprint_monitor_name(monitor_t *m, FILE *rsp);
 void fprint_desktop_id(desktop_t *d, FILE *rsp);
@@ -76,6 +127,9 @@ node_select_t make_node_select(void);
 desktop_select_t make_desktop_select(void);
 monitor_select_t make_monitor_select(void);
 int node_from_desc(char *desc, coordinates_t *ref, coordinates_t *dst);
+bool selects_all(char *desc);
+int node_ids_from_desc(char *desc, coordinates_t *ref, uint32_t **ids, int *len);
+int desktop_ids_from_desc(char *desc, coordinates_t *ref, uint32_t **ids, int *len);
 int desktop_from_desc(char *desc, coordinates_t *ref, coordinates_t *dst);
 int monitor_from_desc(char *desc, coordinates_t *ref, coordinates_t *dst);
 bool locate_leaf(xcb_window_t win, coordinates_t *loc);
@@ -88,6 +142,7 @@ bool desktop_from_index(uint16_t idx, coordinates_t *loc, monitor_t *mm);
 bool monitor_from_id(uint32_t id, coordinates_t *loc);
 bool monitor_from_index(int idx, coordinates_t *loc);
 bool node_matches(coordinates_t *loc, coordinates_t *ref, node_select_t *sel);
+uint32_t node_flags(coordinates_t *loc, coordinates_t *ref, uint32_t mask);
 bool desktop_matches(coordinates_t *loc, coordinates_t *ref, desktop_select_t *sel);
 bool monitor_matches(coordinates_t *loc, __attribute__((unused)) coordinates_t *ref, monitor_select_t *sel);
 
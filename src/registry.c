@@ -0,0 +1,336 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bspwm.h"
+#include "registry.h"
+
+typedef struct bucket_t bucket_t;
+struct bucket_t {
+	uint32_t key;
+	void *value;
+	bucket_t *next;
+};
+
+typedef struct {
+	bucket_t **buckets;
+	uint32_t size;
+	uint32_t count;
+} hash_table_t;
+
+static hash_table_t monitor_ids;
+static hash_table_t monitor_names;
+static hash_table_t desktop_ids;
+static hash_table_t desktop_names;
+
+/* The desktops of all the monitors, in order, rebuilt on demand. */
+static coordinates_t *desktop_order = NULL;
+static unsigned int desktop_order_len = 0;
+static unsigned int desktop_order_cap = 0;
+static bool desktop_order_valid = false;
+
+/* The IDs are allocated sequentially by the server: their low bits are well distributed. */
+static bucket_t **table_slot(hash_table_t *t, uint32_t key)
+{
+	return &t->buckets[key & (t->size - 1)];
+}
+
+static void table_grow(hash_table_t *t)
+{
+	uint32_t size = t->size == 0 ? REGISTRY_INIT_SIZE : 2 * t->size;
+	bucket_t **buckets = calloc(size, sizeof(bucket_t *));
+
+	if (buckets == NULL) {
+		return;
+	}
+
+	hash_table_t grown = {buckets, size, t->count};
+	for (uint32_t i = 0; i < t->size; i++) {
+		bucket_t *b = t->buckets[i];
+		while (b != NULL) {
+			bucket_t *next = b->next;
+			bucket_t **slot = table_slot(&grown, b->key);
+			b->next = *slot;
+			*slot = b;
+			b = next;
+		}
+	}
+
+	free(t->buckets);
+	*t = grown;
+}
+
+static void table_insert(hash_table_t *t, uint32_t key, void *value)
+{
+	if (t->count >= t->size) {
+		table_grow(t);
+		if (t->size == 0) {
+			return;
+		}
+	}
+
+	bucket_t *b = malloc(sizeof(bucket_t));
+	if (b == NULL) {
+		return;
+	}
+
+	bucket_t **slot = table_slot(t, key);
+	b->key = key;
+	b->value = value;
+	b->next = *slot;
+	*slot = b;
+	t->count++;
+}
+
+static void table_remove(hash_table_t *t, uint32_t key, void *value)
+{
+	if (t->size == 0) {
+		return;
+	}
+
+	for (bucket_t **b = table_slot(t, key); *b != NULL; b = &(*b)->next) {
+		if ((*b)->value == value) {
+			bucket_t *dead = *b;
+			*b = dead->next;
+			free(dead);
+			t->count--;
+			return;
+		}
+	}
+}
+
+static bucket_t *table_first(hash_table_t *t, uint32_t key)
+{
+	if (t->size == 0) {
+		return NULL;
+	}
+
+	return *table_slot(t, key);
+}
+
+static void table_clear(hash_table_t *t)
+{
+	for (uint32_t i = 0; i < t->size; i++) {
+		bucket_t *b = t->buckets[i];
+		while (b != NULL) {
+			bucket_t *next = b->next;
+			free(b);
+			b = next;
+		}
+		t->buckets[i] = NULL;
+	}
+	t->count = 0;
+}
+
+static void build_desktop_order(void)
+{
+	if (desktop_order_valid) {
+		return;
+	}
+
+	unsigned int len = 0;
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			len++;
+		}
+	}
+
+	if (len > desktop_order_cap) {
+		coordinates_t *order = realloc(desktop_order, len * sizeof(coordinates_t));
+		if (order == NULL) {
+			desktop_order_len = 0;
+			return;
+		}
+		desktop_order = order;
+		desktop_order_cap = len;
+	}
+
+	unsigned int i = 0;
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next, i++) {
+			d->ordinal = i;
+			desktop_order[i] = (coordinates_t) {m, d, NULL};
+		}
+	}
+
+	desktop_order_len = len;
+	desktop_order_valid = true;
+}
+
+void register_monitor(monitor_t *m)
+{
+	table_insert(&monitor_ids, m->id, m);
+	table_insert(&monitor_names, hash_string(m->name), m);
+	invalidate_desktop_order();
+}
+
+void unregister_monitor(monitor_t *m)
+{
+	table_remove(&monitor_ids, m->id, m);
+	table_remove(&monitor_names, hash_string(m->name), m);
+	invalidate_desktop_order();
+}
+
+void register_desktop(desktop_t *d)
+{
+	table_insert(&desktop_ids, d->id, d);
+	table_insert(&desktop_names, hash_string(d->name), d);
+	invalidate_desktop_order();
+}
+
+void unregister_desktop(desktop_t *d)
+{
+	table_remove(&desktop_ids, d->id, d);
+	table_remove(&desktop_names, hash_string(d->name), d);
+	invalidate_desktop_order();
+}
+
+void invalidate_desktop_order(void)
+{
+	desktop_order_valid = false;
+}
+
+/* Needed whenever IDs are assigned behind our back (e.g. when restoring the state). */
+void rebuild_registry(void)
+{
+	table_clear(&monitor_ids);
+	table_clear(&monitor_names);
+	table_clear(&desktop_ids);
+	table_clear(&desktop_names);
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		register_monitor(m);
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			register_desktop(d);
+		}
+	}
+}
+
+monitor_t *registered_monitor(uint32_t id)
+{
+	for (bucket_t *b = table_first(&monitor_ids, id); b != NULL; b = b->next) {
+		if (b->key == id) {
+			return b->value;
+		}
+	}
+	return NULL;
+}
+
+monitor_t *registered_monitor_named(const char *name)
+{
+	uint32_t h = hash_string(name);
+	monitor_t *found = NULL;
+	unsigned int hits = 0;
+
+	for (bucket_t *b = table_first(&monitor_names, h); b != NULL; b = b->next) {
+		monitor_t *m = b->value;
+		if (b->key == h && streq(m->name, name)) {
+			found = m;
+			hits++;
+		}
+	}
+
+	/* Homonyms: the first one in the list wins. */
+	if (hits > 1) {
+		for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+			if (streq(m->name, name)) {
+				return m;
+			}
+		}
+	}
+
+	return found;
+}
+
+desktop_t *registered_desktop(uint32_t id, monitor_t **m)
+{
+	for (bucket_t *b = table_first(&desktop_ids, id); b != NULL; b = b->next) {
+		if (b->key == id) {
+			desktop_t *d = b->value;
+			if (m != NULL) {
+				coordinates_t loc;
+				*m = desktop_at(desktop_ordinal(d), &loc) && loc.desktop == d ? loc.monitor : NULL;
+			}
+			return d;
+		}
+	}
+	return NULL;
+}
+
+/* Return the first desktop named `name` that comes after `d` in the global order. */
+desktop_t *next_desktop_named(const char *name, desktop_t *d, monitor_t **m)
+{
+	build_desktop_order();
+
+	uint32_t h = hash_string(name);
+	unsigned int start = (d == NULL ? 0 : desktop_ordinal(d) + 1);
+	desktop_t *found = NULL;
+
+	for (bucket_t *b = table_first(&desktop_names, h); b != NULL; b = b->next) {
+		desktop_t *f = b->value;
+		if (b->key != h || !streq(f->name, name)) {
+			continue;
+		}
+		unsigned int i = f->ordinal;
+		if (i < desktop_order_len && desktop_order[i].desktop == f && i >= start &&
+		    (found == NULL || i < found->ordinal)) {
+			found = f;
+		}
+	}
+
+	if (found != NULL && m != NULL) {
+		*m = desktop_order[found->ordinal].monitor;
+	}
+
+	return found;
+}
+
+unsigned int desktop_ordinal(desktop_t *d)
+{
+	build_desktop_order();
+
+	if (d != NULL && d->ordinal < desktop_order_len && desktop_order[d->ordinal].desktop == d) {
+		return d->ordinal;
+	}
+
+	return 0;
+}
+
+bool desktop_at(unsigned int i, coordinates_t *loc)
+{
+	build_desktop_order();
+
+	if (i >= desktop_order_len) {
+		return false;
+	}
+
+	*loc = desktop_order[i];
+	return true;
+}
+
+unsigned int registered_desktops_count(void)
+{
+	build_desktop_order();
+	return desktop_order_len;
+}
@@ -0,0 +1,49 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BSPWM_REGISTRY_H
+#define BSPWM_REGISTRY_H
+
+#include "types.h"
+
+#define REGISTRY_INIT_SIZE  64
+
+/* Hash indexes of the monitors and desktops by ID and by name, and the global
+ * order of the desktops (the one used by EWMH and by the index descriptors). */
+
+void register_monitor(monitor_t *m);
+void unregister_monitor(monitor_t *m);
+void register_desktop(desktop_t *d);
+void unregister_desktop(desktop_t *d);
+void invalidate_desktop_order(void);
+void rebuild_registry(void);
+monitor_t *registered_monitor(uint32_t id);
+monitor_t *registered_monitor_named(const char *name);
+desktop_t *registered_desktop(uint32_t id, monitor_t **m);
+desktop_t *next_desktop_named(const char *name, desktop_t *d, monitor_t **m);
+unsigned int desktop_ordinal(desktop_t *d);
+bool desktop_at(unsigned int i, coordinates_t *loc);
+unsigned int registered_desktops_count(void);
+
+#endif
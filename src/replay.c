@@ -0,0 +1,682 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <xcb/xcb.h>
+#include "helpers.h"
+#include "common.h"
+#include "trace.h"
+
+#define REPLAY_SETTLE_DELAY  100000
+#define REPLAY_WINDOW_SIZE   100
+
+/* Feeds a trace recorded through the 'trace_path' setting to a running bspwm,
+ * usually on a virtual X server: the traced windows are stood in for by
+ * synthetic windows created on demand, the input events are approximated by
+ * pointer warps and the messages are sent as is. */
+
+typedef struct {
+	char name[SMALEN];
+	uint64_t *values;
+	size_t len;
+	size_t cap;
+} series_t;
+
+typedef struct {
+	series_t *items;
+	size_t len;
+	size_t cap;
+} summary_t;
+
+typedef struct {
+	uint32_t *keys;
+	uint32_t *values;
+	size_t len;
+	size_t cap;
+} id_map_t;
+
+typedef struct {
+	char *data;
+	size_t size;
+	trace_header_t *header;
+} trace_t;
+
+static xcb_connection_t *dpy;
+static xcb_screen_t *screen;
+static id_map_t windows;
+static id_map_t atoms;
+static xcb_atom_t net_wm_name;
+static xcb_atom_t net_wm_strut_partial;
+static xcb_atom_t net_wm_state;
+static xcb_atom_t utf8_string;
+static unsigned int name_counter;
+
+static uint64_t replay_clock(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void replay_sleep(uint64_t us)
+{
+	struct timespec ts = {us / 1000000, (us % 1000000) * 1000};
+	nanosleep(&ts, NULL);
+}
+
+static bool read_trace(const char *path, trace_t *t)
+{
+	FILE *f = fopen(path, "r");
+	if (f == NULL) {
+		return false;
+	}
+	size_t cap = BUFSIZ;
+	t->data = malloc(cap);
+	t->size = 0;
+	size_t n;
+	while (t->data != NULL && (n = fread(t->data + t->size, 1, cap - t->size, f)) > 0) {
+		t->size += n;
+		if (t->size == cap) {
+			cap *= 2;
+			char *data = realloc(t->data, cap);
+			if (data == NULL) {
+				free(t->data);
+			}
+			t->data = data;
+		}
+	}
+	fclose(f);
+	if (t->data == NULL || t->size < sizeof(trace_header_t)) {
+		free(t->data);
+		return false;
+	}
+	t->header = (trace_header_t *) t->data;
+	return t->header->magic == TRACE_MAGIC && t->header->version == TRACE_VERSION;
+}
+
+/* Copies the record at `*offset` into `rec` and moves past it, returns false at
+ * the end. The records aren't aligned: they're only read through copies. */
+static bool next_record(trace_t *t, size_t *offset, trace_record_t *rec, char **payload)
+{
+	if (*offset + sizeof(trace_record_t) > t->size) {
+		return false;
+	}
+	memcpy(rec, t->data + *offset, sizeof(trace_record_t));
+	if (*offset + sizeof(trace_record_t) + rec->length > t->size) {
+		return false;
+	}
+	*payload = t->data + *offset + sizeof(trace_record_t);
+	*offset += sizeof(trace_record_t) + rec->length;
+	return true;
+}
+
+static const char *event_name(uint8_t type)
+{
+	switch (type) {
+		case XCB_MAP_REQUEST:
+			return "map_request";
+		case XCB_DESTROY_NOTIFY:
+			return "destroy_notify";
+		case XCB_UNMAP_NOTIFY:
+			return "unmap_notify";
+		case XCB_CLIENT_MESSAGE:
+			return "client_message";
+		case XCB_CONFIGURE_REQUEST:
+			return "configure_request";
+		case XCB_CONFIGURE_NOTIFY:
+			return "configure_notify";
+		case XCB_PROPERTY_NOTIFY:
+			return "property_notify";
+		case XCB_ENTER_NOTIFY:
+			return "enter_notify";
+		case XCB_MOTION_NOTIFY:
+			return "motion_notify";
+		case XCB_BUTTON_PRESS:
+			return "button_press";
+		case XCB_FOCUS_IN:
+			return "focus_in";
+		case XCB_MAPPING_NOTIFY:
+			return "mapping_notify";
+		case 0:
+			return "error";
+		default:
+			return "other_event";
+	}
+}
+
+/* Messages are named after their domain, e.g. 'node' or 'query'. */
+static void record_name(trace_record_t *rec, char *payload, char *name, size_t len)
+{
+	if (rec->kind == TRACE_EVENT) {
+		snprintf(name, len, "%s", event_name((uint8_t) payload[0] & ~0x80));
+	} else {
+		int n = strnlen(payload, rec->length);
+		snprintf(name, len, "message %.*s", n, payload);
+	}
+}
+
+static void summary_add(summary_t *s, const char *name, uint64_t value)
+{
+	series_t *r = NULL;
+	for (size_t i = 0; i < s->len && r == NULL; i++) {
+		if (streq(s->items[i].name, name)) {
+			r = &s->items[i];
+		}
+	}
+	if (r == NULL) {
+		if (s->len == s->cap) {
+			size_t cap = (s->cap > 0 ? 2 * s->cap : 16);
+			series_t *items = realloc(s->items, cap * sizeof(series_t));
+			if (items == NULL) {
+				return;
+			}
+			s->items = items;
+			s->cap = cap;
+		}
+		r = &s->items[s->len++];
+		snprintf(r->name, sizeof(r->name), "%s", name);
+		r->values = NULL;
+		r->len = r->cap = 0;
+	}
+	if (r->len == r->cap) {
+		size_t cap = (r->cap > 0 ? 2 * r->cap : 64);
+		uint64_t *values = realloc(r->values, cap * sizeof(uint64_t));
+		if (values == NULL) {
+			return;
+		}
+		r->values = values;
+		r->cap = cap;
+	}
+	r->values[r->len++] = value;
+}
+
+static int compare_values(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+	return (x > y) - (x < y);
+}
+
+static void print_summary(summary_t *s, const char *title)
+{
+	printf("%-28s %8s %10s %10s %10s %10s\n", title, "count", "mean_us", "p50_us", "p99_us", "max_us");
+	for (size_t i = 0; i < s->len; i++) {
+		series_t *r = &s->items[i];
+		uint64_t total = 0;
+		qsort(r->values, r->len, sizeof(uint64_t), compare_values);
+		for (size_t j = 0; j < r->len; j++) {
+			total += r->values[j];
+		}
+		printf("%-28s %8zu %10.1f %10llu %10llu %10llu\n", r->name, r->len, (double) total / r->len,
+		       (unsigned long long) r->values[r->len / 2], (unsigned long long) r->values[(r->len * 99) / 100],
+		       (unsigned long long) r->values[r->len - 1]);
+		free(r->values);
+	}
+	free(s->items);
+	s->items = NULL;
+	s->len = s->cap = 0;
+}
+
+static int summarize_trace(const char *path, bool list)
+{
+	trace_t t;
+	if (!read_trace(path, &t)) {
+		err("Can't read the trace '%s'.\n", path);
+	}
+
+	summary_t s = {NULL, 0, 0};
+	size_t offset = sizeof(trace_header_t);
+	trace_record_t rec;
+	char *payload;
+	char name[SMALEN];
+
+	while (next_record(&t, &offset, &rec, &payload)) {
+		if (rec.kind == TRACE_ATOM) {
+			continue;
+		}
+		record_name(&rec, payload, name, sizeof(name));
+		if (list) {
+			printf("%12llu %-28s %10u\n", (unsigned long long) rec.time, name, rec.duration);
+		} else {
+			summary_add(&s, name, rec.duration);
+		}
+	}
+
+	if (!list) {
+		print_summary(&s, "handled");
+	}
+
+	free(t.data);
+	return EXIT_SUCCESS;
+}
+
+static uint32_t id_map_get(id_map_t *m, uint32_t key)
+{
+	if (m->cap == 0) {
+		return XCB_NONE;
+	}
+	for (size_t i = key % m->cap; m->keys[i] != 0; i = (i + 1) % m->cap) {
+		if (m->keys[i] == key) {
+			return m->values[i];
+		}
+	}
+	return XCB_NONE;
+}
+
+/* Removed entries keep their key, with a null value, to preserve the probe sequences. */
+static void id_map_put(id_map_t *m, uint32_t key, uint32_t value)
+{
+	if (2 * (m->len + 1) > m->cap) {
+		id_map_t g = {NULL, NULL, 0, m->cap > 0 ? 2 * m->cap : 256};
+		g.keys = calloc(g.cap, sizeof(uint32_t));
+		g.values = calloc(g.cap, sizeof(uint32_t));
+		if (g.keys == NULL || g.values == NULL) {
+			err("Can't grow the identifiers map.\n");
+		}
+		for (size_t i = 0; i < m->cap; i++) {
+			if (m->keys[i] != 0 && m->values[i] != 0) {
+				id_map_put(&g, m->keys[i], m->values[i]);
+			}
+		}
+		free(m->keys);
+		free(m->values);
+		*m = g;
+	}
+	size_t i = key % m->cap;
+	while (m->keys[i] != 0 && m->keys[i] != key) {
+		i = (i + 1) % m->cap;
+	}
+	if (m->keys[i] == 0) {
+		m->keys[i] = key;
+		m->len++;
+	}
+	m->values[i] = value;
+}
+
+static xcb_atom_t intern_atom(const char *name, size_t len)
+{
+	xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(dpy, xcb_intern_atom(dpy, 0, len, name), NULL);
+	xcb_atom_t atom = (reply != NULL ? reply->atom : XCB_NONE);
+	free(reply);
+	return atom;
+}
+
+static xcb_atom_t translate_atom(xcb_atom_t atom)
+{
+	if (atom <= XCB_ATOM_WM_TRANSIENT_FOR) {
+		return atom;
+	}
+	return id_map_get(&atoms, atom);
+}
+
+static xcb_window_t stand_in(xcb_window_t win)
+{
+	xcb_window_t w = id_map_get(&windows, win);
+	if (w != XCB_NONE) {
+		return w;
+	}
+	w = xcb_generate_id(dpy);
+	uint32_t values[] = {screen->white_pixel};
+	xcb_create_window(dpy, XCB_COPY_FROM_PARENT, w, screen->root, 0, 0, REPLAY_WINDOW_SIZE, REPLAY_WINDOW_SIZE, 0,
+	                  XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, XCB_CW_BACK_PIXEL, values);
+	const char class[] = "bspwm-replay\0Bspwm-replay";
+	xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, w, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8, sizeof(class), class);
+	id_map_put(&windows, win, w);
+	return w;
+}
+
+static void change_property(xcb_window_t w, xcb_atom_t atom, uint8_t state)
+{
+	if (state == XCB_PROPERTY_DELETE) {
+		xcb_delete_property(dpy, w, atom);
+		return;
+	}
+	uint32_t zeros[18] = {0};
+	if (atom == XCB_ATOM_WM_HINTS) {
+		xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, w, atom, XCB_ATOM_WM_HINTS, 32, 9, zeros);
+	} else if (atom == XCB_ATOM_WM_NORMAL_HINTS) {
+		xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, w, atom, XCB_ATOM_WM_SIZE_HINTS, 32, 18, zeros);
+	} else if (atom == net_wm_strut_partial) {
+		xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, w, atom, XCB_ATOM_CARDINAL, 32, 12, zeros);
+	} else if (atom == XCB_ATOM_WM_NAME || atom == net_wm_name) {
+		char name[SMALEN];
+		int len = snprintf(name, sizeof(name), "replay %u", name_counter++);
+		xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, w, atom, atom == net_wm_name ? utf8_string : XCB_ATOM_STRING, 8, len, name);
+	}
+}
+
+/* Reproduces the cause of the given event, returns false if it can't be reproduced. */
+static bool replay_event(xcb_generic_event_t *evt, xcb_window_t traced_root)
+{
+	switch (evt->response_type & ~0x80) {
+		case XCB_MAP_REQUEST: {
+			xcb_map_request_event_t *e = (xcb_map_request_event_t *) evt;
+			xcb_map_window(dpy, stand_in(e->window));
+			return true;
+		}
+		case XCB_UNMAP_NOTIFY: {
+			xcb_unmap_notify_event_t *e = (xcb_unmap_notify_event_t *) evt;
+			xcb_window_t w = id_map_get(&windows, e->window);
+			if (w == XCB_NONE) {
+				return false;
+			}
+			xcb_unmap_window(dpy, w);
+			return true;
+		}
+		case XCB_DESTROY_NOTIFY: {
+			xcb_destroy_notify_event_t *e = (xcb_destroy_notify_event_t *) evt;
+			xcb_window_t w = id_map_get(&windows, e->window);
+			if (w == XCB_NONE) {
+				return false;
+			}
+			xcb_destroy_window(dpy, w);
+			id_map_put(&windows, e->window, XCB_NONE);
+			return true;
+		}
+		case XCB_CONFIGURE_REQUEST: {
+			xcb_configure_request_event_t *e = (xcb_configure_request_event_t *) evt;
+			xcb_window_t w = stand_in(e->window);
+			uint16_t mask = e->value_mask;
+			uint32_t values[7];
+			int i = 0;
+			xcb_window_t sibling = id_map_get(&windows, e->sibling);
+			if (sibling == XCB_NONE) {
+				mask &= ~XCB_CONFIG_WINDOW_SIBLING;
+			}
+			if (mask & XCB_CONFIG_WINDOW_X) {
+				values[i++] = e->x;
+			}
+			if (mask & XCB_CONFIG_WINDOW_Y) {
+				values[i++] = e->y;
+			}
+			if (mask & XCB_CONFIG_WINDOW_WIDTH) {
+				values[i++] = e->width;
+			}
+			if (mask & XCB_CONFIG_WINDOW_HEIGHT) {
+				values[i++] = e->height;
+			}
+			if (mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) {
+				values[i++] = e->border_width;
+			}
+			if (mask & XCB_CONFIG_WINDOW_SIBLING) {
+				values[i++] = sibling;
+			}
+			if (mask & XCB_CONFIG_WINDOW_STACK_MODE) {
+				values[i++] = e->stack_mode;
+			}
+			xcb_configure_window(dpy, w, mask, values);
+			return true;
+		}
+		case XCB_PROPERTY_NOTIFY: {
+			xcb_property_notify_event_t *e = (xcb_property_notify_event_t *) evt;
+			xcb_window_t w = id_map_get(&windows, e->window);
+			xcb_atom_t atom = translate_atom(e->atom);
+			if (w == XCB_NONE || atom == XCB_NONE) {
+				return false;
+			}
+			change_property(w, atom, e->state);
+			return true;
+		}
+		case XCB_CLIENT_MESSAGE: {
+			xcb_client_message_event_t e = *(xcb_client_message_event_t *) evt;
+			e.response_type = XCB_CLIENT_MESSAGE;
+			e.type = translate_atom(e.type);
+			e.window = (e.window == traced_root ? screen->root : id_map_get(&windows, e.window));
+			if (e.type == XCB_NONE || e.window == XCB_NONE) {
+				return false;
+			}
+			if (e.type == net_wm_state && e.format == 32) {
+				for (int i = 1; i < 3; i++) {
+					e.data.data32[i] = translate_atom(e.data.data32[i]);
+				}
+			}
+			xcb_send_event(dpy, false, screen->root, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT, (const char *) &e);
+			return true;
+		}
+		case XCB_ENTER_NOTIFY:
+		case XCB_MOTION_NOTIFY: {
+			/* Both events start with the same fields. */
+			xcb_motion_notify_event_t *e = (xcb_motion_notify_event_t *) evt;
+			xcb_warp_pointer(dpy, XCB_NONE, screen->root, 0, 0, 0, 0, e->root_x, e->root_y);
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+static int connect_socket(void)
+{
+	struct sockaddr_un sock_address;
+	sock_address.sun_family = AF_UNIX;
+	char *sp = getenv(SOCKET_ENV_VAR);
+	if (sp != NULL) {
+		snprintf(sock_address.sun_path, sizeof(sock_address.sun_path), "%s", sp);
+	} else {
+		char *host = NULL;
+		int dn = 0, sn = 0;
+		if (xcb_parse_display(NULL, &host, &dn, &sn) != 0) {
+			snprintf(sock_address.sun_path, sizeof(sock_address.sun_path), SOCKET_PATH_TPL, host, dn, sn);
+		}
+		free(host);
+	}
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1 || connect(fd, (struct sockaddr *) &sock_address, sizeof(sock_address)) == -1) {
+		err("Failed to connect to the socket.\n");
+	}
+	return fd;
+}
+
+/* Sends a message and waits for the end of the response, returns false on failure. */
+static bool send_message(const char *msg, size_t len)
+{
+	char rsp[BUFSIZ];
+	int fd = connect_socket();
+	bool ok = (send(fd, msg, len, 0) != -1);
+	ssize_t n;
+	bool first = true;
+	while (ok && (n = recv(fd, rsp, sizeof(rsp), 0)) > 0) {
+		if (first && rsp[0] == FAILURE_MESSAGE[0]) {
+			ok = false;
+		}
+		first = false;
+	}
+	close(fd);
+	return ok;
+}
+
+static bool set_trace_path(const char *path)
+{
+	char msg[BUFSIZ];
+	int len = snprintf(msg, sizeof(msg), "config%ctrace_path%c%s%c", 0, 0, path, 0);
+	return len < (int) sizeof(msg) && send_message(msg, len);
+}
+
+/* Subscriptions would never end, the others would alter the session. */
+static bool is_replayable(char *msg, size_t len)
+{
+	char *arg1 = msg;
+	size_t n = strnlen(arg1, len);
+	char *arg2 = (n + 1 < len ? arg1 + n + 1 : "");
+	return !streq("subscribe", arg1) && !streq("quit", arg1) &&
+	       !(streq("config", arg1) && streq("trace_path", arg2)) &&
+	       !(streq("wm", arg1) && (streq("-r", arg2) || streq("--restart", arg2)));
+}
+
+static int replay_trace(const char *path, bool paced, const char *output)
+{
+	trace_t t;
+	if (!read_trace(path, &t)) {
+		err("Can't read the trace '%s'.\n", path);
+	}
+
+	int default_screen;
+	dpy = xcb_connect(NULL, &default_screen);
+	if (xcb_connection_has_error(dpy)) {
+		err("Can't open the display.\n");
+	}
+	xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(dpy));
+	for (int i = 0; i < default_screen; i++) {
+		xcb_screen_next(&it);
+	}
+	screen = it.data;
+
+	size_t offset = sizeof(trace_header_t);
+	trace_record_t rec;
+	char *payload;
+
+	while (next_record(&t, &offset, &rec, &payload)) {
+		if (rec.kind == TRACE_ATOM && rec.length > sizeof(uint32_t)) {
+			uint32_t traced;
+			memcpy(&traced, payload, sizeof(traced));
+			xcb_atom_t atom = intern_atom(payload + sizeof(traced), rec.length - sizeof(traced));
+			if (atom != XCB_NONE) {
+				id_map_put(&atoms, traced, atom);
+			}
+		}
+	}
+
+	net_wm_name = intern_atom("_NET_WM_NAME", strlen("_NET_WM_NAME"));
+	net_wm_strut_partial = intern_atom("_NET_WM_STRUT_PARTIAL", strlen("_NET_WM_STRUT_PARTIAL"));
+	net_wm_state = intern_atom("_NET_WM_STATE", strlen("_NET_WM_STATE"));
+	utf8_string = intern_atom("UTF8_STRING", strlen("UTF8_STRING"));
+
+	char output_path[2 * MAXLEN];
+	if (output != NULL) {
+		char cwd[MAXLEN];
+		if (output[0] != '/' && getcwd(cwd, sizeof(cwd)) != NULL) {
+			snprintf(output_path, sizeof(output_path), "%s/%s", cwd, output);
+		} else {
+			snprintf(output_path, sizeof(output_path), "%s", output);
+		}
+		if (!set_trace_path(output_path)) {
+			err("Can't trace the replay into '%s'.\n", output_path);
+		}
+	}
+
+	summary_t sent = {NULL, 0, 0}, skipped = {NULL, 0, 0};
+	char name[SMALEN];
+	uint64_t start = replay_clock();
+	offset = sizeof(trace_header_t);
+
+	while (next_record(&t, &offset, &rec, &payload)) {
+		if (rec.kind == TRACE_ATOM) {
+			continue;
+		}
+		if (paced) {
+			uint64_t now = replay_clock();
+			if (start + rec.time > now) {
+				replay_sleep(start + rec.time - now);
+			}
+		}
+		record_name(&rec, payload, name, sizeof(name));
+		if (rec.kind == TRACE_EVENT && rec.length >= TRACE_EVENT_SIZE) {
+			xcb_generic_event_t evt = {0};
+			memcpy(&evt, payload, TRACE_EVENT_SIZE);
+			if (replay_event(&evt, t.header->root)) {
+				xcb_flush(dpy);
+				summary_add(&sent, name, 0);
+			} else {
+				summary_add(&skipped, name, 0);
+			}
+		} else if (rec.kind == TRACE_MESSAGE && is_replayable(payload, rec.length)) {
+			/* The pending requests must reach the server before the message is handled. */
+			free(xcb_get_input_focus_reply(dpy, xcb_get_input_focus(dpy), NULL));
+			uint64_t sent_at = replay_clock();
+			send_message(payload, rec.length);
+			summary_add(&sent, name, replay_clock() - sent_at);
+		} else {
+			summary_add(&skipped, name, 0);
+		}
+	}
+
+	free(xcb_get_input_focus_reply(dpy, xcb_get_input_focus(dpy), NULL));
+	replay_sleep(REPLAY_SETTLE_DELAY);
+
+	if (output != NULL) {
+		set_trace_path("");
+	}
+
+	print_summary(&sent, "replayed");
+	print_summary(&skipped, "skipped");
+
+	free(windows.keys);
+	free(windows.values);
+	free(atoms.keys);
+	free(atoms.values);
+	free(t.data);
+	xcb_disconnect(dpy);
+
+	if (output != NULL) {
+		printf("\n");
+		return summarize_trace(output_path, false);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+	bool paced = true, summarize = false, list = false;
+	char *output = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "haslo:")) != -1) {
+		switch (opt) {
+			case 'h':
+				printf("bspwm-replay [-h|-a|-s|-l|-o OUTPUT] TRACE\n");
+				return EXIT_SUCCESS;
+			case 'a':
+				paced = false;
+				break;
+			case 's':
+				summarize = true;
+				break;
+			case 'l':
+				list = true;
+				break;
+			case 'o':
+				output = optarg;
+				break;
+			default:
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (optind >= argc) {
+		err("No trace given.\n");
+	}
+
+	if (summarize || list) {
+		return summarize_trace(argv[optind], list);
+	}
+
+	return replay_trace(argv[optind], paced, output);
+}
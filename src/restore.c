@@ -27,6 +27,7 @@
 #include <string.h>
 #include <unistd.h>
 #include "bspwm.h"
+#include "backend.h"
 #include "desktop.h"
 #include "ewmh.h"
 #include "history.h"
@@ -37,9 +38,12 @@
 #include "tree.h"
 #include "settings.h"
 #include "subscribe.h"
+#include "manage.h"
 #include "restore.h"
 #include "window.h"
 #include "parse.h"
+#include "journal.h"
+#include "registry.h"
 
 bool restore_state(const char *file_path)
 {
@@ -183,19 +187,46 @@ bool restore_state(const char *file_path)
 		restore_stack(&stacking_list_token, json);
 	}
 
+	replay_journal(file_path);
+
+	/* Send the requests of every client before waiting for any reply. */
+	unsigned int n_clients = 0;
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-		m->id = xcb_generate_id(dpy);
 		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			d->id = xcb_generate_id(dpy);
+			n_clients += clients_count_in(d->root);
+		}
+	}
+
+	client_cookies_t *cookies = malloc(n_clients * sizeof(client_cookies_t));
+	unsigned int i = 0;
+
+	if (cookies != NULL) {
+		for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+			for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+				for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
+					if (n->client != NULL) {
+						request_client_cookies(n->id, &cookies[i++]);
+					}
+				}
+			}
+		}
+	}
+
+	i = 0;
+
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		m->id = backend->generate_id();
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			d->id = backend->generate_id();
 			regenerate_ids_in(d->root);
 			refresh_presel_feedbacks(m, d, d->root);
 			restack_presel_feedbacks(d);
 
-			for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 				if (n->client == NULL) {
 					continue;
 				}
-				initialize_client(n);
+				initialize_client(n, cookies != NULL ? &cookies[i++] : NULL);
 				uint32_t values[] = {CLIENT_EVENT_MASK | (focus_follows_pointer ? XCB_EVENT_MASK_ENTER_WINDOW : 0)};
 				xcb_change_window_attributes(dpy, n->id, XCB_CW_EVENT_MASK, values);
 				window_grab_buttons(n->id);
@@ -203,6 +234,14 @@ bool restore_state(const char *file_path)
 		}
 	}
 
+	free(cookies);
+
+	rebuild_registry();
+
+	if (desktop_containers) {
+		update_desktop_containers();
+	}
+
 	ewmh_update_number_of_desktops();
 	ewmh_update_desktop_names();
 	ewmh_update_desktop_viewport();
@@ -298,6 +337,11 @@ monitor_t *restore_monitor(jsmntok_t **t, char *json)
 		}
 	}
 
+	m->sticky_count = 0;
+	if (m->desk != NULL) {
+		register_stickies(m, m->desk->root);
+	}
+
 	return m;
 }
 
@@ -327,6 +371,7 @@ desktop_t *restore_desktop(jsmntok_t **t, char *json)
 		} else if (keyeq("root", *t, json)) {
 			(*t)++;
 			d->root = restore_node(t, json);
+			thread_leaves(d, d->root);
 			continue;
 		} else {
 			warn("Restore desktop: unknown key: '%.*s'.\n", (*t)->end - (*t)->start, json + (*t)->start);
@@ -450,6 +495,9 @@ client_t *restore_client(jsmntok_t **t, char *json)
 			} else if (keyeq("instanceName", *t, json)) {
 				(*t)++;
 				snprintf(c->instance_name, (*t)->end - (*t)->start + 1, "%s", json + (*t)->start);
+			} else if (keyeq("title", *t, json)) {
+				/* Read again from the window when the client is initialized. */
+				(*t)++;
 			RESTORE_ANY(state, &c->state, parse_client_state)
 			RESTORE_ANY(lastState, &c->last_state, parse_client_state)
 			RESTORE_ANY(layer, &c->layer, parse_stack_layer)
@@ -583,6 +631,35 @@ void restore_subscriber(subscriber_list_t *s, jsmntok_t **t, char *json)
 			s->fifo_path = copy_string(json + (*t)->start, (*t)->end - (*t)->start);
 		RESTORE_INT(field, &s->field)
 		RESTORE_INT(count, &s->count)
+		} else if (keyeq("filter", *t, json)) {
+			(*t)++;
+			free_subscriber_filter(s->filter);
+			s->filter = make_subscriber_filter();
+			restore_subscriber_filter(s->filter, t, json);
+			continue;
+		}
+		(*t)++;
+	}
+}
+
+void restore_subscriber_filter(subscriber_filter_t *f, jsmntok_t **t, char *json)
+{
+	int n = (*t)->size;
+	(*t)++;
+
+	for (int i = 0; i < n; i++) {
+		if (keyeq("monitorId", *t, json)) {
+			(*t)++;
+			sscanf(json + (*t)->start, "%u", &f->monitor_id);
+		} else if (keyeq("desktopId", *t, json)) {
+			(*t)++;
+			sscanf(json + (*t)->start, "%u", &f->desktop_id);
+		} else if (keyeq("nodeId", *t, json)) {
+			(*t)++;
+			sscanf(json + (*t)->start, "%u", &f->node_id);
+		RESTORE_ANY(monitorModifiers, f, set_monitor_filter)
+		RESTORE_ANY(desktopModifiers, f, set_desktop_filter)
+		RESTORE_ANY(nodeModifiers, f, set_node_filter)
 		}
 		(*t)++;
 	}
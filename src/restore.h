@@ -39,6 +39,7 @@ void restore_padding(padding_t *p, jsmntok_t **t, char *json);
 void restore_history(jsmntok_t **t, char *json);
 void restore_subscribers(jsmntok_t **t, char *json);
 void restore_subscriber(subscriber_list_t *s, jsmntok_t **t, char *json);
+void restore_subscriber_filter(subscriber_filter_t *f, jsmntok_t **t, char *json);
 void restore_coordinates(coordinates_t *loc, jsmntok_t **t, char *json);
 void restore_stack(jsmntok_t **t, char *json);
 bool keyeq(char *s, jsmntok_t *key, char *json);
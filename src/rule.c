@@ -216,10 +216,10 @@ event_queue_t *make_event_queue(xcb_generic_event_t *evt)
 		*(csq->layer) = (val); \
 	} while (0)
 
-void _apply_window_type(xcb_window_t win, rule_consequence_t *csq)
+void _apply_window_type(xcb_window_t win, xcb_get_property_cookie_t cookie, rule_consequence_t *csq)
 {
 	xcb_ewmh_get_atoms_reply_t win_type;
-	if (xcb_ewmh_get_wm_window_type_reply(ewmh, xcb_ewmh_get_wm_window_type(ewmh, win), &win_type, NULL) == 1) {
+	if (xcb_ewmh_get_wm_window_type_reply(ewmh, cookie, &win_type, NULL) == 1) {
 		for (unsigned int i = 0; i < win_type.atoms_len; i++) {
 			xcb_atom_t a = win_type.atoms[i];
 			if (a == ewmh->_NET_WM_WINDOW_TYPE_TOOLBAR ||
@@ -241,10 +241,10 @@ void _apply_window_type(xcb_window_t win, rule_consequence_t *csq)
 	}
 }
 
-void _apply_window_state(xcb_window_t win, rule_consequence_t *csq)
+void _apply_window_state(xcb_get_property_cookie_t cookie, rule_consequence_t *csq)
 {
 	xcb_ewmh_get_atoms_reply_t win_state;
-	if (xcb_ewmh_get_wm_state_reply(ewmh, xcb_ewmh_get_wm_state(ewmh, win), &win_state, NULL) == 1) {
+	if (xcb_ewmh_get_wm_state_reply(ewmh, cookie, &win_state, NULL) == 1) {
 		for (unsigned int i = 0; i < win_state.atoms_len; i++) {
 			xcb_atom_t a = win_state.atoms[i];
 			if (a == ewmh->_NET_WM_STATE_FULLSCREEN) {
@@ -261,19 +261,19 @@ void _apply_window_state(xcb_window_t win, rule_consequence_t *csq)
 	}
 }
 
-void _apply_transient(xcb_window_t win, rule_consequence_t *csq)
+void _apply_transient(xcb_get_property_cookie_t cookie, rule_consequence_t *csq)
 {
 	xcb_window_t transient_for = XCB_NONE;
-	xcb_icccm_get_wm_transient_for_reply(dpy, xcb_icccm_get_wm_transient_for(dpy, win), &transient_for, NULL);
+	xcb_icccm_get_wm_transient_for_reply(dpy, cookie, &transient_for, NULL);
 	if (transient_for != XCB_NONE) {
 		SET_CSQ_STATE(STATE_FLOATING);
 	}
 }
 
-void _apply_hints(xcb_window_t win, rule_consequence_t *csq)
+void _apply_hints(xcb_get_property_cookie_t cookie, rule_consequence_t *csq)
 {
 	xcb_size_hints_t size_hints;
-	if (xcb_icccm_get_wm_normal_hints_reply(dpy, xcb_icccm_get_wm_normal_hints(dpy, win), &size_hints, NULL) == 1) {
+	if (xcb_icccm_get_wm_normal_hints_reply(dpy, cookie, &size_hints, NULL) == 1) {
 		if ((size_hints.flags & (XCB_ICCCM_SIZE_HINT_P_MIN_SIZE | XCB_ICCCM_SIZE_HINT_P_MAX_SIZE)) &&
 		    size_hints.min_width == size_hints.max_width && size_hints.min_height == size_hints.max_height) {
 			SET_CSQ_STATE(STATE_FLOATING);
@@ -281,20 +281,20 @@ void _apply_hints(xcb_window_t win, rule_consequence_t *csq)
 	}
 }
 
-void _apply_class(xcb_window_t win, rule_consequence_t *csq)
+void _apply_class(xcb_get_property_cookie_t cookie, rule_consequence_t *csq)
 {
 	xcb_icccm_get_wm_class_reply_t reply;
-	if (xcb_icccm_get_wm_class_reply(dpy, xcb_icccm_get_wm_class(dpy, win), &reply, NULL) == 1) {
+	if (xcb_icccm_get_wm_class_reply(dpy, cookie, &reply, NULL) == 1) {
 		snprintf(csq->class_name, sizeof(csq->class_name), "%s", reply.class_name);
 		snprintf(csq->instance_name, sizeof(csq->instance_name), "%s", reply.instance_name);
 		xcb_icccm_get_wm_class_reply_wipe(&reply);
 	}
 }
 
-void _apply_name(xcb_window_t win, rule_consequence_t *csq)
+void _apply_name(xcb_get_property_cookie_t cookie, rule_consequence_t *csq)
 {
 	xcb_icccm_get_text_property_reply_t reply;
-	if (xcb_icccm_get_wm_name_reply(dpy, xcb_icccm_get_wm_name(dpy, win), &reply, NULL) == 1) {
+	if (xcb_icccm_get_wm_name_reply(dpy, cookie, &reply, NULL) == 1) {
 		snprintf(csq->name, sizeof(csq->name), "%s", reply.name);
 		xcb_icccm_get_text_property_reply_wipe(&reply);
 	}
@@ -311,14 +311,40 @@ void parse_keys_values(char *buf, rule_consequence_t *csq)
 	}
 }
 
-void apply_rules(xcb_window_t win, rule_consequence_t *csq)
+void request_rule_cookies(xcb_window_t win, rule_cookies_t *rc)
 {
-	_apply_window_type(win, csq);
-	_apply_window_state(win, csq);
-	_apply_transient(win, csq);
-	_apply_hints(win, csq);
-	_apply_class(win, csq);
-	_apply_name(win, csq);
+	rc->window_type = xcb_ewmh_get_wm_window_type(ewmh, win);
+	rc->window_state = xcb_ewmh_get_wm_state(ewmh, win);
+	rc->transient_for = xcb_icccm_get_wm_transient_for(dpy, win);
+	rc->normal_hints = xcb_icccm_get_wm_normal_hints(dpy, win);
+	rc->class = xcb_icccm_get_wm_class(dpy, win);
+	rc->name = xcb_icccm_get_wm_name(dpy, win);
+}
+
+void discard_rule_cookies(rule_cookies_t *rc)
+{
+	xcb_discard_reply(dpy, rc->window_type.sequence);
+	xcb_discard_reply(dpy, rc->window_state.sequence);
+	xcb_discard_reply(dpy, rc->transient_for.sequence);
+	xcb_discard_reply(dpy, rc->normal_hints.sequence);
+	xcb_discard_reply(dpy, rc->class.sequence);
+	xcb_discard_reply(dpy, rc->name.sequence);
+}
+
+void apply_rules(xcb_window_t win, rule_cookies_t *rc, rule_consequence_t *csq)
+{
+	rule_cookies_t cookies;
+	if (rc == NULL) {
+		request_rule_cookies(win, &cookies);
+		rc = &cookies;
+	}
+
+	_apply_window_type(win, rc->window_type, csq);
+	_apply_window_state(rc->window_state, csq);
+	_apply_transient(rc->transient_for, csq);
+	_apply_hints(rc->normal_hints, csq);
+	_apply_class(rc->class, csq);
+	_apply_name(rc->name, csq);
 
 	rule_t *rule = rule_head;
 	while (rule != NULL) {
@@ -39,14 +39,16 @@ void add_pending_rule(pending_rule_t *pr);
 void remove_pending_rule(pending_rule_t *pr);
 void postpone_event(pending_rule_t *pr, xcb_generic_event_t *evt);
 event_queue_t *make_event_queue(xcb_generic_event_t *evt);
-void _apply_window_type(xcb_window_t win, rule_consequence_t *csq);
-void _apply_window_state(xcb_window_t win, rule_consequence_t *csq);
-void _apply_transient(xcb_window_t win, rule_consequence_t *csq);
-void _apply_hints(xcb_window_t win, rule_consequence_t *csq);
-void _apply_class(xcb_window_t win, rule_consequence_t *csq);
-void _apply_name(xcb_window_t win, rule_consequence_t *csq);
+void _apply_window_type(xcb_window_t win, xcb_get_property_cookie_t cookie, rule_consequence_t *csq);
+void _apply_window_state(xcb_get_property_cookie_t cookie, rule_consequence_t *csq);
+void _apply_transient(xcb_get_property_cookie_t cookie, rule_consequence_t *csq);
+void _apply_hints(xcb_get_property_cookie_t cookie, rule_consequence_t *csq);
+void _apply_class(xcb_get_property_cookie_t cookie, rule_consequence_t *csq);
+void _apply_name(xcb_get_property_cookie_t cookie, rule_consequence_t *csq);
 void parse_keys_values(char *buf, rule_consequence_t *csq);
-void apply_rules(xcb_window_t win, rule_consequence_t *csq);
+void request_rule_cookies(xcb_window_t win, rule_cookies_t *rc);
+void discard_rule_cookies(rule_cookies_t *rc);
+void apply_rules(xcb_window_t win, rule_cookies_t *rc, rule_consequence_t *csq);
 bool schedule_rules(xcb_window_t win, rule_consequence_t *csq);
 void parse_rule_consequence(int fd, rule_consequence_t *csq);
 void parse_key_value(char *key, char *value, rule_consequence_t *csq);
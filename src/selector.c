@@ -0,0 +1,418 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bspwm.h"
+#include "history.h"
+#include "parse.h"
+#include "query.h"
+#include "tree.h"
+#include "window.h"
+#include "selector.h"
+
+/* Most recently used first. */
+static node_desc_t *node_desc_head = NULL;
+static node_desc_t *node_desc_tail = NULL;
+static int node_desc_count = 0;
+
+/* Mirrors the parsing of the descriptor done by the former node_from_desc: the
+ * errors are recorded in `status` and reported after the reference is resolved. */
+node_desc_t *make_node_desc(char *desc)
+{
+	node_desc_t *nd = calloc(1, sizeof(node_desc_t));
+	nd->text = copy_string(desc, strlen(desc));
+	nd->status = SELECTOR_OK;
+	nd->sel = make_node_select();
+
+	char *desc_copy = copy_string(desc, strlen(desc));
+	desc = desc_copy;
+
+	char *hash = strrchr(desc, '#');
+	char *path = strrchr(desc, '@');
+	char *colon = strrchr(desc, ':');
+
+	/* Adjust or discard hashes inside a DESKTOP_SEL, e.g. `newest#@prev#older:/1/2` */
+	if (hash != NULL && colon != NULL && path != NULL &&
+	    path < hash && hash < colon) {
+		if (path > desc && *(path - 1) == '#') {
+			hash = path - 1;
+		} else {
+			hash = NULL;
+		}
+	}
+
+	if (hash != NULL) {
+		*hash = '\0';
+		nd->reference = make_node_desc(desc);
+		desc = hash + 1;
+	}
+
+	/* Discard colons within references, e.g. `@next.occupied:/#any.descendant_of.window` */
+	if (colon != NULL && hash != NULL && colon < hash) {
+		colon = NULL;
+	}
+
+	if (!parse_node_modifiers(colon != NULL ? colon : desc, &nd->sel)) {
+		nd->status = SELECTOR_BAD_MODIFIERS;
+		free(desc_copy);
+		return nd;
+	}
+
+	if (parse_direction(desc, &nd->dir)) {
+		nd->kind = NODE_DESC_DIRECTION;
+	} else if (parse_cycle_direction(desc, &nd->cyc)) {
+		nd->kind = NODE_DESC_CYCLE;
+	} else if (parse_history_direction(desc, &nd->hdi)) {
+		nd->kind = NODE_DESC_HISTORY;
+	} else if (streq("any", desc)) {
+		nd->kind = NODE_DESC_ANY;
+	} else if (streq("all", desc)) {
+		nd->kind = NODE_DESC_ALL;
+	} else if (streq("first_ancestor", desc)) {
+		nd->kind = NODE_DESC_FIRST_ANCESTOR;
+	} else if (streq("last", desc)) {
+		nd->kind = NODE_DESC_LAST;
+	} else if (streq("newest", desc)) {
+		nd->kind = NODE_DESC_NEWEST;
+	} else if (streq("biggest", desc)) {
+		nd->kind = NODE_DESC_BIGGEST;
+	} else if (streq("smallest", desc)) {
+		nd->kind = NODE_DESC_SMALLEST;
+	} else if (streq("pointed", desc)) {
+		nd->kind = NODE_DESC_POINTED;
+	} else if (streq("focused", desc)) {
+		nd->kind = NODE_DESC_FOCUSED;
+	} else if (*desc == '@') {
+		nd->kind = NODE_DESC_PATH;
+		desc++;
+		if (colon != NULL) {
+			*colon = '\0';
+			nd->desktop = copy_string(desc, strlen(desc));
+			desc = colon + 1;
+		}
+		nd->from_root = (*desc == '/');
+		int cap = 0;
+		char *move = strtok(desc, PTH_TOK);
+		while (move != NULL) {
+			if (nd->path_len == cap) {
+				cap = (cap == 0 ? 4 : 2 * cap);
+				nd->path = realloc(nd->path, cap * sizeof(path_step_t));
+			}
+			path_step_t *step = &nd->path[nd->path_len++];
+			if (streq("first", move) || streq("1", move)) {
+				step->kind = PATH_FIRST;
+			} else if (streq("second", move) || streq("2", move)) {
+				step->kind = PATH_SECOND;
+			} else if (streq("parent", move)) {
+				step->kind = PATH_PARENT;
+			} else if (streq("brother", move)) {
+				step->kind = PATH_BROTHER;
+			} else if (parse_direction(move, &step->dir)) {
+				step->kind = PATH_FENCE;
+			} else {
+				/* only an error if the walk gets that far */
+				step->kind = PATH_INVALID;
+				break;
+			}
+			move = strtok(NULL, PTH_TOK);
+		}
+	} else if (parse_id(desc, &nd->id)) {
+		nd->kind = NODE_DESC_ID;
+	} else {
+		nd->status = SELECTOR_BAD_DESCRIPTOR;
+	}
+
+	free(desc_copy);
+	return nd;
+}
+
+void free_node_desc(node_desc_t *nd)
+{
+	if (nd == NULL) {
+		return;
+	}
+	free_node_desc(nd->reference);
+	free(nd->text);
+	free(nd->desktop);
+	free(nd->path);
+	free(nd);
+}
+
+node_desc_t *cached_node_desc(char *desc)
+{
+	uint32_t hash = hash_string(desc);
+	node_desc_t *nd = node_desc_head;
+
+	while (nd != NULL && (nd->hash != hash || !streq(nd->text, desc))) {
+		nd = nd->next;
+	}
+
+	if (nd != NULL) {
+		if (nd == node_desc_head) {
+			return nd;
+		}
+		nd->prev->next = nd->next;
+		if (nd->next != NULL) {
+			nd->next->prev = nd->prev;
+		} else {
+			node_desc_tail = nd->prev;
+		}
+	} else {
+		nd = make_node_desc(desc);
+		nd->hash = hash;
+		node_desc_count++;
+		if (node_desc_count > NODE_DESC_CACHE_SIZE) {
+			node_desc_t *last = node_desc_tail;
+			node_desc_tail = last->prev;
+			node_desc_tail->next = NULL;
+			free_node_desc(last);
+			node_desc_count--;
+		}
+	}
+
+	nd->prev = NULL;
+	nd->next = node_desc_head;
+	if (node_desc_head != NULL) {
+		node_desc_head->prev = nd;
+	} else {
+		node_desc_tail = nd;
+	}
+	node_desc_head = nd;
+
+	return nd;
+}
+
+void empty_node_desc_cache(void)
+{
+	node_desc_t *nd = node_desc_head;
+	while (nd != NULL) {
+		node_desc_t *next = nd->next;
+		free_node_desc(nd);
+		nd = next;
+	}
+	node_desc_head = node_desc_tail = NULL;
+	node_desc_count = 0;
+}
+
+int node_from_node_desc(node_desc_t *nd, coordinates_t *ref, coordinates_t *dst)
+{
+	dst->node = NULL;
+
+	coordinates_t ref_copy = *ref;
+	ref = &ref_copy;
+
+	if (nd->reference != NULL) {
+		int ret;
+		coordinates_t tmp = {mon, mon->desk, mon->desk->focus};
+		if ((ret = node_from_node_desc(nd->reference, &tmp, ref)) != SELECTOR_OK) {
+			return ret;
+		}
+	}
+
+	if (nd->status != SELECTOR_OK) {
+		return nd->status;
+	}
+
+	node_select_t *sel = &nd->sel;
+
+	switch (nd->kind) {
+		case NODE_DESC_DIRECTION:
+			find_nearest_neighbor(ref, dst, nd->dir, sel);
+			break;
+		case NODE_DESC_CYCLE:
+			find_closest_node(ref, dst, nd->cyc, sel);
+			break;
+		case NODE_DESC_HISTORY:
+			history_find_node(nd->hdi, ref, dst, sel);
+			break;
+		case NODE_DESC_ANY:
+			find_any_node(ref, dst, sel);
+			break;
+		case NODE_DESC_ALL:
+			/* Only valid as the target of the node command. */
+			return SELECTOR_BAD_DESCRIPTOR;
+		case NODE_DESC_FIRST_ANCESTOR:
+			find_first_ancestor(ref, dst, sel);
+			break;
+		case NODE_DESC_LAST:
+			history_find_node(HISTORY_OLDER, ref, dst, sel);
+			break;
+		case NODE_DESC_NEWEST:
+			history_find_newest_node(ref, dst, sel);
+			break;
+		case NODE_DESC_BIGGEST:
+			find_by_area(AREA_BIGGEST, ref, dst, sel);
+			break;
+		case NODE_DESC_SMALLEST:
+			find_by_area(AREA_SMALLEST, ref, dst, sel);
+			break;
+		case NODE_DESC_POINTED: {
+			xcb_window_t win = XCB_NONE;
+			query_pointer(&win, NULL);
+			if (locate_leaf(win, dst) && node_matches(dst, ref, sel)) {
+				return SELECTOR_OK;
+			} else {
+				return SELECTOR_INVALID;
+			}
+		}
+		case NODE_DESC_FOCUSED: {
+			coordinates_t loc = {mon, mon->desk, mon->desk->focus};
+			if (node_matches(&loc, ref, sel)) {
+				*dst = loc;
+			}
+			break;
+		}
+		case NODE_DESC_PATH:
+			return node_from_path(nd, ref, dst);
+		case NODE_DESC_ID:
+			if (find_by_id(nd->id, dst) && node_matches(dst, ref, sel)) {
+				return SELECTOR_OK;
+			} else {
+				return SELECTOR_INVALID;
+			}
+	}
+
+	if (dst->node == NULL) {
+		return SELECTOR_INVALID;
+	}
+
+	return SELECTOR_OK;
+}
+
+static bool collect_node_ids(monitor_t *m, desktop_t *d, node_t *n, coordinates_t *ref, node_select_t *sel, uint32_t **ids, int *len, int *cap)
+{
+	if (n == NULL) {
+		return true;
+	}
+	coordinates_t loc = {m, d, n};
+	if (node_matches(&loc, ref, sel)) {
+		if (*len == *cap) {
+			int c = (*cap == 0 ? 16 : 2 * *cap);
+			uint32_t *new = realloc(*ids, c * sizeof(uint32_t));
+			if (new == NULL) {
+				return false;
+			}
+			*ids = new;
+			*cap = c;
+		}
+		(*ids)[(*len)++] = n->id;
+	}
+	return collect_node_ids(m, d, n->first_child, ref, sel, ids, len, cap) &&
+	       collect_node_ids(m, d, n->second_child, ref, sel, ids, len, cap);
+}
+
+/* Collects the IDs of the nodes matching a selector whose descriptor is
+ * `all`, in the order of `any`. The IDs are freed by the caller. */
+int node_ids_from_node_desc(node_desc_t *nd, coordinates_t *ref, uint32_t **ids, int *len)
+{
+	*ids = NULL;
+	*len = 0;
+
+	coordinates_t ref_copy = *ref;
+	ref = &ref_copy;
+
+	if (nd->reference != NULL) {
+		int ret;
+		coordinates_t tmp = {mon, mon->desk, mon->desk->focus};
+		if ((ret = node_from_node_desc(nd->reference, &tmp, ref)) != SELECTOR_OK) {
+			return ret;
+		}
+	}
+
+	if (nd->status != SELECTOR_OK) {
+		return nd->status;
+	}
+
+	if (nd->kind != NODE_DESC_ALL) {
+		return SELECTOR_BAD_DESCRIPTOR;
+	}
+
+	int cap = 0;
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			if (!collect_node_ids(m, d, d->root, ref, &nd->sel, ids, len, &cap)) {
+				free(*ids);
+				*ids = NULL;
+				*len = 0;
+				return SELECTOR_INVALID;
+			}
+		}
+	}
+
+	return SELECTOR_OK;
+}
+
+int node_from_path(node_desc_t *nd, coordinates_t *ref, coordinates_t *dst)
+{
+	*dst = *ref;
+
+	if (nd->desktop != NULL) {
+		int ret;
+		if ((ret = desktop_from_desc(nd->desktop, ref, dst)) == SELECTOR_OK) {
+			dst->node = dst->desktop->focus;
+		} else {
+			return ret;
+		}
+	}
+
+	if (nd->from_root) {
+		dst->node = dst->desktop->root;
+	}
+
+	for (int i = 0; i < nd->path_len && dst->node != NULL; i++) {
+		path_step_t *step = &nd->path[i];
+		switch (step->kind) {
+			case PATH_FIRST:
+				dst->node = dst->node->first_child;
+				break;
+			case PATH_SECOND:
+				dst->node = dst->node->second_child;
+				break;
+			case PATH_PARENT:
+				dst->node = dst->node->parent;
+				break;
+			case PATH_BROTHER:
+				dst->node = brother_tree(dst->node);
+				break;
+			case PATH_FENCE:
+				dst->node = find_fence(dst->node, step->dir);
+				break;
+			case PATH_INVALID:
+				return SELECTOR_BAD_DESCRIPTOR;
+		}
+	}
+
+	if (dst->node != NULL) {
+		if (node_matches(dst, ref, &nd->sel)) {
+			return SELECTOR_OK;
+		} else {
+			return SELECTOR_INVALID;
+		}
+	} else if (dst->desktop->root != NULL) {
+		return SELECTOR_INVALID;
+	}
+
+	return SELECTOR_OK;
+}
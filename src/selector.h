@@ -0,0 +1,92 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BSPWM_SELECTOR_H
+#define BSPWM_SELECTOR_H
+
+#include "types.h"
+
+#define NODE_DESC_CACHE_SIZE  64
+
+typedef enum {
+	NODE_DESC_DIRECTION,
+	NODE_DESC_CYCLE,
+	NODE_DESC_HISTORY,
+	NODE_DESC_ANY,
+	NODE_DESC_ALL,
+	NODE_DESC_FIRST_ANCESTOR,
+	NODE_DESC_LAST,
+	NODE_DESC_NEWEST,
+	NODE_DESC_BIGGEST,
+	NODE_DESC_SMALLEST,
+	NODE_DESC_POINTED,
+	NODE_DESC_FOCUSED,
+	NODE_DESC_PATH,
+	NODE_DESC_ID
+} node_desc_kind_t;
+
+typedef enum {
+	PATH_FIRST,
+	PATH_SECOND,
+	PATH_PARENT,
+	PATH_BROTHER,
+	PATH_FENCE,
+	PATH_INVALID
+} path_step_kind_t;
+
+typedef struct {
+	path_step_kind_t kind;
+	direction_t dir;
+} path_step_t;
+
+/* A node selector compiled once and evaluated against the current tree. */
+typedef struct node_desc_t node_desc_t;
+struct node_desc_t {
+	char *text;
+	uint32_t hash;
+	int status;
+	node_desc_t *reference;
+	node_desc_kind_t kind;
+	direction_t dir;
+	cycle_dir_t cyc;
+	history_dir_t hdi;
+	uint32_t id;
+	node_select_t sel;
+	char *desktop;
+	bool from_root;
+	path_step_t *path;
+	int path_len;
+	node_desc_t *prev;
+	node_desc_t *next;
+};
+
+node_desc_t *make_node_desc(char *desc);
+void free_node_desc(node_desc_t *nd);
+node_desc_t *cached_node_desc(char *desc);
+void empty_node_desc_cache(void);
+int node_from_node_desc(node_desc_t *nd, coordinates_t *ref, coordinates_t *dst);
+int node_ids_from_node_desc(node_desc_t *nd, coordinates_t *ref, uint32_t **ids, int *len);
+int node_from_path(node_desc_t *nd, coordinates_t *ref, coordinates_t *dst);
+
+#endif
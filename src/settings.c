@@ -30,6 +30,10 @@
 
 char external_rules_command[MAXLEN];
 char status_prefix[MAXLEN];
+char journal_path[MAXLEN];
+int journal_compaction_threshold;
+char trace_path[MAXLEN];
+int history_size_limit;
 
 char normal_border_color[MAXLEN];
 char active_border_color[MAXLEN];
@@ -48,6 +52,7 @@ tightness_t directional_focus_tightness;
 
 uint16_t pointer_modifier;
 uint32_t pointer_motion_interval;
+uint32_t node_title_interval;
 pointer_action_t pointer_actions[3];
 int8_t mapping_events_count;
 
@@ -56,6 +61,8 @@ bool borderless_monocle;
 bool gapless_monocle;
 bool single_monocle;
 bool borderless_singleton;
+bool desktop_containers;
+bool state_mirror;
 
 bool focus_follows_pointer;
 bool pointer_follows_focus;
@@ -80,10 +87,6 @@ void run_config(int run_level)
 	// create a new process
 	// in the created child process (PID==0):
 	if (fork() == 0) {
-		if (dpy != NULL) {
-			// close the display connection's file descriptor
-			close(xcb_get_file_descriptor(dpy));
-		}
 		// decouple the child from the parent
 		// the pid of the parent now is now 1 (init)
 		setsid();
@@ -102,6 +105,10 @@ void load_settings(void)
 {
 	snprintf(external_rules_command, sizeof(external_rules_command), "%s", EXTERNAL_RULES_COMMAND);
 	snprintf(status_prefix, sizeof(status_prefix), "%s", STATUS_PREFIX);
+	snprintf(journal_path, sizeof(journal_path), "%s", JOURNAL_PATH);
+	journal_compaction_threshold = JOURNAL_COMPACTION_THRESHOLD;
+	snprintf(trace_path, sizeof(trace_path), "%s", TRACE_PATH);
+	history_size_limit = HISTORY_SIZE_LIMIT;
 
 	snprintf(normal_border_color, sizeof(normal_border_color), "%s", NORMAL_BORDER_COLOR);
 	snprintf(active_border_color, sizeof(active_border_color), "%s", ACTIVE_BORDER_COLOR);
@@ -120,6 +127,7 @@ void load_settings(void)
 
 	pointer_modifier = POINTER_MODIFIER;
 	pointer_motion_interval = POINTER_MOTION_INTERVAL;
+	node_title_interval = NODE_TITLE_INTERVAL;
 	pointer_actions[0] = ACTION_MOVE;
 	pointer_actions[1] = ACTION_RESIZE_SIDE;
 	pointer_actions[2] = ACTION_RESIZE_CORNER;
@@ -130,6 +138,8 @@ void load_settings(void)
 	gapless_monocle = GAPLESS_MONOCLE;
 	single_monocle = SINGLE_MONOCLE;
 	borderless_singleton = BORDERLESS_SINGLETON;
+	desktop_containers = DESKTOP_CONTAINERS;
+	state_mirror = STATE_MIRROR;
 
 	focus_follows_pointer = FOCUS_FOLLOWS_POINTER;
 	pointer_follows_focus = POINTER_FOLLOWS_FOCUS;
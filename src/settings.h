@@ -29,8 +29,13 @@
 
 #define POINTER_MODIFIER         XCB_MOD_MASK_4
 #define POINTER_MOTION_INTERVAL  17
+#define NODE_TITLE_INTERVAL      100
 #define EXTERNAL_RULES_COMMAND   ""
 #define STATUS_PREFIX            "W"
+#define JOURNAL_PATH             ""
+#define JOURNAL_COMPACTION_THRESHOLD  256
+#define TRACE_PATH                    ""
+#define HISTORY_SIZE_LIMIT            1024
 
 #define NORMAL_BORDER_COLOR           "#30302f"
 #define ACTIVE_BORDER_COLOR           "#474645"
@@ -50,6 +55,8 @@
 #define GAPLESS_MONOCLE             false
 #define SINGLE_MONOCLE              false
 #define BORDERLESS_SINGLETON        false
+#define DESKTOP_CONTAINERS          false
+#define STATE_MIRROR                false
 
 #define FOCUS_FOLLOWS_POINTER       false
 #define POINTER_FOLLOWS_FOCUS       false
@@ -70,6 +77,10 @@
 
 extern char external_rules_command[MAXLEN];
 extern char status_prefix[MAXLEN];
+extern char journal_path[MAXLEN];
+extern int journal_compaction_threshold;
+extern char trace_path[MAXLEN];
+extern int history_size_limit;
 
 extern char normal_border_color[MAXLEN];
 extern char active_border_color[MAXLEN];
@@ -88,6 +99,7 @@ extern tightness_t directional_focus_tightness;
 
 extern uint16_t pointer_modifier;
 extern uint32_t pointer_motion_interval;
+extern uint32_t node_title_interval;
 extern pointer_action_t pointer_actions[3];
 extern int8_t mapping_events_count;
 
@@ -96,6 +108,8 @@ extern bool borderless_monocle;
 extern bool gapless_monocle;
 extern bool single_monocle;
 extern bool borderless_singleton;
+extern bool desktop_containers;
+extern bool state_mirror;
 
 extern bool focus_follows_pointer;
 extern bool pointer_follows_focus;
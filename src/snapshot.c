@@ -0,0 +1,422 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "bspwm.h"
+#include "common.h"
+#include "helpers.h"
+#include "jsmn.h"
+#include "query.h"
+#include "stats.h"
+#include "transaction.h"
+#include "snapshot.h"
+
+typedef struct {
+	uint32_t id;
+	int start;
+	int end;
+} snapshot_entry_t;
+
+typedef struct {
+	char *json;
+	size_t len;
+	snapshot_entry_t *entries;
+	int entries_len;
+	bool indexed;
+	unsigned int refs;
+} snapshot_t;
+
+typedef struct snapshot_job_t snapshot_job_t;
+struct snapshot_job_t {
+	snapshot_t *snapshot;
+	uint32_t id;
+	int fd;
+	/* What remains to be written, followed by `tail`. */
+	const char *data;
+	size_t len;
+	const char *tail;
+	uint64_t deadline;
+	snapshot_job_t *next;
+};
+
+/* Protects the job queue and the reference counts. */
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t snapshot_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;
+static snapshot_job_t *job_head = NULL;
+static snapshot_job_t *job_tail = NULL;
+static unsigned int jobs_count = 0;
+static bool worker_started = false;
+/* Wakes the worker up while it waits for its clients. */
+static int wake_fds[2] = {-1, -1};
+
+/* Only accessed by the main thread, which holds a reference on it. */
+static snapshot_t *current = NULL;
+static bool snapshot_pending = true;
+
+void touch_snapshot(void)
+{
+	snapshot_pending = true;
+}
+
+static void release_snapshot(snapshot_t *s)
+{
+	pthread_mutex_lock(&snapshot_lock);
+	bool last = (--s->refs == 0);
+	pthread_mutex_unlock(&snapshot_lock);
+	if (last) {
+		free(s->json);
+		free(s->entries);
+		free(s);
+	}
+}
+
+static snapshot_t *make_snapshot(void)
+{
+	snapshot_t *s = calloc(1, sizeof(snapshot_t));
+	if (s == NULL) {
+		return NULL;
+	}
+	FILE *stream = open_memstream(&s->json, &s->len);
+	if (stream == NULL) {
+		free(s);
+		return NULL;
+	}
+	query_state(stream);
+	if (fclose(stream) != 0) {
+		free(s->json);
+		free(s);
+		return NULL;
+	}
+	s->refs = 1;
+	return s;
+}
+
+static snapshot_t *current_snapshot(void)
+{
+	if (current != NULL && !snapshot_pending) {
+		return current;
+	}
+	uint64_t start = stats_clock();
+	snapshot_t *s = make_snapshot();
+	if (s == NULL) {
+		return NULL;
+	}
+	stats_record_since(STAT_SNAPSHOT_BUILD, start);
+	if (current != NULL) {
+		release_snapshot(current);
+	}
+	current = s;
+	snapshot_pending = false;
+	return current;
+}
+
+static bool key_is_id(snapshot_t *s, jsmntok_t *t)
+{
+	return t->type == JSMN_STRING && t->end - t->start == 2 && strncmp(s->json + t->start, "id", 2) == 0;
+}
+
+/* Records the extent of every object that has an `id` key and returns the
+ * token that follows the given value. */
+static jsmntok_t *index_value(snapshot_t *s, jsmntok_t *t)
+{
+	if (t->type == JSMN_OBJECT) {
+		jsmntok_t *obj = t++;
+		for (int i = 0; i < obj->size; i++) {
+			jsmntok_t *key = t++;
+			if (key_is_id(s, key) && t->type == JSMN_PRIMITIVE) {
+				snapshot_entry_t *e = &s->entries[s->entries_len++];
+				e->id = strtoul(s->json + t->start, NULL, 10);
+				e->start = obj->start;
+				e->end = obj->end;
+			}
+			t = index_value(s, t);
+		}
+		return t;
+	} else if (t->type == JSMN_ARRAY) {
+		int size = t->size;
+		t++;
+		for (int i = 0; i < size; i++) {
+			t = index_value(s, t);
+		}
+		return t;
+	} else {
+		return t + 1;
+	}
+}
+
+static int entry_cmp(const void *a, const void *b)
+{
+	uint32_t ia = ((const snapshot_entry_t *) a)->id, ib = ((const snapshot_entry_t *) b)->id;
+	return (ia > ib) - (ia < ib);
+}
+
+static void index_snapshot(snapshot_t *s)
+{
+	s->indexed = true;
+	jsmn_parser parser;
+	jsmn_init(&parser);
+	int count = jsmn_parse(&parser, s->json, s->len, NULL, 0);
+	if (count < 1) {
+		return;
+	}
+	jsmntok_t *tokens = malloc(count * sizeof(jsmntok_t));
+	if (tokens == NULL) {
+		return;
+	}
+	jsmn_init(&parser);
+	if (jsmn_parse(&parser, s->json, s->len, tokens, count) == count) {
+		int objects = 0;
+		for (int i = 0; i < count; i++) {
+			if (tokens[i].type == JSMN_OBJECT) {
+				objects++;
+			}
+		}
+		s->entries = malloc(objects * sizeof(snapshot_entry_t));
+		if (s->entries != NULL) {
+			index_value(s, tokens);
+			qsort(s->entries, s->entries_len, sizeof(snapshot_entry_t), entry_cmp);
+		}
+	}
+	free(tokens);
+}
+
+/* Selects the part of the snapshot the job responds with. */
+static void prepare_job(snapshot_job_t *job)
+{
+	snapshot_t *s = job->snapshot;
+	job->data = s->json;
+	job->len = s->len;
+	job->tail = "\n";
+	job->deadline = stats_clock() + SNAPSHOT_WRITE_TIMEOUT * 1000;
+	fcntl(job->fd, F_SETFL, O_NONBLOCK | fcntl(job->fd, F_GETFL));
+	if (job->id != XCB_NONE) {
+		if (!s->indexed) {
+			index_snapshot(s);
+		}
+		snapshot_entry_t key = {.id = job->id};
+		snapshot_entry_t *e = (s->entries_len > 0 ? bsearch(&key, s->entries, s->entries_len, sizeof(snapshot_entry_t), entry_cmp) : NULL);
+		if (e == NULL) {
+			job->data = FAILURE_MESSAGE;
+			job->len = strlen(FAILURE_MESSAGE);
+			job->tail = "";
+			return;
+		}
+		job->data += e->start;
+		job->len = e->end - e->start;
+	}
+}
+
+/* Writes what the client accepts without blocking and returns whether the
+ * job is over. */
+static bool run_job(snapshot_job_t *job)
+{
+	while (true) {
+		if (job->len == 0) {
+			if (job->tail[0] == '\0') {
+				return true;
+			}
+			job->data = job->tail;
+			job->len = strlen(job->tail);
+			job->tail = "";
+		}
+		ssize_t n = write(job->fd, job->data, job->len);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return (errno != EAGAIN && errno != EWOULDBLOCK);
+		}
+		job->data += n;
+		job->len -= n;
+	}
+}
+
+static void finish_job(snapshot_job_t *job)
+{
+	close(job->fd);
+	release_snapshot(job->snapshot);
+	free(job);
+	pthread_mutex_lock(&snapshot_lock);
+	if (--jobs_count == 0) {
+		pthread_cond_broadcast(&idle_cond);
+	}
+	pthread_mutex_unlock(&snapshot_lock);
+}
+
+/* The jobs are served concurrently: a client that doesn't read its response
+ * can't delay the others, and is dropped once its deadline has passed. */
+static void *snapshot_worker(void *arg)
+{
+	(void) arg;
+	snapshot_job_t *active = NULL;
+	unsigned int active_count = 0;
+	while (true) {
+		pthread_mutex_lock(&snapshot_lock);
+		while (job_head == NULL && active == NULL) {
+			pthread_cond_wait(&snapshot_cond, &snapshot_lock);
+		}
+		snapshot_job_t *queued = job_head;
+		job_head = job_tail = NULL;
+		pthread_mutex_unlock(&snapshot_lock);
+
+		char buf[32];
+		while (read(wake_fds[0], buf, sizeof(buf)) > 0) {
+		}
+
+		while (queued != NULL) {
+			snapshot_job_t *job = queued;
+			queued = job->next;
+			prepare_job(job);
+			job->next = active;
+			active = job;
+			active_count++;
+		}
+
+		uint64_t now = stats_clock();
+		uint64_t next_deadline = UINT64_MAX;
+		snapshot_job_t **link = &active;
+		while (*link != NULL) {
+			snapshot_job_t *job = *link;
+			if (run_job(job) || now >= job->deadline) {
+				*link = job->next;
+				active_count--;
+				finish_job(job);
+			} else {
+				next_deadline = MIN(next_deadline, job->deadline);
+				link = &job->next;
+			}
+		}
+
+		if (active == NULL) {
+			continue;
+		}
+
+		struct pollfd fds[active_count + 1];
+		unsigned int i = 0;
+		fds[i].fd = wake_fds[0];
+		fds[i++].events = POLLIN;
+		for (snapshot_job_t *job = active; job != NULL; job = job->next) {
+			fds[i].fd = job->fd;
+			fds[i++].events = POLLOUT;
+		}
+		poll(fds, i, (next_deadline - now) / 1000 + 1);
+	}
+	return NULL;
+}
+
+static bool start_worker(void)
+{
+	if (worker_started) {
+		return true;
+	}
+	if (wake_fds[0] == -1) {
+		if (pipe(wake_fds) == -1) {
+			warn("Start snapshot worker: can't create pipe.\n");
+			return false;
+		}
+		for (int i = 0; i < 2; i++) {
+			fcntl(wake_fds[i], F_SETFD, FD_CLOEXEC);
+			fcntl(wake_fds[i], F_SETFL, O_NONBLOCK);
+		}
+	}
+	/* The signals are handled by the main thread. */
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	pthread_t thread;
+	int err = pthread_create(&thread, NULL, snapshot_worker, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (err != 0) {
+		warn("Start snapshot worker: %s.\n", strerror(err));
+		return false;
+	}
+	pthread_detach(thread);
+	worker_started = true;
+	return true;
+}
+
+/* Hands the response over to the worker thread and returns whether it did.
+ * The identifier of a monitor, desktop or node selects the corresponding
+ * part of the state, `XCB_NONE` selects the whole state. */
+bool serve_snapshot(uint32_t id, FILE *rsp)
+{
+	int rsp_fd = fileno(rsp);
+	if (in_transaction() || rsp_fd == -1 || restart) {
+		return false;
+	}
+	snapshot_t *s = current_snapshot();
+	if (s == NULL || !start_worker()) {
+		return false;
+	}
+	snapshot_job_t *job = malloc(sizeof(snapshot_job_t));
+	if (job == NULL) {
+		return false;
+	}
+	fflush(rsp);
+	job->fd = fcntl(rsp_fd, F_DUPFD_CLOEXEC, 0);
+	if (job->fd == -1) {
+		free(job);
+		return false;
+	}
+	job->snapshot = s;
+	job->id = id;
+	job->next = NULL;
+	pthread_mutex_lock(&snapshot_lock);
+	s->refs++;
+	jobs_count++;
+	if (job_tail == NULL) {
+		job_head = job_tail = job;
+	} else {
+		job_tail->next = job;
+		job_tail = job;
+	}
+	pthread_cond_signal(&snapshot_cond);
+	pthread_mutex_unlock(&snapshot_lock);
+	/* The worker might be waiting for its clients, a full pipe will wake it up anyway. */
+	if (write(wake_fds[1], "", 1) == -1 && errno != EAGAIN) {
+		warn("Wake snapshot worker: %s.\n", strerror(errno));
+	}
+	return true;
+}
+
+/* Waits until every queued response has been written or dropped: the process
+ * is about to exit or to replace itself. The wait is bounded by the deadline
+ * of the jobs. */
+void drain_snapshots(void)
+{
+	pthread_mutex_lock(&snapshot_lock);
+	while (jobs_count > 0) {
+		pthread_cond_wait(&idle_cond, &snapshot_lock);
+	}
+	pthread_mutex_unlock(&snapshot_lock);
+}
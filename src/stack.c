@@ -38,6 +38,42 @@ stacking_list_t *make_stack(node_t *n)
 	return s;
 }
 
+static void stack_relabel(void)
+{
+	unsigned int count = 0;
+	for (stacking_list_t *s = stack_head; s != NULL; s = s->next) {
+		count++;
+	}
+	uint32_t gap = UINT32_MAX / (count + 2);
+	if (gap > STACK_SEQ_GAP) {
+		gap = STACK_SEQ_GAP;
+	}
+	uint32_t seq = 0;
+	for (stacking_list_t *s = stack_head; s != NULL; s = s->next) {
+		seq += gap;
+		s->seq = seq;
+	}
+}
+
+/* Sequence numbers grow from the bottom to the top of the stack, like the
+ * ones of the history, hence two entries can be ordered without walking the
+ * list. */
+static void stack_label(stacking_list_t *s)
+{
+	s->node->stack = s;
+	uint32_t lo = (s->prev != NULL ? s->prev->seq : 0);
+	if (s->next == NULL) {
+		if (lo <= UINT32_MAX - STACK_SEQ_GAP) {
+			s->seq = lo + STACK_SEQ_GAP;
+			return;
+		}
+	} else if (s->next->seq - lo > 1) {
+		s->seq = lo + (s->next->seq - lo) / 2;
+		return;
+	}
+	stack_relabel();
+}
+
 void stack_insert_after(stacking_list_t *a, node_t *n)
 {
 	stacking_list_t *s = make_stack(n);
@@ -60,6 +96,7 @@ void stack_insert_after(stacking_list_t *a, node_t *n)
 			stack_tail = s;
 		}
 	}
+	stack_label(s);
 }
 
 void stack_insert_before(stacking_list_t *a, node_t *n)
@@ -84,6 +121,7 @@ void stack_insert_before(stacking_list_t *a, node_t *n)
 			stack_head = s;
 		}
 	}
+	stack_label(s);
 }
 
 void remove_stack(stacking_list_t *s)
@@ -105,18 +143,16 @@ void remove_stack(stacking_list_t *s)
 	if (s == stack_tail) {
 		stack_tail = a;
 	}
+	if (s->node->stack == s) {
+		s->node->stack = NULL;
+	}
 	free(s);
 }
 
 void remove_stack_node(node_t *n)
 {
 	for (node_t *f = first_extrema(n); f != NULL; f = next_leaf(f, n)) {
-		for (stacking_list_t *s = stack_head; s != NULL; s = s->next) {
-			if (s->node == f) {
-				remove_stack(s);
-				break;
-			}
-		}
+		remove_stack(f->stack);
 	}
 }
 
@@ -179,12 +215,20 @@ void stack(desktop_t *d, node_t *n, bool focused)
 			int i = stack_cmp(f->client, s->node->client);
 			if (i < 0 || (i == 0 && !focused)) {
 				stack_insert_before(s, f);
-				window_below(f->id, s->node->id);
-				put_status(SBSC_MASK_NODE_STACK, "node_stack 0x%08X below 0x%08X\n", f->id, s->node->id);
+				if (d->container != XCB_NONE) {
+					restack_in_container(d, s->prev);
+				} else {
+					window_below(f->id, s->node->id);
+				}
+				put_status_in(SBSC_MASK_NODE_STACK, &(coordinates_t) {NULL, d, f}, NULL, "node_stack 0x%08X below 0x%08X\n", f->id, s->node->id);
 			} else {
 				stack_insert_after(s, f);
-				window_above(f->id, s->node->id);
-				put_status(SBSC_MASK_NODE_STACK, "node_stack 0x%08X above 0x%08X\n", f->id, s->node->id);
+				if (d->container != XCB_NONE) {
+					restack_in_container(d, s->next);
+				} else {
+					window_above(f->id, s->node->id);
+				}
+				put_status_in(SBSC_MASK_NODE_STACK, &(coordinates_t) {NULL, d, f}, NULL, "node_stack 0x%08X above 0x%08X\n", f->id, s->node->id);
 			}
 		}
 	}
@@ -193,26 +237,84 @@ void stack(desktop_t *d, node_t *n, bool focused)
 	restack_presel_feedbacks(d);
 }
 
-void restack_presel_feedbacks(desktop_t *d)
+/* Places the window of `s` right below the next window of its desktop in the
+ * stacking list, or right above the previous one. */
+void restack_in_container(desktop_t *d, stacking_list_t *s)
 {
+	stacking_list_t *above = NULL, *below = NULL;
+	for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
+		stacking_list_t *t = n->stack;
+		if (t == NULL || t == s) {
+			continue;
+		}
+		if (t->seq > s->seq) {
+			if (above == NULL || t->seq < above->seq) {
+				above = t;
+			}
+		} else if (below == NULL || t->seq > below->seq) {
+			below = t;
+		}
+	}
+	if (above != NULL) {
+		window_below(s->node->id, above->node->id);
+	} else if (below != NULL) {
+		window_above(s->node->id, below->node->id);
+	}
+}
+
+void restack_node(desktop_t *d, node_t *n)
+{
+	for (stacking_list_t *s = stack_head; s != NULL; s = s->next) {
+		if (is_descendant(s->node, n)) {
+			restack_in_container(d, s);
+		}
+	}
+	restack_presel_feedbacks(d);
+}
+
+stacking_list_t *topmost_tiled(desktop_t *d)
+{
+	if (d->container != XCB_NONE) {
+		stacking_list_t *top = NULL;
+		for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
+			if (n->stack != NULL && IS_TILED(n->client) && (top == NULL || n->stack->seq > top->seq)) {
+				top = n->stack;
+			}
+		}
+		return top;
+	}
 	stacking_list_t *s = stack_tail;
 	while (s != NULL && !IS_TILED(s->node->client)) {
 		s = s->prev;
 	}
+	return s;
+}
+
+void restack_presel_feedbacks(desktop_t *d)
+{
+	stacking_list_t *s = topmost_tiled(d);
 	if (s != NULL) {
-		restack_presel_feedbacks_in(d->root, s->node);
+		restack_presel_feedbacks_in(d->root, s);
 	}
 }
 
-void restack_presel_feedbacks_in(node_t *r, node_t *n)
+/* A feedback stays right above its anchor as long as neither the anchor nor
+ * the window that follows it in the stacking order has changed. */
+void restack_presel_feedbacks_in(node_t *r, stacking_list_t *s)
 {
 	if (r == NULL) {
 		return;
 	} else {
-		if (r->presel != NULL) {
-			window_above(r->presel->feedback, n->id);
+		presel_t *p = r->presel;
+		if (p != NULL && p->feedback != XCB_NONE) {
+			xcb_window_t next = (s->next != NULL ? s->next->node->id : XCB_NONE);
+			if (p->feedback_anchor != s->node->id || p->feedback_anchor_next != next) {
+				window_above(p->feedback, s->node->id);
+				p->feedback_anchor = s->node->id;
+				p->feedback_anchor_next = next;
+			}
 		}
-		restack_presel_feedbacks_in(r->first_child, n);
-		restack_presel_feedbacks_in(r->second_child, n);
+		restack_presel_feedbacks_in(r->first_child, s);
+		restack_presel_feedbacks_in(r->second_child, s);
 	}
 }
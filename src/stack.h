@@ -25,6 +25,8 @@
 #ifndef BSPWM_STACK_H
 #define BSPWM_STACK_H
 
+#define STACK_SEQ_GAP  64
+
 stacking_list_t *make_stack(node_t *n);
 void stack_insert_after(stacking_list_t *a, node_t *n);
 void stack_insert_before(stacking_list_t *a, node_t *n);
@@ -35,7 +37,10 @@ int stack_cmp(client_t *c1, client_t *c2);
 stacking_list_t *limit_above(node_t *n);
 stacking_list_t *limit_below(node_t *n);
 void stack(desktop_t *d, node_t *n, bool focused);
+void restack_in_container(desktop_t *d, stacking_list_t *s);
+void restack_node(desktop_t *d, node_t *n);
+stacking_list_t *topmost_tiled(desktop_t *d);
 void restack_presel_feedbacks(desktop_t *d);
-void restack_presel_feedbacks_in(node_t *r, node_t *n);
+void restack_presel_feedbacks_in(node_t *r, stacking_list_t *s);
 
 #endif
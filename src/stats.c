@@ -0,0 +1,110 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "stats.h"
+
+/* Durations are expressed in microseconds. */
+static stat_t stats[STATS_COUNT];
+
+/* The measure started by `stats_begin`, if any. */
+static stat_id_t pending_id;
+static uint64_t pending_start;
+
+static const char *stat_names[STATS_COUNT] = {
+	[STAT_DESKTOP_SWITCH_WINDOWS] = "desktopSwitchWindows",
+	[STAT_DESKTOP_SWITCH_CONTAINERS] = "desktopSwitchContainers",
+	[STAT_SNAPSHOT_BUILD] = "snapshotBuild",
+	[STAT_CONFIGURE_COALESCED] = "configureCoalesced",
+	[STAT_CONFIGURE_THROTTLED] = "configureThrottled",
+	[STAT_MAP_REQUESTS_CANCELED] = "mapRequestsCanceled",
+	[STAT_PROPERTY_NOTIFIES_COLLAPSED] = "propertyNotifiesCollapsed",
+	[STAT_COMMANDS_FILE] = "commandsFile",
+	[STAT_STARTUP] = "startup",
+	[STAT_RESTART] = "restart",
+};
+
+uint64_t stats_clock(void)
+{
+	struct timespec ts;
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1) {
+		return 0;
+	}
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void stats_record(stat_id_t id, uint64_t value)
+{
+	stat_t *s = &stats[id];
+	s->count++;
+	s->total += value;
+	if (value > s->max) {
+		s->max = value;
+	}
+}
+
+void stats_record_since(stat_id_t id, uint64_t start)
+{
+	uint64_t now = stats_clock();
+	stats_record(id, now > start ? now - start : 0);
+}
+
+/* Start measuring the time until the requests issued from now on are
+ * flushed by the caller of `stats_end`. */
+void stats_begin(stat_id_t id)
+{
+	pending_id = id;
+	pending_start = stats_clock();
+}
+
+bool stats_pending(void)
+{
+	return pending_start > 0;
+}
+
+/* Called right after the requests were flushed. */
+void stats_end(void)
+{
+	if (pending_start == 0) {
+		return;
+	}
+	stats_record_since(pending_id, pending_start);
+	pending_start = 0;
+}
+
+void query_stats(FILE *rsp)
+{
+	fprintf(rsp, "{");
+	for (int i = 0; i < STATS_COUNT; i++) {
+		stat_t *s = &stats[i];
+		fprintf(rsp, "\"%s\":{\"count\":%llu,\"total\":%llu,\"max\":%llu}", stat_names[i],
+		        (unsigned long long) s->count, (unsigned long long) s->total, (unsigned long long) s->max);
+		if (i < STATS_COUNT - 1) {
+			fprintf(rsp, ",");
+		}
+	}
+	fprintf(rsp, "}");
+}
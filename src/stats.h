@@ -0,0 +1,60 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BSPWM_STATS_H
+#define BSPWM_STATS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+	STAT_DESKTOP_SWITCH_WINDOWS,
+	STAT_DESKTOP_SWITCH_CONTAINERS,
+	STAT_SNAPSHOT_BUILD,
+	STAT_CONFIGURE_COALESCED,
+	STAT_CONFIGURE_THROTTLED,
+	STAT_MAP_REQUESTS_CANCELED,
+	STAT_PROPERTY_NOTIFIES_COLLAPSED,
+	STAT_COMMANDS_FILE,
+	STAT_STARTUP,
+	STAT_RESTART,
+	STATS_COUNT
+} stat_id_t;
+
+typedef struct {
+	uint64_t count;
+	uint64_t total;
+	uint64_t max;
+} stat_t;
+
+uint64_t stats_clock(void);
+void stats_record(stat_id_t id, uint64_t value);
+void stats_record_since(stat_id_t id, uint64_t start);
+void stats_begin(stat_id_t id);
+bool stats_pending(void);
+void stats_end(void);
+void query_stats(FILE *rsp);
+
+#endif
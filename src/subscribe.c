@@ -27,12 +27,27 @@
 #include <unistd.h>
 #include <ctype.h>
 #include <stdarg.h>
+#include <string.h>
 #include <fcntl.h>
 #include "bspwm.h"
 #include "desktop.h"
 #include "settings.h"
 #include "subscribe.h"
 #include "tree.h"
+#include "parse.h"
+#include "query.h"
+#include "registry.h"
+#include "journal.h"
+#include "transaction.h"
+#include "delta.h"
+#include "mirror.h"
+#include "snapshot.h"
+
+/* The last report delivered to the subscribers: reports are built at most once
+ * per iteration of the event loop, and not sent again if they didn't change. */
+static char *last_report = NULL;
+static size_t last_report_len = 0;
+static bool report_pending = false;
 
 subscriber_list_t *make_subscriber(FILE *stream, char *fifo_path, int field, int count)
 {
@@ -42,6 +57,7 @@ subscriber_list_t *make_subscriber(FILE *stream, char *fifo_path, int field, int
 	sb->fifo_path = fifo_path;
 	sb->field = field;
 	sb->count = count;
+	sb->filter = NULL;
 	return sb;
 }
 
@@ -71,12 +87,47 @@ void remove_subscriber(subscriber_list_t *sb)
 		fclose(sb->stream);
 		unlink(sb->fifo_path);
 	}
+	forget_subscriber(sb);
+	free_subscriber_filter(sb->filter);
 	free(sb->fifo_path);
 	free(sb);
 }
 
+/* Store the current report in the cache and return whether it changed. */
+static bool cache_report(void)
+{
+	char *report = NULL;
+	size_t len = 0;
+	FILE *stream = open_memstream(&report, &len);
+
+	if (stream == NULL) {
+		return false;
+	}
+
+	print_report(stream);
+	fclose(stream);
+
+	if (last_report != NULL && len == last_report_len && memcmp(report, last_report, len) == 0) {
+		free(report);
+		return false;
+	}
+
+	free(last_report);
+	last_report = report;
+	last_report_len = len;
+	return true;
+}
+
 void add_subscriber(subscriber_list_t *sb)
 {
+	if (sb->field & SBSC_MASK_TREE_DELTA) {
+		/* The other mirrors must be up to date before the fingerprints are shared. */
+		flush_tree_delta();
+	}
+	if ((sb->field & SBSC_MASK_REPORT) && report_pending) {
+		/* The cached report is stale: deliver the pending changes to the others first. */
+		flush_report();
+	}
 	if (subscribe_head == NULL) {
 		subscribe_head = subscribe_tail = sb;
 	} else {
@@ -87,11 +138,111 @@ void add_subscriber(subscriber_list_t *sb)
 	int cli_fd = fileno(sb->stream);
 	fcntl(cli_fd, F_SETFD, FD_CLOEXEC | fcntl(cli_fd, F_GETFD));
 	if (sb->field & SBSC_MASK_REPORT) {
-		print_report(sb->stream);
+		/* The new subscriber gets what the others received last. */
+		if (last_report != NULL || cache_report()) {
+			fwrite(last_report, 1, last_report_len, sb->stream);
+			fflush(sb->stream);
+		} else {
+			print_report(sb->stream);
+		}
 		if (sb->count-- == 1) {
 			remove_subscriber(sb);
+			return;
 		}
 	}
+	if (sb->field & SBSC_MASK_TREE_DELTA) {
+		print_tree_snapshot(sb->stream);
+		if (sb->count-- == 1) {
+			remove_subscriber(sb);
+		}
+	}
+}
+
+subscriber_filter_t *make_subscriber_filter(void)
+{
+	subscriber_filter_t *f = calloc(1, sizeof(subscriber_filter_t));
+	f->monitor_sel = make_monitor_select();
+	f->desktop_sel = make_desktop_select();
+	f->node_sel = make_node_select();
+	return f;
+}
+
+void free_subscriber_filter(subscriber_filter_t *f)
+{
+	if (f == NULL) {
+		return;
+	}
+	free(f->monitor_modifiers);
+	free(f->desktop_modifiers);
+	free(f->node_modifiers);
+	free(f);
+}
+
+/* The modifiers are kept, to be dumped with the state on restart. */
+#define SET_FILTER(kind) \
+	bool set_##kind##_filter(char *modifiers, subscriber_filter_t *f) \
+	{ \
+		kind##_select_t sel = make_##kind##_select(); \
+		char *desc = copy_string(modifiers, strlen(modifiers)); \
+		if (!parse_##kind##_modifiers(desc, &sel)) { \
+			free(desc); \
+			return false; \
+		} \
+		strcpy(desc, modifiers); \
+		free(f->kind##_modifiers); \
+		f->kind##_modifiers = desc; \
+		f->kind##_sel = sel; \
+		return true; \
+	}
+SET_FILTER(monitor)
+SET_FILTER(desktop)
+SET_FILTER(node)
+#undef SET_FILTER
+
+static bool filter_matches(subscriber_filter_t *f, coordinates_t *loc)
+{
+	/* Some events don't know the monitor of their desktop. */
+	coordinates_t tmp = *loc;
+	if (loc->monitor == NULL && loc->desktop != NULL) {
+		registered_desktop(loc->desktop->id, &tmp.monitor);
+		loc = &tmp;
+	}
+	if (mon == NULL || loc->monitor == NULL) {
+		return true;
+	}
+	coordinates_t ref = {mon, mon->desk, mon->desk->focus};
+	coordinates_t m_loc = {loc->monitor, NULL, NULL};
+	if ((f->monitor_id != 0 && loc->monitor->id != f->monitor_id) ||
+	    (f->monitor_modifiers != NULL && !monitor_matches(&m_loc, &ref, &f->monitor_sel))) {
+		return false;
+	}
+	if (loc->desktop == NULL) {
+		return true;
+	}
+	coordinates_t d_loc = {loc->monitor, loc->desktop, NULL};
+	if ((f->desktop_id != 0 && loc->desktop->id != f->desktop_id) ||
+	    (f->desktop_modifiers != NULL && !desktop_matches(&d_loc, &ref, &f->desktop_sel))) {
+		return false;
+	}
+	if (loc->node == NULL) {
+		return true;
+	}
+	if ((f->node_id != 0 && loc->node->id != f->node_id) ||
+	    (f->node_modifiers != NULL && !node_matches(loc, &ref, &f->node_sel))) {
+		return false;
+	}
+	return true;
+}
+
+static bool subscriber_wants(subscriber_list_t *sb, subscriber_mask_t mask, coordinates_t *loc, coordinates_t *alt)
+{
+	if (!(sb->field & mask)) {
+		return false;
+	}
+	if (sb->filter == NULL || loc == NULL) {
+		return true;
+	}
+	return filter_matches(sb->filter, loc) || (alt != NULL && filter_matches(sb->filter, alt));
 }
 
 int print_report(FILE *stream)
@@ -107,7 +258,7 @@ int print_report(FILE *stream)
 			fprintf(stream, ":%c%s", c, d->name);
 		}
 		if (m->desk != NULL) {
-			fprintf(stream, ":L%c", LAYOUT_CHR(m->desk->layout));
+			fprintf(stream, ":L%c", layout_chr(m->desk->layout));
 			if (m->desk->focus != NULL) {
 				node_t *n = m->desk->focus;
 				if (n->client != NULL) {
@@ -141,28 +292,143 @@ int print_report(FILE *stream)
 	return fflush(stream);
 }
 
+static void send_status(subscriber_list_t *sb, char *fmt, va_list args)
+{
+	if (sb->count > 0) {
+		sb->count--;
+	}
+	va_list copy;
+	va_copy(copy, args);
+	vfprintf(sb->stream, fmt, copy);
+	va_end(copy);
+	if (fflush(sb->stream) != 0 || sb->count == 0) {
+		remove_subscriber(sb);
+	}
+}
+
+static void vput_status(subscriber_mask_t mask, coordinates_t *loc, coordinates_t *alt, char *fmt, va_list args)
+{
+	if (mask != SBSC_MASK_TREE_DELTA) {
+		state_changed(loc);
+		if (alt != NULL) {
+			state_changed(alt);
+		}
+	}
+	if (in_transaction()) {
+		int count = 0;
+		for (subscriber_list_t *sb = subscribe_head; sb != NULL; sb = sb->next) {
+			if (subscriber_wants(sb, mask, loc, alt)) {
+				count++;
+			}
+		}
+		subscriber_list_t **recipients = (count > 0 ? malloc(count * sizeof(subscriber_list_t *)) : NULL);
+		if (count == 0 || recipients != NULL) {
+			int i = 0;
+			for (subscriber_list_t *sb = subscribe_head; sb != NULL && i < count; sb = sb->next) {
+				if (subscriber_wants(sb, mask, loc, alt)) {
+					recipients[i++] = sb;
+				}
+			}
+			if (defer_status(mask, recipients, count, fmt, args)) {
+				return;
+			}
+			free(recipients);
+		}
+	}
+	va_list copy;
+	va_copy(copy, args);
+	journal_record(mask, fmt, copy);
+	va_end(copy);
+	subscriber_list_t *sb = subscribe_head;
+	while (sb != NULL) {
+		subscriber_list_t *next = sb->next;
+		if (subscriber_wants(sb, mask, loc, alt)) {
+			send_status(sb, fmt, args);
+		}
+		sb = next;
+	}
+}
+
+void state_changed(coordinates_t *loc)
+{
+	touch_tree_delta(loc);
+	touch_state_mirror();
+	touch_snapshot();
+}
+
 void put_status(subscriber_mask_t mask, ...)
 {
+	if (mask == SBSC_MASK_REPORT) {
+		report_pending = true;
+		state_changed(NULL);
+		return;
+	}
+	va_list args;
+	va_start(args, mask);
+	char *fmt = va_arg(args, char *);
+	vput_status(mask, NULL, NULL, fmt, args);
+	va_end(args);
+}
+
+void put_status_in(subscriber_mask_t mask, coordinates_t *loc, coordinates_t *alt, ...)
+{
+	va_list args;
+	va_start(args, alt);
+	char *fmt = va_arg(args, char *);
+	vput_status(mask, loc, alt, fmt, args);
+	va_end(args);
+}
+
+void put_status_to(subscriber_mask_t mask, subscriber_list_t **recipients, int count, ...)
+{
+	va_list args;
+	va_start(args, count);
+	char *fmt = va_arg(args, char *);
+	va_list copy;
+	va_copy(copy, args);
+	journal_record(mask, fmt, copy);
+	va_end(copy);
+	for (int i = 0; i < count; i++) {
+		if (recipients[i] != NULL) {
+			send_status(recipients[i], fmt, args);
+		}
+	}
+	va_end(args);
+}
+
+void flush_report(void)
+{
+	if (!report_pending) {
+		return;
+	}
+
+	report_pending = false;
+
+	bool wanted = false;
+	for (subscriber_list_t *sb = subscribe_head; sb != NULL && !wanted; sb = sb->next) {
+		wanted = (sb->field & SBSC_MASK_REPORT);
+	}
+
+	if (!wanted) {
+		invalidate_report();
+		return;
+	}
+
+	if (!cache_report()) {
+		return;
+	}
+
+	char *report = last_report;
+	size_t len = last_report_len;
 	subscriber_list_t *sb = subscribe_head;
-	int ret;
 	while (sb != NULL) {
 		subscriber_list_t *next = sb->next;
-		if (sb->field & mask) {
+		if (sb->field & SBSC_MASK_REPORT) {
 			if (sb->count > 0) {
 				sb->count--;
 			}
-			if (mask == SBSC_MASK_REPORT) {
-				ret = print_report(sb->stream);
-			} else {
-				char *fmt;
-				va_list args;
-				va_start(args, mask);
-				fmt = va_arg(args, char *);
-				vfprintf(sb->stream, fmt, args);
-				va_end(args);
-				ret = fflush(sb->stream);
-			}
-			if (ret != 0 || sb->count == 0) {
+			fwrite(report, 1, len, sb->stream);
+			if (fflush(sb->stream) != 0 || sb->count == 0) {
 				remove_subscriber(sb);
 			}
 		}
@@ -170,6 +436,13 @@ void put_status(subscriber_mask_t mask, ...)
 	}
 }
 
+void invalidate_report(void)
+{
+	free(last_report);
+	last_report = NULL;
+	last_report_len = 0;
+}
+
 void prune_dead_subscribers(void)
 {
 	subscriber_list_t *sb = subscribe_head;
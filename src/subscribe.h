@@ -55,19 +55,45 @@ typedef enum {
 	SBSC_MASK_NODE_STATE = 1 << 24,
 	SBSC_MASK_NODE_FLAG = 1 << 25,
 	SBSC_MASK_NODE_LAYER = 1 << 26,
-	SBSC_MASK_POINTER_ACTION = 1 << 27,
+	SBSC_MASK_NODE_TITLE = 1 << 27,
+	SBSC_MASK_POINTER_ACTION = 1 << 28,
+	SBSC_MASK_TREE_DELTA = 1 << 29,
 	SBSC_MASK_MONITOR = (1 << 7) - (1 << 1),
 	SBSC_MASK_DESKTOP = (1 << 15) - (1 << 7),
-	SBSC_MASK_NODE = (1 << 28) - (1 << 15),
-	SBSC_MASK_ALL = (1 << 28) - 1
+	SBSC_MASK_NODE = (1 << 29) - (1 << 15),
+	SBSC_MASK_ALL = (1 << 29) - 1
 } subscriber_mask_t;
 
 subscriber_list_t *make_subscriber(FILE *stream, char *fifo_path, int field, int count);
 void remove_subscriber(subscriber_list_t *sb);
 void add_subscriber(subscriber_list_t *sb);
+subscriber_filter_t *make_subscriber_filter(void);
+void free_subscriber_filter(subscriber_filter_t *f);
+bool set_monitor_filter(char *modifiers, subscriber_filter_t *f);
+bool set_desktop_filter(char *modifiers, subscriber_filter_t *f);
+bool set_node_filter(char *modifiers, subscriber_filter_t *f);
 int print_report(FILE *stream);
+
+/* Invalidate the dumps of the state after a change within the monitor and
+ * desktop of `loc`, or outside of any of them if `loc` is `NULL`. Called by
+ * `arrange` and for every event. */
+void state_changed(coordinates_t *loc);
 void put_status(subscriber_mask_t mask, ...);
 
+/* Send an event about the item at `loc` (and, for the events involving two
+ * items, `alt`) to the subscribers whose filters accept either one. The
+ * filters are evaluated before anything is formatted. */
+void put_status_in(subscriber_mask_t mask, coordinates_t *loc, coordinates_t *alt, ...);
+
+/* Send an event to the given subscribers only: used for the events held by a
+ * transaction, whose recipients were chosen when they were emitted. */
+void put_status_to(subscriber_mask_t mask, subscriber_list_t **recipients, int count, ...);
+
+/* Send the report to its subscribers if it was requested since the last call
+ * and differs from the last one sent. */
+void flush_report(void);
+void invalidate_report(void);
+
 /* Remove any subscriber for which the stream has been closed and is no longer
  * writable. */
 void prune_dead_subscribers(void);
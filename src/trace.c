@@ -0,0 +1,232 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bspwm.h"
+#include "ewmh.h"
+#include "settings.h"
+#include "stats.h"
+#include "trace.h"
+
+#define TRACE_NONE  ((size_t) -1)
+
+/* Records are accumulated in memory and written at the end of each iteration
+ * of the event loop, like the journal. */
+static char *trace_buf = NULL;
+static size_t trace_len = 0;
+static size_t trace_cap = 0;
+static int trace_fd = -1;
+static uint64_t trace_origin = 0;
+static size_t trace_pending = TRACE_NONE;
+static uint64_t trace_pending_start = 0;
+
+static bool trace_reserve(size_t len)
+{
+	if (trace_len + len <= trace_cap) {
+		return true;
+	}
+	size_t cap = MAX(2 * trace_cap, trace_len + len);
+	char *buf = realloc(trace_buf, cap);
+	if (buf == NULL) {
+		return false;
+	}
+	trace_buf = buf;
+	trace_cap = cap;
+	return true;
+}
+
+/* Returns the offset of the new record, or `TRACE_NONE` if it was dropped. */
+static size_t trace_append(trace_kind_t kind, uint64_t time, uint64_t duration, const void *head, size_t head_len, const void *data, size_t data_len)
+{
+	size_t length = head_len + data_len;
+	if (length > UINT16_MAX || !trace_reserve(sizeof(trace_record_t) + length)) {
+		return TRACE_NONE;
+	}
+	trace_record_t rec = {
+		.kind = kind,
+		.length = length,
+		.duration = MIN(duration, UINT32_MAX),
+		.time = time,
+	};
+	size_t offset = trace_len;
+	memcpy(trace_buf + trace_len, &rec, sizeof(rec));
+	trace_len += sizeof(rec);
+	if (head_len > 0) {
+		memcpy(trace_buf + trace_len, head, head_len);
+		trace_len += head_len;
+	}
+	if (data_len > 0) {
+		memcpy(trace_buf + trace_len, data, data_len);
+		trace_len += data_len;
+	}
+	return offset;
+}
+
+static void trace_atom(xcb_atom_t atom, const char *name)
+{
+	uint32_t value = atom;
+	trace_append(TRACE_ATOM, 0, 0, &value, sizeof(value), name, strlen(name));
+}
+
+bool trace_open(void)
+{
+	trace_close();
+
+	if (trace_path[0] == '\0') {
+		return true;
+	}
+
+	trace_fd = open(trace_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+
+	if (trace_fd == -1) {
+		warn("Trace: can't open '%s'.\n", trace_path);
+		return false;
+	}
+
+	trace_origin = stats_clock();
+
+	trace_header_t header = {
+		.magic = TRACE_MAGIC,
+		.version = TRACE_VERSION,
+		.root = root,
+	};
+
+	if (trace_reserve(sizeof(header))) {
+		memcpy(trace_buf, &header, sizeof(header));
+		trace_len = sizeof(header);
+	}
+
+	/* The atoms whose value matters to the handlers of the traced events. */
+#define TRACE_ATOM(a)  trace_atom(ewmh->a, #a);
+	TRACE_ATOM(_NET_CURRENT_DESKTOP)
+	TRACE_ATOM(_NET_ACTIVE_WINDOW)
+	TRACE_ATOM(_NET_CLOSE_WINDOW)
+	TRACE_ATOM(_NET_WM_DESKTOP)
+	TRACE_ATOM(_NET_WM_NAME)
+	TRACE_ATOM(_NET_WM_STRUT_PARTIAL)
+	TRACE_ATOM(_NET_WM_STATE)
+	TRACE_ATOM(_NET_WM_STATE_FULLSCREEN)
+	TRACE_ATOM(_NET_WM_STATE_BELOW)
+	TRACE_ATOM(_NET_WM_STATE_ABOVE)
+	TRACE_ATOM(_NET_WM_STATE_HIDDEN)
+	TRACE_ATOM(_NET_WM_STATE_STICKY)
+	TRACE_ATOM(_NET_WM_STATE_DEMANDS_ATTENTION)
+	TRACE_ATOM(_NET_WM_STATE_MODAL)
+	TRACE_ATOM(_NET_WM_STATE_MAXIMIZED_VERT)
+	TRACE_ATOM(_NET_WM_STATE_MAXIMIZED_HORZ)
+	TRACE_ATOM(_NET_WM_STATE_SHADED)
+	TRACE_ATOM(_NET_WM_STATE_SKIP_TASKBAR)
+	TRACE_ATOM(_NET_WM_STATE_SKIP_PAGER)
+#undef TRACE_ATOM
+
+	trace_flush();
+	return trace_fd != -1;
+}
+
+static void trace_stop(void)
+{
+	close(trace_fd);
+	trace_fd = -1;
+	free(trace_buf);
+	trace_buf = NULL;
+	trace_len = trace_cap = 0;
+	trace_pending = TRACE_NONE;
+}
+
+void trace_close(void)
+{
+	if (trace_fd == -1) {
+		return;
+	}
+	trace_pending = TRACE_NONE;
+	trace_flush();
+	if (trace_fd != -1) {
+		trace_stop();
+	}
+}
+
+/* Returns zero when tracing is off, which spares a system call per event. */
+uint64_t trace_clock(void)
+{
+	return (trace_fd == -1 ? 0 : stats_clock());
+}
+
+void trace_event(xcb_generic_event_t *evt, uint64_t start)
+{
+	if (trace_fd == -1 || start < trace_origin) {
+		return;
+	}
+	trace_append(TRACE_EVENT, start - trace_origin, stats_clock() - start, evt, TRACE_EVENT_SIZE, NULL, 0);
+}
+
+/* The arguments are recorded before being handled, since they might be
+ * altered in the process, and the duration is filled in afterwards. */
+void trace_begin_message(char *msg, int msg_len)
+{
+	if (trace_fd == -1 || msg_len < 0) {
+		return;
+	}
+	trace_pending_start = stats_clock();
+	trace_pending = trace_append(TRACE_MESSAGE, trace_pending_start - trace_origin, 0, msg, msg_len, NULL, 0);
+}
+
+void trace_end_message(void)
+{
+	if (trace_fd == -1 || trace_pending == TRACE_NONE) {
+		return;
+	}
+	trace_record_t rec;
+	memcpy(&rec, trace_buf + trace_pending, sizeof(rec));
+	rec.duration = MIN(stats_clock() - trace_pending_start, UINT32_MAX);
+	memcpy(trace_buf + trace_pending, &rec, sizeof(rec));
+	trace_pending = TRACE_NONE;
+}
+
+void trace_flush(void)
+{
+	if (trace_fd == -1 || trace_pending != TRACE_NONE) {
+		return;
+	}
+
+	size_t i = 0;
+	while (i < trace_len) {
+		ssize_t n = write(trace_fd, trace_buf + i, trace_len - i);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			/* The next records would follow a truncated one. */
+			warn("Trace: write failed, tracing stopped.\n");
+			trace_stop();
+			return;
+		}
+		i += n;
+	}
+	trace_len = 0;
+}
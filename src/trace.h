@@ -0,0 +1,76 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BSPWM_TRACE_H
+#define BSPWM_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+/* The layout of the trace files, shared with bspwm-replay.
+ *
+ * The header is followed by records, each one made of a `trace_record_t` and
+ * `length` bytes of payload: the wire bytes of the event for `TRACE_EVENT`, the
+ * null separated arguments for `TRACE_MESSAGE` and, for `TRACE_ATOM`, the
+ * value of an atom followed by its name. The atom records come first: they
+ * allow atoms to be translated from one X server to another. All the times
+ * are in microseconds, the record times are relative to the opening of the
+ * trace. */
+
+#define TRACE_MAGIC       0x74707362
+#define TRACE_VERSION     1
+#define TRACE_EVENT_SIZE  32
+
+typedef enum {
+	TRACE_ATOM = 1,
+	TRACE_EVENT = 2,
+	TRACE_MESSAGE = 3
+} trace_kind_t;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t root;
+	uint32_t reserved;
+} trace_header_t;
+
+typedef struct {
+	uint8_t kind;
+	uint8_t reserved;
+	uint16_t length;
+	uint32_t duration;
+	uint64_t time;
+} trace_record_t;
+
+/* Used by the window manager only. */
+bool trace_open(void);
+void trace_close(void);
+uint64_t trace_clock(void);
+void trace_event(xcb_generic_event_t *evt, uint64_t start);
+void trace_begin_message(char *msg, int msg_len);
+void trace_end_message(void);
+void trace_flush(void);
+
+#endif
@@ -0,0 +1,204 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "bspwm.h"
+#include "ewmh.h"
+#include "registry.h"
+#include "tree.h"
+#include "transaction.h"
+
+typedef struct deferred_status_t deferred_status_t;
+struct deferred_status_t {
+	subscriber_mask_t mask;
+	subscriber_list_t **recipients;
+	int count;
+	char *text;
+	deferred_status_t *next;
+};
+
+static unsigned int depth;
+static bool committing;
+static uint32_t *dirty_desktops;
+static int dirty_len, dirty_cap;
+static unsigned int dirty_properties;
+static deferred_status_t *status_head, *status_tail;
+
+void begin_transaction(void)
+{
+	depth++;
+}
+
+void commit_transaction(void)
+{
+	if (depth == 0 || --depth > 0) {
+		return;
+	}
+
+	/* Arrange for real, while the events are still held. */
+	depth++;
+	committing = true;
+	for (int i = 0; i < dirty_len; i++) {
+		monitor_t *m = NULL;
+		desktop_t *d = registered_desktop(dirty_desktops[i], &m);
+		if (d != NULL) {
+			arrange(m, d);
+		}
+	}
+	dirty_len = 0;
+	committing = false;
+	depth--;
+
+	unsigned int props = dirty_properties;
+	dirty_properties = 0;
+	if (props & EWMH_ACTIVE_WINDOW) {
+		ewmh_update_active_window();
+	}
+	if (props & EWMH_NUMBER_OF_DESKTOPS) {
+		ewmh_update_number_of_desktops();
+	}
+	if (props & EWMH_CURRENT_DESKTOP) {
+		ewmh_update_current_desktop();
+	}
+	if (props & EWMH_WM_DESKTOPS) {
+		ewmh_update_wm_desktops();
+	}
+	if (props & EWMH_DESKTOP_NAMES) {
+		ewmh_update_desktop_names();
+	}
+	if (props & EWMH_DESKTOP_VIEWPORT) {
+		ewmh_update_desktop_viewport();
+	}
+	if (props & EWMH_CLIENT_LIST) {
+		ewmh_update_client_list(false);
+	}
+	if (props & EWMH_CLIENT_LIST_STACKING) {
+		ewmh_update_client_list(true);
+	}
+
+	/* Pop each event before sending it: the recipients removed on the way
+	 * are forgotten by the remaining ones. */
+	while (status_head != NULL) {
+		deferred_status_t *ds = status_head;
+		status_head = ds->next;
+		if (status_head == NULL) {
+			status_tail = NULL;
+		}
+		put_status_to(ds->mask, ds->recipients, ds->count, "%s", ds->text);
+		free(ds->recipients);
+		free(ds->text);
+		free(ds);
+	}
+}
+
+bool in_transaction(void)
+{
+	return depth > 0;
+}
+
+bool layout_deferred(void)
+{
+	return depth > 0 && !committing;
+}
+
+bool defer_arrange(desktop_t *d)
+{
+	if (!layout_deferred()) {
+		return false;
+	}
+	for (int i = 0; i < dirty_len; i++) {
+		if (dirty_desktops[i] == d->id) {
+			return true;
+		}
+	}
+	if (dirty_len == dirty_cap) {
+		int cap = (dirty_cap == 0 ? 8 : 2 * dirty_cap);
+		uint32_t *dirty = realloc(dirty_desktops, cap * sizeof(uint32_t));
+		if (dirty == NULL) {
+			/* Arrange right away. */
+			return false;
+		}
+		dirty_desktops = dirty;
+		dirty_cap = cap;
+	}
+	dirty_desktops[dirty_len++] = d->id;
+	return true;
+}
+
+bool defer_ewmh_update(ewmh_property_t p)
+{
+	if (depth == 0) {
+		return false;
+	}
+	dirty_properties |= p;
+	return true;
+}
+
+bool defer_status(subscriber_mask_t mask, subscriber_list_t **recipients, int count, char *fmt, va_list args)
+{
+	if (depth == 0) {
+		return false;
+	}
+
+	va_list copy;
+	va_copy(copy, args);
+	int len = vsnprintf(NULL, 0, fmt, copy);
+	va_end(copy);
+
+	deferred_status_t *ds = malloc(sizeof(deferred_status_t));
+	char *text = (len < 0 ? NULL : malloc(len + 1));
+	if (ds == NULL || text == NULL) {
+		free(ds);
+		free(text);
+		/* Deliver it right away. */
+		return false;
+	}
+
+	vsnprintf(text, len + 1, fmt, args);
+	ds->mask = mask;
+	ds->recipients = recipients;
+	ds->count = count;
+	ds->text = text;
+	ds->next = NULL;
+	if (status_tail == NULL) {
+		status_head = status_tail = ds;
+	} else {
+		status_tail->next = ds;
+		status_tail = ds;
+	}
+	return true;
+}
+
+void forget_subscriber(subscriber_list_t *sb)
+{
+	for (deferred_status_t *ds = status_head; ds != NULL; ds = ds->next) {
+		for (int i = 0; i < ds->count; i++) {
+			if (ds->recipients[i] == sb) {
+				ds->recipients[i] = NULL;
+			}
+		}
+	}
+}
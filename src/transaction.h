@@ -0,0 +1,58 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BSPWM_TRANSACTION_H
+#define BSPWM_TRANSACTION_H
+
+#include <stdarg.h>
+#include "types.h"
+#include "subscribe.h"
+
+#define BATCH_SEPARATOR  ";"
+
+/* The EWMH root window properties whose update can be postponed. */
+typedef enum {
+	EWMH_ACTIVE_WINDOW = 1 << 0,
+	EWMH_NUMBER_OF_DESKTOPS = 1 << 1,
+	EWMH_CURRENT_DESKTOP = 1 << 2,
+	EWMH_WM_DESKTOPS = 1 << 3,
+	EWMH_DESKTOP_NAMES = 1 << 4,
+	EWMH_DESKTOP_VIEWPORT = 1 << 5,
+	EWMH_CLIENT_LIST = 1 << 6,
+	EWMH_CLIENT_LIST_STACKING = 1 << 7
+} ewmh_property_t;
+
+/* Within a transaction, the window geometries, the EWMH root window properties
+ * and the events are computed as usual but only sent to the X server and to
+ * the subscribers when the outermost transaction is committed. */
+void begin_transaction(void);
+void commit_transaction(void);
+bool in_transaction(void);
+bool layout_deferred(void);
+bool defer_arrange(desktop_t *d);
+bool defer_ewmh_update(ewmh_property_t p);
+bool defer_status(subscriber_mask_t mask, subscriber_list_t **recipients, int count, char *fmt, va_list args);
+void forget_subscriber(subscriber_list_t *sb);
+
+#endif
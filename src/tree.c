@@ -27,7 +27,9 @@
 #include <stdbool.h>
 #include <limits.h>
 #include "bspwm.h"
+#include "backend.h"
 #include "desktop.h"
+#include "events.h"
 #include "ewmh.h"
 #include "history.h"
 #include "monitor.h"
@@ -35,9 +37,12 @@
 #include "geometry.h"
 #include "subscribe.h"
 #include "settings.h"
-#include "pointer.h"
 #include "stack.h"
+#include "stats.h"
+#include "transaction.h"
 #include "window.h"
+#include "journal.h"
+#include "delta.h"
 #include "tree.h"
 
 void arrange(monitor_t *m, desktop_t *d)
@@ -46,6 +51,10 @@ void arrange(monitor_t *m, desktop_t *d)
 		return;
 	}
 
+	/* Within a transaction, only the rectangles of the nodes are computed. */
+	defer_arrange(d);
+	state_changed(&(coordinates_t) {m, d, NULL});
+
 	xcb_rectangle_t rect = m->rectangle;
 
 	rect.x += m->padding.left + d->padding.left;
@@ -67,7 +76,11 @@ void arrange(monitor_t *m, desktop_t *d)
 		rect.height -= d->window_gap;
 	}
 
-	apply_layout(m, d, d->root, rect, rect);
+	if (d->layout == LAYOUT_TILED || d->layout == LAYOUT_MONOCLE) {
+		apply_layout(m, d, d->root, rect, rect);
+	} else {
+		apply_leaves_layout(m, d, rect);
+	}
 }
 
 void apply_layout(monitor_t *m, desktop_t *d, node_t *n, xcb_rectangle_t rect, xcb_rectangle_t root_rect)
@@ -78,7 +91,9 @@ void apply_layout(monitor_t *m, desktop_t *d, node_t *n, xcb_rectangle_t rect, x
 
 	n->rectangle = rect;
 
-	if (n->presel != NULL) {
+	bool deferred = layout_deferred();
+
+	if (n->presel != NULL && !deferred) {
 		draw_presel_feedback(m, d, n);
 	}
 
@@ -99,7 +114,6 @@ void apply_layout(monitor_t *m, desktop_t *d, node_t *n, xcb_rectangle_t rect, x
 		}
 
 		xcb_rectangle_t r;
-		xcb_rectangle_t cr = get_window_rectangle(n);
 		client_state_t s = n->client->state;
 		/* tiled and pseudo-tiled clients */
 		if (s == STATE_TILED || s == STATE_PSEUDO_TILED) {
@@ -130,10 +144,16 @@ void apply_layout(monitor_t *m, desktop_t *d, node_t *n, xcb_rectangle_t rect, x
 
 		apply_size_hints(n->client, &r.width, &r.height);
 
+		if (deferred) {
+			return;
+		}
+
+		xcb_rectangle_t cr = get_window_rectangle(n);
+
 		if (!rect_eq(r, cr)) {
 			window_move_resize(n->id, r.x, r.y, r.width, r.height);
 			if (!grabbing) {
-				put_status(SBSC_MASK_NODE_GEOMETRY, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", m->id, d->id, n->id, r.width, r.height, r.x, r.y);
+				put_status_in(SBSC_MASK_NODE_GEOMETRY, &(coordinates_t) {m, d, n}, NULL, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", m->id, d->id, n->id, r.width, r.height, r.x, r.y);
 			}
 		}
 
@@ -181,6 +201,100 @@ void apply_layout(monitor_t *m, desktop_t *d, node_t *n, xcb_rectangle_t rect, x
 	}
 }
 
+/* In the master_stack, centered_master and grid layouts, the rectangles of the
+ * leaves are given by their order. The split ratio of the root node sets the
+ * width of the master area. */
+void apply_leaves_layout(monitor_t *m, desktop_t *d, xcb_rectangle_t rect)
+{
+	int count = 0;
+	for (node_t *f = d->leaf_head; f != NULL; f = f->leaf_next) {
+		if (!f->vacant) {
+			count++;
+		}
+	}
+	int index = 0;
+	apply_leaves_layout_in(m, d, d->root, rect, count, &index);
+}
+
+void apply_leaves_layout_in(monitor_t *m, desktop_t *d, node_t *n, xcb_rectangle_t rect, int count, int *index)
+{
+	if (n == NULL) {
+		return;
+	}
+
+	if (is_leaf(n)) {
+		xcb_rectangle_t r = n->vacant ? rect : leaf_tile(d, rect, (*index)++, count);
+		apply_layout(m, d, n, r, rect);
+		return;
+	}
+
+	apply_leaves_layout_in(m, d, n->first_child, rect, count, index);
+	apply_leaves_layout_in(m, d, n->second_child, rect, count, index);
+
+	/* The rectangle of an internal node is the bounding box of its tiles. */
+	xcb_rectangle_t a = n->first_child->rectangle, b = n->second_child->rectangle;
+	if (n->vacant) {
+		n->rectangle = rect;
+	} else if (n->first_child->vacant) {
+		n->rectangle = b;
+	} else if (n->second_child->vacant) {
+		n->rectangle = a;
+	} else {
+		n->rectangle = rect_union(a, b);
+	}
+
+	if (n->presel != NULL && !layout_deferred()) {
+		draw_presel_feedback(m, d, n);
+	}
+}
+
+xcb_rectangle_t leaf_tile(desktop_t *d, xcb_rectangle_t rect, int index, int count)
+{
+	if (count < 2) {
+		return rect;
+	}
+
+	if (d->layout == LAYOUT_GRID) {
+		int cols = 1;
+		while (cols * cols < count) {
+			cols++;
+		}
+		int rows = (count + cols - 1) / cols;
+		int row = index / cols;
+		int cells = (row < rows - 1 ? cols : count - cols * (rows - 1));
+		return rect_slice(rect_slice(rect, row, rows, false), index % cols, cells, true);
+	}
+
+	uint16_t master_width = rect.width * d->root->split_ratio;
+	xcb_rectangle_t master = rect, left = rect, right = rect;
+
+	if (d->layout == LAYOUT_CENTERED_MASTER && count > 2) {
+		left.width = (rect.width - master_width) / 2;
+		master.x = rect.x + left.width;
+		master.width = master_width;
+		right.x = master.x + master.width;
+		right.width = rect.x + rect.width - right.x;
+		if (index == 0) {
+			return master;
+		}
+		/* The first half of the stack goes on the right. */
+		int stack = count - 1, right_count = (stack + 1) / 2;
+		if (index <= right_count) {
+			return rect_slice(right, index - 1, right_count, false);
+		} else {
+			return rect_slice(left, index - 1 - right_count, stack - right_count, false);
+		}
+	}
+
+	master.width = master_width;
+	right.x = rect.x + master_width;
+	right.width = rect.width - master_width;
+	if (index == 0) {
+		return master;
+	}
+	return rect_slice(right, index - 1, count - 1, false);
+}
+
 presel_t *make_presel(void)
 {
 	presel_t *p = calloc(1, sizeof(presel_t));
@@ -199,6 +313,7 @@ void set_type(node_t *n, split_type_t typ)
 	n->split_type = typ;
 	update_constraints(n);
 	rebuild_constraints_towards_root(n);
+	journal_printf("node_type 0x%08X %s\n", n->id, SPLIT_TYPE_STR(typ));
 }
 
 void set_ratio(node_t *n, double rat)
@@ -208,6 +323,7 @@ void set_ratio(node_t *n, double rat)
 	}
 
 	n->split_ratio = rat;
+	journal_ratio(n);
 }
 
 void presel_dir(monitor_t *m, desktop_t *d, node_t *n, direction_t dir)
@@ -218,7 +334,7 @@ void presel_dir(monitor_t *m, desktop_t *d, node_t *n, direction_t dir)
 
 	n->presel->split_dir = dir;
 
-	put_status(SBSC_MASK_NODE_PRESEL, "node_presel 0x%08X 0x%08X 0x%08X dir %s\n", m->id, d->id, n->id, SPLIT_DIR_STR(dir));
+	put_status_in(SBSC_MASK_NODE_PRESEL, &(coordinates_t) {m, d, n}, NULL, "node_presel 0x%08X 0x%08X 0x%08X dir %s\n", m->id, d->id, n->id, SPLIT_DIR_STR(dir));
 }
 
 void presel_ratio(monitor_t *m, desktop_t *d, node_t *n, double ratio)
@@ -229,7 +345,7 @@ void presel_ratio(monitor_t *m, desktop_t *d, node_t *n, double ratio)
 
 	n->presel->split_ratio = ratio;
 
-	put_status(SBSC_MASK_NODE_PRESEL, "node_presel 0x%08X 0x%08X 0x%08X ratio %lf\n", m->id, d->id, n->id, ratio);
+	put_status_in(SBSC_MASK_NODE_PRESEL, &(coordinates_t) {m, d, n}, NULL, "node_presel 0x%08X 0x%08X 0x%08X ratio %lf\n", m->id, d->id, n->id, ratio);
 }
 
 void cancel_presel(monitor_t *m, desktop_t *d, node_t *n)
@@ -238,14 +354,11 @@ void cancel_presel(monitor_t *m, desktop_t *d, node_t *n)
 		return;
 	}
 
-	if (n->presel->feedback != XCB_NONE) {
-		xcb_destroy_window(dpy, n->presel->feedback);
-	}
-
+	release_presel_feedback(d, n->presel);
 	free(n->presel);
 	n->presel = NULL;
 
-	put_status(SBSC_MASK_NODE_PRESEL, "node_presel 0x%08X 0x%08X 0x%08X cancel\n", m->id, d->id, n->id);
+	put_status_in(SBSC_MASK_NODE_PRESEL, &(coordinates_t) {m, d, n}, NULL, "node_presel 0x%08X 0x%08X 0x%08X cancel\n", m->id, d->id, n->id);
 }
 
 void cancel_presel_in(monitor_t *m, desktop_t *d, node_t *n)
@@ -264,7 +377,7 @@ node_t *find_public(desktop_t *d)
 	unsigned int b_automatic_area = 0;
 	node_t *b_manual = NULL;
 	node_t *b_automatic = NULL;
-	for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+	for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
 		if (n->vacant) {
 			continue;
 		}
@@ -316,6 +429,7 @@ node_t *insert_node(monitor_t *m, desktop_t *d, node_t *n, node_t *f)
 			d->root = n;
 		}
 		n->parent = p;
+		unthread_leaf(d, f);
 		free(f);
 		f = NULL;
 	} else {
@@ -400,7 +514,7 @@ node_t *insert_node(monitor_t *m, desktop_t *d, node_t *n, node_t *f)
 					rot = 270;
 				}
 				if (!n->vacant) {
-					rotate_tree(p, rot);
+					rotate_tree(d, p, rot);
 				}
 			}
 		} else {
@@ -444,6 +558,7 @@ node_t *insert_node(monitor_t *m, desktop_t *d, node_t *n, node_t *f)
 		}
 	}
 
+	thread_leaves(d, n);
 	propagate_flags_upward(m, d, n);
 
 	if (d->focus == NULL && is_focusable(n)) {
@@ -456,8 +571,9 @@ node_t *insert_node(monitor_t *m, desktop_t *d, node_t *n, node_t *f)
 void insert_receptacle(monitor_t *m, desktop_t *d, node_t *n)
 {
 	node_t *r = make_node(XCB_NONE);
+	journal_printf("node_receptacle 0x%08X 0x%08X 0x%08X 0x%08X\n", m->id, d->id, n != NULL ? n->id : 0, r->id);
 	insert_node(m, d, r, n);
-	put_status(SBSC_MASK_NODE_ADD, "node_add 0x%08X 0x%08X 0x%08X 0x%08X\n", m->id, d->id, n->id, r->id);
+	put_status_in(SBSC_MASK_NODE_ADD, &(coordinates_t) {m, d, n}, NULL, "node_add 0x%08X 0x%08X 0x%08X 0x%08X\n", m->id, d->id, n->id, r->id);
 
 	if (single_monocle && d->layout == LAYOUT_MONOCLE && tiled_count(d->root, true) > 1) {
 		set_layout(m, d, d->user_layout, false);
@@ -504,27 +620,159 @@ bool activate_node(monitor_t *m, desktop_t *d, node_t *n)
 		return true;
 	}
 
-	put_status(SBSC_MASK_NODE_ACTIVATE, "node_activate 0x%08X 0x%08X 0x%08X\n", m->id, d->id, n->id);
+	put_status_in(SBSC_MASK_NODE_ACTIVATE, &(coordinates_t) {m, d, n}, NULL, "node_activate 0x%08X 0x%08X 0x%08X\n", m->id, d->id, n->id);
 
 	return true;
 }
 
-void transfer_sticky_nodes(monitor_t *ms, desktop_t *ds, monitor_t *md, desktop_t *dd, node_t *n)
+/* Each monitor registers the sticky nodes of its active desktop, hence
+ * switching desktops only visits the sticky nodes instead of the whole tree.
+ * The registry also keeps the monitor's sticky count. */
+
+bool is_registered_sticky(monitor_t *m, node_t *n)
 {
-	if (n == NULL) {
+	return (n->sticky_prev != NULL || m->sticky_head == n);
+}
+
+void register_sticky(monitor_t *m, node_t *n)
+{
+	if (is_registered_sticky(m, n)) {
 		return;
-	} else if (n->sticky) {
-		sticky_still = false;
-		transfer_node(ms, ds, n, md, dd, dd->focus, false);
-		sticky_still = true;
+	}
+	n->sticky_prev = m->sticky_tail;
+	n->sticky_next = NULL;
+	if (m->sticky_tail != NULL) {
+		m->sticky_tail->sticky_next = n;
+	} else {
+		m->sticky_head = n;
+	}
+	m->sticky_tail = n;
+	m->sticky_count++;
+}
+
+void unregister_sticky(monitor_t *m, node_t *n)
+{
+	if (!is_registered_sticky(m, n)) {
+		return;
+	}
+	if (n->sticky_prev != NULL) {
+		n->sticky_prev->sticky_next = n->sticky_next;
+	} else {
+		m->sticky_head = n->sticky_next;
+	}
+	if (n->sticky_next != NULL) {
+		n->sticky_next->sticky_prev = n->sticky_prev;
 	} else {
-		/* we need references to the children because n might be freed after
-		 * the first recursive call */
-		node_t *first_child = n->first_child;
-		node_t *second_child = n->second_child;
-		transfer_sticky_nodes(ms, ds, md, dd, first_child);
-		transfer_sticky_nodes(ms, ds, md, dd, second_child);
+		m->sticky_tail = n->sticky_prev;
+	}
+	n->sticky_prev = n->sticky_next = NULL;
+	m->sticky_count--;
+}
+
+void register_stickies(monitor_t *m, node_t *n)
+{
+	if (n == NULL) {
+		return;
+	}
+	if (n->sticky) {
+		register_sticky(m, n);
+	}
+	register_stickies(m, n->first_child);
+	register_stickies(m, n->second_child);
+}
+
+void unregister_stickies(monitor_t *m, node_t *n)
+{
+	if (n == NULL) {
+		return;
+	}
+	if (n->sticky) {
+		unregister_sticky(m, n);
+	}
+	unregister_stickies(m, n->first_child);
+	unregister_stickies(m, n->second_child);
+}
+
+/* Moves the outermost sticky nodes of the registry of `ms` that belong to `ds`.
+ * Unlike `transfer_node`, the windows are neither hidden nor restacked, the
+ * focus history of the nodes follows them and each desktop is arranged once. */
+void transfer_sticky_nodes(monitor_t *ms, desktop_t *ds, monitor_t *md, desktop_t *dd)
+{
+	if (ds == dd) {
+		return;
+	}
+
+	bool moved = false;
+	node_t *n = ms->sticky_head;
+
+	while (n != NULL) {
+		node_t *next = n->sticky_next;
+		node_t *r = n;
+		while (r->parent != NULL && !r->parent->sticky) {
+			r = r->parent;
+		}
+		if (r->parent == NULL && r == ds->root) {
+			transfer_sticky_node(ms, ds, n, md, dd);
+			moved = true;
+			/* the descendants of `n` have left the registry too */
+			if (md != ms) {
+				next = ms->sticky_head;
+			}
+		}
+		n = next;
+	}
+
+	if (!moved) {
+		return;
+	}
+
+	if (single_monocle) {
+		if (ds->layout != LAYOUT_MONOCLE && tiled_count(ds->root, true) <= 1) {
+			set_layout(ms, ds, LAYOUT_MONOCLE, false);
+		}
+		if (dd->layout == LAYOUT_MONOCLE && tiled_count(dd->root, true) > 1) {
+			set_layout(md, dd, dd->user_layout, false);
+		}
+	}
+
+	arrange(ms, ds);
+	arrange(md, dd);
+}
+
+void transfer_sticky_node(monitor_t *ms, desktop_t *ds, node_t *n, monitor_t *md, desktop_t *dd)
+{
+	put_status_in(SBSC_MASK_NODE_TRANSFER, &(coordinates_t) {ms, ds, n}, &(coordinates_t) {md, dd, n}, "node_transfer 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X\n", ms->id, ds->id, n->id, md->id, dd->id, dd->focus!=NULL?dd->focus->id:0);
+
+	bool held_focus = is_descendant(ds->focus, n);
+
+	if (held_focus && ds == mon->desk) {
+		clear_input_focus();
+	}
+
+	unlink_node(ms, ds, n);
+	insert_node(md, dd, n, dd->focus);
+	reparent_node_windows(n, desktop_parent(ds), desktop_parent(dd));
+
+	if (md != ms) {
+		if (n->client == NULL || monitor_from_client(n->client) != md) {
+			adapt_geometry(&ms->rectangle, &md->rectangle, n);
+		}
+		unregister_stickies(ms, n);
+		register_stickies(md, n);
+	}
+
+	ewmh_set_wm_desktop(n, dd);
+	history_transfer_node(md, dd, n);
+
+	if (held_focus) {
+		ds->focus = history_last_node(ds, NULL);
+		if (ds->focus == NULL) {
+			ds->focus = first_focusable_leaf(ds->root);
+		}
+		draw_border(ds->focus, true, (ms == mon));
 	}
+
+	draw_border(n, is_descendant(n, dd->focus), (md == mon));
 }
 
 bool focus_node(monitor_t *m, desktop_t *d, node_t *n)
@@ -582,7 +830,7 @@ bool focus_node(monitor_t *m, desktop_t *d, node_t *n)
 			n = m->desk->focus;
 		}
 
-		transfer_sticky_nodes(m, m->desk, m, d, m->desk->root);
+		transfer_sticky_nodes(m, m->desk, m, d);
 
 		if (n == NULL && d->focus != NULL) {
 			n = d->focus;
@@ -631,10 +879,11 @@ bool focus_node(monitor_t *m, desktop_t *d, node_t *n)
 			center_pointer(m->rectangle);
 		}
 
-		put_status(SBSC_MASK_MONITOR_FOCUS, "monitor_focus 0x%08X\n", m->id);
+		put_status_in(SBSC_MASK_MONITOR_FOCUS, &(coordinates_t) {m, NULL, NULL}, NULL, "monitor_focus 0x%08X\n", m->id);
 	}
 
 	if (m->desk != d) {
+		stats_begin(d->container != XCB_NONE ? STAT_DESKTOP_SWITCH_CONTAINERS : STAT_DESKTOP_SWITCH_WINDOWS);
 		show_desktop(d);
 		set_input_focus(n);
 		has_input_focus = true;
@@ -644,7 +893,7 @@ bool focus_node(monitor_t *m, desktop_t *d, node_t *n)
 
 	if (desk_changed) {
 		ewmh_update_current_desktop();
-		put_status(SBSC_MASK_DESKTOP_FOCUS, "desktop_focus 0x%08X 0x%08X\n", m->id, d->id);
+		put_status_in(SBSC_MASK_DESKTOP_FOCUS, &(coordinates_t) {m, d, NULL}, NULL, "desktop_focus 0x%08X 0x%08X\n", m->id, d->id);
 	}
 
 	d->focus = n;
@@ -663,7 +912,7 @@ bool focus_node(monitor_t *m, desktop_t *d, node_t *n)
 		return true;
 	}
 
-	put_status(SBSC_MASK_NODE_FOCUS, "node_focus 0x%08X 0x%08X 0x%08X\n", m->id, d->id, n->id);
+	put_status_in(SBSC_MASK_NODE_FOCUS, &(coordinates_t) {m, d, n}, NULL, "node_focus 0x%08X 0x%08X 0x%08X\n", m->id, d->id, n->id);
 
 	stack(d, n, true);
 
@@ -681,7 +930,8 @@ void hide_node(desktop_t *d, node_t *n)
 	if (n == NULL || (!hide_sticky && n->sticky)) {
 		return;
 	} else {
-		if (!n->hidden) {
+		/* The windows of a container stay mapped: only the container is unmapped. */
+		if (!n->hidden && d->container == XCB_NONE) {
 			if (n->presel != NULL && d->layout != LAYOUT_MONOCLE) {
 				window_hide(n->presel->feedback);
 			}
@@ -703,7 +953,7 @@ void show_node(desktop_t *d, node_t *n)
 		// end of recursion
 		return;
 	} else {
-		if (!n->hidden) {
+		if (!n->hidden && d->container == XCB_NONE) {
 			if (n->client != NULL) {
 				window_show(n->id);
 			}
@@ -723,11 +973,14 @@ void show_node(desktop_t *d, node_t *n)
 node_t *make_node(uint32_t id)
 {
 	if (id == XCB_NONE) {
-		id = xcb_generate_id(dpy);
+		id = backend->generate_id();
 	}
 	node_t *n = calloc(1, sizeof(node_t));
 	n->id = id;
 	n->parent = n->first_child = n->second_child = NULL;
+	n->leaf_prev = n->leaf_next = NULL;
+	n->sticky_prev = n->sticky_next = NULL;
+	n->fullscreen_prev = n->fullscreen_next = NULL;
 	n->vacant = n->hidden = n->sticky = n->private = n->locked = n->marked = false;
 	n->split_ratio = split_ratio;
 	n->split_type = TYPE_VERTICAL;
@@ -752,55 +1005,11 @@ client_t *make_client(void)
 	c->icccm_props.take_focus = false;
 	c->icccm_props.delete_window = false;
 	c->size_hints.flags = 0;
+	c->configure_tokens = CONFIGURE_REQUEST_BURST;
+	c->throttled_configure = NULL;
 	return c;
 }
 
-void initialize_client(node_t *n)
-{
-	xcb_window_t win = n->id;
-	client_t *c = n->client;
-	xcb_icccm_get_wm_protocols_reply_t protos;
-	if (xcb_icccm_get_wm_protocols_reply(dpy, xcb_icccm_get_wm_protocols(dpy, win, ewmh->WM_PROTOCOLS), &protos, NULL) == 1) {
-		for (uint32_t i = 0; i < protos.atoms_len; i++) {
-			if (protos.atoms[i] == WM_TAKE_FOCUS) {
-				c->icccm_props.take_focus = true;
-			} else if (protos.atoms[i] == WM_DELETE_WINDOW) {
-				c->icccm_props.delete_window = true;
-			}
-		}
-		xcb_icccm_get_wm_protocols_reply_wipe(&protos);
-	}
-	xcb_ewmh_get_atoms_reply_t wm_state;
-	if (xcb_ewmh_get_wm_state_reply(ewmh, xcb_ewmh_get_wm_state(ewmh, win), &wm_state, NULL) == 1) {
-		for (unsigned int i = 0; i < wm_state.atoms_len && i < MAX_WM_STATES; i++) {
-#define HANDLE_WM_STATE(s) \
-			if (wm_state.atoms[i] == ewmh->_NET_WM_STATE_##s) { \
-				c->wm_flags |= WM_FLAG_##s; continue; \
-			}
-			HANDLE_WM_STATE(MODAL)
-			HANDLE_WM_STATE(STICKY)
-			HANDLE_WM_STATE(MAXIMIZED_VERT)
-			HANDLE_WM_STATE(MAXIMIZED_HORZ)
-			HANDLE_WM_STATE(SHADED)
-			HANDLE_WM_STATE(SKIP_TASKBAR)
-			HANDLE_WM_STATE(SKIP_PAGER)
-			HANDLE_WM_STATE(HIDDEN)
-			HANDLE_WM_STATE(FULLSCREEN)
-			HANDLE_WM_STATE(ABOVE)
-			HANDLE_WM_STATE(BELOW)
-			HANDLE_WM_STATE(DEMANDS_ATTENTION)
-#undef HANDLE_WM_STATE
-		}
-		xcb_ewmh_get_atoms_reply_wipe(&wm_state);
-	}
-	xcb_icccm_wm_hints_t hints;
-	if (xcb_icccm_get_wm_hints_reply(dpy, xcb_icccm_get_wm_hints(dpy, win), &hints, NULL) == 1
-		&& (hints.flags & XCB_ICCCM_WM_HINT_INPUT)) {
-		c->icccm_props.input_hint = hints.input;
-	}
-	xcb_icccm_get_wm_normal_hints_reply(dpy, xcb_icccm_get_wm_normal_hints(dpy, win), &c->size_hints, NULL);
-}
-
 bool is_focusable(node_t *n)
 {
 	for (node_t *f = first_extrema(n); f != NULL; f = next_leaf(f, n)) {
@@ -953,6 +1162,114 @@ node_t *prev_leaf(node_t *n, node_t *r)
 	return second_extrema(p->parent->first_child);
 }
 
+/* The leaves of a desktop are threaded in a doubly linked list, in the order of
+ * first_extrema and next_leaf, so that iterating over them doesn't walk the
+ * tree. The leaves of a subtree are contiguous in that list. */
+bool is_threaded(desktop_t *d, node_t *n)
+{
+	return n->leaf_prev != NULL || n->leaf_next != NULL || d->leaf_head == n;
+}
+
+void thread_leaf(desktop_t *d, node_t *n, node_t *p)
+{
+	n->leaf_prev = p;
+	if (p != NULL) {
+		n->leaf_next = p->leaf_next;
+		p->leaf_next = n;
+	} else {
+		n->leaf_next = d->leaf_head;
+		d->leaf_head = n;
+	}
+	if (n->leaf_next != NULL) {
+		n->leaf_next->leaf_prev = n;
+	} else {
+		d->leaf_tail = n;
+	}
+	if (n->client != NULL && IS_FULLSCREEN(n->client)) {
+		track_fullscreen(d, n);
+	}
+}
+
+void unthread_leaf(desktop_t *d, node_t *n)
+{
+	if (!is_threaded(d, n)) {
+		return;
+	}
+	if (n->leaf_prev != NULL) {
+		n->leaf_prev->leaf_next = n->leaf_next;
+	} else {
+		d->leaf_head = n->leaf_next;
+	}
+	if (n->leaf_next != NULL) {
+		n->leaf_next->leaf_prev = n->leaf_prev;
+	} else {
+		d->leaf_tail = n->leaf_prev;
+	}
+	n->leaf_prev = n->leaf_next = NULL;
+	untrack_fullscreen(d, n);
+}
+
+/* The threaded leaves holding fullscreen clients are also kept in a list,
+ * which is usually empty, so that focusing doesn't have to look for them. */
+bool is_tracked_fullscreen(desktop_t *d, node_t *n)
+{
+	return n->fullscreen_prev != NULL || d->fullscreen_head == n;
+}
+
+void track_fullscreen(desktop_t *d, node_t *n)
+{
+	if (is_tracked_fullscreen(d, n)) {
+		return;
+	}
+	n->fullscreen_prev = NULL;
+	n->fullscreen_next = d->fullscreen_head;
+	if (d->fullscreen_head != NULL) {
+		d->fullscreen_head->fullscreen_prev = n;
+	}
+	d->fullscreen_head = n;
+}
+
+void untrack_fullscreen(desktop_t *d, node_t *n)
+{
+	if (!is_tracked_fullscreen(d, n)) {
+		return;
+	}
+	if (n->fullscreen_prev != NULL) {
+		n->fullscreen_prev->fullscreen_next = n->fullscreen_next;
+	} else {
+		d->fullscreen_head = n->fullscreen_next;
+	}
+	if (n->fullscreen_next != NULL) {
+		n->fullscreen_next->fullscreen_prev = n->fullscreen_prev;
+	}
+	n->fullscreen_prev = n->fullscreen_next = NULL;
+}
+
+/* While several subtrees are being moved, the desktop may hold other unthreaded
+ * leaves: they are skipped when looking for the predecessor of the subtree. */
+void thread_leaves(desktop_t *d, node_t *n)
+{
+	if (n == NULL) {
+		return;
+	}
+	node_t *p = prev_leaf(first_extrema(n), d->root);
+	while (p != NULL && !is_threaded(d, p)) {
+		p = prev_leaf(p, d->root);
+	}
+	for (node_t *f = first_extrema(n); f != NULL; f = next_leaf(f, n)) {
+		unthread_leaf(d, f);
+		thread_leaf(d, f, p);
+		p = f;
+	}
+}
+
+void unthread_leaves(desktop_t *d, node_t *n)
+{
+	for (node_t *f = first_extrema(n); f != NULL; f = next_leaf(f, n)) {
+		unthread_leaf(d, f);
+	}
+}
+
 node_t *next_tiled_leaf(node_t *n, node_t *r)
 {
 	node_t *next = next_leaf(n, r);
@@ -1121,7 +1438,7 @@ void find_nearest_neighbor(coordinates_t *ref, coordinates_t *dst, direction_t d
 
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
 		desktop_t *d = m->desk;
-		for (node_t *f = first_extrema(d->root); f != NULL; f = next_leaf(f, d->root)) {
+		for (node_t *f = d->leaf_head; f != NULL; f = f->leaf_next) {
 			coordinates_t loc = {m, d, f};
 			xcb_rectangle_t r = get_rectangle(m, d, f);
 			if (f == ref->node ||
@@ -1157,7 +1474,8 @@ int tiled_count(node_t *n, bool include_receptacles)
 		return 0;
 	}
 	int cnt = 0;
-	for (node_t *f = first_extrema(n); f != NULL; f = next_leaf(f, n)) {
+	node_t *l = second_extrema(n);
+	for (node_t *f = first_extrema(n); f != NULL; f = (f == l ? NULL : f->leaf_next)) {
 		if (!f->hidden && ((include_receptacles && f->client == NULL) ||
 		                   (f->client != NULL && IS_TILED(f->client)))) {
 			cnt++;
@@ -1177,7 +1495,7 @@ void find_by_area(area_peak_t ap, coordinates_t *ref, coordinates_t *dst, node_s
 
 	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
 		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-			for (node_t *f = first_extrema(d->root); f != NULL; f = next_leaf(f, d->root)) {
+			for (node_t *f = d->leaf_head; f != NULL; f = f->leaf_next) {
 				coordinates_t loc = {m, d, f};
 				if (f->vacant || !node_matches(&loc, ref, sel)) {
 					continue;
@@ -1192,11 +1510,16 @@ void find_by_area(area_peak_t ap, coordinates_t *ref, coordinates_t *dst, node_s
 	}
 }
 
-void rotate_tree(node_t *n, int deg)
+void rotate_tree(desktop_t *d, node_t *n, int deg)
 {
+	unthread_leaves(d, n);
 	rotate_tree_rec(n, deg);
+	thread_leaves(d, n);
 	rebuild_constraints_from_leaves(n);
 	rebuild_constraints_towards_root(n);
+	if (n != NULL) {
+		journal_printf("node_rotate 0x%08X %i\n", n->id, deg);
+	}
 }
 
 void rotate_tree_rec(node_t *n, int deg)
@@ -1228,7 +1551,19 @@ void rotate_tree_rec(node_t *n, int deg)
 	rotate_tree_rec(n->second_child, deg);
 }
 
-void flip_tree(node_t *n, flip_t flp)
+void flip_tree(desktop_t *d, node_t *n, flip_t flp)
+{
+	if (n == NULL || is_leaf(n)) {
+		return;
+	}
+
+	unthread_leaves(d, n);
+	flip_tree_rec(n, flp);
+	thread_leaves(d, n);
+	journal_printf("node_flip 0x%08X %s\n", n->id, flp == FLIP_HORIZONTAL ? "horizontal" : "vertical");
+}
+
+void flip_tree_rec(node_t *n, flip_t flp)
 {
 	if (n == NULL || is_leaf(n)) {
 		return;
@@ -1244,8 +1579,8 @@ void flip_tree(node_t *n, flip_t flp)
 		n->split_ratio = 1.0 - n->split_ratio;
 	}
 
-	flip_tree(n->first_child, flp);
-	flip_tree(n->second_child, flp);
+	flip_tree_rec(n->first_child, flp);
+	flip_tree_rec(n->second_child, flp);
 }
 
 void equalize_tree(node_t *n)
@@ -1253,7 +1588,7 @@ void equalize_tree(node_t *n)
 	if (n == NULL || n->vacant) {
 		return;
 	} else {
-		n->split_ratio = split_ratio;
+		set_ratio(n, split_ratio);
 		equalize_tree(n->first_child);
 		equalize_tree(n->second_child);
 	}
@@ -1270,7 +1605,7 @@ int balance_tree(node_t *n)
 		int b2 = balance_tree(n->second_child);
 		int b = b1 + b2;
 		if (b1 > 0 && b2 > 0) {
-			n->split_ratio = (double) b1 / b;
+			set_ratio(n, (double) b1 / b);
 		}
 		return b;
 	}
@@ -1296,7 +1631,7 @@ void adjust_ratios(node_t *n, xcb_rectangle_t rect)
 
 	ratio = MAX(0.0, ratio);
 	ratio = MIN(1.0, ratio);
-	n->split_ratio = ratio;
+	set_ratio(n, ratio);
 
 	xcb_rectangle_t first_rect;
 	xcb_rectangle_t second_rect;
@@ -1322,6 +1657,8 @@ void unlink_node(monitor_t *m, desktop_t *d, node_t *n)
 		return;
 	}
 
+	unthread_leaves(d, n);
+
 	node_t *p = n->parent;
 
 	if (p == NULL) {
@@ -1336,7 +1673,7 @@ void unlink_node(monitor_t *m, desktop_t *d, node_t *n)
 		cancel_presel(m, d, p);
 
 		if (p->sticky) {
-			m->sticky_count--;
+			unregister_sticky(m, p);
 		}
 
 		node_t *b = brother_tree(n);
@@ -1357,9 +1694,9 @@ void unlink_node(monitor_t *m, desktop_t *d, node_t *n)
 		if (!n->vacant && removal_adjustment) {
 			if (automatic_scheme == SCHEME_SPIRAL) {
 				if (is_first_child(n)) {
-					rotate_tree(b, 270);
+					rotate_tree(d, b, 270);
 				} else {
-					rotate_tree(b, 90);
+					rotate_tree(d, b, 90);
 				}
 			} else if (automatic_scheme == SCHEME_LONGEST_SIDE || g == NULL) {
 				if (p != NULL) {
@@ -1378,6 +1715,7 @@ void unlink_node(monitor_t *m, desktop_t *d, node_t *n)
 			}
 		}
 
+		tree_delta_removed("node", p->id, &p->delta);
 		free(p);
 		n->parent = NULL;
 
@@ -1393,7 +1731,7 @@ void close_node(node_t *n)
 		if (n->client->icccm_props.delete_window) {
 			send_client_message(n->id, ewmh->WM_PROTOCOLS, WM_DELETE_WINDOW);
 		} else {
-			xcb_kill_client(dpy, n->id);
+			backend->kill_client(n->id);
 		}
 	} else {
 		close_node(n->first_child);
@@ -1408,12 +1746,12 @@ void kill_node(monitor_t *m, desktop_t *d, node_t *n)
 	}
 
 	if (IS_RECEPTACLE(n)) {
-		put_status(SBSC_MASK_NODE_REMOVE, "node_remove 0x%08X 0x%08X 0x%08X\n", m->id, d->id, n->id);
+		put_status_in(SBSC_MASK_NODE_REMOVE, &(coordinates_t) {m, d, n}, NULL, "node_remove 0x%08X 0x%08X 0x%08X\n", m->id, d->id, n->id);
 		remove_node(m, d, n);
 	} else {
 		for (node_t *f = first_extrema(n); f != NULL; f = next_leaf(f, n)) {
 			if (f->client != NULL) {
-				xcb_kill_client(dpy, f->id);
+				backend->kill_client(f->id);
 			}
 		}
 	}
@@ -1430,7 +1768,7 @@ void remove_node(monitor_t *m, desktop_t *d, node_t *n)
 	remove_stack_node(n);
 	cancel_presel_in(m, d, n);
 	if (m->sticky_count > 0 && d == m->desk) {
-		m->sticky_count -= sticky_count(n);
+		unregister_stickies(m, n);
 	}
 	clients_count -= clients_count_in(n);
 	if (is_descendant(grabbed_node, n)) {
@@ -1461,6 +1799,11 @@ void free_node(node_t *n)
 	}
 	node_t *first_child = n->first_child;
 	node_t *second_child = n->second_child;
+	tree_delta_removed("node", n->id, &n->delta);
+	if (n->client != NULL) {
+		discard_throttled_configure(n->client);
+		discard_pending_title(n->client);
+	}
 	free(n->client);
 	free(n);
 	free_node(first_child);
@@ -1475,7 +1818,10 @@ bool swap_nodes(monitor_t *m1, desktop_t *d1, node_t *n1, monitor_t *m2, desktop
 		return false;
 	}
 
-	put_status(SBSC_MASK_NODE_SWAP, "node_swap 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X\n", m1->id, d1->id, n1->id, m2->id, d2->id, n2->id);
+	put_status_in(SBSC_MASK_NODE_SWAP, &(coordinates_t) {m1, d1, n1}, &(coordinates_t) {m2, d2, n2}, "node_swap 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X\n", m1->id, d1->id, n1->id, m2->id, d2->id, n2->id);
+
+	unthread_leaves(d1, n1);
+	unthread_leaves(d2, n2);
 
 	node_t *pn1 = n1->parent;
 	node_t *pn2 = n2->parent;
@@ -1508,6 +1854,11 @@ bool swap_nodes(monitor_t *m1, desktop_t *d1, node_t *n1, monitor_t *m2, desktop
 	propagate_flags_upward(m2, d2, n1);
 	propagate_flags_upward(m1, d1, n2);
 
+	if (d1 == d2) {
+		thread_leaves(d1, n1);
+		thread_leaves(d1, n2);
+	}
+
 	if (d1 != d2) {
 		if (d1->root == n1) {
 			d1->root = n2;
@@ -1517,6 +1868,9 @@ bool swap_nodes(monitor_t *m1, desktop_t *d1, node_t *n1, monitor_t *m2, desktop
 			d2->root = n1;
 		}
 
+		thread_leaves(d2, n1);
+		thread_leaves(d1, n2);
+
 		if (n1_held_focus) {
 			d1->focus = n2_held_focus ? last_d2_focus : n2;
 		}
@@ -1533,6 +1887,13 @@ bool swap_nodes(monitor_t *m1, desktop_t *d1, node_t *n1, monitor_t *m2, desktop
 		ewmh_set_wm_desktop(n1, d2);
 		ewmh_set_wm_desktop(n2, d1);
 
+		if (d1->container != d2->container) {
+			reparent_node_windows(n1, desktop_parent(d1), desktop_parent(d2));
+			reparent_node_windows(n2, desktop_parent(d2), desktop_parent(d1));
+			restack_node(d2, n1);
+			restack_node(d1, n2);
+		}
+
 		history_remove(d1, n1, true);
 		history_remove(d2, n2, true);
 
@@ -1614,11 +1975,11 @@ bool transfer_node(monitor_t *ms, desktop_t *ds, node_t *ns, monitor_t *md, desk
 	}
 
 	unsigned int sc = (ms->sticky_count > 0 && ds == ms->desk) ? sticky_count(ns) : 0;
-	if (sticky_still && sc > 0 && dd != md->desk) {
+	if (sc > 0 && dd != md->desk) {
 		return false;
 	}
 
-	put_status(SBSC_MASK_NODE_TRANSFER, "node_transfer 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X\n", ms->id, ds->id, ns->id, md->id, dd->id, nd!=NULL?nd->id:0);
+	put_status_in(SBSC_MASK_NODE_TRANSFER, &(coordinates_t) {ms, ds, ns}, &(coordinates_t) {md, dd, ns}, "node_transfer 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X\n", ms->id, ds->id, ns->id, md->id, dd->id, nd!=NULL?nd->id:0);
 
 	bool held_focus = is_descendant(ds->focus, ns);
 	/* avoid ending up with a dangling pointer (because of unlink_node) */
@@ -1631,23 +1992,24 @@ bool transfer_node(monitor_t *ms, desktop_t *ds, node_t *ns, monitor_t *md, desk
 
 	unlink_node(ms, ds, ns);
 	insert_node(md, dd, ns, nd);
+	reparent_node_windows(ns, desktop_parent(ds), desktop_parent(dd));
 
 	if (md != ms) {
 		if (ns->client == NULL || monitor_from_client(ns->client) != md) {
 			adapt_geometry(&ms->rectangle, &md->rectangle, ns);
 		}
-		ms->sticky_count -= sc;
-		md->sticky_count += sc;
+		if (sc > 0) {
+			unregister_stickies(ms, ns);
+			register_stickies(md, ns);
+		}
 	}
 
 	if (ds != dd) {
 		ewmh_set_wm_desktop(ns, dd);
-		if (sticky_still) {
-			if (ds == ms->desk && dd != md->desk) {
-				hide_node(ds, ns);
-			} else if (ds != ms->desk && dd == md->desk) {
-				show_node(dd, ns);
-			}
+		if (ds == ms->desk && dd != md->desk) {
+			hide_node(ds, ns);
+		} else if (ds != ms->desk && dd == md->desk) {
+			show_node(dd, ns);
 		}
 	}
 
@@ -1856,7 +2218,7 @@ bool set_layer(monitor_t *m, desktop_t *d, node_t *n, stack_layer_t l)
 
 	ewmh_wm_state_update(n);
 
-	put_status(SBSC_MASK_NODE_LAYER, "node_layer 0x%08X 0x%08X 0x%08X %s\n", m->id, d->id, n->id, LAYER_STR(l));
+	put_status_in(SBSC_MASK_NODE_LAYER, &(coordinates_t) {m, d, n}, NULL, "node_layer 0x%08X 0x%08X 0x%08X %s\n", m->id, d->id, n->id, LAYER_STR(l));
 
 	if (d->focus == n) {
 		neutralize_occluding_windows(m, d, n);
@@ -1880,6 +2242,14 @@ bool set_state(monitor_t *m, desktop_t *d, node_t *n, client_state_t s)
 	c->last_state = c->state;
 	c->state = s;
 
+	if (is_threaded(d, n)) {
+		if (s == STATE_FULLSCREEN) {
+			track_fullscreen(d, n);
+		} else if (c->last_state == STATE_FULLSCREEN) {
+			untrack_fullscreen(d, n);
+		}
+	}
+
 	switch (c->last_state) {
 		case STATE_TILED:
 		case STATE_PSEUDO_TILED:
@@ -1892,7 +2262,7 @@ bool set_state(monitor_t *m, desktop_t *d, node_t *n, client_state_t s)
 			break;
 	}
 
-	put_status(SBSC_MASK_NODE_STATE, "node_state 0x%08X 0x%08X 0x%08X %s off\n", m->id, d->id, n->id, STATE_STR(c->last_state));
+	put_status_in(SBSC_MASK_NODE_STATE, &(coordinates_t) {m, d, n}, NULL, "node_state 0x%08X 0x%08X 0x%08X %s off\n", m->id, d->id, n->id, STATE_STR(c->last_state));
 
 	switch (c->state) {
 		case STATE_TILED:
@@ -1906,7 +2276,7 @@ bool set_state(monitor_t *m, desktop_t *d, node_t *n, client_state_t s)
 			break;
 	}
 
-	put_status(SBSC_MASK_NODE_STATE, "node_state 0x%08X 0x%08X 0x%08X %s on\n", m->id, d->id, n->id, STATE_STR(c->state));
+	put_status_in(SBSC_MASK_NODE_STATE, &(coordinates_t) {m, d, n}, NULL, "node_state 0x%08X 0x%08X 0x%08X %s on\n", m->id, d->id, n->id, STATE_STR(c->state));
 
 	if (n == m->desk->focus) {
 		put_status(SBSC_MASK_REPORT);
@@ -1969,13 +2339,23 @@ void set_fullscreen(monitor_t *m, desktop_t *d, node_t *n, bool value)
 
 void neutralize_occluding_windows(monitor_t *m, desktop_t *d, node_t *n)
 {
+	if (d->fullscreen_head == NULL) {
+		return;
+	}
 	bool changed = false;
 	for (node_t *f = first_extrema(n); f != NULL; f = next_leaf(f, n)) {
-		for (node_t *a = first_extrema(d->root); a != NULL; a = next_leaf(a, d->root)) {
-			if (a != f && a->client != NULL && f->client != NULL &&
-			    IS_FULLSCREEN(a->client) && stack_cmp(f->client, a->client) < 0) {
-				set_state(m, d, a, a->client->last_state);
+		if (f->client == NULL) {
+			continue;
+		}
+		node_t *a = d->fullscreen_head;
+		while (a != NULL) {
+			if (a != f && stack_cmp(f->client, a->client) < 0 &&
+			    set_state(m, d, a, a->client->last_state)) {
 				changed = true;
+				/* the list might have changed beyond `a` */
+				a = d->fullscreen_head;
+			} else {
+				a = a->fullscreen_next;
 			}
 		}
 	}
@@ -2052,7 +2432,7 @@ void set_hidden(monitor_t *m, desktop_t *d, node_t *n, bool value)
 	propagate_hidden_downward(m, d, n, value);
 	propagate_hidden_upward(m, d, n);
 
-	put_status(SBSC_MASK_NODE_FLAG, "node_flag 0x%08X 0x%08X 0x%08X hidden %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
+	put_status_in(SBSC_MASK_NODE_FLAG, &(coordinates_t) {m, d, n}, NULL, "node_flag 0x%08X 0x%08X 0x%08X hidden %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
 
 	if (held_focus || d->focus == NULL) {
 		if (d->focus != NULL) {
@@ -2084,8 +2464,8 @@ void set_hidden_local(monitor_t *m, desktop_t *d, node_t *n, bool value)
 	n->hidden = value;
 
 	if (n->client != NULL) {
-		if (n->client->shown) {
-			window_set_visibility(n->id, !value);
+		if (n->client->shown || d->container != XCB_NONE) {
+			window_set_visibility_in(desktop_parent(d), n->id, !value);
 		}
 
 		if (IS_TILED(n->client)) {
@@ -2142,9 +2522,9 @@ void set_sticky(monitor_t *m, desktop_t *d, node_t *n, bool value)
 	n->sticky = value;
 
 	if (value) {
-		m->sticky_count++;
+		register_sticky(m, n);
 	} else {
-		m->sticky_count--;
+		unregister_sticky(m, n);
 	}
 
 	if (n->client != NULL) {
@@ -2156,7 +2536,7 @@ void set_sticky(monitor_t *m, desktop_t *d, node_t *n, bool value)
 		ewmh_wm_state_update(n);
 	}
 
-	put_status(SBSC_MASK_NODE_FLAG, "node_flag 0x%08X 0x%08X 0x%08X sticky %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
+	put_status_in(SBSC_MASK_NODE_FLAG, &(coordinates_t) {m, d, n}, NULL, "node_flag 0x%08X 0x%08X 0x%08X sticky %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
 
 	if (n == m->desk->focus) {
 		put_status(SBSC_MASK_REPORT);
@@ -2171,7 +2551,7 @@ void set_private(monitor_t *m, desktop_t *d, node_t *n, bool value)
 
 	n->private = value;
 
-	put_status(SBSC_MASK_NODE_FLAG, "node_flag 0x%08X 0x%08X 0x%08X private %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
+	put_status_in(SBSC_MASK_NODE_FLAG, &(coordinates_t) {m, d, n}, NULL, "node_flag 0x%08X 0x%08X 0x%08X private %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
 
 	if (n == m->desk->focus) {
 		put_status(SBSC_MASK_REPORT);
@@ -2186,7 +2566,7 @@ void set_locked(monitor_t *m, desktop_t *d, node_t *n, bool value)
 
 	n->locked = value;
 
-	put_status(SBSC_MASK_NODE_FLAG, "node_flag 0x%08X 0x%08X 0x%08X locked %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
+	put_status_in(SBSC_MASK_NODE_FLAG, &(coordinates_t) {m, d, n}, NULL, "node_flag 0x%08X 0x%08X 0x%08X locked %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
 
 	if (n == m->desk->focus) {
 		put_status(SBSC_MASK_REPORT);
@@ -2201,7 +2581,7 @@ void set_marked(monitor_t *m, desktop_t *d, node_t *n, bool value)
 
 	n->marked = value;
 
-	put_status(SBSC_MASK_NODE_FLAG, "node_flag 0x%08X 0x%08X 0x%08X marked %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
+	put_status_in(SBSC_MASK_NODE_FLAG, &(coordinates_t) {m, d, n}, NULL, "node_flag 0x%08X 0x%08X 0x%08X marked %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
 
 	if (n == m->desk->focus) {
 		put_status(SBSC_MASK_REPORT);
@@ -2224,7 +2604,7 @@ void set_urgent(monitor_t *m, desktop_t *d, node_t *n, bool value)
 
 	ewmh_wm_state_update(n);
 
-	put_status(SBSC_MASK_NODE_FLAG, "node_flag 0x%08X 0x%08X 0x%08X urgent %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
+	put_status_in(SBSC_MASK_NODE_FLAG, &(coordinates_t) {m, d, n}, NULL, "node_flag 0x%08X 0x%08X 0x%08X urgent %s\n", m->id, d->id, n->id, ON_OFF_STR(value));
 	put_status(SBSC_MASK_REPORT);
 }
 
@@ -2256,9 +2636,9 @@ void listen_enter_notify(node_t *n, bool enable)
 		if (f->client == NULL) {
 			continue;
 		}
-		xcb_change_window_attributes(dpy, f->id, XCB_CW_EVENT_MASK, &mask);
+		backend->change_attributes(f->id, XCB_CW_EVENT_MASK, &mask);
 		if (f->presel != NULL) {
-			xcb_change_window_attributes(dpy, f->presel->feedback, XCB_CW_EVENT_MASK, &mask);
+			backend->change_attributes(f->presel->feedback, XCB_CW_EVENT_MASK, &mask);
 		}
 	}
 }
@@ -2268,7 +2648,7 @@ void regenerate_ids_in(node_t *n)
 	if (n == NULL || n->client != NULL) {
 		return;
 	}
-	n->id = xcb_generate_id(dpy);
+	n->id = backend->generate_id();
 	regenerate_ids_in(n->first_child);
 	regenerate_ids_in(n->second_child);
 }
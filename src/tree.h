@@ -30,6 +30,9 @@
 
 void arrange(monitor_t *m, desktop_t *d);
 void apply_layout(monitor_t *m, desktop_t *d, node_t *n, xcb_rectangle_t rect, xcb_rectangle_t root_rect);
+void apply_leaves_layout(monitor_t *m, desktop_t *d, xcb_rectangle_t rect);
+void apply_leaves_layout_in(monitor_t *m, desktop_t *d, node_t *n, xcb_rectangle_t rect, int count, int *index);
+xcb_rectangle_t leaf_tile(desktop_t *d, xcb_rectangle_t rect, int index, int count);
 presel_t *make_presel(void);
 void set_type(node_t *n, split_type_t typ);
 void set_ratio(node_t *n, double rat);
@@ -41,13 +44,18 @@ node_t *find_public(desktop_t *d);
 node_t *insert_node(monitor_t *m, desktop_t *d, node_t *n, node_t *f);
 void insert_receptacle(monitor_t *m, desktop_t *d, node_t *n);
 bool activate_node(monitor_t *m, desktop_t *d, node_t *n);
-void transfer_sticky_nodes(monitor_t *ms, desktop_t *ds, monitor_t *md, desktop_t *dd, node_t *n);
+bool is_registered_sticky(monitor_t *m, node_t *n);
+void register_sticky(monitor_t *m, node_t *n);
+void unregister_sticky(monitor_t *m, node_t *n);
+void register_stickies(monitor_t *m, node_t *n);
+void unregister_stickies(monitor_t *m, node_t *n);
+void transfer_sticky_nodes(monitor_t *ms, desktop_t *ds, monitor_t *md, desktop_t *dd);
+void transfer_sticky_node(monitor_t *ms, desktop_t *ds, node_t *n, monitor_t *md, desktop_t *dd);
 bool focus_node(monitor_t *m, desktop_t *d, node_t *n);
 void hide_node(desktop_t *d, node_t *n);
 void show_node(desktop_t *d, node_t *n);
 node_t *make_node(uint32_t id);
 client_t *make_client(void);
-void initialize_client(node_t *n);
 bool is_focusable(node_t *n);
 bool is_leaf(node_t *n);
 bool is_first_child(node_t *n);
@@ -61,6 +69,14 @@ node_t *next_node(node_t *n);
 node_t *prev_node(node_t *n);
 node_t *next_leaf(node_t *n, node_t *r);
 node_t *prev_leaf(node_t *n, node_t *r);
+bool is_threaded(desktop_t *d, node_t *n);
+void thread_leaf(desktop_t *d, node_t *n, node_t *p);
+void unthread_leaf(desktop_t *d, node_t *n);
+bool is_tracked_fullscreen(desktop_t *d, node_t *n);
+void track_fullscreen(desktop_t *d, node_t *n);
+void untrack_fullscreen(desktop_t *d, node_t *n);
+void thread_leaves(desktop_t *d, node_t *n);
+void unthread_leaves(desktop_t *d, node_t *n);
 node_t *next_tiled_leaf(node_t *n, node_t *r);
 node_t *prev_tiled_leaf(node_t *n, node_t *r);
 bool is_adjacent(node_t *a, node_t *b, direction_t dir);
@@ -76,9 +92,10 @@ void find_nearest_neighbor(coordinates_t *ref, coordinates_t *dst, direction_t d
 unsigned int node_area(desktop_t *d, node_t *n);
 int tiled_count(node_t *n, bool include_receptacles);
 void find_by_area(area_peak_t ap, coordinates_t *ref, coordinates_t *dst, node_select_t *sel);
-void rotate_tree(node_t *n, int deg);
+void rotate_tree(desktop_t *d, node_t *n, int deg);
 void rotate_tree_rec(node_t *n, int deg);
-void flip_tree(node_t *n, flip_t flp);
+void flip_tree(desktop_t *d, node_t *n, flip_t flp);
+void flip_tree_rec(node_t *n, flip_t flp);
 void equalize_tree(node_t *n);
 int balance_tree(node_t *n);
 void adjust_ratios(node_t *n, xcb_rectangle_t rect);
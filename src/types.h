@@ -132,7 +132,10 @@ typedef enum {
 
 typedef enum {
 	LAYOUT_TILED,
-	LAYOUT_MONOCLE
+	LAYOUT_MONOCLE,
+	LAYOUT_MASTER_STACK,
+	LAYOUT_CENTERED_MASTER,
+	LAYOUT_GRID
 } layout_t;
 
 typedef enum {
@@ -160,31 +163,41 @@ typedef enum {
 	STATE_TRANSITION_EXIT = 1 << 1,
 } state_transition_t;
 
+/* Node properties tested by the node selectors, the *active* modifier
+ * covers both NODE_FLAG_ACTIVE and NODE_FLAG_ACTIVE_DESKTOP. */
+typedef enum {
+	NODE_FLAG_AUTOMATIC = 1 << 0,
+	NODE_FLAG_FOCUSED = 1 << 1,
+	NODE_FLAG_ACTIVE = 1 << 2,
+	NODE_FLAG_LOCAL = 1 << 3,
+	NODE_FLAG_LEAF = 1 << 4,
+	NODE_FLAG_WINDOW = 1 << 5,
+	NODE_FLAG_TILED = 1 << 6,
+	NODE_FLAG_PSEUDO_TILED = 1 << 7,
+	NODE_FLAG_FLOATING = 1 << 8,
+	NODE_FLAG_FULLSCREEN = 1 << 9,
+	NODE_FLAG_HIDDEN = 1 << 10,
+	NODE_FLAG_STICKY = 1 << 11,
+	NODE_FLAG_PRIVATE = 1 << 12,
+	NODE_FLAG_LOCKED = 1 << 13,
+	NODE_FLAG_MARKED = 1 << 14,
+	NODE_FLAG_URGENT = 1 << 15,
+	NODE_FLAG_SAME_CLASS = 1 << 16,
+	NODE_FLAG_DESCENDANT_OF = 1 << 17,
+	NODE_FLAG_ANCESTOR_OF = 1 << 18,
+	NODE_FLAG_BELOW = 1 << 19,
+	NODE_FLAG_NORMAL = 1 << 20,
+	NODE_FLAG_ABOVE = 1 << 21,
+	NODE_FLAG_HORIZONTAL = 1 << 22,
+	NODE_FLAG_VERTICAL = 1 << 23,
+	NODE_FLAG_ACTIVE_DESKTOP = 1 << 24,
+	NODE_FLAG_RELATIVE = NODE_FLAG_FOCUSED | NODE_FLAG_ACTIVE | NODE_FLAG_LOCAL | NODE_FLAG_SAME_CLASS | NODE_FLAG_DESCENDANT_OF | NODE_FLAG_ANCESTOR_OF | NODE_FLAG_ACTIVE_DESKTOP,
+} node_flag_t;
+
+/* A node matches when its flags agree with `value` on the bits of `mask`. */
 typedef struct {
-	option_bool_t automatic;
-	option_bool_t focused;
-	option_bool_t active;
-	option_bool_t local;
-	option_bool_t leaf;
-	option_bool_t window;
-	option_bool_t tiled;
-	option_bool_t pseudo_tiled;
-	option_bool_t floating;
-	option_bool_t fullscreen;
-	option_bool_t hidden;
-	option_bool_t sticky;
-	option_bool_t private;
-	option_bool_t locked;
-	option_bool_t marked;
-	option_bool_t urgent;
-	option_bool_t same_class;
-	option_bool_t descendant_of;
-	option_bool_t ancestor_of;
-	option_bool_t below;
-	option_bool_t normal;
-	option_bool_t above;
-	option_bool_t horizontal;
-	option_bool_t vertical;
+	uint32_t mask;
+	uint32_t value;
 } node_select_t;
 
 typedef struct {
@@ -195,8 +208,14 @@ typedef struct {
 	option_bool_t local;
 	option_bool_t tiled;
 	option_bool_t monocle;
+	option_bool_t master_stack;
+	option_bool_t centered_master;
+	option_bool_t grid;
 	option_bool_t user_tiled;
 	option_bool_t user_monocle;
+	option_bool_t user_master_stack;
+	option_bool_t user_centered_master;
+	option_bool_t user_grid;
 } desktop_select_t;
 
 typedef struct {
@@ -227,6 +246,15 @@ typedef struct {
 	xcb_size_hints_t size_hints;
 	icccm_props_t icccm_props;
 	wm_flags_t wm_flags;
+	/* Rate limit of the configure requests: a token bucket, refilled at the
+	 * given time, and the pending request that exceeded the rate. */
+	double configure_tokens;
+	uint64_t configure_stamp;
+	xcb_configure_request_event_t *throttled_configure;
+	/* Rate limit of the title events: when the last one was sent, and
+	 * whether a title change is waiting to be sent. */
+	uint64_t title_stamp;
+	bool title_pending;
 } client_t;
 
 typedef struct presel_t presel_t;
@@ -234,8 +262,19 @@ struct presel_t {
 	double split_ratio;
 	direction_t split_dir;
 	xcb_window_t feedback;
+	/* What was last sent for the feedback window: its rectangle, the node it
+	 * was stacked above and the window that was above that node. */
+	xcb_rectangle_t feedback_rectangle;
+	xcb_window_t feedback_anchor;
+	xcb_window_t feedback_anchor_next;
 };
 
+/* The last representation sent to the `tree_delta` subscribers. */
+typedef struct {
+	uint32_t hash;
+	char *text;
+} delta_record_t;
+
 typedef struct constraints_t constraints_t;
 struct constraints_t {
 	uint16_t min_width;
@@ -246,6 +285,9 @@ struct constraints_t {
  * @brief A node is a rectangle that contains either zero or two children
  *
  */
+typedef struct history_t history_t;
+typedef struct stacking_list_t stacking_list_t;
+
 typedef struct node_t node_t;
 struct node_t {
 	uint32_t id;
@@ -263,7 +305,20 @@ struct node_t {
 	node_t *first_child;
 	node_t *second_child;
 	node_t *parent;
+	/* The neighbors of a leaf in the in-order list of the leaves of its desktop. */
+	node_t *leaf_prev;
+	node_t *leaf_next;
+	/* The neighbors of a sticky node in the registry of its monitor. */
+	node_t *sticky_prev;
+	node_t *sticky_next;
+	/* The neighbors of a fullscreen leaf in the list of its desktop. */
+	node_t *fullscreen_prev;
+	node_t *fullscreen_next;
 	client_t *client;
+	history_t *history;
+	/* The entry of a leaf in the stacking list, if any. */
+	stacking_list_t *stack;
+	delta_record_t delta;
 };
 
 typedef struct padding_t padding_t;
@@ -287,11 +342,19 @@ struct desktop_t {
 	layout_t user_layout;
 	node_t *root;
 	node_t *focus;
+	node_t *leaf_head;
+	node_t *leaf_tail;
+	node_t *fullscreen_head;
 	desktop_t *prev;
 	desktop_t *next;
 	padding_t padding;
 	int window_gap;
 	unsigned int border_width;
+	unsigned int ordinal;
+	history_t *history;
+	xcb_window_t container;
+	delta_record_t delta;
+	bool delta_dirty;
 };
 
 /**
@@ -307,6 +370,8 @@ struct monitor_t {
 	bool wired;
 	padding_t padding;
 	unsigned int sticky_count;
+	node_t *sticky_head;
+	node_t *sticky_tail;
 	int window_gap;
 	unsigned int border_width;
 	xcb_rectangle_t rectangle;
@@ -315,6 +380,8 @@ struct monitor_t {
 	desktop_t *desk_tail;
 	monitor_t *prev;
 	monitor_t *next;
+	delta_record_t delta;
+	bool delta_dirty;
 };
 
 typedef struct {
@@ -323,17 +390,19 @@ typedef struct {
 	node_t *node;
 } coordinates_t;
 
-typedef struct history_t history_t;
 struct history_t {
 	coordinates_t loc;
 	bool latest;
+	uint32_t seq;
 	history_t *prev;
 	history_t *next;
+	history_t *older;
+	history_t *newer;
 };
 
-typedef struct stacking_list_t stacking_list_t;
 struct stacking_list_t {
 	node_t *node;
+	uint32_t seq;
 	stacking_list_t *prev;
 	stacking_list_t *next;
 };
@@ -345,12 +414,27 @@ struct event_queue_t {
 	event_queue_t *next;
 };
 
+/* Restrict the events sent to a subscriber to the ones about the given items:
+ * an ID of 0 or a NULL modifiers string matches any item. */
+typedef struct {
+	uint32_t monitor_id;
+	uint32_t desktop_id;
+	uint32_t node_id;
+	char *monitor_modifiers;
+	char *desktop_modifiers;
+	char *node_modifiers;
+	monitor_select_t monitor_sel;
+	desktop_select_t desktop_sel;
+	node_select_t node_sel;
+} subscriber_filter_t;
+
 typedef struct subscriber_list_t subscriber_list_t;
 struct subscriber_list_t {
 	FILE *stream;
 	char* fifo_path;
 	int field;
 	int count;
+	subscriber_filter_t *filter;
 	subscriber_list_t *prev;
 	subscriber_list_t *next;
 };
@@ -390,6 +474,32 @@ typedef struct {
 	xcb_rectangle_t *rect;
 } rule_consequence_t;
 
+/* Requests sent ahead of their replies, so that several windows can share round trips. */
+typedef struct {
+	xcb_get_property_cookie_t window_type;
+	xcb_get_property_cookie_t window_state;
+	xcb_get_property_cookie_t transient_for;
+	xcb_get_property_cookie_t normal_hints;
+	xcb_get_property_cookie_t class;
+	xcb_get_property_cookie_t name;
+} rule_cookies_t;
+
+typedef struct {
+	xcb_get_property_cookie_t protocols;
+	xcb_get_property_cookie_t window_state;
+	xcb_get_property_cookie_t hints;
+	xcb_get_property_cookie_t normal_hints;
+	xcb_get_property_cookie_t wm_name;
+	xcb_get_property_cookie_t net_wm_name;
+} client_cookies_t;
+
+typedef struct {
+	xcb_get_window_attributes_cookie_t attributes;
+	rule_cookies_t rule;
+	client_cookies_t client;
+	xcb_get_geometry_cookie_t geometry;
+} window_cookies_t;
+
 typedef struct pending_rule_t pending_rule_t;
 struct pending_rule_t {
 	int fd;
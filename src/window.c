@@ -32,257 +32,127 @@
 #include "monitor.h"
 #include "desktop.h"
 #include "query.h"
-#include "rule.h"
 #include "settings.h"
 #include "geometry.h"
-#include "pointer.h"
 #include "stack.h"
+#include "stats.h"
+#include "subscribe.h"
 #include "tree.h"
 #include "parse.h"
+#include "backend.h"
 #include "window.h"
 
-void schedule_window(xcb_window_t win)
-{
-	coordinates_t loc;
-	uint8_t override_redirect = 0;
-	xcb_get_window_attributes_reply_t *wa = xcb_get_window_attributes_reply(dpy, xcb_get_window_attributes(dpy, win), NULL);
+/* Unmapped feedback windows, children of the root window, ready to be reused. */
+static xcb_window_t presel_feedback_pool[PRESEL_FEEDBACK_POOL_SIZE];
+static int presel_feedback_pool_len = 0;
 
-	if (wa != NULL) {
-		override_redirect = wa->override_redirect;
-		free(wa);
-	}
+/* The number of clients with a title change waiting to be sent. */
+static int pending_titles_count = 0;
 
-	if (override_redirect || locate_window(win, &loc)) {
-		return;
-	}
+void set_window_state(xcb_window_t win, xcb_icccm_wm_state_t state)
+{
+	long data[] = {state, XCB_NONE};
+	backend->change_property(win, WM_STATE, WM_STATE, 32, 2, data);
+}
 
-	/* ignore pending windows */
-	for (pending_rule_t *pr = pending_rule_head; pr != NULL; pr = pr->next) {
-		if (pr->win == win) {
-			return;
-		}
+static bool has_presel_feedback(node_t *n, xcb_window_t win)
+{
+	if (n == NULL) {
+		return false;
 	}
-
-	rule_consequence_t *csq = make_rule_consequence();
-	apply_rules(win, csq);
-	if (!schedule_rules(win, csq)) {
-		manage_window(win, csq, -1);
-		free(csq);
+	if (n->presel != NULL && n->presel->feedback == win) {
+		return true;
 	}
+	return has_presel_feedback(n->first_child, win) || has_presel_feedback(n->second_child, win);
 }
 
-bool manage_window(xcb_window_t win, rule_consequence_t *csq, int fd)
+/* The feedbacks of the hidden desktops and of the pool are unmapped: only the
+ * visible desktops are searched. */
+bool is_presel_window(xcb_window_t win)
 {
-	monitor_t *m = mon;
-	desktop_t *d = mon->desk;
-	node_t *f = mon->desk->focus;
-
-	parse_rule_consequence(fd, csq);
-
-	if (!ignore_ewmh_struts && ewmh_handle_struts(win)) {
-		for (monitor_t *m = mon_head; m != NULL; m = m->next) {
-			for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
-				arrange(m, d);
-			}
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		if (m->desk != NULL && has_presel_feedback(m->desk->root, win)) {
+			return true;
 		}
 	}
+	return false;
+}
 
-	if (!csq->manage) {
-		free(csq->layer);
-		free(csq->state);
-		window_show(win);
-		return false;
+void initialize_presel_feedback(desktop_t *d, node_t *n)
+{
+	if (n == NULL || n->presel == NULL || n->presel->feedback != XCB_NONE) {
+		return;
 	}
 
-	if (csq->node_desc[0] != '\0') {
-		coordinates_t ref = {m, d, f};
-		coordinates_t trg = {NULL, NULL, NULL};
-		if (node_from_desc(csq->node_desc, &ref, &trg) == SELECTOR_OK) {
-			m = trg.monitor;
-			d = trg.desktop;
-			f = trg.node;
-		}
-	} else if (csq->desktop_desc[0] != '\0') {
-		coordinates_t ref = {m, d, NULL};
-		coordinates_t trg = {NULL, NULL, NULL};
-		if (desktop_from_desc(csq->desktop_desc, &ref, &trg) == SELECTOR_OK) {
-			m = trg.monitor;
-			d = trg.desktop;
-			f = trg.desktop->focus;
-		}
-	} else if (csq->monitor_desc[0] != '\0') {
-		coordinates_t ref = {m, NULL, NULL};
-		coordinates_t trg = {NULL, NULL, NULL};
-		if (monitor_from_desc(csq->monitor_desc, &ref, &trg) == SELECTOR_OK) {
-			m = trg.monitor;
-			d = trg.monitor->desk;
-			f = trg.monitor->desk->focus;
+	presel_t *p = n->presel;
+	xcb_window_t win;
+
+	if (presel_feedback_pool_len > 0) {
+		win = presel_feedback_pool[--presel_feedback_pool_len];
+		/* The color might have changed since the window was created. */
+		uint32_t values[] = {get_color_pixel(presel_feedback_color), XCB_EVENT_MASK_NO_EVENT};
+		backend->change_attributes(win, XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK, values);
+		/* The pooled windows are unmapped and moved when they're drawn: there's
+		 * no position to keep and no unmap notification to mask. */
+		xcb_window_t parent = desktop_parent(d);
+		if (parent != root) {
+			backend->reparent_window(win, parent, 0, 0);
 		}
-	}
-
-	if (csq->sticky) {
-		m = mon;
-		d = mon->desk;
-		f = mon->desk->focus;
-	}
-
-	if (csq->split_dir != NULL && f != NULL) {
-		presel_dir(m, d, f, *csq->split_dir);
-	}
-
-	if (csq->split_ratio != 0 && f != NULL) {
-		presel_ratio(m, d, f, csq->split_ratio);
-	}
-
-	node_t *n = make_node(win);
-	client_t *c = make_client();
-	c->border_width = csq->border ? d->border_width : 0;
-	n->client = c;
-	initialize_client(n);
-	initialize_floating_rectangle(n);
-
-	if (csq->rect != NULL) {
-		c->floating_rectangle = *csq->rect;
-		free(csq->rect);
-	} else if (c->floating_rectangle.x == 0 && c->floating_rectangle.y == 0) {
-		csq->center = true;
-	}
-
-	monitor_t *mm = monitor_from_client(c);
-	embrace_client(mm, c);
-	adapt_geometry(&mm->rectangle, &m->rectangle, n);
-
-	if (csq->center) {
-		window_center(m, c);
-	}
-
-	snprintf(c->class_name, sizeof(c->class_name), "%s", csq->class_name);
-	snprintf(c->instance_name, sizeof(c->instance_name), "%s", csq->instance_name);
-
-	if ((csq->state != NULL && (*(csq->state) == STATE_FLOATING || *(csq->state) == STATE_FULLSCREEN)) || csq->hidden) {
-		n->vacant = true;
-	}
-
-	f = insert_node(m, d, n, f);
-	clients_count++;
-	if (single_monocle && d->layout == LAYOUT_MONOCLE && tiled_count(d->root, true) > 1) {
-		set_layout(m, d, d->user_layout, false);
-	}
-
-	n->vacant = false;
-
-	put_status(SBSC_MASK_NODE_ADD, "node_add 0x%08X 0x%08X 0x%08X 0x%08X\n", m->id, d->id, f!=NULL?f->id:0, win);
-
-	if (f != NULL && f->client != NULL && csq->state != NULL && *(csq->state) == STATE_FLOATING) {
-		c->layer = f->client->layer;
-	}
-
-	if (csq->layer != NULL) {
-		c->layer = *(csq->layer);
-	}
-
-	if (csq->state != NULL) {
-		set_state(m, d, n, *(csq->state));
-	}
-
-	set_hidden(m, d, n, csq->hidden);
-	set_sticky(m, d, n, csq->sticky);
-	set_private(m, d, n, csq->private);
-	set_locked(m, d, n, csq->locked);
-	set_marked(m, d, n, csq->marked);
-
-	arrange(m, d);
-
-	uint32_t values[] = {CLIENT_EVENT_MASK | (focus_follows_pointer ? XCB_EVENT_MASK_ENTER_WINDOW : 0)};
-	xcb_change_window_attributes(dpy, win, XCB_CW_EVENT_MASK, values);
-	set_window_state(win, XCB_ICCCM_WM_STATE_NORMAL);
-	window_grab_buttons(win);
-
-	if (d == m->desk) {
-		show_node(d, n);
 	} else {
-		hide_node(d, n);
-	}
-
-	ewmh_update_client_list(false);
-	ewmh_set_wm_desktop(n, d);
+		win = backend->generate_id();
+		uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_SAVE_UNDER;
+		uint32_t values[] = {get_color_pixel(presel_feedback_color), 1};
+		backend->create_window(win, desktop_parent(d), (xcb_rectangle_t) {0, 0, 1, 1}, XCB_WINDOW_CLASS_INPUT_OUTPUT, mask, values);
 
-	if (!csq->hidden && csq->focus) {
-		if (d == mon->desk || csq->follow) {
-			focus_node(m, d, n);
-		} else {
-			activate_node(m, d, n);
-		}
-	} else {
-		stack(d, n, false);
-		draw_border(n, false, (m == mon));
+		set_wm_class(win, sizeof(PRESEL_FEEDBACK_IC), PRESEL_FEEDBACK_IC);
+		/* Make presel window's input shape NULL to pass any input to window below */
+		backend->shape_rectangles(XCB_SHAPE_SK_INPUT, win, 0, NULL);
 	}
 
-	free(csq->layer);
-	free(csq->state);
+	p->feedback = win;
+	p->feedback_rectangle = (xcb_rectangle_t) {0, 0, 0, 0};
+	p->feedback_anchor = p->feedback_anchor_next = XCB_NONE;
 
-	return true;
-}
-
-void set_window_state(xcb_window_t win, xcb_icccm_wm_state_t state)
-{
-	long data[] = {state, XCB_NONE};
-	xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, win, WM_STATE, WM_STATE, 32, 2, data);
+	stacking_list_t *s = topmost_tiled(d);
+	if (s != NULL) {
+		window_above(win, s->node->id);
+		p->feedback_anchor = s->node->id;
+		p->feedback_anchor_next = (s->next != NULL ? s->next->node->id : XCB_NONE);
+	}
 }
 
-void unmanage_window(xcb_window_t win)
+void release_presel_feedback(desktop_t *d, presel_t *p)
 {
-	coordinates_t loc;
-	if (locate_window(win, &loc)) {
-		put_status(SBSC_MASK_NODE_REMOVE, "node_remove 0x%08X 0x%08X 0x%08X\n", loc.monitor->id, loc.desktop->id, win);
-		remove_node(loc.monitor, loc.desktop, loc.node);
-		arrange(loc.monitor, loc.desktop);
-	} else {
-		for (pending_rule_t *pr = pending_rule_head; pr != NULL; pr = pr->next) {
-			if (pr->win == win) {
-				remove_pending_rule(pr);
-				return;
-			}
-		}
+	if (p->feedback == XCB_NONE) {
+		return;
 	}
-}
 
-bool is_presel_window(xcb_window_t win)
-{
-	xcb_icccm_get_wm_class_reply_t reply;
-	bool ret = false;
-	if (xcb_icccm_get_wm_class_reply(dpy, xcb_icccm_get_wm_class(dpy, win), &reply, NULL) == 1) {
-		if (streq(BSPWM_CLASS_NAME, reply.class_name) && streq(PRESEL_FEEDBACK_I, reply.instance_name)) {
-			ret = true;
+	if (presel_feedback_pool_len < PRESEL_FEEDBACK_POOL_SIZE) {
+		xcb_window_t parent = desktop_parent(d);
+		window_hide_in(parent, p->feedback);
+		if (parent != root) {
+			backend->reparent_window(p->feedback, root, 0, 0);
 		}
-		xcb_icccm_get_wm_class_reply_wipe(&reply);
+		presel_feedback_pool[presel_feedback_pool_len++] = p->feedback;
+	} else {
+		backend->destroy_window(p->feedback);
 	}
-	return ret;
+
+	p->feedback = XCB_NONE;
 }
 
-void initialize_presel_feedback(node_t *n)
+/* Forces the next drawing and restacking of the feedbacks to be sent. */
+void invalidate_presel_feedbacks(node_t *n)
 {
-	if (n == NULL || n->presel == NULL || n->presel->feedback != XCB_NONE) {
+	if (n == NULL) {
 		return;
 	}
-
-	xcb_window_t win = xcb_generate_id(dpy);
-	uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_SAVE_UNDER;
-	uint32_t values[] = {get_color_pixel(presel_feedback_color), 1};
-	xcb_create_window(dpy, XCB_COPY_FROM_PARENT, win, root, 0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
-			          XCB_COPY_FROM_PARENT, mask, values);
-
-	xcb_icccm_set_wm_class(dpy, win, sizeof(PRESEL_FEEDBACK_IC), PRESEL_FEEDBACK_IC);
-	/* Make presel window's input shape NULL to pass any input to window below */
-	xcb_shape_rectangles(dpy, XCB_SHAPE_SO_SET, XCB_SHAPE_SK_INPUT, XCB_CLIP_ORDERING_UNSORTED, win, 0, 0, 0, NULL);
-	stacking_list_t *s = stack_tail;
-	while (s != NULL && !IS_TILED(s->node->client)) {
-		s = s->prev;
+	if (n->presel != NULL) {
+		n->presel->feedback_rectangle = (xcb_rectangle_t) {0, 0, 0, 0};
+		n->presel->feedback_anchor = n->presel->feedback_anchor_next = XCB_NONE;
 	}
-	if (s != NULL) {
-		window_above(win, s->node->id);
-	}
-	n->presel->feedback = win;
+	invalidate_presel_feedbacks(n->first_child);
+	invalidate_presel_feedbacks(n->second_child);
 }
 
 void draw_presel_feedback(monitor_t *m, desktop_t *d, node_t *n)
@@ -293,7 +163,7 @@ void draw_presel_feedback(monitor_t *m, desktop_t *d, node_t *n)
 
 	bool exists = (n->presel->feedback != XCB_NONE);
 	if (!exists) {
-		initialize_presel_feedback(n);
+		initialize_presel_feedback(d, n);
 	}
 
 	int gap = gapless_monocle && d->layout == LAYOUT_MONOCLE ? 0 : d->window_gap;
@@ -321,11 +191,16 @@ void draw_presel_feedback(monitor_t *m, desktop_t *d, node_t *n)
 			break;
 	}
 
-	window_move_resize(p->feedback, n->rectangle.x + presel_rect.x, n->rectangle.y + presel_rect.y,
-	                   presel_rect.width, presel_rect.height);
+	presel_rect.x += n->rectangle.x;
+	presel_rect.y += n->rectangle.y;
+
+	if (!rect_eq(presel_rect, p->feedback_rectangle)) {
+		window_move_resize(p->feedback, presel_rect.x, presel_rect.y, presel_rect.width, presel_rect.height);
+		p->feedback_rectangle = presel_rect;
+	}
 
-	if (!exists && m->desk == d) {
-		window_show(p->feedback);
+	if (!exists && (m->desk == d || d->container != XCB_NONE)) {
+		window_show_in(desktop_parent(d), p->feedback);
 	}
 }
 
@@ -350,7 +225,7 @@ void show_presel_feedbacks(monitor_t *m, desktop_t *d, node_t *n)
 	} else {
 		// show preselection feedback
 		if (n->presel != NULL) {
-			window_show(n->presel->feedback);
+			window_show_in(desktop_parent(d), n->presel->feedback);
 		}
 		// recursively show the feedbacks of the node's children
 		show_presel_feedbacks(m, d, n->first_child);
@@ -366,7 +241,7 @@ void hide_presel_feedbacks(monitor_t *m, desktop_t *d, node_t *n)
 	} else {
 		// hide preselection feedback
 		if (n->presel != NULL) {
-			window_hide(n->presel->feedback);
+			window_hide_in(desktop_parent(d), n->presel->feedback);
 		}
 		// recursively hide the feedbacks of the node's children
 		hide_presel_feedbacks(m, d, n->first_child);
@@ -390,11 +265,11 @@ void update_colors_in(node_t *n, desktop_t *d, monitor_t *m)
 	} else {
 		if (n->presel != NULL) {
 			uint32_t pxl = get_color_pixel(presel_feedback_color);
-			xcb_change_window_attributes(dpy, n->presel->feedback, XCB_CW_BACK_PIXEL, &pxl);
+			backend->change_attributes(n->presel->feedback, XCB_CW_BACK_PIXEL, &pxl);
 			if (d == m->desk) {
 				/* hack to induce back pixel refresh */
-				window_hide(n->presel->feedback);
-				window_show(n->presel->feedback);
+				window_hide_in(desktop_parent(d), n->presel->feedback);
+				window_show_in(desktop_parent(d), n->presel->feedback);
 			}
 		}
 		if (n == d->focus) {
@@ -424,28 +299,7 @@ void draw_border(node_t *n, bool focused_node, bool focused_monitor)
 
 void window_draw_border(xcb_window_t win, uint32_t border_color_pxl)
 {
-	xcb_change_window_attributes(dpy, win, XCB_CW_BORDER_PIXEL, &border_color_pxl);
-}
-
-void adopt_orphans(void)
-{
-	xcb_query_tree_reply_t *qtr = xcb_query_tree_reply(dpy, xcb_query_tree(dpy, root), NULL);
-	if (qtr == NULL) {
-		return;
-	}
-
-	int len = xcb_query_tree_children_length(qtr);
-	xcb_window_t *wins = xcb_query_tree_children(qtr);
-
-	for (int i = 0; i < len; i++) {
-		uint32_t idx;
-		xcb_window_t win = wins[i];
-		if (xcb_ewmh_get_wm_desktop_reply(ewmh, xcb_ewmh_get_wm_desktop(ewmh, win), &idx, NULL) == 1) {
-			schedule_window(win);
-		}
-	}
-
-	free(qtr);
+	backend->change_attributes(win, XCB_CW_BORDER_PIXEL, &border_color_pxl);
 }
 
 uint32_t get_border_color(bool focused_node, bool focused_monitor)
@@ -459,28 +313,14 @@ uint32_t get_border_color(bool focused_node, bool focused_monitor)
 	}
 }
 
-void initialize_floating_rectangle(node_t *n)
-{
-	client_t *c = n->client;
-
-	xcb_get_geometry_reply_t *geo = xcb_get_geometry_reply(dpy, xcb_get_geometry(dpy, n->id), NULL);
-
-	if (geo != NULL) {
-		c->floating_rectangle = (xcb_rectangle_t) {geo->x, geo->y, geo->width, geo->height};
-	}
-
-	free(geo);
-}
-
 xcb_rectangle_t get_window_rectangle(node_t *n)
 {
 	client_t *c = n->client;
 	if (c != NULL) {
-		xcb_get_geometry_reply_t *g = xcb_get_geometry_reply(dpy, xcb_get_geometry(dpy, n->id), NULL);
-		if (g != NULL) {
-			xcb_rectangle_t rect = (xcb_rectangle_t) {g->x, g->y, g->width, g->height};
-			free(g);
-			return rect;
+		window_geometry_t geo;
+		backend->get_geometries(&n->id, 1, &geo);
+		if (geo.valid) {
+			return geo.rectangle;
 		}
 	}
 	return (xcb_rectangle_t) {0, 0, screen_width, screen_height};
@@ -530,7 +370,7 @@ bool move_client(coordinates_t *loc, int dx, int dy)
 		c->floating_rectangle.x = x;
 		c->floating_rectangle.y = y;
 		if (!grabbing) {
-			put_status(SBSC_MASK_NODE_GEOMETRY, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc->monitor->id, loc->desktop->id, loc->node->id, rect.width, rect.height, x, y);
+			put_status_in(SBSC_MASK_NODE_GEOMETRY, loc, NULL, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc->monitor->id, loc->desktop->id, loc->node->id, rect.width, rect.height, x, y);
 		}
 		pm = monitor_from_client(c);
 	}
@@ -579,7 +419,7 @@ bool resize_client(coordinates_t *loc, resize_handle_t rh, int dx, int dy, bool
 			}
 			sr = MAX(0, sr);
 			sr = MIN(1, sr);
-			vertical_fence->split_ratio = sr;
+			set_ratio(vertical_fence, sr);
 		}
 		if (horizontal_fence != NULL) {
 			double sr = 0.0;
@@ -590,7 +430,7 @@ bool resize_client(coordinates_t *loc, resize_handle_t rh, int dx, int dy, bool
 			}
 			sr = MAX(0, sr);
 			sr = MIN(1, sr);
-			horizontal_fence->split_ratio = sr;
+			set_ratio(horizontal_fence, sr);
 		}
 		node_t *target_fence = horizontal_fence != NULL ? horizontal_fence : vertical_fence;
 		adjust_ratios(target_fence, target_fence->rectangle);
@@ -626,7 +466,7 @@ bool resize_client(coordinates_t *loc, resize_handle_t rh, int dx, int dy, bool
 			window_move_resize(n->id, x, y, width, height);
 
 			if (!grabbing) {
-				put_status(SBSC_MASK_NODE_GEOMETRY, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc->monitor->id, loc->desktop->id, loc->node->id, width, height, x, y);
+				put_status_in(SBSC_MASK_NODE_GEOMETRY, loc, NULL, "node_geometry 0x%08X 0x%08X 0x%08X %ux%u+%i+%i\n", loc->monitor->id, loc->desktop->id, loc->node->id, width, height, x, y);
 			}
 		} else {
 			arrange(loc->monitor, loc->desktop);
@@ -728,38 +568,151 @@ void apply_size_hints(client_t *c, uint16_t *width, uint16_t *height)
 	}
 }
 
+/* Sends the title event if the title of `n` changed, unless one was sent less
+ * than `node_title_interval` ago: the event is then sent by
+ * `flush_pending_titles`. */
+void set_title(monitor_t *m, desktop_t *d, node_t *n, const char *title)
+{
+	client_t *c = n->client;
+	if (streq(title, c->name)) {
+		return;
+	}
+	snprintf(c->name, sizeof(c->name), "%s", title);
+	if (stats_clock() - c->title_stamp < (uint64_t) node_title_interval * 1000) {
+		if (!c->title_pending) {
+			c->title_pending = true;
+			pending_titles_count++;
+		}
+		return;
+	}
+	put_title(m, d, n);
+}
+
+void put_title(monitor_t *m, desktop_t *d, node_t *n)
+{
+	client_t *c = n->client;
+	discard_pending_title(c);
+	c->title_stamp = stats_clock();
+	put_status_in(SBSC_MASK_NODE_TITLE, &(coordinates_t) {m, d, n}, NULL, "node_title 0x%08X 0x%08X 0x%08X %s\n", m->id, d->id, n->id, c->name);
+}
+
+void discard_pending_title(client_t *c)
+{
+	if (!c->title_pending) {
+		return;
+	}
+	c->title_pending = false;
+	pending_titles_count--;
+}
+
+void discard_throttled_configure(client_t *c)
+{
+	if (c->throttled_configure == NULL) {
+		return;
+	}
+	free(c->throttled_configure);
+	c->throttled_configure = NULL;
+	throttled_count--;
+}
+
+/* Returns the number of microseconds until a pending title event can be
+ * sent, or -1 if there are none. */
+int64_t pending_title_delay(void)
+{
+	if (pending_titles_count == 0) {
+		return -1;
+	}
+	uint64_t now = stats_clock();
+	uint64_t interval = (uint64_t) node_title_interval * 1000;
+	int64_t delay = -1;
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
+				client_t *c = n->client;
+				if (c == NULL || !c->title_pending) {
+					continue;
+				}
+				uint64_t elapsed = now - c->title_stamp;
+				int64_t wait = (elapsed >= interval ? 0 : (int64_t) (interval - elapsed));
+				if (delay == -1 || wait < delay) {
+					delay = wait;
+				}
+			}
+		}
+	}
+	return delay;
+}
+
+/* Sends the pending title events whose interval has elapsed. */
+void flush_pending_titles(void)
+{
+	if (pending_titles_count == 0) {
+		return;
+	}
+	uint64_t now = stats_clock();
+	uint64_t interval = (uint64_t) node_title_interval * 1000;
+	for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+		for (desktop_t *d = m->desk_head; d != NULL; d = d->next) {
+			for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
+				client_t *c = n->client;
+				if (c != NULL && c->title_pending && now - c->title_stamp >= interval) {
+					put_title(m, d, n);
+				}
+			}
+		}
+	}
+}
+
 void query_pointer(xcb_window_t *win, xcb_point_t *pt)
 {
 	if (motion_recorder.enabled) {
 		window_hide(motion_recorder.id);
 	}
 
-	xcb_query_pointer_reply_t *qpr = xcb_query_pointer_reply(dpy, xcb_query_pointer(dpy, root), NULL);
+	xcb_window_t child;
+	xcb_point_t root_pt;
+	bool found = backend->query_pointer(root, &child, &root_pt);
+
+	if (found && child != XCB_NONE && desktop_containers) {
+		/* The children of the root window are desktop containers: look one level deeper. */
+		for (monitor_t *m = mon_head; m != NULL; m = m->next) {
+			if (m->desk == NULL || m->desk->container != child) {
+				continue;
+			}
+			xcb_window_t container_child;
+			xcb_point_t container_pt;
+			if (backend->query_pointer(child, &container_child, &container_pt)) {
+				child = container_child;
+			}
+			if (child == XCB_NONE && focus_follows_pointer) {
+				child = m->root;
+			}
+			break;
+		}
+	}
 
-	if (qpr != NULL) {
+	if (found) {
 		if (win != NULL) {
-			if (qpr->child == XCB_NONE) {
-				xcb_point_t mpt = (xcb_point_t) {qpr->root_x, qpr->root_y};
-				monitor_t *m = monitor_from_point(mpt);
+			if (child == XCB_NONE) {
+				monitor_t *m = monitor_from_point(root_pt);
 				if (m != NULL) {
 					desktop_t *d = m->desk;
-					for (node_t *n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
-						if (n->client == NULL && is_inside(mpt, get_rectangle(m, d, n))) {
+					for (node_t *n = d->leaf_head; n != NULL; n = n->leaf_next) {
+						if (n->client == NULL && is_inside(root_pt, get_rectangle(m, d, n))) {
 							*win = n->id;
 							break;
 						}
 					}
 				}
 			} else {
-				*win = qpr->child;
-				xcb_point_t pt = {qpr->root_x, qpr->root_y};
+				*win = child;
 				for (stacking_list_t *s = stack_tail; s != NULL; s = s->prev) {
 					if (!s->node->client->shown || s->node->hidden) {
 						continue;
 					}
 					xcb_rectangle_t rect = get_rectangle(NULL, NULL, s->node);
-					if (is_inside(pt, rect)) {
-						if (s->node->id == qpr->child || is_presel_window(qpr->child)) {
+					if (is_inside(root_pt, rect)) {
+						if (s->node->id == child || is_presel_window(child)) {
 							*win = s->node->id;
 						}
 						break;
@@ -768,12 +721,10 @@ void query_pointer(xcb_window_t *win, xcb_point_t *pt)
 			}
 		}
 		if (pt != NULL) {
-			*pt = (xcb_point_t) {qpr->root_x, qpr->root_y};
+			*pt = root_pt;
 		}
 	}
 
-	free(qpr);
-
 	if (motion_recorder.enabled) {
 		window_show(motion_recorder.id);
 	}
@@ -793,30 +744,32 @@ void update_motion_recorder(void)
 	}
 	desktop_t *d = m->desk;
 	node_t *n = NULL;
-	for (n = first_extrema(d->root); n != NULL; n = next_leaf(n, d->root)) {
+	for (n = d->leaf_head; n != NULL; n = n->leaf_next) {
 		if (n->id == win || (n->presel != NULL && n->presel->feedback == win)) {
 			break;
 		}
 	}
 	if ((n != NULL && n != mon->desk->focus) || (n == NULL && m != mon)) {
-		enable_motion_recorder(win);
+		/* The motion recorder is a child of the root window. */
+		bool contained = (d->container != XCB_NONE && (n != NULL || win == m->root));
+		enable_motion_recorder(win, contained ? d->container : win);
 	} else {
 		disable_motion_recorder();
 	}
 }
 
-void enable_motion_recorder(xcb_window_t win)
+void enable_motion_recorder(xcb_window_t win, xcb_window_t sibling)
 {
-	xcb_get_geometry_reply_t *geo = xcb_get_geometry_reply(dpy, xcb_get_geometry(dpy, win), NULL);
-	if (geo != NULL) {
-		uint16_t width = geo->width + 2 * geo->border_width;
-		uint16_t height = geo->height + 2 * geo->border_width;
-		window_move_resize(motion_recorder.id, geo->x, geo->y, width, height);
-		window_above(motion_recorder.id, win);
+	window_geometry_t geo;
+	backend->get_geometries(&win, 1, &geo);
+	if (geo.valid) {
+		uint16_t width = geo.rectangle.width + 2 * geo.border_width;
+		uint16_t height = geo.rectangle.height + 2 * geo.border_width;
+		window_move_resize(motion_recorder.id, geo.rectangle.x, geo.rectangle.y, width, height);
+		window_above(motion_recorder.id, sibling);
 		window_show(motion_recorder.id);
 		motion_recorder.enabled = true;
 	}
-	free(geo);
 }
 
 void disable_motion_recorder(void)
@@ -831,25 +784,25 @@ void disable_motion_recorder(void)
 void window_border_width(xcb_window_t win, uint32_t bw)
 {
 	uint32_t values[] = {bw};
-	xcb_configure_window(dpy, win, XCB_CONFIG_WINDOW_BORDER_WIDTH, values);
+	backend->configure_window(win, XCB_CONFIG_WINDOW_BORDER_WIDTH, values);
 }
 
 void window_move(xcb_window_t win, int16_t x, int16_t y)
 {
 	uint32_t values[] = {x, y};
-	xcb_configure_window(dpy, win, XCB_CONFIG_WINDOW_X_Y, values);
+	backend->configure_window(win, XCB_CONFIG_WINDOW_X_Y, values);
 }
 
 void window_resize(xcb_window_t win, uint16_t w, uint16_t h)
 {
 	uint32_t values[] = {w, h};
-	xcb_configure_window(dpy, win, XCB_CONFIG_WINDOW_WIDTH_HEIGHT, values);
+	backend->configure_window(win, XCB_CONFIG_WINDOW_WIDTH_HEIGHT, values);
 }
 
 void window_move_resize(xcb_window_t win, int16_t x, int16_t y, uint16_t w, uint16_t h)
 {
 	uint32_t values[] = {x, y, w, h};
-	xcb_configure_window(dpy, win, XCB_CONFIG_WINDOW_X_Y_WIDTH_HEIGHT, values);
+	backend->configure_window(win, XCB_CONFIG_WINDOW_X_Y_WIDTH_HEIGHT, values);
 }
 
 void window_center(monitor_t *m, client_t *c)
@@ -877,7 +830,7 @@ void window_stack(xcb_window_t w1, xcb_window_t w2, uint32_t mode)
 	}
 	uint16_t mask = XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE;
 	uint32_t values[] = {w2, mode};
-	xcb_configure_window(dpy, w1, mask, values);
+	backend->configure_window(w1, mask, values);
 }
 
 void window_above(xcb_window_t w1, xcb_window_t w2)
@@ -893,32 +846,117 @@ void window_below(xcb_window_t w1, xcb_window_t w2)
 void window_lower(xcb_window_t win)
 {
 	uint32_t values[] = {XCB_STACK_MODE_BELOW};
-	xcb_configure_window(dpy, win, XCB_CONFIG_WINDOW_STACK_MODE, values);
+	backend->configure_window(win, XCB_CONFIG_WINDOW_STACK_MODE, values);
 }
 
 void window_set_visibility(xcb_window_t win, bool visible)
 {
-	uint32_t values_off[] = {ROOT_EVENT_MASK & ~XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY};
-	uint32_t values_on[] = {ROOT_EVENT_MASK};
-	xcb_change_window_attributes(dpy, root, XCB_CW_EVENT_MASK, values_off);
+	window_set_visibility_in(root, win, visible);
+}
+
+void window_hide(xcb_window_t win)
+{
+	window_set_visibility(win, false);
+}
+
+void window_show(xcb_window_t win)
+{
+	window_set_visibility(win, true);
+}
+
+void window_set_visibility_in(xcb_window_t parent, xcb_window_t win, bool visible)
+{
+	uint32_t mask = (parent == root ? ROOT_EVENT_MASK : container_event_mask());
+	uint32_t values_off[] = {mask & ~XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY};
+	uint32_t values_on[] = {mask};
+	backend->change_attributes(parent, XCB_CW_EVENT_MASK, values_off);
 	if (visible) {
 		set_window_state(win, XCB_ICCCM_WM_STATE_NORMAL);
-		xcb_map_window(dpy, win);
+		backend->map_window(win);
 	} else {
-		xcb_unmap_window(dpy, win);
+		backend->unmap_window(win);
 		set_window_state(win, XCB_ICCCM_WM_STATE_ICONIC);
 	}
-	xcb_change_window_attributes(dpy, root, XCB_CW_EVENT_MASK, values_on);
+	backend->change_attributes(parent, XCB_CW_EVENT_MASK, values_on);
 }
 
-void window_hide(xcb_window_t win)
+void window_hide_in(xcb_window_t parent, xcb_window_t win)
 {
-	window_set_visibility(win, false);
+	window_set_visibility_in(parent, win, false);
 }
 
-void window_show(xcb_window_t win)
+void window_show_in(xcb_window_t parent, xcb_window_t win)
 {
-	window_set_visibility(win, true);
+	window_set_visibility_in(parent, win, true);
+}
+
+void reparent_windows(xcb_window_t *wins, int len, xcb_window_t from, xcb_window_t to)
+{
+	if (len < 1 || from == to) {
+		return;
+	}
+
+	window_geometry_t *geos = malloc(len * sizeof(window_geometry_t));
+	if (geos == NULL) {
+		return;
+	}
+
+	backend->get_geometries(wins, len, geos);
+
+	/* Reparenting a mapped window unmaps it first: don't mistake that for a withdrawal. */
+	uint32_t mask = (from == root ? ROOT_EVENT_MASK : container_event_mask());
+	uint32_t values_off[] = {mask & ~XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY};
+	uint32_t values_on[] = {mask};
+	backend->change_attributes(from, XCB_CW_EVENT_MASK, values_off);
+
+	for (int i = 0; i < len; i++) {
+		if (!geos[i].valid) {
+			continue;
+		}
+		if (to != root) {
+			backend->change_save_set(XCB_SET_MODE_INSERT, wins[i]);
+		}
+		backend->reparent_window(wins[i], to, geos[i].rectangle.x, geos[i].rectangle.y);
+	}
+
+	backend->change_attributes(from, XCB_CW_EVENT_MASK, values_on);
+	free(geos);
+}
+
+static void collect_node_windows(node_t *n, xcb_window_t **wins, int *len, int *cap)
+{
+	if (n == NULL) {
+		return;
+	}
+	if (*len + 2 > *cap) {
+		int c = (*cap == 0 ? 16 : 2 * *cap);
+		xcb_window_t *w = realloc(*wins, c * sizeof(xcb_window_t));
+		if (w == NULL) {
+			return;
+		}
+		*wins = w;
+		*cap = c;
+	}
+	if (n->client != NULL) {
+		(*wins)[(*len)++] = n->id;
+	}
+	if (n->presel != NULL && n->presel->feedback != XCB_NONE) {
+		(*wins)[(*len)++] = n->presel->feedback;
+	}
+	collect_node_windows(n->first_child, wins, len, cap);
+	collect_node_windows(n->second_child, wins, len, cap);
+}
+
+void reparent_node_windows(node_t *n, xcb_window_t from, xcb_window_t to)
+{
+	if (n == NULL || from == to) {
+		return;
+	}
+	xcb_window_t *wins = NULL;
+	int len = 0, cap = 0;
+	collect_node_windows(n, &wins, &len, &cap);
+	reparent_windows(wins, len, from, to);
+	free(wins);
 }
 
 void update_input_focus(void)
@@ -932,7 +970,7 @@ void set_input_focus(node_t *n)
 		clear_input_focus();
 	} else {
 		if (n->client->icccm_props.input_hint) {
-			xcb_set_input_focus(dpy, XCB_INPUT_FOCUS_PARENT, n->id, XCB_CURRENT_TIME);
+			backend->set_input_focus(XCB_INPUT_FOCUS_PARENT, n->id);
 		} else if (n->client->icccm_props.take_focus) {
 			send_client_message(n->id, ewmh->WM_PROTOCOLS, WM_TAKE_FOCUS);
 		}
@@ -941,7 +979,7 @@ void set_input_focus(node_t *n)
 
 void clear_input_focus(void)
 {
-	xcb_set_input_focus(dpy, XCB_INPUT_FOCUS_POINTER_ROOT, root, XCB_CURRENT_TIME);
+	backend->set_input_focus(XCB_INPUT_FOCUS_POINTER_ROOT, root);
 }
 
 void center_pointer(xcb_rectangle_t r)
@@ -953,23 +991,17 @@ void center_pointer(xcb_rectangle_t r)
 	int16_t cx = r.x + r.width / 2;
 	int16_t cy = r.y + r.height / 2;
 	// move the mouse pointer to the calculated position
-	xcb_warp_pointer(dpy, XCB_NONE, root, 0, 0, 0, 0, cx, cy);
+	backend->warp_pointer(cx, cy);
 }
 
-void get_atom(char *name, xcb_atom_t *atom)
+void set_atom(xcb_window_t win, xcb_atom_t atom, uint32_t value)
 {
-	xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(dpy, xcb_intern_atom(dpy, 0, strlen(name), name), NULL);
-	if (reply != NULL) {
-		*atom = reply->atom;
-	} else {
-		*atom = XCB_NONE;
-	}
-	free(reply);
+	backend->change_property(win, atom, XCB_ATOM_CARDINAL, 32, 1, &value);
 }
 
-void set_atom(xcb_window_t win, xcb_atom_t atom, uint32_t value)
+void set_wm_class(xcb_window_t win, uint32_t len, const char *class_instance)
 {
-	xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, win, atom, XCB_ATOM_CARDINAL, 32, 1, &value);
+	backend->change_property(win, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8, len, class_instance);
 }
 
 void send_client_message(xcb_window_t win, xcb_atom_t property, xcb_atom_t value)
@@ -983,20 +1015,12 @@ void send_client_message(xcb_window_t win, xcb_atom_t property, xcb_atom_t value
 	e->data.data32[0] = value;
 	e->data.data32[1] = XCB_CURRENT_TIME;
 
-	xcb_send_event(dpy, false, win, XCB_EVENT_MASK_NO_EVENT, (char *) e);
-	xcb_flush(dpy);
+	backend->send_event(win, XCB_EVENT_MASK_NO_EVENT, (char *) e);
+	backend->flush();
 	free(e);
 }
 
 bool window_exists(xcb_window_t win)
 {
-	xcb_generic_error_t *err;
-	free(xcb_query_tree_reply(dpy, xcb_query_tree(dpy, win), &err));
-
-	if (err != NULL) {
-		free(err);
-		return false;
-	}
-
-	return true;
+	return backend->query_tree(win, NULL, NULL);
 }
@@ -31,12 +31,13 @@
 #include <xcb/xcb_icccm.h>
 #include "types.h"
 
-void schedule_window(xcb_window_t win);
-bool manage_window(xcb_window_t win, rule_consequence_t *csq, int fd);
+#define PRESEL_FEEDBACK_POOL_SIZE  8
+
 void set_window_state(xcb_window_t win, xcb_icccm_wm_state_t state);
-void unmanage_window(xcb_window_t win);
 bool is_presel_window(xcb_window_t win);
-void initialize_presel_feedback(node_t *n);
+void initialize_presel_feedback(desktop_t *d, node_t *n);
+void release_presel_feedback(desktop_t *d, presel_t *p);
+void invalidate_presel_feedbacks(node_t *n);
 void draw_presel_feedback(monitor_t *m, desktop_t *d, node_t *n);
 void refresh_presel_feedbacks(monitor_t *m, desktop_t *d, node_t *n);
 
@@ -68,7 +69,6 @@ void draw_border(node_t *n, bool focused_node, bool focused_monitor);
  * @param border_color_pxl the border color
  */
 void window_draw_border(xcb_window_t win, uint32_t border_color_pxl);
-void adopt_orphans(void);
 
 
 /**
@@ -79,14 +79,19 @@ void adopt_orphans(void);
  * @return uint32_t: the border color
  */
 uint32_t get_border_color(bool focused_node, bool focused_monitor);
-void initialize_floating_rectangle(node_t *n);
 xcb_rectangle_t get_window_rectangle(node_t *n);
 bool move_client(coordinates_t *loc, int dx, int dy);
 bool resize_client(coordinates_t *loc, resize_handle_t rh, int dx, int dy, bool relative);
 void apply_size_hints(client_t *c, uint16_t *width, uint16_t *height);
+void set_title(monitor_t *m, desktop_t *d, node_t *n, const char *title);
+void put_title(monitor_t *m, desktop_t *d, node_t *n);
+void discard_pending_title(client_t *c);
+void discard_throttled_configure(client_t *c);
+int64_t pending_title_delay(void);
+void flush_pending_titles(void);
 void query_pointer(xcb_window_t *win, xcb_point_t *pt);
 void update_motion_recorder(void);
-void enable_motion_recorder(xcb_window_t win);
+void enable_motion_recorder(xcb_window_t win, xcb_window_t sibling);
 void disable_motion_recorder(void);
 
 /**
@@ -189,6 +194,36 @@ void window_hide(xcb_window_t win);
  */
 void window_show(xcb_window_t win);
 
+/**
+ * @brief Set the visibility of a window whose parent isn't necessarily the root
+ *
+ * @param parent the parent of the window
+ * @param win the window
+ * @param visible true: set window visible, else invisible
+ */
+void window_set_visibility_in(xcb_window_t parent, xcb_window_t win, bool visible);
+void window_hide_in(xcb_window_t parent, xcb_window_t win);
+void window_show_in(xcb_window_t parent, xcb_window_t win);
+
+/**
+ * @brief Move windows from one parent to another without altering their positions
+ *
+ * @param wins the windows
+ * @param len the number of windows
+ * @param from the current parent
+ * @param to the new parent
+ */
+void reparent_windows(xcb_window_t *wins, int len, xcb_window_t from, xcb_window_t to);
+
+/**
+ * @brief Move the windows of the given subtree from one parent to another
+ *
+ * @param n the root of the subtree
+ * @param from the current parent
+ * @param to the new parent
+ */
+void reparent_node_windows(node_t *n, xcb_window_t from, xcb_window_t to);
+
 /**
  * @brief Set the input focus to the currently focused node
  * (to prevent input focus stealing)
@@ -216,14 +251,8 @@ void clear_input_focus(void);
  */
 void center_pointer(xcb_rectangle_t r);
 
-/**
- * @brief Get the atom by name
- *
- * @param name name of the atom
- * @param atom pointer to the xcb_atom_t object
- */
-void get_atom(char *name, xcb_atom_t *atom);
 void set_atom(xcb_window_t win, xcb_atom_t atom, uint32_t value);
+void set_wm_class(xcb_window_t win, uint32_t len, const char *class_instance);
 void send_client_message(xcb_window_t win, xcb_atom_t property, xcb_atom_t value);
 bool window_exists(xcb_window_t win);
 
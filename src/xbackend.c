@@ -0,0 +1,195 @@
+/* Copyright (c) 2012, Bastien Dejean
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <xcb/shape.h>
+#include "bspwm.h"
+#include "backend.h"
+
+static uint32_t x_generate_id(void)
+{
+	return xcb_generate_id(dpy);
+}
+
+static void x_configure_window(xcb_window_t win, uint16_t mask, const uint32_t *values)
+{
+	xcb_configure_window(dpy, win, mask, values);
+}
+
+static void x_change_attributes(xcb_window_t win, uint32_t mask, const uint32_t *values)
+{
+	xcb_change_window_attributes(dpy, win, mask, values);
+}
+
+static void x_change_property(xcb_window_t win, xcb_atom_t property, xcb_atom_t type, uint8_t format, uint32_t len, const void *data)
+{
+	xcb_change_property(dpy, XCB_PROP_MODE_REPLACE, win, property, type, format, len, data);
+}
+
+static void x_map_window(xcb_window_t win)
+{
+	xcb_map_window(dpy, win);
+}
+
+static void x_unmap_window(xcb_window_t win)
+{
+	xcb_unmap_window(dpy, win);
+}
+
+static void x_set_input_focus(uint8_t revert_to, xcb_window_t win)
+{
+	xcb_set_input_focus(dpy, revert_to, win, XCB_CURRENT_TIME);
+}
+
+static void x_flush(void)
+{
+	xcb_flush(dpy);
+}
+
+static void x_create_window(xcb_window_t win, xcb_window_t parent, xcb_rectangle_t rect, uint16_t class, uint32_t mask, const uint32_t *values)
+{
+	xcb_create_window(dpy, XCB_COPY_FROM_PARENT, win, parent, rect.x, rect.y, rect.width, rect.height, 0,
+	                  class, XCB_COPY_FROM_PARENT, mask, values);
+}
+
+static void x_destroy_window(xcb_window_t win)
+{
+	xcb_destroy_window(dpy, win);
+}
+
+static void x_reparent_window(xcb_window_t win, xcb_window_t parent, int16_t x, int16_t y)
+{
+	xcb_reparent_window(dpy, win, parent, x, y);
+}
+
+static void x_change_save_set(uint8_t mode, xcb_window_t win)
+{
+	xcb_change_save_set(dpy, mode, win);
+}
+
+static void x_shape_rectangles(uint8_t kind, xcb_window_t win, uint32_t len, const xcb_rectangle_t *rects)
+{
+	xcb_shape_rectangles(dpy, XCB_SHAPE_SO_SET, kind, XCB_CLIP_ORDERING_UNSORTED, win, 0, 0, len, rects);
+}
+
+static void x_send_event(xcb_window_t win, uint32_t mask, const char *event)
+{
+	xcb_send_event(dpy, false, win, mask, event);
+}
+
+static void x_warp_pointer(int16_t x, int16_t y)
+{
+	xcb_warp_pointer(dpy, XCB_NONE, root, 0, 0, 0, 0, x, y);
+}
+
+static void x_kill_client(xcb_window_t win)
+{
+	xcb_kill_client(dpy, win);
+}
+
+static bool x_query_tree(xcb_window_t win, xcb_window_t **children, int *len)
+{
+	xcb_query_tree_reply_t *qtr = xcb_query_tree_reply(dpy, xcb_query_tree(dpy, win), NULL);
+	if (qtr == NULL) {
+		return false;
+	}
+	if (children != NULL) {
+		*len = xcb_query_tree_children_length(qtr);
+		*children = malloc(*len * sizeof(xcb_window_t));
+		if (*children == NULL) {
+			*len = 0;
+		} else {
+			memcpy(*children, xcb_query_tree_children(qtr), *len * sizeof(xcb_window_t));
+		}
+	}
+	free(qtr);
+	return true;
+}
+
+static void read_geometry(xcb_get_geometry_cookie_t cookie, window_geometry_t *g)
+{
+	xcb_get_geometry_reply_t *geo = xcb_get_geometry_reply(dpy, cookie, NULL);
+	if (geo != NULL) {
+		*g = (window_geometry_t) {{geo->x, geo->y, geo->width, geo->height}, geo->border_width, true};
+	} else {
+		g->valid = false;
+	}
+	free(geo);
+}
+
+/* All the requests are sent before waiting for the first reply. */
+static void x_get_geometries(const xcb_window_t *wins, int len, window_geometry_t *geos)
+{
+	xcb_get_geometry_cookie_t *cookies = malloc(len * sizeof(xcb_get_geometry_cookie_t));
+	if (cookies == NULL) {
+		for (int i = 0; i < len; i++) {
+			read_geometry(xcb_get_geometry(dpy, wins[i]), &geos[i]);
+		}
+		return;
+	}
+	for (int i = 0; i < len; i++) {
+		cookies[i] = xcb_get_geometry(dpy, wins[i]);
+	}
+	for (int i = 0; i < len; i++) {
+		read_geometry(cookies[i], &geos[i]);
+	}
+	free(cookies);
+}
+
+static bool x_query_pointer(xcb_window_t win, xcb_window_t *child, xcb_point_t *pt)
+{
+	xcb_query_pointer_reply_t *qpr = xcb_query_pointer_reply(dpy, xcb_query_pointer(dpy, win), NULL);
+	if (qpr == NULL) {
+		return false;
+	}
+	*child = qpr->child;
+	*pt = (xcb_point_t) {qpr->root_x, qpr->root_y};
+	free(qpr);
+	return true;
+}
+
+const backend_t x_backend = {
+	"x",
+	x_generate_id,
+	x_configure_window,
+	x_change_attributes,
+	x_change_property,
+	x_map_window,
+	x_unmap_window,
+	x_set_input_focus,
+	x_flush,
+	x_create_window,
+	x_destroy_window,
+	x_reparent_window,
+	x_change_save_set,
+	x_shape_rectangles,
+	x_send_event,
+	x_warp_pointer,
+	x_kill_client,
+	x_query_tree,
+	x_get_geometries,
+	x_query_pointer
+};
+